@@ -29,6 +29,8 @@
 #include "gsthailobuffermeta.hpp"
 #include "gstmedialibcommon.hpp"
 #include "media_library/media_library_types.hpp"
+#include "media_library/buffer_pool_registry.hpp"
+#include "media_library/threading_manager.hpp"
 #include <algorithm>
 #include <iostream>
 #include <sstream>
@@ -59,13 +61,14 @@ media_library_return MediaLibraryEncoder::Impl::init_buffer_pool(const InputPara
     uint frame_height = input_params.height;
     size_t max_buffers = input_params.max_pool_size;
 
-    m_buffer_pool = std::make_shared<MediaLibraryBufferPool>(frame_width, frame_height, HAILO_FORMAT_GRAY8, max_buffers,
-                                                             HAILO_MEMORY_TYPE_DMABUF, name);
-    if (m_buffer_pool->init() != MEDIA_LIBRARY_SUCCESS)
+    buffer_pool_key_t key = {frame_width, frame_height, HAILO_FORMAT_GRAY8, HAILO_MEMORY_TYPE_DMABUF, frame_width};
+    auto pool_expected = BufferPoolRegistry::get_instance().lease(key, max_buffers, name);
+    if (!pool_expected.has_value())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to initialize buffer pool");
         return media_library_return::MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
+    m_buffer_pool = pool_expected.value();
     LOGGER__MODULE__INFO(MODULE_NAME, "Buffer pool initialized successfully with frame size {}x{}", frame_width,
                          frame_height);
     return media_library_return::MEDIA_LIBRARY_SUCCESS;
@@ -143,7 +146,10 @@ media_library_return MediaLibraryEncoder::Impl::start()
         return MEDIA_LIBRARY_ERROR;
     }
 
-    m_main_loop_thread = std::make_shared<std::thread>([this]() { g_main_loop_run(m_main_loop); });
+    m_main_loop_thread = std::make_shared<std::thread>([this]() {
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_ENCODER_LOOP);
+        g_main_loop_run(m_main_loop);
+    });
 
     return MEDIA_LIBRARY_SUCCESS;
 }
@@ -453,13 +459,14 @@ GstFlowReturn MediaLibraryEncoder::Impl::on_new_sample(GstAppSink *appsink)
         break;
     }
     case EncoderType::Jpeg: {
-        HailoMediaLibraryBufferPtr hailo_buffer = std::make_shared<hailo_media_library_buffer>();
-        if (m_buffer_pool->acquire_buffer(hailo_buffer) != MEDIA_LIBRARY_SUCCESS)
+        auto hailo_buffer_expected = m_buffer_pool->acquire_buffer();
+        if (!hailo_buffer_expected.has_value())
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire buffer");
             return GST_FLOW_ERROR;
         }
-        hailo_buffer->sync_start();
+        HailoMediaLibraryBufferPtr hailo_buffer = std::move(hailo_buffer_expected.value());
+        hailo_buffer->sync_start(DMA_SYNC_ACCESS_WRITE);
         size_t input_size;
         hailo_buffer_from_jpeg_gst_buffer(buffer, hailo_buffer, &input_size);
         hailo_buffer->sync_end();
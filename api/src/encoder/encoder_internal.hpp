@@ -108,7 +108,7 @@ class MediaLibraryEncoder::Impl final
     encoder_monitors get_encoder_monitors();
     static InputParams extract_input_params(const encoder_config_t &cfg);
     static EncoderType extract_encoder_type(const encoder_config_t &cfg);
-    static constexpr uint32_t DEFAULT_MAX_POOL_SIZE = 5;
+    static constexpr uint32_t DEFAULT_MAX_POOL_SIZE = input_config_t::DEFAULT_MAX_POOL_SIZE;
     /**
      * Below are public functions that are not part of the public API
      * but are public for GStreamer callbacks.
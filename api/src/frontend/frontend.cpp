@@ -9,6 +9,7 @@
 #include "media_library/config_manager.hpp"
 #include "media_library/logger_macros.hpp"
 #include "media_library/media_library_logger.hpp"
+#include "media_library/threading_manager.hpp"
 #include "frontend_internal.hpp"
 #include "gsthailobuffermeta.hpp"
 #include "gstmedialibcommon.hpp"
@@ -314,7 +315,10 @@ media_library_return MediaLibraryFrontend::Impl::start()
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to start pipeline");
         return MEDIA_LIBRARY_ERROR;
     }
-    m_main_loop_thread = std::make_shared<std::thread>([this]() { g_main_loop_run(m_main_loop); });
+    m_main_loop_thread = std::make_shared<std::thread>([this]() {
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_FRONTEND_LOOP);
+        g_main_loop_run(m_main_loop);
+    });
 
     // Wait for the main loop to start before we proceed to avoid racing condition in case start() is called again
     // before g_main_loop is ready/running
@@ -7,6 +7,7 @@
 #include "media_library/common.hpp"
 #include "media_library/media_library_types.hpp"
 #include "media_library/sensor_registry.hpp"
+#include "media_library/dma_budget_manager.hpp"
 #include <nlohmann/json.hpp>
 #include <iostream>
 #include <string>
@@ -745,6 +746,20 @@ media_library_return MediaLibrary::set_override_parameters(config_profile_t prof
         return MEDIA_LIBRARY_PROFILE_IS_RESTRICTED;
     }
     config_profile_t new_profile = m_media_lib_config_manager->get_current_profile();
+
+    // Check that the profile's buffer pools fit in DMA memory before anything is reallocated
+    auto budget_plan = DmaBudgetManager::get_instance().admit_profile(new_profile);
+    if (!budget_plan.has_value())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Profile {} does not fit in DMA memory", new_profile.name);
+        m_media_lib_config_manager->set_profile(previous_profile);
+        return budget_plan.error();
+    }
+    if (budget_plan->degraded)
+    {
+        m_media_lib_config_manager->set_profile(new_profile);
+        new_profile = m_media_lib_config_manager->get_current_profile();
+    }
     bool restart_required = stream_restart_required(previous_profile, new_profile);
     bool frontend_pause_unpause_required = frontend_pause_required(previous_profile, new_profile, restart_required);
     if (restart_required)
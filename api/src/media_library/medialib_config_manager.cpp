@@ -1,8 +1,10 @@
 #include "media_library/medialib_config_manager.hpp"
 #include "media_library/config_manager.hpp"
+#include "media_library/dma_budget_manager.hpp"
 #include "media_library/logger_macros.hpp"
 #include "media_library/media_library_types.hpp"
 #include "media_library/sensor_registry.hpp"
+#include "media_library/threading_manager.hpp"
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <string>
@@ -73,6 +75,12 @@ media_library_return MediaLibConfigManagerCore::configure_medialib(std::string m
         return MEDIA_LIBRARY_CONFIGURATION_ERROR;
     }
     m_medialib_configs[idx] = medialib_config_json;
+    if (ThreadingManager::get_instance().configure(medialib_config_json.threading) != MEDIA_LIBRARY_SUCCESS)
+    {
+        // not fatal, the threads keep running with their current scheduling
+        LOGGER__MODULE__WARNING(MODULE_NAME, "Failed to apply the threading configuration to all the threads");
+    }
+    DmaBudgetManager::get_instance().configure(medialib_config_json.dma_budget);
     m_current_profiles[idx] = m_medialib_configs[idx].profiles[m_medialib_configs[idx].default_profile];
     m_medialib_json_config_strings[idx] = medialib_json_config_string;
 
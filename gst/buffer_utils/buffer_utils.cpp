@@ -210,6 +210,59 @@ static inline void hailo_media_library_buffer_release(PtrWrapper *wrapper)
     delete wrapper;
 }
 
+/**
+ * Creates a GstMemory over a plane of a hailo buffer, holding a reference to the hailo buffer until it is freed.
+ * A plane that is not mapped to the CPU yet (of a device only buffer pool) is wrapped as dmabuf memory, so it is
+ * only mapped if a downstream element maps it - the Hailo elements reach the buffer through its meta instead.
+ *
+ * @param[in] hailo_buffer HailoMediaLibraryBufferPtr
+ * @param[in] plane_index index of the plane the memory starts at
+ * @param[in] size size of the memory, may span the following planes of a buffer with contiguous planes
+ * @return GstMemory
+ */
+static GstMemory *gst_memory_from_hailo_plane(HailoMediaLibraryBufferPtr hailo_buffer, uint plane_index, size_t size)
+{
+    PtrWrapper *wrapper = new PtrWrapper();
+    wrapper->ptr = hailo_buffer;
+
+    int fd = hailo_buffer->get_plane_fd(plane_index);
+    if (fd >= 0 && !hailo_buffer->is_plane_mapped(plane_index))
+    {
+        static GstAllocator *dmabuf_allocator = gst_dmabuf_allocator_new();
+        size_t offset = hailo_buffer->get_plane_offset(plane_index);
+        GstMemory *memory =
+            gst_dmabuf_allocator_alloc_with_flags(dmabuf_allocator, fd, offset + size, GST_FD_MEMORY_FLAG_DONT_CLOSE);
+        if (memory != nullptr)
+        {
+            gst_memory_resize(memory, offset, size);
+            gst_mini_object_set_qdata(GST_MINI_OBJECT(memory), g_quark_from_static_string("hailo-buffer"), wrapper,
+                                      GDestroyNotify(hailo_media_library_buffer_release));
+            return memory;
+        }
+    }
+
+    return gst_memory_new_wrapped(GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS, hailo_buffer->get_plane_ptr(plane_index), size,
+                                  0, size, wrapper, GDestroyNotify(hailo_media_library_buffer_release));
+}
+
+/**
+ * Checks if all the planes of a hailo buffer are laid out in a single dmabuf, as allocated by a buffer pool with
+ * contiguous planes
+ */
+static bool hailo_buffer_planes_contiguous(HailoMediaLibraryBufferPtr hailo_buffer)
+{
+    uint num_of_planes = hailo_buffer->get_num_of_planes();
+    if (num_of_planes < 2)
+        return false;
+
+    for (uint i = 1; i < num_of_planes; i++)
+    {
+        if (!hailo_buffer->shares_previous_plane_fd(i))
+            return false;
+    }
+    return true;
+}
+
 /**
  * Creates a GstBuffer from a HailoMediaLibraryBufferPtr
  * Create GstMemory for each plane and set the destroy notify to delete the hailo buffer
@@ -220,17 +273,23 @@ static inline void hailo_media_library_buffer_release(PtrWrapper *wrapper)
 GstBuffer *gst_buffer_from_hailo_buffer(HailoMediaLibraryBufferPtr hailo_buffer, GstCaps *caps)
 {
     GstBuffer *gst_outbuf = gst_buffer_new();
+    bool contiguous_planes = hailo_buffer_planes_contiguous(hailo_buffer);
 
-    for (uint i = 0; i < hailo_buffer->get_num_of_planes(); i++)
+    if (contiguous_planes)
     {
-        hailo_data_plane_t plane = hailo_buffer->buffer_data->planes[i];
-        PtrWrapper *wrapper = new PtrWrapper();
-        wrapper->ptr = hailo_buffer;
-
-        gst_buffer_append_memory(gst_outbuf,
-                                 gst_memory_new_wrapped(GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS, plane.userptr,
-                                                        plane.bytesused, 0, plane.bytesused, wrapper,
-                                                        GDestroyNotify(hailo_media_library_buffer_release)));
+        // A single memory spans all the planes, the video meta locates each plane in it
+        hailo_data_plane_t &first_plane = hailo_buffer->buffer_data->planes.front();
+        hailo_data_plane_t &last_plane = hailo_buffer->buffer_data->planes.back();
+        size_t size = last_plane.offset - first_plane.offset + last_plane.bytesused;
+        gst_buffer_append_memory(gst_outbuf, gst_memory_from_hailo_plane(hailo_buffer, 0, size));
+    }
+    else
+    {
+        for (uint i = 0; i < hailo_buffer->get_num_of_planes(); i++)
+        {
+            size_t bytesused = hailo_buffer->buffer_data->planes[i].bytesused;
+            gst_buffer_append_memory(gst_outbuf, gst_memory_from_hailo_plane(hailo_buffer, i, bytesused));
+        }
     }
     gst_buffer_add_hailo_buffer_meta(gst_outbuf, hailo_buffer, gst_buffer_get_size(gst_outbuf));
 
@@ -252,6 +311,14 @@ GstBuffer *gst_buffer_from_hailo_buffer(HailoMediaLibraryBufferPtr hailo_buffer,
             gst_buffer_unref(gst_outbuf);
             return nullptr;
         }
+
+        if (contiguous_planes)
+        {
+            for (uint i = 0; i < meta->n_planes && i < hailo_buffer->get_num_of_planes(); i++)
+            {
+                meta->offset[i] = hailo_buffer->get_plane_offset(i) - hailo_buffer->get_plane_offset(0);
+            }
+        }
     }
     else
     {
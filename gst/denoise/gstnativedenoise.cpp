@@ -406,7 +406,8 @@ static GstFlowReturn gst_hailo_denoise_chain(GstPad *pad, GstObject *parent, Gst
     }
     gst_video_info_free(video_info);
 
-    HailoMediaLibraryBufferPtr output_frame_ptr = std::make_shared<hailo_media_library_buffer>();
+    // Set by the media library to a buffer of its output pool
+    HailoMediaLibraryBufferPtr output_frame_ptr;
 
     GST_DEBUG_OBJECT(self, "Call media library handle frame - GstBuffer offset %ld", GST_BUFFER_OFFSET(buffer));
     media_library_return media_lib_ret =
@@ -423,7 +424,7 @@ static GstFlowReturn gst_hailo_denoise_chain(GstPad *pad, GstObject *parent, Gst
         GST_ERROR_OBJECT(self, "Media library handle frame failed on error %d", media_lib_ret);
         return GST_FLOW_ERROR;
     }
-    if (output_frame_ptr->buffer_data == nullptr)
+    if (output_frame_ptr == nullptr || output_frame_ptr->buffer_data == nullptr)
     {
         GST_DEBUG_OBJECT(self, "Post ISP Denoise disabled, pushing buffer to srcpad");
         gst_hailo_denoise_push_output_frame(self, input_frame_ptr, buffer);
@@ -235,7 +235,8 @@ static GstFlowReturn gst_hailo_dewarp_chain(GstPad *pad, GstObject *parent, GstB
         return GST_FLOW_ERROR;
     }
 
-    HailoMediaLibraryBufferPtr output_frame_ptr = std::make_shared<hailo_media_library_buffer>();
+    // Set by the media library to a buffer of its output pool
+    HailoMediaLibraryBufferPtr output_frame_ptr;
     media_library_return media_lib_ret = self->params->medialib_dewarp->handle_frame(input_frame_ptr, output_frame_ptr);
 
     if (media_lib_ret != MEDIA_LIBRARY_SUCCESS)
@@ -206,13 +206,16 @@ static GstFlowReturn gst_hailo_image_freeze_chain(GstPad *pad, GstObject *parent
         if (!self->params->frozen_buffer)
         {
             GST_INFO_OBJECT(self, "Freezing buffer, creating new buffer and copying data");
-            self->params->frozen_buffer = std::make_shared<hailo_media_library_buffer>();
-            if (self->params->m_buffer_pool->acquire_buffer(self->params->frozen_buffer) != MEDIA_LIBRARY_SUCCESS)
+            auto frozen_buffer_expected = self->params->m_buffer_pool->acquire_buffer();
+            if (!frozen_buffer_expected.has_value())
             {
                 GST_ERROR_OBJECT(self, "Failed to acquire buffer to freeze");
                 return GST_FLOW_ERROR;
             }
+            self->params->frozen_buffer = std::move(frozen_buffer_expected.value());
 
+            input_buffer->sync_start(DMA_SYNC_ACCESS_READ);
+            self->params->frozen_buffer->sync_start(DMA_SYNC_ACCESS_WRITE);
             for (size_t i = 0; i < input_buffer->get_num_of_planes(); i++)
             {
                 void *input_plane = input_buffer->get_plane_ptr(i);
@@ -220,6 +223,8 @@ static GstFlowReturn gst_hailo_image_freeze_chain(GstPad *pad, GstObject *parent
 
                 memcpy(freeze_plane, input_plane, input_buffer->get_plane_size(i));
             }
+            self->params->frozen_buffer->sync_end();
+            input_buffer->sync_end();
         }
         else
         {
@@ -103,7 +103,8 @@ media_library_return OverlayImpl::end_sync_buffer(GstVideoFrame *video_frame)
     for (int i = 0; i < (int)GST_VIDEO_FRAME_N_PLANES(video_frame); i++)
     {
         void *buffer_ptr = (void *)GST_VIDEO_FRAME_PLANE_DATA(video_frame, i);
-        media_library_return status = DmaMemoryAllocator::get_instance().dmabuf_sync_end(buffer_ptr);
+        media_library_return status =
+            DmaMemoryAllocator::get_instance().dmabuf_sync_end(buffer_ptr, DMA_SYNC_ACCESS_WRITE);
         if (status != MEDIA_LIBRARY_SUCCESS)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Error: dmabuf_sync_end - failed to sync buffer for plane ", i);
@@ -119,7 +120,9 @@ media_library_return OverlayImpl::start_sync_buffer(GstVideoFrame *video_frame)
     for (int i = 0; i < (int)GST_VIDEO_FRAME_N_PLANES(video_frame); i++)
     {
         void *buffer_ptr = (void *)GST_VIDEO_FRAME_PLANE_DATA(video_frame, i);
-        media_library_return status = DmaMemoryAllocator::get_instance().dmabuf_sync_start(buffer_ptr);
+        // The frame is only written, no need to invalidate the cache
+        media_library_return status =
+            DmaMemoryAllocator::get_instance().dmabuf_sync_start(buffer_ptr, DMA_SYNC_ACCESS_WRITE);
         if (status != MEDIA_LIBRARY_SUCCESS)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Error: dmabuf_sync_start - failed to sync buffer for plane ", i);
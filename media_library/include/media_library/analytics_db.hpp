@@ -9,6 +9,7 @@
 #include "buffer_pool.hpp"
 #include "hailo/hailort.h"
 #include "media_library_types.hpp"
+#include "profiled_mutex.hpp"
 
 using Timestamp = std::chrono::time_point<std::chrono::steady_clock>;
 
@@ -69,8 +70,8 @@ class AnalyticsDB
     // map<analytics_id, map<Timestamp, AnalyticsData>>
     std::map<std::string, std::map<Timestamp, DetectionAnalyticsData>> m_detection_entries_db;
     std::map<std::string, std::map<Timestamp, InstanceSegmentationAnalyticsData>> m_instance_segmentation_entries_db;
-    std::mutex m_mutex;
-    std::condition_variable m_cv;
+    ProfiledMutex m_mutex{"analytics_db"};
+    std::condition_variable_any m_cv;
 
     template <typename DataT, typename MapT, typename ConfigMapT>
     media_library_return add_entry(MapT &db, const std::string &analytics_id, DataT data, const ConfigMapT &config_map);
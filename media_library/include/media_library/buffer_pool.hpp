@@ -36,10 +36,14 @@
 #include <vector>
 #include <condition_variable>
 #include <functional>
+#include <atomic>
+#include <chrono>
 
 #include "media_library_types.hpp"
 #include "hailo_v4l2/hailo_v4l2.h"
 #include "dma_memory_allocator.hpp"
+#include "buffer_tracker.hpp"
+#include "profiled_mutex.hpp"
 
 /** @defgroup media_library_buffer_pool_definitions MediaLibrary BufferPool CPP
  * API definitions
@@ -50,12 +54,19 @@ class MediaLibraryBufferPool;
 using MediaLibraryBufferPoolPtr = std::shared_ptr<MediaLibraryBufferPool>;
 
 class HailoBucket;
+struct BufferPoolRecord;
+class BufferPoolRecords;
 
 struct hailo_media_library_buffer;
 using HailoMediaLibraryBufferPtr = std::shared_ptr<hailo_media_library_buffer>;
 
 using HailoBucketPtr = std::shared_ptr<HailoBucket>;
 
+/** Maximum number of planes (buckets) of a buffer pool buffer */
+#define MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES (4)
+/** Handle value of a plane that is not held from a buffer pool bucket */
+#define MEDIA_LIBRARY_BUFFER_POOL_INVALID_HANDLE (UINT64_MAX)
+
 /**
  * @class MediaLibraryBufferPool
  * @brief A class representing a buffer pool in the media library.
@@ -73,14 +84,13 @@ using HailoBucketPtr = std::shared_ptr<HailoBucket>;
  * bufferPool.init();
  *
  * // Acquire a buffer from the pool
- * HailoMediaLibraryBufferPtr buffer = std::make_shared<hailo_media_library_buffer>();;
- * bufferPool.acquire_buffer(buffer);
+ * HailoMediaLibraryBufferPtr buffer = bufferPool.acquire_buffer().value();
  *
  * // Use the acquired buffer
  * // ...
  *
- * // Release the buffer back to the pool
- * bufferPool.release_buffer(&buffer);
+ * // The buffer returns to the pool once its last reference is dropped
+ * buffer.reset();
  *
  * // Free the buffer pool
  * bufferPool.free();
@@ -89,16 +99,47 @@ using HailoBucketPtr = std::shared_ptr<HailoBucket>;
 class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryBufferPool>
 {
   private:
+    // Upper bound of the threads that allocate buckets concurrently in init_pools()
+    static constexpr size_t MAX_ALLOCATION_THREADS = 4;
+
     std::string m_name;
     std::vector<HailoBucketPtr> m_buckets;
     uint m_width;
     uint m_height;
     uint m_bytes_per_line;
     HailoFormat m_format;
-    std::shared_ptr<std::mutex> m_buffer_pool_mutex;
+    std::shared_ptr<ProfiledMutex> m_buffer_pool_mutex;
     size_t m_max_buffers;
-    uint32_t m_buffer_index;
-    std::condition_variable m_pool_cv;
+    HailoMemoryType m_memory_type;
+    size_t m_planes_count;
+    // Offset of each plane in the buffer of its bucket, non zero only when the planes share a bucket
+    std::vector<size_t> m_plane_offsets;
+    bool m_contiguous_planes;
+    bool m_arena_mode;
+    bool m_device_only;
+    bool m_unmap_on_release;
+    size_t m_buffers_limit;
+    // Time the last init() took to allocate the buffers of the pool
+    std::chrono::microseconds m_init_duration;
+    std::atomic<uint32_t> m_buffer_index;
+    std::condition_variable_any m_pool_cv;
+    std::atomic<uint32_t> m_pool_waiters;
+
+    // Preconstructed buffer objects handed out by the allocation free acquire_buffer()
+    std::unique_ptr<BufferPoolRecords> m_records;
+    std::atomic<size_t> m_allocating_acquires;
+
+    void create_buckets();
+    static media_library_return init_pools(std::vector<MediaLibraryBufferPool *> pools);
+    media_library_return fill_planes_layout(hailo_data_plane_t *planes);
+    media_library_return acquire_planes(hailo_data_plane_t *planes, uint64_t *handles);
+    media_library_return try_acquire_buffer(HailoMediaLibraryBufferPtr buffer);
+    tl::expected<HailoMediaLibraryBufferPtr, media_library_return> try_acquire_pooled_buffer();
+    uint32_t next_buffer_index();
+    bool buffers_available();
+    void notify_buffer_released();
+
+    friend struct BufferPoolRecord;
 
   public:
     /**
@@ -136,7 +177,7 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
 
     /**
      * @brief Initialization of MediaLibraryBufferPool
-     * Allocates all the required buffers (according to max_buffers)
+     * Allocates all the required buffers (according to max_buffers or the buffers limit), the buckets concurrently
      *
      * @return media_library_return
      *
@@ -150,6 +191,25 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
      * @endcode
      */
     media_library_return init();
+    /**
+     * @brief Initializes several pools at once. The buckets of all the pools are allocated concurrently, so the time
+     * it takes follows the largest bucket instead of the sum of all the pools.
+     *
+     * @param[in] pools - the pools to initialize
+     * @return media_library_return - MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if any of the pools failed to allocate,
+     * the pools that did allocate are left initialized
+     */
+    static media_library_return init_pools(const std::vector<MediaLibraryBufferPoolPtr> &pools);
+    /**
+     * @brief Gets the time the last initialization took to allocate the buffers of the pool
+     *
+     * @return std::chrono::microseconds - the allocation time
+     */
+    std::chrono::microseconds get_init_duration()
+    {
+        std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+        return m_init_duration;
+    }
     /**
      * @brief Free all the allocated buffers
      * @param[in] fail_on_used_buffers - bool flag to indicate if the function should fail if there are still used
@@ -166,7 +226,8 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
      */
     media_library_return free(bool fail_on_used_buffers = true);
     /**
-     * @brief Acquire a buffer from the pool
+     * @brief Acquire a buffer from the pool into a caller provided buffer object
+     * This allocates the buffer data of every acquisition, per frame paths use the pooled acquire_buffer() instead.
      *
      * @param[out] buffer - HailoMediaLibraryBufferPtr to acquire
      * @return media_library_return
@@ -181,6 +242,62 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
      * @endcode
      */
     media_library_return acquire_buffer(HailoMediaLibraryBufferPtr buffer);
+    /**
+     * @brief Acquire a buffer from the pool, blocking until one is released if the pool is empty
+     *
+     * @param[out] buffer - HailoMediaLibraryBufferPtr to acquire
+     * @param[in] timeout_ms - maximum time to wait for a buffer to be released back to the pool
+     * @return media_library_return - MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if no buffer was available within the
+     * timeout
+     *
+     * Example usage:
+     * @code{.cpp}
+     * HailoMediaLibraryBufferPtr buffer = std::make_shared<hailo_media_library_buffer>();
+     * media_library_return result = buffer_pool.acquire_buffer(buffer, std::chrono::milliseconds(10));
+     * if (result != MEDIA_LIBRARY_SUCCESS) {
+     *     // Handle error
+     * }
+     * @endcode
+     */
+    media_library_return acquire_buffer(HailoMediaLibraryBufferPtr buffer, const std::chrono::milliseconds &timeout_ms);
+    /**
+     * @brief Acquire a buffer from the pool without heap allocations
+     * The returned buffer object and its buffer data are preconstructed and owned by the pool, they are recycled
+     * back to the pool once the last reference to the buffer is dropped.
+     *
+     * @return tl::expected<HailoMediaLibraryBufferPtr, media_library_return> - the acquired buffer, or
+     * MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if the pool is empty
+     *
+     * Example usage:
+     * @code{.cpp}
+     * auto buffer = buffer_pool.acquire_buffer();
+     * if (!buffer.has_value()) {
+     *     // Handle error
+     * }
+     * @endcode
+     */
+    tl::expected<HailoMediaLibraryBufferPtr, media_library_return> acquire_buffer();
+    /**
+     * @brief Acquire a buffer from the pool without heap allocations, blocking until one is released if the pool is
+     * empty
+     *
+     * @param[in] timeout_ms - maximum time to wait for a buffer to be released back to the pool
+     * @return tl::expected<HailoMediaLibraryBufferPtr, media_library_return> - the acquired buffer, or
+     * MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if no buffer was available within the timeout
+     */
+    tl::expected<HailoMediaLibraryBufferPtr, media_library_return> acquire_buffer(
+        const std::chrono::milliseconds &timeout_ms);
+    /**
+     * @brief Gets the number of buffer acquisitions that needed a heap allocation.
+     * Acquisitions through acquire_buffer(HailoMediaLibraryBufferPtr) always allocate their buffer data, while the
+     * pooled acquire_buffer() only allocates when a previous holder still references the recycled buffer data.
+     *
+     * @return The number of allocating acquisitions since the pool was created.
+     */
+    size_t get_allocating_acquires_count()
+    {
+        return m_allocating_acquires.load();
+    }
     /**
      * @brief Release a specific plane of a given buffer using the pool
      *
@@ -219,6 +336,39 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
      */
     media_library_return for_each_buffer(std::function<bool(int, size_t)> func);
 
+    /**
+     * @brief Allocates the buffers of each plane out of a single dmabuf instead of a dmabuf per buffer.
+     * The pool is then allocated and freed with a few syscalls and holds one fd per plane, but its buffers share
+     * that fd and are located by hailo_data_plane_t::offset - only consumers that honor the plane offset may use it.
+     * Arena buckets are always fully allocated, shrink() does not release their buffers.
+     *
+     * @param[in] arena_mode - true to enable the arena mode
+     * @return media_library_return - MEDIA_LIBRARY_ERROR if the pool is already allocated
+     */
+    media_library_return set_arena_mode(bool arena_mode);
+
+    /**
+     * @brief Allocates all the planes of a buffer as a single dmabuf, each plane at its offset in it (for NV12 the UV
+     * plane follows the Y plane). A buffer then needs a single fd, sync and device mapping instead of one per plane.
+     * The planes share the fd and are located by hailo_data_plane_t::offset - only consumers that honor the plane
+     * offset may use it.
+     *
+     * @param[in] contiguous_planes - true to allocate the planes of a buffer contiguously
+     * @return media_library_return - MEDIA_LIBRARY_ERROR if the pool is already allocated
+     */
+    media_library_return set_contiguous_planes(bool contiguous_planes);
+
+    /**
+     * @brief Allocates the buffers for device access only - a buffer carries only its fd and is mapped to the CPU on
+     * the first hailo_media_library_buffer::get_plane_ptr() call, so that pools that only the DSP, encoder or NN core
+     * access do not map their buffers at allocation. Does not apply to an arena, which is mapped once.
+     *
+     * @param[in] device_only - true to map the buffers on demand
+     * @param[in] unmap_on_release - true to drop the CPU mapping of a buffer when it is released to the pool
+     * @return media_library_return - MEDIA_LIBRARY_ERROR if the pool is already allocated
+     */
+    media_library_return set_device_only(bool device_only, bool unmap_on_release = false);
+
     /**
      * @brief Waits for all the buffers in the pool to be used.
      * @param timeout_ms The timeout in milliseconds to wait for the buffers to be used.
@@ -271,6 +421,77 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
         return m_name;
     }
 
+    /**
+     * @brief Calculates the sizes of the planes of a single buffer with the given layout
+     *
+     * @param[in] height - buffer height
+     * @param[in] format - buffer format
+     * @param[in] bytes_per_line - bytes per line of the buffer
+     * @return std::vector<size_t> - the size in bytes of each plane, empty if the format is not supported
+     */
+    static std::vector<size_t> get_planes_sizes(uint height, HailoFormat format, uint bytes_per_line);
+    /**
+     * @brief Calculates the DMA memory a pool with the given layout holds once initialized.
+     * Each plane is allocated separately from the dma-heap, so each plane size is rounded up to whole pages.
+     *
+     * @param[in] height - buffer height
+     * @param[in] format - buffer format
+     * @param[in] max_buffers - number of buffers of the pool
+     * @param[in] bytes_per_line - bytes per line of the buffer
+     * @return size_t - the footprint in bytes
+     */
+    static size_t get_dma_footprint(uint height, HailoFormat format, size_t max_buffers, uint bytes_per_line);
+    /**
+     * @brief Gets the DMA memory currently allocated by the pool
+     *
+     * @return size_t - allocated bytes
+     */
+    size_t get_allocated_bytes();
+    /**
+     * @brief Gets the maximal number of buffers used at once since the pool was created or since the last
+     * reset_used_buffers_high_water_mark()
+     *
+     * @return size_t - the high-water mark of used buffers
+     */
+    size_t get_used_buffers_high_water_mark();
+    /**
+     * @brief Restarts the used buffers high-water mark from the current number of used buffers
+     */
+    void reset_used_buffers_high_water_mark();
+    /**
+     * @brief Frees available buffers until at most min_buffers are allocated.
+     * Buffers in use are never freed. A shrunk pool allocates buffers again, up to its max buffers, when an acquire
+     * finds it empty.
+     *
+     * @param[in] min_buffers - number of buffers to keep allocated
+     * @return size_t - the number of bytes freed
+     */
+    size_t shrink(size_t min_buffers);
+    /**
+     * @brief Limits the number of buffers the pool may allocate, below the max buffers it was created with.
+     * init() allocates up to the limit, and acquires grow the pool only up to it. Lowering the limit does not free
+     * buffers, use shrink() for that. Not supported in arena mode.
+     *
+     * @param[in] buffers_limit - number of buffers, between 1 and the max buffers of the pool
+     * @return media_library_return - MEDIA_LIBRARY_INVALID_ARGUMENT if the limit is out of range
+     */
+    media_library_return set_buffers_limit(size_t buffers_limit);
+    /**
+     * @brief Allocates buffers until at least the given number of buffers are allocated, so that acquires do not have
+     * to grow the pool on the frame path
+     *
+     * @param[in] buffers - number of buffers to allocate, up to the buffers limit
+     * @return media_library_return - MEDIA_LIBRARY_INVALID_ARGUMENT if above the buffers limit,
+     * MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if a buffer could not be allocated
+     */
+    media_library_return reserve(size_t buffers);
+    /**
+     * @brief Gets the number of buffers the pool may allocate
+     *
+     * @return size_t - the buffers limit, the max buffers of the pool unless set_buffers_limit() was called
+     */
+    size_t get_buffers_limit();
+
     /**
      * @brief Gets the format of the buffer pool.
      *
@@ -282,12 +503,21 @@ class MediaLibraryBufferPool : public std::enable_shared_from_this<MediaLibraryB
     }
 };
 
+/**
+ * Ownership of a buffer plane for cache coherency - owned by the device, or by the CPU with the access it was synced
+ * for
+ */
+enum HailoPlaneSyncState : uint8_t
+{
+    HAILO_PLANE_SYNC_STATE_DEVICE = 0,
+    HAILO_PLANE_SYNC_STATE_CPU_READ = DMA_SYNC_ACCESS_READ,
+    HAILO_PLANE_SYNC_STATE_CPU_WRITE = DMA_SYNC_ACCESS_WRITE,
+    HAILO_PLANE_SYNC_STATE_CPU_READ_WRITE = DMA_SYNC_ACCESS_READ_WRITE
+};
+
 struct hailo_media_library_buffer
 {
   private:
-    std::shared_ptr<std::mutex> m_buffer_mutex;
-    std::shared_ptr<std::mutex> m_plane_mutex;
-
     bool dispose()
     {
         owner = nullptr;
@@ -296,36 +526,54 @@ struct hailo_media_library_buffer
     }
     std::function<void(void *)> on_free;
     void *on_free_data;
+    // Per-plane handles of the owner pool buckets, used to release the planes back to the pool
+    uint64_t m_pool_plane_handles[MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES];
+    // Per-plane cache ownership, so that only real ownership transitions issue a sync ioctl
+    HailoPlaneSyncState m_plane_sync_state[MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES];
 
-  public:
-    HailoBufferDataPtr buffer_data;
-    MediaLibraryBufferPoolPtr owner;
-    struct hailo15_vsm vsm;
-    int32_t isp_ae_fps;
-    bool isp_ae_converged;
-    uint64_t isp_ae_integration_time;
-    uint8_t isp_ae_average_luma;
-    int32_t video_fd;
-    uint32_t buffer_index;
-    uint64_t isp_timestamp_ns;
-    uint64_t pts;
-    HailoMediaLibraryBufferPtr motion_detection_buffer;
-    bool motion_detected;
-    float optical_zoom_magnification;
+    void reset_plane_sync_state()
+    {
+        for (uint32_t i = 0; i < MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES; i++)
+        {
+            m_plane_sync_state[i] = HAILO_PLANE_SYNC_STATE_DEVICE;
+        }
+    }
 
-    hailo_media_library_buffer()
-        : m_buffer_mutex(std::make_shared<std::mutex>()), m_plane_mutex(std::make_shared<std::mutex>()),
-          buffer_data(nullptr), owner(nullptr), isp_ae_fps(HAILO_ISP_AE_FPS_DEFAULT_VALUE),
-          isp_ae_converged(HAILO_ISP_AE_CONVERGED_DEFAULT_VALUE),
-          isp_ae_integration_time(HAILO_ISP_AE_INTEGRATION_TIME_DEFAULT_VALUE),
-          isp_ae_average_luma(HAILO_ISP_AE_LUMA_DEFUALT_VALUE), video_fd(-1), buffer_index(0), isp_timestamp_ns(0),
-          pts(0), motion_detection_buffer(nullptr), motion_detected(false), optical_zoom_magnification(1.0f)
+    void move_plane_sync_state(hailo_media_library_buffer &other)
     {
-        vsm.dx = HAILO_VSM_DEFAULT_VALUE;
-        vsm.dy = HAILO_VSM_DEFAULT_VALUE;
+        for (uint32_t i = 0; i < MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES; i++)
+        {
+            m_plane_sync_state[i] = other.m_plane_sync_state[i];
+        }
+        other.reset_plane_sync_state();
     }
 
-    ~hailo_media_library_buffer()
+    // The first plane that lives in the same dmabuf as the given plane, it holds the sync state of the dmabuf
+    uint32_t get_sync_plane(uint32_t index)
+    {
+        while (shares_previous_plane_fd(index))
+            index--;
+        return index;
+    }
+
+    void reset_pool_plane_handles()
+    {
+        for (uint32_t i = 0; i < MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES; i++)
+        {
+            m_pool_plane_handles[i] = MEDIA_LIBRARY_BUFFER_POOL_INVALID_HANDLE;
+        }
+    }
+
+    void move_pool_plane_handles(hailo_media_library_buffer &other)
+    {
+        for (uint32_t i = 0; i < MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES; i++)
+        {
+            m_pool_plane_handles[i] = other.m_pool_plane_handles[i];
+        }
+        other.reset_pool_plane_handles();
+    }
+
+    void release_resources()
     {
         // free the planes back to their buffer pools
         if (buffer_data)
@@ -352,11 +600,80 @@ struct hailo_media_library_buffer
 
         dispose();
     }
+
+    /**
+     * @brief Release the buffer resources and reset it to its default state, so that a pool can reuse the object
+     * instead of destroying it
+     */
+    void recycle()
+    {
+        release_resources();
+        on_free = nullptr;
+        on_free_data = nullptr;
+        vsm.dx = HAILO_VSM_DEFAULT_VALUE;
+        vsm.dy = HAILO_VSM_DEFAULT_VALUE;
+        isp_ae_fps = HAILO_ISP_AE_FPS_DEFAULT_VALUE;
+        isp_ae_converged = HAILO_ISP_AE_CONVERGED_DEFAULT_VALUE;
+        isp_ae_integration_time = HAILO_ISP_AE_INTEGRATION_TIME_DEFAULT_VALUE;
+        isp_ae_average_luma = HAILO_ISP_AE_LUMA_DEFUALT_VALUE;
+        video_fd = -1;
+        buffer_index = 0;
+        isp_timestamp_ns = 0;
+        pts = 0;
+        motion_detection_buffer = nullptr;
+        motion_detected = false;
+        motion_map = nullptr;
+        motion_result_age = 0;
+        optical_zoom_magnification = 1.0f;
+        reset_pool_plane_handles();
+        reset_plane_sync_state();
+    }
+
+    friend class MediaLibraryBufferPool;
+    friend struct BufferPoolRecord;
+
+  public:
+    HailoBufferDataPtr buffer_data;
+    MediaLibraryBufferPoolPtr owner;
+    struct hailo15_vsm vsm;
+    int32_t isp_ae_fps;
+    bool isp_ae_converged;
+    uint64_t isp_ae_integration_time;
+    uint8_t isp_ae_average_luma;
+    int32_t video_fd;
+    uint32_t buffer_index;
+    uint64_t isp_timestamp_ns;
+    uint64_t pts;
+    HailoMediaLibraryBufferPtr motion_detection_buffer;
+    bool motion_detected;
+    // Where motion was detected, when the motion map of the motion detection is enabled
+    MotionMapPtr motion_map;
+    // Frames between the frame the motion results were computed on and this one, 0 when computed on this frame
+    uint32_t motion_result_age;
+    float optical_zoom_magnification;
+
+    hailo_media_library_buffer()
+        : on_free(nullptr), on_free_data(nullptr), buffer_data(nullptr), owner(nullptr),
+          isp_ae_fps(HAILO_ISP_AE_FPS_DEFAULT_VALUE),
+          isp_ae_converged(HAILO_ISP_AE_CONVERGED_DEFAULT_VALUE),
+          isp_ae_integration_time(HAILO_ISP_AE_INTEGRATION_TIME_DEFAULT_VALUE),
+          isp_ae_average_luma(HAILO_ISP_AE_LUMA_DEFUALT_VALUE), video_fd(-1), buffer_index(0), isp_timestamp_ns(0),
+          pts(0), motion_detection_buffer(nullptr), motion_detected(false), motion_map(nullptr),
+          motion_result_age(0), optical_zoom_magnification(1.0f)
+    {
+        vsm.dx = HAILO_VSM_DEFAULT_VALUE;
+        vsm.dy = HAILO_VSM_DEFAULT_VALUE;
+        reset_pool_plane_handles();
+        reset_plane_sync_state();
+    }
+
+    ~hailo_media_library_buffer()
+    {
+        release_resources();
+    }
     // Move constructor
     hailo_media_library_buffer(hailo_media_library_buffer &&other) noexcept
     {
-        m_buffer_mutex = other.m_buffer_mutex;
-        m_plane_mutex = other.m_plane_mutex;
         buffer_data = other.buffer_data;
         owner = other.owner;
         vsm = other.vsm;
@@ -370,13 +687,15 @@ struct hailo_media_library_buffer
         pts = other.pts;
         motion_detection_buffer = other.motion_detection_buffer;
         motion_detected = other.motion_detected;
+        motion_map = other.motion_map;
+        motion_result_age = other.motion_result_age;
         optical_zoom_magnification = other.optical_zoom_magnification;
         on_free = other.on_free;
         on_free_data = other.on_free_data;
+        move_pool_plane_handles(other);
+        move_plane_sync_state(other);
         other.buffer_data = nullptr;
         other.owner = nullptr;
-        other.m_buffer_mutex = nullptr;
-        other.m_plane_mutex = nullptr;
         other.isp_ae_fps = HAILO_ISP_AE_FPS_DEFAULT_VALUE;
         other.isp_ae_converged = HAILO_ISP_AE_CONVERGED_DEFAULT_VALUE;
         other.isp_ae_integration_time = HAILO_ISP_AE_INTEGRATION_TIME_DEFAULT_VALUE;
@@ -389,6 +708,8 @@ struct hailo_media_library_buffer
         other.pts = 0;
         other.motion_detection_buffer = nullptr;
         other.motion_detected = false;
+        other.motion_map = nullptr;
+        other.motion_result_age = 0;
         other.optical_zoom_magnification = 1.0f;
         other.on_free = nullptr;
         other.on_free_data = nullptr;
@@ -399,8 +720,6 @@ struct hailo_media_library_buffer
     {
         if (this != &other)
         {
-            m_buffer_mutex = other.m_buffer_mutex;
-            m_plane_mutex = other.m_plane_mutex;
             buffer_data = other.buffer_data;
             owner = other.owner;
             vsm = other.vsm;
@@ -414,13 +733,15 @@ struct hailo_media_library_buffer
             pts = other.pts;
             motion_detection_buffer = other.motion_detection_buffer;
             motion_detected = other.motion_detected;
+            motion_map = other.motion_map;
+            motion_result_age = other.motion_result_age;
             optical_zoom_magnification = other.optical_zoom_magnification;
             on_free = other.on_free;
             on_free_data = other.on_free_data;
+            move_pool_plane_handles(other);
+            move_plane_sync_state(other);
             other.buffer_data = nullptr;
             other.owner = nullptr;
-            other.m_buffer_mutex = nullptr;
-            other.m_plane_mutex = nullptr;
             other.isp_ae_fps = HAILO_ISP_AE_FPS_DEFAULT_VALUE;
             other.isp_ae_converged = HAILO_ISP_AE_CONVERGED_DEFAULT_VALUE;
             other.isp_ae_integration_time = HAILO_ISP_AE_INTEGRATION_TIME_DEFAULT_VALUE;
@@ -433,6 +754,8 @@ struct hailo_media_library_buffer
             other.pts = 0;
             other.motion_detection_buffer = nullptr;
             other.motion_detected = false;
+            other.motion_map = nullptr;
+            other.motion_result_age = 0;
             other.optical_zoom_magnification = 1.0f;
             other.on_free = nullptr;
             other.on_free_data = nullptr;
@@ -462,6 +785,8 @@ struct hailo_media_library_buffer
         pts = other->pts;
         motion_detection_buffer = other->motion_detection_buffer;
         motion_detected = other->motion_detected;
+        motion_map = other->motion_map;
+        motion_result_age = other->motion_result_age;
         optical_zoom_magnification = other->optical_zoom_magnification;
     }
 
@@ -470,7 +795,51 @@ struct hailo_media_library_buffer
         if (index >= buffer_data->planes_count)
             return nullptr;
 
-        return buffer_data->planes[index].userptr;
+        hailo_data_plane_t &plane = buffer_data->planes[index];
+        std::atomic_ref<void *> userptr(plane.userptr);
+        void *plane_ptr = userptr.load(std::memory_order_acquire);
+        // Device only pool buffers are mapped to the CPU on first access. Stages holding the buffer may race on it,
+        // the allocator maps an fd once and hands the same mapping to all of them, and the first one publishes it.
+        if (plane_ptr == nullptr && plane.fd >= 0 && owner != nullptr)
+        {
+            void *mapped_memory = nullptr;
+            if (DmaMemoryAllocator::get_instance().map_device_dma_buffer(plane.fd, &mapped_memory) !=
+                MEDIA_LIBRARY_SUCCESS)
+            {
+                return nullptr;
+            }
+            plane_ptr = static_cast<uint8_t *>(mapped_memory) + plane.offset;
+            void *published_ptr = nullptr;
+            if (!userptr.compare_exchange_strong(published_ptr, plane_ptr, std::memory_order_acq_rel))
+            {
+                return published_ptr;
+            }
+        }
+
+        return plane_ptr;
+    }
+
+    /**
+     * @brief Checks whether a plane has a CPU mapping, planes of device only pool buffers are mapped on first
+     * get_plane_ptr()
+     */
+    bool is_plane_mapped(uint32_t index)
+    {
+        if (index >= buffer_data->planes_count)
+            return false;
+        return std::atomic_ref<void *>(buffer_data->planes[index].userptr).load(std::memory_order_acquire) != nullptr;
+    }
+
+    /**
+     * @brief Records the pipeline stage currently holding the buffer, reported by the buffer tracker
+     *
+     * @param[in] stage - name of the stage
+     */
+    void mark_stage(const std::string &stage)
+    {
+        BufferTracker &tracker = BufferTracker::get_instance();
+        if (tracker.is_enabled() && owner != nullptr)
+            tracker.on_touch(owner.get(), m_pool_plane_handles[0], stage);
     }
 
     int get_plane_fd(uint32_t index)
@@ -480,6 +849,23 @@ struct hailo_media_library_buffer
         return buffer_data->planes[index].fd;
     }
 
+    size_t get_plane_offset(uint32_t index)
+    {
+        if (index >= buffer_data->planes_count)
+            return 0;
+        return buffer_data->planes[index].offset;
+    }
+
+    /**
+     * @brief Checks if a plane lives in the same dmabuf as the previous plane, as with contiguous planes
+     * Such a plane must not be synced or shared with a device on its own
+     */
+    bool shares_previous_plane_fd(uint32_t index)
+    {
+        return index > 0 && index < buffer_data->planes_count &&
+               buffer_data->planes[index].fd == buffer_data->planes[index - 1].fd;
+    }
+
     uint32_t get_plane_size(uint32_t index)
     {
         if (index >= buffer_data->planes_count)
@@ -511,6 +897,7 @@ struct hailo_media_library_buffer
         this->buffer_data = buffer_data;
         this->on_free = on_free;
         this->on_free_data = on_free_data;
+        reset_plane_sync_state();
         return MEDIA_LIBRARY_SUCCESS;
     }
 
@@ -519,7 +906,16 @@ struct hailo_media_library_buffer
         return (buffer_data->memory == HAILO_MEMORY_TYPE_DMABUF);
     }
 
-    media_library_return sync_start(uint plane)
+    /**
+     * @brief Hands a plane over to the CPU for the given access.
+     * The sync ioctl is issued only on a real ownership transition - a plane already owned by the CPU for the access
+     * is not synced again, and a write-only access skips the cache invalidation.
+     *
+     * @param[in] plane - plane index
+     * @param[in] access - the CPU access to the plane until sync_end()
+     * @return media_library_return
+     */
+    media_library_return sync_start(uint plane, dma_sync_access_t access = DMA_SYNC_ACCESS_READ_WRITE)
     {
         if (!is_dmabuf())
         {
@@ -530,16 +926,47 @@ struct hailo_media_library_buffer
         if (plane_fd == -1)
             return MEDIA_LIBRARY_ERROR;
 
-        media_library_return ret = DmaMemoryAllocator::get_instance().dmabuf_sync_start(plane_fd);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
+        DmaMemoryAllocator &allocator = DmaMemoryAllocator::get_instance();
+        HailoPlaneSyncState &state = m_plane_sync_state[get_sync_plane(plane)];
+        if ((static_cast<uint8_t>(state) & access) == access)
         {
-            return ret;
+            allocator.count_elided_sync();
+            return MEDIA_LIBRARY_SUCCESS;
+        }
+
+        if (state == HAILO_PLANE_SYNC_STATE_DEVICE)
+        {
+            media_library_return ret = allocator.dmabuf_sync_start(plane_fd, access);
+            if (ret != MEDIA_LIBRARY_SUCCESS)
+            {
+                return ret;
+            }
+            state = static_cast<HailoPlaneSyncState>(access);
+        }
+        else if (access & DMA_SYNC_ACCESS_READ)
+        {
+            // Reading after a write-only start - write back the CPU writes before invalidating the cache
+            media_library_return ret = allocator.dmabuf_sync_end(plane_fd, DMA_SYNC_ACCESS_WRITE);
+            if (ret == MEDIA_LIBRARY_SUCCESS)
+                ret = allocator.dmabuf_sync_start(plane_fd, DMA_SYNC_ACCESS_READ_WRITE);
+            if (ret != MEDIA_LIBRARY_SUCCESS)
+            {
+                state = HAILO_PLANE_SYNC_STATE_DEVICE;
+                return ret;
+            }
+            state = HAILO_PLANE_SYNC_STATE_CPU_READ_WRITE;
+        }
+        else
+        {
+            // Writing after a read start - the cache is already valid, sync_end() writes it back
+            allocator.count_elided_sync();
+            state = HAILO_PLANE_SYNC_STATE_CPU_READ_WRITE;
         }
 
         return MEDIA_LIBRARY_SUCCESS;
     }
 
-    media_library_return sync_start()
+    media_library_return sync_start(dma_sync_access_t access = DMA_SYNC_ACCESS_READ_WRITE)
     {
         if (!is_dmabuf())
         {
@@ -548,7 +975,10 @@ struct hailo_media_library_buffer
 
         for (uint32_t i = 0; i < get_num_of_planes(); i++)
         {
-            if (sync_start(i) != MEDIA_LIBRARY_SUCCESS)
+            if (shares_previous_plane_fd(i))
+                continue;
+
+            if (sync_start(i, access) != MEDIA_LIBRARY_SUCCESS)
             {
                 return MEDIA_LIBRARY_ERROR;
             }
@@ -557,13 +987,30 @@ struct hailo_media_library_buffer
         return MEDIA_LIBRARY_SUCCESS;
     }
 
+    /**
+     * @brief Hands a plane back to the device, the cache is written back only if the CPU access wrote.
+     * A plane that is already owned by the device is not synced.
+     *
+     * @param[in] plane - plane index
+     * @return media_library_return
+     */
     media_library_return sync_end(uint plane)
     {
         int plane_fd = get_plane_fd(plane);
         if (plane_fd == -1)
             return MEDIA_LIBRARY_ERROR;
 
-        media_library_return ret = DmaMemoryAllocator::get_instance().dmabuf_sync_end(plane_fd);
+        DmaMemoryAllocator &allocator = DmaMemoryAllocator::get_instance();
+        HailoPlaneSyncState &state = m_plane_sync_state[get_sync_plane(plane)];
+        if (state == HAILO_PLANE_SYNC_STATE_DEVICE)
+        {
+            allocator.count_elided_sync();
+            return MEDIA_LIBRARY_SUCCESS;
+        }
+
+        dma_sync_access_t access = static_cast<dma_sync_access_t>(state);
+        state = HAILO_PLANE_SYNC_STATE_DEVICE;
+        media_library_return ret = allocator.dmabuf_sync_end(plane_fd, access);
         if (ret != MEDIA_LIBRARY_SUCCESS)
         {
             return ret;
@@ -581,6 +1028,9 @@ struct hailo_media_library_buffer
 
         for (uint32_t i = 0; i < get_num_of_planes(); i++)
         {
+            if (shares_previous_plane_fd(i))
+                continue;
+
             media_library_return ret = sync_end(i);
             if (ret != MEDIA_LIBRARY_SUCCESS)
             {
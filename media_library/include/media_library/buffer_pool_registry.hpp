@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file buffer_pool_registry.hpp
+ * @brief Process wide registry of buffer pools shared by consumers with identical buffer geometry
+ **/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <tl/expected.hpp>
+#include "buffer_pool.hpp"
+
+/** Geometry of the buffers of a shared pool, consumers with an equal key share a pool */
+struct buffer_pool_key_t
+{
+    uint width;
+    uint height;
+    HailoFormat format;
+    HailoMemoryType memory_type;
+    uint bytes_per_line;
+
+    bool operator<(const buffer_pool_key_t &other) const
+    {
+        return std::tie(width, height, format, memory_type, bytes_per_line) <
+               std::tie(other.width, other.height, other.format, other.memory_type, other.bytes_per_line);
+    }
+};
+
+/** Runtime state of a shared pool */
+struct shared_pool_usage_t
+{
+    std::string name;
+    size_t leases;
+    /** Sum of the depths of the leases */
+    size_t leased_buffers;
+    /** Combined in-flight depth the pool is sized to */
+    size_t in_flight_buffers;
+    size_t allocated_bytes;
+};
+
+/**
+ * @class BufferPoolRegistry
+ * @brief Hands out buffer pools shared by all the consumers of the same buffer geometry.
+ *
+ * A consumer leases a pool with the depth it may hold at once. The consumers of a geometry are fed the same frames
+ * and rarely reach their worst case together, so the pool is sized to their combined in-flight depth - the deepest
+ * lease in full and half of the depth of every other lease - instead of the sum of the worst-case depths. The buffers
+ * are allocated when leased, not on the frame path. The lease is returned when the last copy of the leased pool
+ * pointer is released, and the pool is freed with its last lease.
+ *
+ * Consumers of a shared pool must not free() it or change its geometry.
+ */
+class BufferPoolRegistry
+{
+  private:
+    static constexpr size_t DEFAULT_SHARED_POOL_CAPACITY = 32;
+
+    struct SharedPool
+    {
+        MediaLibraryBufferPoolPtr pool;
+        size_t leases;
+        size_t leased_buffers;
+        // depth of every lease, the deepest one is counted in full
+        std::multiset<size_t> lease_depths;
+    };
+
+    std::shared_ptr<std::mutex> m_registry_mutex;
+    std::map<buffer_pool_key_t, SharedPool> m_pools;
+    size_t m_shared_pool_capacity;
+
+    BufferPoolRegistry();
+    ~BufferPoolRegistry() = default;
+
+    void return_lease(const buffer_pool_key_t &key, size_t depth);
+    static size_t get_in_flight_depth(const std::multiset<size_t> &lease_depths);
+
+    friend class BufferPoolLease;
+
+  public:
+    static BufferPoolRegistry &get_instance()
+    {
+        static BufferPoolRegistry instance;
+        return instance;
+    }
+
+    BufferPoolRegistry(BufferPoolRegistry const &) = delete;
+    void operator=(BufferPoolRegistry const &) = delete;
+
+    /**
+     * @brief Sets the maximal number of buffers of a shared pool created from now on, which bounds the combined
+     * in-flight depth of its leases
+     *
+     * @param[in] capacity - max buffers of a shared pool
+     */
+    void set_shared_pool_capacity(size_t capacity);
+
+    /**
+     * @brief Leases a pool of the given geometry, creating it if no consumer holds one, and allocates the buffers
+     * the combined in-flight depth of its leases needs
+     *
+     * @param[in] key - the buffer geometry
+     * @param[in] depth - number of buffers the consumer may hold at once
+     * @param[in] consumer - name of the consumer, used for logging
+     * @return tl::expected<MediaLibraryBufferPoolPtr, media_library_return> - the shared pool, the lease is returned
+     * when the last copy of this pointer is released. MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR if the pool could not be
+     * allocated
+     */
+    tl::expected<MediaLibraryBufferPoolPtr, media_library_return> lease(const buffer_pool_key_t &key, size_t depth,
+                                                                        const std::string &consumer);
+
+    /**
+     * @brief Gets the state of all the shared pools
+     *
+     * @return std::vector<shared_pool_usage_t> - per pool leases and usage
+     */
+    std::vector<shared_pool_usage_t> get_shared_pools_usage();
+};
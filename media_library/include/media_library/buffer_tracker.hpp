@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file buffer_tracker.hpp
+ * @brief Optional tracking of the buffers held out of the buffer pools, to find leaks and right-size pools
+ **/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <utility>
+
+class MediaLibraryBufferPool;
+
+/**
+ * @class BufferTracker
+ * @brief Records, per buffer acquired from a pool, the acquiring pool, the acquire time and the last pipeline stage
+ * that touched it, and keeps a per pool histogram of the time buffers were held. Stages mark the buffers they hold
+ * with hailo_media_library_buffer::mark_stage().
+ *
+ * Tracking is off unless enabled by the MEDIALIB_BUFFER_TRACKING_ENABLE environment variable or enable(). When off
+ * the pool hooks cost a single relaxed atomic load.
+ */
+class BufferTracker
+{
+  public:
+    // Hold time bin i counts holds of [2^(i-1), 2^i) ms, the first bin holds under 1 ms and the last everything above
+    static constexpr size_t HOLD_TIME_BINS = 13;
+
+  private:
+    struct TrackedBuffer
+    {
+        std::string pool_name;
+        std::chrono::steady_clock::time_point acquire_time;
+        std::string last_stage;
+    };
+
+    struct PoolHoldTimes
+    {
+        std::array<uint64_t, HOLD_TIME_BINS> bins;
+        std::chrono::milliseconds max_hold_time;
+    };
+
+    using BufferKey = std::pair<const MediaLibraryBufferPool *, uint64_t>;
+
+    std::atomic<bool> m_enabled;
+    std::shared_ptr<std::mutex> m_tracker_mutex;
+    std::map<BufferKey, TrackedBuffer> m_buffers;
+    // Keyed by pool name, so that the histogram of a pool outlives a profile switch that recreates it
+    std::map<std::string, PoolHoldTimes> m_hold_times;
+
+    BufferTracker();
+    ~BufferTracker() = default;
+
+    static size_t hold_time_bin(std::chrono::milliseconds hold_time);
+
+  public:
+    static constexpr const char *DUMP_COMMAND = "buffers";
+
+    static BufferTracker &get_instance()
+    {
+        static BufferTracker instance;
+        return instance;
+    }
+
+    BufferTracker(BufferTracker const &) = delete;
+    void operator=(BufferTracker const &) = delete;
+
+    /**
+     * @brief Turns tracking on or off. Turning it off drops the tracked buffers and the histograms
+     *
+     * @param[in] enable - true to track
+     */
+    void enable(bool enable);
+
+    inline bool is_enabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Starts tracking a buffer acquired from a pool
+     *
+     * @param[in] pool - the acquiring pool
+     * @param[in] pool_name - name of the acquiring pool
+     * @param[in] handle - the pool handle of the first plane of the buffer, unique while the buffer is held
+     */
+    void on_acquire(const MediaLibraryBufferPool *pool, const std::string &pool_name, uint64_t handle);
+    /**
+     * @brief Records the pipeline stage currently holding a buffer
+     *
+     * @param[in] pool - the pool of the buffer
+     * @param[in] handle - the pool handle of the first plane of the buffer
+     * @param[in] stage - name of the stage
+     */
+    void on_touch(const MediaLibraryBufferPool *pool, uint64_t handle, const std::string &stage);
+    /**
+     * @brief Stops tracking a buffer released to its pool and adds its hold time to the pool histogram
+     *
+     * @param[in] pool - the pool of the buffer
+     * @param[in] handle - the pool handle of the first plane of the buffer
+     */
+    void on_release(const MediaLibraryBufferPool *pool, uint64_t handle);
+    /**
+     * @brief Drops the tracked buffers of a pool that was freed, its histogram is kept
+     *
+     * @param[in] pool - the freed pool
+     */
+    void on_pool_freed(const MediaLibraryBufferPool *pool);
+
+    /**
+     * @brief Describes the buffers currently held and the hold time histograms
+     *
+     * @param[in] pool_name - name of a pool to describe, empty for all the pools
+     * @return std::string - a human readable report
+     */
+    std::string dump(const std::string &pool_name = "");
+};
@@ -5,6 +5,7 @@
 #include <vector>
 #include <mutex>
 #include <optional>
+#include "profiled_mutex.hpp"
 
 template <typename T> class ConcurrentQueue
 {
@@ -15,7 +16,7 @@ template <typename T> class ConcurrentQueue
 
     void enqueue(const T &item)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
         if (m_size == m_buffer.capacity())
         {
             // Overwrite the oldest element (leaky behavior)
@@ -29,7 +30,7 @@ template <typename T> class ConcurrentQueue
 
     void enqueue_many(const std::vector<T> &items)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
 
         for (const auto &item : items)
         {
@@ -52,7 +53,7 @@ template <typename T> class ConcurrentQueue
 
     std::optional<T> dequeue()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
 
         if (m_size == 0)
         {
@@ -67,7 +68,7 @@ template <typename T> class ConcurrentQueue
 
     std::vector<T> dequeue_many(const std::function<bool(const T &)> &predicate)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
         std::vector<T> items;
 
         for (T item = m_buffer[m_head]; m_size > 0 && predicate(item); item = m_buffer[m_head])
@@ -83,7 +84,7 @@ template <typename T> class ConcurrentQueue
     std::optional<T> find_first(const std::function<bool(const T &)> &predicate,
                                 const std::function<bool(const T &)> &continue_predicate = nullptr)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
         size_t current_head = m_head;
         size_t count = m_size;
         while (count > 0)
@@ -105,7 +106,7 @@ template <typename T> class ConcurrentQueue
     std::optional<T> find_last(const std::function<bool(const T &)> &predicate,
                                const std::function<bool(const T &)> &continue_predicate = nullptr)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
         size_t current_tail = (m_tail + m_buffer.capacity() - 1) % m_buffer.capacity(); // Start from the last item
         size_t count = m_size;
         while (count > 0)
@@ -126,19 +127,19 @@ template <typename T> class ConcurrentQueue
 
     size_t size() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<ProfiledMutex> lock(m_mutex);
         return m_size;
     }
 
     bool empty() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<ProfiledMutex> lock(m_mutex);
         return m_size == 0;
     }
 
     std::optional<T> peek() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<ProfiledMutex> lock(m_mutex);
         if (m_size == 0)
         {
             return std::nullopt;
@@ -151,5 +152,5 @@ template <typename T> class ConcurrentQueue
     size_t m_head;
     size_t m_tail;
     size_t m_size;
-    mutable std::mutex m_mutex;
+    mutable ProfiledMutex m_mutex{"concurrent_queue"};
 };
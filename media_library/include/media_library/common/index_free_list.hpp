@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Lock-free free list of indices into a fixed array (a Treiber stack).
+ * The head packs the top index with an ABA tag that is advanced on every update.
+ */
+class IndexFreeList
+{
+  public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    explicit IndexFreeList(size_t capacity)
+        : m_next(std::make_unique<std::atomic<uint32_t>[]>(capacity)), m_head(pack_head(0, INVALID_INDEX))
+    {
+    }
+
+    uint32_t pop()
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        while (head_index(head) != INVALID_INDEX)
+        {
+            uint32_t next = m_next[head_index(head)].load(std::memory_order_relaxed);
+            if (m_head.compare_exchange_weak(head, pack_head(head_tag(head) + 1, next), std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+            {
+                return head_index(head);
+            }
+        }
+        return INVALID_INDEX;
+    }
+
+    bool empty()
+    {
+        return head_index(m_head.load(std::memory_order_acquire)) == INVALID_INDEX;
+    }
+
+    void push(uint32_t index)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        do
+        {
+            m_next[index].store(head_index(head), std::memory_order_relaxed);
+        } while (!m_head.compare_exchange_weak(head, pack_head(head_tag(head) + 1, index), std::memory_order_release,
+                                               std::memory_order_relaxed));
+    }
+
+  private:
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    std::atomic<uint64_t> m_head;
+
+    static uint64_t pack_head(uint32_t tag, uint32_t index)
+    {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+    static uint32_t head_index(uint64_t head)
+    {
+        return static_cast<uint32_t>(head);
+    }
+    static uint32_t head_tag(uint64_t head)
+    {
+        return static_cast<uint32_t>(head >> 32);
+    }
+};
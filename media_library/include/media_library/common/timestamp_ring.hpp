@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Default timestamp accessor, for items that carry a timestamp_ns member
+ */
+template <typename T> struct timestamp_ns_of
+{
+    uint64_t operator()(const T &item) const
+    {
+        return item.timestamp_ns;
+    }
+};
+
+/**
+ * @brief Single producer, single consumer ring of items ordered by timestamp.
+ *
+ * The producer pushes without locking, and the consumer searches the queued items by timestamp with a binary search
+ * and extracts ranges of them into its own storage.
+ *
+ * Items must be pushed in non decreasing timestamp order, an item older than the last pushed one is dropped. When the
+ * ring is full the oldest item is dropped to make room for the new one, as the producer keeps running while nobody
+ * consumes. The producer drops it by advancing the read index shared with the consumer with a compare-and-swap, and
+ * only then overwrites its slot. The consumer copies items out and re-validates the read index afterwards, retrying
+ * when the items it copied were dropped meanwhile, so it never returns an overwritten item.
+ */
+template <typename T, typename TimestampOf = timestamp_ns_of<T>> class TimestampRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "The consumer copies items the producer may overwrite");
+
+  public:
+    explicit TimestampRing(size_t capacity)
+        : m_buffer(round_up_power_of_two(capacity)), m_mask(m_buffer.size() - 1), m_write_index(0),
+          m_last_timestamp(0), m_dropped(0), m_read_index(0)
+    {
+    }
+
+    size_t capacity() const
+    {
+        return m_buffer.size();
+    }
+
+    // Producer side
+
+    /**
+     * @brief Push items, oldest first
+     *
+     * @param[in] items - items to push
+     * @param[in] count - number of items
+     * @return size_t - number of items pushed, the rest were out of order and dropped
+     */
+    size_t push_many(const T *items, size_t count)
+    {
+        uint64_t write_index = m_write_index.load(std::memory_order_relaxed);
+        size_t pushed = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t timestamp = TimestampOf()(items[i]);
+            if (timestamp < m_last_timestamp)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            if (write_index - read_index == m_buffer.size())
+            {
+                // Drop the oldest item, unless the consumer removed it meanwhile
+                if (m_read_index.compare_exchange_strong(read_index, read_index + 1, std::memory_order_acq_rel))
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            // A consumer that reads the new content of the slot then sees the read index past its old item
+            std::atomic_thread_fence(std::memory_order_release);
+            m_buffer[write_index & m_mask] = items[i];
+            m_last_timestamp = timestamp;
+            write_index++;
+            pushed++;
+            m_write_index.store(write_index, std::memory_order_release);
+        }
+        return pushed;
+    }
+
+    size_t push_many(const std::vector<T> &items)
+    {
+        return push_many(items.data(), items.size());
+    }
+
+    bool push(const T &item)
+    {
+        return push_many(&item, 1) == 1;
+    }
+
+    /**
+     * @brief Number of items dropped because the ring was full (the oldest ones) or they were out of order
+     */
+    uint64_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    // Consumer side
+
+    size_t size() const
+    {
+        uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+        uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+        // the producer may drop items between the two loads
+        return write_index > read_index ? write_index - read_index : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Number of queued items whose timestamp is lower than the given one
+     */
+    size_t lower_bound(uint64_t timestamp)
+    {
+        return count_before(timestamp, [](uint64_t item_timestamp, uint64_t value) { return item_timestamp < value; });
+    }
+
+    /**
+     * @brief Number of queued items whose timestamp is not greater than the given one
+     */
+    size_t upper_bound(uint64_t timestamp)
+    {
+        return count_before(timestamp, [](uint64_t item_timestamp, uint64_t value) { return item_timestamp <= value; });
+    }
+
+    /**
+     * @brief Newest queued item not after a timestamp that satisfies a predicate, without removing it
+     */
+    template <typename Predicate> std::optional<T> find_last(uint64_t timestamp, Predicate predicate)
+    {
+        for (;;)
+        {
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+            uint64_t index = bound(read_index, write_index, timestamp,
+                                   [](uint64_t item_timestamp, uint64_t value) { return item_timestamp <= value; });
+            if (!is_valid(read_index))
+                continue;
+
+            // Walk back from the newest item not after the timestamp, until the items were dropped
+            while (index > read_index)
+            {
+                T item = m_buffer[--index & m_mask];
+                if (!is_valid_from(index))
+                    return std::nullopt;
+                if (predicate(item))
+                    return item;
+            }
+            return std::nullopt;
+        }
+    }
+
+    /**
+     * @brief Remove the oldest items
+     *
+     * @param[in] count - number of items to remove, clamped to the number of queued items
+     * @return size_t - number of items removed, fewer than requested if the producer dropped some of them
+     */
+    size_t discard(size_t count)
+    {
+        uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+            uint64_t new_read_index = read_index + std::min<uint64_t>(count, write_index - read_index);
+            if (m_read_index.compare_exchange_weak(read_index, new_read_index, std::memory_order_acq_rel))
+                return new_read_index - read_index;
+        }
+    }
+
+    /**
+     * @brief Move out the oldest items up to a timestamp (inclusive)
+     *
+     * @param[in] timestamp - timestamp of the newest item to extract
+     * @param[out] out - storage for the items
+     * @param[in] max_count - capacity of out
+     * @return size_t - number of items extracted
+     */
+    size_t pop_until(uint64_t timestamp, T *out, size_t max_count)
+    {
+        for (;;)
+        {
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            size_t count = std::min<uint64_t>(upper_bound_index(read_index, timestamp) - read_index, max_count);
+            copy(read_index, count, out);
+            if (commit_pop(read_index, count))
+                return count;
+        }
+    }
+
+    /**
+     * @brief Move out the oldest items up to a timestamp (inclusive), replacing the content of out
+     */
+    size_t pop_until(uint64_t timestamp, std::vector<T> &out)
+    {
+        for (;;)
+        {
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            out.resize(upper_bound_index(read_index, timestamp) - read_index);
+            copy(read_index, out.size(), out.data());
+            if (commit_pop(read_index, out.size()))
+                return out.size();
+        }
+    }
+
+    std::optional<T> pop()
+    {
+        for (;;)
+        {
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            if (m_write_index.load(std::memory_order_acquire) <= read_index)
+                return std::nullopt;
+
+            T item;
+            copy(read_index, 1, &item);
+            if (commit_pop(read_index, 1))
+                return item;
+        }
+    }
+
+  private:
+    static size_t round_up_power_of_two(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    /**
+     * @brief Whether the items from an index on were not dropped, to check after reading them
+     */
+    bool is_valid_from(uint64_t index) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_read_index.load(std::memory_order_relaxed) <= index;
+    }
+
+    /**
+     * @brief Whether the read index did not move, to check after reading the items from it
+     */
+    bool is_valid(uint64_t read_index) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_read_index.load(std::memory_order_relaxed) == read_index;
+    }
+
+    void copy(uint64_t first, size_t count, T *out) const
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = m_buffer[(first + i) & m_mask];
+    }
+
+    /**
+     * @brief Removes items copied from the read index, fails if the producer dropped some of them meanwhile
+     */
+    bool commit_pop(uint64_t read_index, size_t count)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_read_index.compare_exchange_strong(read_index, read_index + count, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Index of the first item after a timestamp, searched from a read index, valid when the read index is
+     */
+    uint64_t upper_bound_index(uint64_t read_index, uint64_t timestamp) const
+    {
+        uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+        return bound(read_index, write_index, timestamp,
+                     [](uint64_t item_timestamp, uint64_t value) { return item_timestamp <= value; });
+    }
+
+    template <typename Compare> size_t count_before(uint64_t timestamp, Compare compare)
+    {
+        for (;;)
+        {
+            uint64_t read_index = m_read_index.load(std::memory_order_acquire);
+            uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+            uint64_t index = bound(read_index, write_index, timestamp, compare);
+            if (is_valid(read_index))
+                return index - read_index;
+        }
+    }
+
+    /**
+     * @brief Binary search of the first item in [first, last) for which compare is false, last if none
+     * The items read may be overwritten concurrently, the caller validates the read index afterwards.
+     */
+    template <typename Compare>
+    uint64_t bound(uint64_t first, uint64_t last, uint64_t timestamp, Compare compare) const
+    {
+        uint64_t count = last > first ? last - first : 0;
+        while (count > 0)
+        {
+            uint64_t step = count / 2;
+            if (compare(TimestampOf()(m_buffer[(first + step) & m_mask]), timestamp))
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+    std::vector<T> m_buffer;
+    const uint64_t m_mask;
+
+    // Written by the producer, the indices only grow and are masked on access
+    alignas(64) std::atomic<uint64_t> m_write_index;
+    uint64_t m_last_timestamp;
+    std::atomic<uint64_t> m_dropped;
+
+    // Advanced by the consumer when it pops, and by the producer when it drops the oldest item of a full ring
+    alignas(64) std::atomic<uint64_t> m_read_index;
+};
@@ -22,6 +22,7 @@
  */
 #pragma once
 
+#include "denoise_common.hpp"
 #include "encoder_config_types.hpp"
 #include "hailort_denoise.hpp"
 #include "config_manager.hpp"
@@ -68,7 +69,8 @@ class MediaLibraryDenoise
                                    const input_video_config_t &input_video_configs);
 
     // Perform pre-processing on the input frame and return the output frames
-    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr output_frame);
+    // The output frame is set to a buffer acquired by the denoise module, it is left untouched when denoise is disabled
+    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr &output_frame);
 
     // get the denoise configurations object
     denoise_config_t get_denoise_configs();
@@ -89,8 +91,9 @@ class MediaLibraryDenoise
     static constexpr std::chrono::milliseconds HAILORT_SCHEDULER_TIMEOUT{1000};
     static constexpr int HAILORT_SCHEDULER_BATCH_SIZE = 2;
 
-    static constexpr size_t BUFFER_POOL_MAX_BUFFERS = 6;
-    static constexpr int RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK = 16;
+    static constexpr size_t BUFFER_POOL_MAX_BUFFERS = denoise_common::BUFFER_POOL_MAX_BUFFERS;
+    static constexpr int RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK =
+        denoise_common::RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK;
 
     // configured flag - to determine if first configuration was done
     // configuration manager
@@ -135,7 +138,7 @@ class MediaLibraryDenoise
     media_library_return decode_config_json_string(denoise_config_t &denoise_configs, hailort_t &hailort_configs,
                                                    std::string config_string);
     media_library_return perform_denoise(HailoMediaLibraryBufferPtr input_buffer,
-                                         HailoMediaLibraryBufferPtr output_buffer);
+                                         HailoMediaLibraryBufferPtr &output_buffer);
     media_library_return perform_initial_batch(HailoMediaLibraryBufferPtr input_buffer,
                                                HailoMediaLibraryBufferPtr output_buffer);
     media_library_return perform_subsequent_batches(HailoMediaLibraryBufferPtr input_buffer,
@@ -166,7 +169,7 @@ class MediaLibraryDenoise
     virtual media_library_return create_and_initialize_buffer_pools(
         const input_video_config_t &input_video_configs) = 0;
     virtual media_library_return free_buffer_pools() = 0;
-    virtual media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr output_buffer) = 0;
+    virtual media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr &output_buffer) = 0;
     virtual bool process_inference(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr loopback_buffer,
                                    HailoMediaLibraryBufferPtr output_buffer) = 0;
     virtual void copy_meta(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr output_buffer) = 0;
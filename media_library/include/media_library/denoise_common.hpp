@@ -26,6 +26,15 @@
 
 namespace denoise_common
 {
+// Sizing of the denoise buffer pools
+static constexpr size_t BUFFER_POOL_MAX_BUFFERS = 6;
+static constexpr int RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK = 16;
+// pre-isp denoise dgain and bls pools
+static constexpr int DGAIN_WIDTH = 1;
+static constexpr int DGAIN_HEIGHT = 1;
+static constexpr int BLS_WIDTH = 4;
+static constexpr int BLS_HEIGHT = 1;
+
 // When bayer=true, post isp denoise is disabled
 inline bool post_isp_enable_changed(const denoise_config_t &old_configs, const denoise_config_t &new_configs)
 {
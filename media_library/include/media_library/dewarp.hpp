@@ -51,6 +51,9 @@ class MediaLibraryDewarp
     std::shared_ptr<Impl> m_impl;
 
   public:
+    /** Size of the output buffer pool, the configured pool_max_buffers is not used for it */
+    static constexpr uint OUTPUT_POOL_MAX_BUFFERS = 5;
+
     class callbacks_t
     {
       public:
@@ -99,11 +102,11 @@ class MediaLibraryDewarp
      * @brief Perform dewarp on the input frame and return the output frames
      *
      * @param[in] input_frame - pointer to the input frame to be pre-processed
-     * @param[out] output_frames - vector of output frames after dewarp
+     * @param[out] output_frame - set to the output frame after dewarp, acquired from the output buffer pool
      *
      * @return media_library_return - status of the dewarp operation
      */
-    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr output_frame);
+    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr &output_frame);
 
     /**
      * @brief get the dewarp configurations object
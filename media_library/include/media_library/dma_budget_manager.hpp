@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file dma_budget_manager.hpp
+ * @brief Process wide accounting of the DMA memory held by buffer pools
+ **/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_set>
+#include <tl/expected.hpp>
+#include "media_library_types.hpp"
+
+class MediaLibraryBufferPool;
+
+/** DMA footprint of a single buffer pool */
+struct dma_pool_footprint_t
+{
+    std::string name;
+    uint width;
+    uint height;
+    HailoFormat format;
+    size_t max_buffers;
+    size_t bytes;
+};
+
+/** DMA footprint of all the buffer pools a profile creates */
+struct dma_footprint_plan_t
+{
+    std::vector<dma_pool_footprint_t> pools;
+    size_t total_bytes;
+    size_t available_bytes;
+    bool degraded;
+};
+
+/**
+ * @class DmaBudgetManager
+ * @brief Tracks the DMA memory of all the buffer pools in the process and checks profiles against the memory left
+ * in the CMA before their pools are allocated.
+ *
+ * Buffer pools register themselves on creation. The footprint planner sizes the pools each module creates for a
+ * profile (multi-resize, motion detection, dewarp, denoise, encoders and privacy masks) with the sizing constants the
+ * modules export. When configured with an idle shrink interval, a background thread periodically frees the buffers
+ * the pools did not use since the previous period.
+ */
+class DmaBudgetManager
+{
+  private:
+    static constexpr size_t BYTES_PER_MB = 1024 * 1024;
+
+    std::shared_ptr<std::mutex> m_budget_mutex;
+    std::unordered_set<MediaLibraryBufferPool *> m_pools;
+    size_t m_budget_bytes;
+    size_t m_min_pool_buffers;
+    dma_budget_policy_t m_policy;
+
+    // idle pools shrinking thread, runs while the shrink interval is set
+    std::thread m_shrink_thread;
+    std::condition_variable m_shrink_cv;
+    std::chrono::milliseconds m_shrink_interval;
+    bool m_shrink_stop;
+
+    DmaBudgetManager();
+    ~DmaBudgetManager();
+
+    size_t get_available_bytes_locked();
+    bool degrade_profile(config_profile_t &profile);
+    void shrink_idle_pools_loop();
+    void stop_shrink_thread();
+
+  public:
+    static DmaBudgetManager &get_instance()
+    {
+        static DmaBudgetManager instance;
+        return instance;
+    }
+
+    DmaBudgetManager(DmaBudgetManager const &) = delete;
+    void operator=(DmaBudgetManager const &) = delete;
+
+    void register_pool(MediaLibraryBufferPool *pool);
+    void unregister_pool(MediaLibraryBufferPool *pool);
+
+    /**
+     * @brief Applies the dma_budget section of the medialib config - the budget, the policy of admit_profile() and
+     * the minimal pool size. Starts the idle pools shrinking thread when an idle shrink interval is set, and stops it
+     * otherwise.
+     *
+     * @param[in] config - the DMA budget configuration
+     */
+    void configure(const dma_budget_config_t &config);
+
+    /**
+     * @brief Computes the DMA footprint of every buffer pool a profile creates
+     *
+     * @param[in] profile - the profile to plan
+     * @return dma_footprint_plan_t - the per pool footprint and the total
+     */
+    dma_footprint_plan_t plan_profile(const config_profile_t &profile);
+    /**
+     * @brief Checks that a profile fits in the DMA memory before any of its pools is allocated.
+     * The memory held by the currently registered pools is counted as available, since a profile switch releases
+     * them. With DMA_BUDGET_POLICY_DEGRADE an oversized profile is modified in place to fit.
+     *
+     * @param[in,out] profile - the profile to admit
+     * @return tl::expected<dma_footprint_plan_t, media_library_return> - the plan of the admitted profile, or
+     * MEDIA_LIBRARY_OUT_OF_RESOURCES if it does not fit
+     */
+    tl::expected<dma_footprint_plan_t, media_library_return> admit_profile(config_profile_t &profile);
+
+    /**
+     * @brief Frees the buffers that idle pools did not need since the last call.
+     * Each pool keeps the maximum of its used buffers high-water mark and the minimal pool buffers.
+     *
+     * @return size_t - the number of bytes freed
+     */
+    size_t shrink_idle_pools();
+};
@@ -27,17 +27,44 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
 #include <stdint.h>
 #include <unordered_map>
+#include <vector>
 #include <string_view>
 #include <linux/dma-heap.h>
 #include <linux/dma-buf.h>
 #include "media_library_types.hpp"
+#include "profiled_mutex.hpp"
 
 #define MIN_FD_RANGE 1024
 
+/** CPU access to a dmabuf between a sync start and a sync end */
+enum dma_sync_access_t
+{
+    DMA_SYNC_ACCESS_READ = DMA_BUF_SYNC_READ,
+    DMA_SYNC_ACCESS_WRITE = DMA_BUF_SYNC_WRITE,
+    DMA_SYNC_ACCESS_READ_WRITE = DMA_BUF_SYNC_RW
+};
+
+/** Number of dmabuf sync ioctls issued, and of syncs that were skipped since the CPU ownership did not change */
+struct dma_sync_statistics_t
+{
+    uint64_t issued;
+    uint64_t elided;
+};
+
+/** A sub-buffer carved out of a dma arena */
+struct dma_arena_buffer_t
+{
+    int fd;
+    size_t offset;
+    void *arena;
+};
+
 class DmaMemoryAllocator
 {
   private:
@@ -45,9 +72,22 @@ class DmaMemoryAllocator
     int m_dma_heap_fd;
     bool m_dma_heap_fd_open;
     bool m_should_fd_dup;
-    std::shared_ptr<std::mutex> m_allocator_mutex;
+    // Guards the dma-heap device fd
+    std::shared_ptr<ProfiledMutex> m_allocator_mutex;
+    // Guards the buffer indexes below, lookups take it shared so that they do not serialize each other
+    std::shared_ptr<ProfiledSharedMutex> m_index_mutex;
     std::unordered_map<void *, dma_heap_allocation_data> m_allocated_buffers;
     std::unordered_map<void *, dma_heap_allocation_data> m_external_buffers;
+    // Reverse (fd -> ptr) indexes of the maps above
+    std::unordered_map<int, void *> m_allocated_fds;
+    std::unordered_map<int, void *> m_external_fds;
+    // Arenas are single dma-heap allocations that are carved into page aligned sub-buffers
+    std::unordered_map<void *, dma_heap_allocation_data> m_arenas;
+    std::unordered_map<void *, dma_arena_buffer_t> m_arena_buffers;
+    // Buffers allocated for device access only (fd -> data), mapped to the CPU on demand
+    std::unordered_map<int, dma_heap_allocation_data> m_device_buffers;
+    std::atomic<uint64_t> m_syncs_issued;
+    std::atomic<uint64_t> m_syncs_elided;
     DmaMemoryAllocator();
     ~DmaMemoryAllocator();
 
@@ -72,12 +112,88 @@ class DmaMemoryAllocator
 
     media_library_return allocate_dma_buffer(uint size, void **buffer);
     media_library_return free_dma_buffer(void *buffer);
+    /**
+     * @brief Allocates a single dmabuf and carves it into page aligned sub-buffers.
+     * All the sub-buffers share the fd of the arena, each one is located by its offset in it.
+     *
+     * @param[in] buffer_size - size of each sub-buffer
+     * @param[in] num_buffers - number of sub-buffers
+     * @param[out] buffers - the mapped sub-buffers, in offset order
+     * @return media_library_return
+     */
+    media_library_return allocate_dma_arena(uint buffer_size, uint num_buffers, std::vector<void *> &buffers);
+    /**
+     * @brief Frees an arena and all its sub-buffers
+     *
+     * @param[in] arena - the first sub-buffer of the arena
+     * @return media_library_return
+     */
+    media_library_return free_dma_arena(void *arena);
+    /**
+     * @brief Gets the fd of a buffer and its offset in the dmabuf, which is non zero only for arena sub-buffers
+     */
+    media_library_return get_fd_offset(void *buffer, int &fd, size_t &offset);
+    /**
+     * @brief Allocates a dma buffer without mapping it to the CPU, for buffers that only devices access
+     *
+     * @param[in] size - buffer size
+     * @param[out] fd - the dmabuf fd of the buffer
+     * @return media_library_return
+     */
+    media_library_return allocate_device_dma_buffer(uint size, int &fd);
+    /**
+     * @brief Maps a device dma buffer to the CPU, or gets its mapping if it is already mapped.
+     * Once mapped, the buffer is found by get_fd() and get_ptr() as any allocated buffer.
+     *
+     * @param[in] fd - the dmabuf fd of the buffer
+     * @param[out] buffer - the mapped buffer
+     * @return media_library_return
+     */
+    media_library_return map_device_dma_buffer(int fd, void **buffer);
+    /**
+     * @brief Drops the CPU mapping of a device dma buffer, the buffer itself is kept
+     *
+     * @param[in] fd - the dmabuf fd of the buffer
+     * @return media_library_return
+     */
+    media_library_return unmap_device_dma_buffer(int fd);
+    /**
+     * @brief Frees a device dma buffer, and its CPU mapping if it is mapped
+     *
+     * @param[in] fd - the dmabuf fd of the buffer
+     * @return media_library_return
+     */
+    media_library_return free_device_dma_buffer(int fd);
     media_library_return map_external_dma_buffer(uint size, uint fd, void **buffer);
     media_library_return unmap_external_dma_buffer(void *buffer);
     media_library_return dmabuf_sync_start(void *buffer);
     media_library_return dmabuf_sync_start(int fd);
     media_library_return dmabuf_sync_end(void *buffer);
     media_library_return dmabuf_sync_end(int fd);
+    /**
+     * @brief Starts a CPU access to a dmabuf, the cache is invalidated only if the access reads
+     */
+    media_library_return dmabuf_sync_start(int fd, dma_sync_access_t access);
+    media_library_return dmabuf_sync_start(void *buffer, dma_sync_access_t access);
+    /**
+     * @brief Ends a CPU access to a dmabuf, the cache is written back only if the access writes
+     */
+    media_library_return dmabuf_sync_end(int fd, dma_sync_access_t access);
+    media_library_return dmabuf_sync_end(void *buffer, dma_sync_access_t access);
+    /**
+     * @brief Counts a sync that a caller skipped since it would not change the ownership of the buffer
+     */
+    void count_elided_sync()
+    {
+        m_syncs_elided.fetch_add(1, std::memory_order_relaxed);
+    }
+    /**
+     * @brief Gets the number of issued and elided dmabuf syncs since the process started
+     */
+    dma_sync_statistics_t get_sync_statistics()
+    {
+        return {m_syncs_issued.load(std::memory_order_relaxed), m_syncs_elided.load(std::memory_order_relaxed)};
+    }
     media_library_return get_fd(void *buffer, int &fd, bool include_external = true);
     media_library_return get_ptr(uint fd, void **buffer, bool include_external = true);
     size_t get_free_memory_mb();
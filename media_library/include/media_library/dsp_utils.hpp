@@ -30,11 +30,26 @@
 #include "hailo/hailodsp.h"
 #include "media_library_buffer.hpp"
 #include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <optional>
 
 #define MIN_ISP_AE_FPS_FOR_DIS (20)
 
+// Default maximum number of asynchronous DSP jobs submitted and not completed yet
+#ifndef MEDIALIB_DSP_ASYNC_QUEUE_DEPTH
+#define MEDIALIB_DSP_ASYNC_QUEUE_DEPTH 4
+#endif
+
+// Number of threads issuing asynchronous DSP jobs to the device
+#ifndef MEDIALIB_DSP_ASYNC_WORKERS
+#define MEDIALIB_DSP_ASYNC_WORKERS 2
+#endif
+
 /** @defgroup dsp_utils_definitions MediaLibrary DSP utilities CPP API
  * definitions
  *  @{
@@ -105,6 +120,62 @@ struct hailo_dsp_buffer_data_t
 
 namespace dsp_utils
 {
+/**
+ * @brief Completion fence of an asynchronous DSP job.
+ * The fence is signaled once the job completed, successfully or not. It can be waited on directly, or polled
+ * (POLLIN) through its eventfd from an event loop.
+ */
+class DspFence
+{
+  public:
+    DspFence();
+    ~DspFence();
+
+    DspFence(const DspFence &) = delete;
+    DspFence &operator=(const DspFence &) = delete;
+
+    /**
+     * @brief Blocks until the job completed
+     *
+     * @return dsp_status - the status of the job
+     */
+    dsp_status wait();
+
+    /**
+     * @brief Blocks until the job completed or the timeout expired
+     *
+     * @param[in] timeout - maximum time to wait
+     * @return std::optional<dsp_status> - the status of the job, std::nullopt if it did not complete in time
+     */
+    std::optional<dsp_status> wait_for(const std::chrono::milliseconds &timeout);
+
+    bool is_signaled();
+
+    /**
+     * @brief Gets an eventfd that becomes readable once the job completed, owned by the fence.
+     * The fd is created on first use, so fences that are only waited on do not cost a file descriptor.
+     *
+     * @return int - the fd, or -1 if it could not be created
+     */
+    int fd();
+
+    void signal(dsp_status status);
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_signaled;
+    dsp_status m_status;
+    int m_fd;
+};
+
+using DspFencePtr = std::shared_ptr<DspFence>;
+
+/**
+ * A DSP operation, called with the DSP device by the thread that executes it
+ */
+using dsp_job_t = std::function<dsp_status(dsp_device)>;
+
 /**
   Crop and resize parameters
 */
@@ -200,6 +271,54 @@ void free_image_property_planes(dsp_image_properties_t *image_properties);
 
 size_t get_dsp_desired_stride_from_width(size_t width);
 
+/**
+ * @brief Sets the maximum number of asynchronous DSP jobs submitted and not completed yet.
+ * Once it is reached, a submission blocks until a job completes.
+ *
+ * @param[in] depth - the queue depth, at least 1
+ * @return dsp_status - DSP_INVALID_ARGUMENT if the depth is 0
+ */
+dsp_status set_async_queue_depth(size_t depth);
+
+/**
+ * @brief Enables running asynchronous DSP operations on the CPU backend when the queue is full.
+ * Such an operation runs on the submitting thread instead of blocking it until a queued job completes, trading CPU
+ * time for latency when the DSP is overloaded. Disabled by default.
+ *
+ * @param[in] enabled - whether to fall back to the CPU backend
+ */
+void set_cpu_fallback(bool enabled);
+
+/**
+ * @brief Submits a DSP operation to be executed by the asynchronous DSP workers
+ * Jobs are started in submission order. Everything the job points to must stay valid until its fence is signaled.
+ *
+ * @param[in] trace_name - name of the job in the DSP trace track, must be a string literal
+ * @param[in] job - the operation
+ * @return DspFencePtr - fence signaled with the status of the operation
+ */
+DspFencePtr submit_dsp_job(const char *trace_name, dsp_job_t job);
+
+/*
+  Asynchronous versions of the DSP operations. The parameter structs and image properties passed to them are copied
+  into the job, so they may be locals of the caller. Everything they point to must stay valid until the returned fence
+  is signaled: the image planes, the crop and resize groups and their destinations, meshes, overlays and privacy mask
+  params. The synchronous perform_dsp_* functions execute the same jobs on the calling thread.
+*/
+DspFencePtr submit_dsp_frontend_process(const dsp_frontend_params_t &frontend_params);
+
+DspFencePtr submit_dsp_multi_resize(dsp_multi_crop_resize_params_t *multi_crop_resize_params);
+
+DspFencePtr submit_dsp_privacy_mask(dsp_image_properties_t *image_properties,
+                                    const unified_dsp_privacy_mask_t *privacy_mask_params);
+
+DspFencePtr submit_dsp_dewarp(dsp_image_properties_t *input_image_properties,
+                              dsp_image_properties_t *output_image_properties, dsp_dewarp_mesh_t *mesh,
+                              dsp_interpolation_type_t interpolation);
+
+DspFencePtr submit_dsp_multiblend(dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlay,
+                                  size_t overlays_count);
+
 static constexpr int max_blend_overlays = 50;
 
 } // namespace dsp_utils
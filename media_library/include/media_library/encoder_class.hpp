@@ -44,6 +44,9 @@ struct EncoderOutputBuffer
 class Encoder
 {
   public:
+    /** Size of the output buffer pool, enough for a full GOP in flight */
+    static constexpr uint OUTPUT_POOL_MAX_BUFFERS = MAX_GOP_SIZE + 3;
+
     Encoder(std::string json_string);
     ~Encoder();
     int get_gop_size();
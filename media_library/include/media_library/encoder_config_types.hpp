@@ -79,6 +79,9 @@ enum deblocking_filter_type_t
 
 struct input_config_t
 {
+    /** Size of the input buffer pool when max_pool_size is not set */
+    static constexpr uint32_t DEFAULT_MAX_POOL_SIZE = 5;
+
     uint32_t width;
     uint32_t height;
     uint32_t framerate;
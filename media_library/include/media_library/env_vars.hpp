@@ -12,6 +12,7 @@
 #define MEDIALIB_FD_DUP_ENV_VAR ("MEDIALIB_FD_DUP")
 
 #define MEDIALIB_SNAPSHOT_ENABLE_ENV_VAR ("MEDIALIB_SNAPSHOT_ENABLE")
+#define MEDIALIB_BUFFER_TRACKING_ENABLE_ENV_VAR ("MEDIALIB_BUFFER_TRACKING_ENABLE")
 #define MEDIALIB_DEWARP_DSP_OPTIMIZATION_ENV_VAR ("MEDIALIB_DEWARP_DSP_OPTIMIZATION")
 #define MEDIALIB_DEFAULT_TOTAL_COOLING_WAIT_TIME_IN_MINUTES_ENV_VAR ("DEFAULT_TOTAL_COOLING_WAIT_TIME_IN_MINUTES")
 #define MEDIALIB_USE_DIV_FRAMERATE_LOGIC_ENV_VAR ("MEDIALIB_USE_DIV_FRAMERATE_LOGIC")
@@ -9,7 +9,7 @@
 #include <tl/expected.hpp>
 #include "eis_types.hpp"
 #include "media_library/media_library_types.hpp"
-#include "common/concurrent_queue.hpp"
+#include "common/timestamp_ring.hpp"
 
 #define FIFO_BUF_SIZE (10)
 #define MAX_CHANNEL_ID (4)
@@ -46,7 +46,8 @@ class GyroDevice
   private:
     struct iio_context *m_ctx = NULL;
     struct iio_device *m_iio_dev;
-    std::unique_ptr<ConcurrentQueue<gyro_sample_t>> m_vector_samples;
+    // Filled by the gyro thread, searched and drained by the frame thread
+    std::unique_ptr<TimestampRing<gyro_sample_t>> m_vector_samples;
     std::string m_device_freq;
     double m_gyro_scale;
     sig_atomic_t m_stopRunning;
@@ -71,7 +72,7 @@ class GyroDevice
   public:
     std::condition_variable cv;
     GyroDevice(std::string name, std::string device_freq, double gyro_scale)
-        : m_vector_samples(std::make_unique<ConcurrentQueue<gyro_sample_t>>(MAX_VECTOR_SIZE))
+        : m_vector_samples(std::make_unique<TimestampRing<gyro_sample_t>>(MAX_VECTOR_SIZE))
     {
         m_device_freq = device_freq;
         m_gyro_scale = gyro_scale;
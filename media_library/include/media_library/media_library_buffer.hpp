@@ -74,6 +74,8 @@ struct hailo_data_plane_t
     size_t bytesperline;
     /** Number of bytes occupied by data (payload) in the plane */
     size_t bytesused;
+    /** Offset in bytes of the plane in the dmabuf of #fd, non zero when the plane is carved out of a dma arena */
+    size_t offset = 0;
     template <typename T> T As() const;
 };
 
@@ -37,6 +37,8 @@
 #include <ctime>
 #include <optional>
 #include <map>
+#include <memory>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 /** @defgroup media_library_types_definitions MediaLibrary Types CPP API definitions
@@ -161,6 +163,17 @@ enum motion_detection_sensitivity_levels_t
     MOTION_DETECTION_SENSITIVITY_LEVELS_MAX = INT_MAX
 };
 
+enum output_drop_policy_t
+{
+    /** Skip only the output whose buffer pool is exhausted, the other outputs of the frame are produced */
+    OUTPUT_DROP_POLICY_DROP = 0,
+    /** Wait up to drop_timeout_ms for a buffer to be released back to the pool, then skip the output */
+    OUTPUT_DROP_POLICY_BLOCK,
+
+    /** Max enum value to maintain ABI Integrity */
+    OUTPUT_DROP_POLICY_MAX = INT_MAX
+};
+
 enum sensor_index_t
 {
     SENSOR_0 = 0,
@@ -343,6 +356,10 @@ struct output_resolution_t
     dsp_utils::crop_resize_dims_t dimensions;
     std::string stream_id;
     dsp_scaling_mode_t scaling_mode;
+    // Outputs are served in descending priority, so that a blocking low priority output waits last
+    uint32_t priority = 0;
+    output_drop_policy_t drop_policy = OUTPUT_DROP_POLICY_DROP;
+    uint32_t drop_timeout_ms = 0;
 
     bool operator==(const output_resolution_t &other) const
     {
@@ -384,6 +401,30 @@ struct output_resolution_t
     }
 };
 
+struct motion_map_config_t
+{
+    bool enabled = false;
+    // grid of cells covering the motion detection frame
+    uint32_t columns = 16;
+    uint32_t rows = 16;
+    // fraction of the pixels of a cell that must move for the cell to be marked
+    float cell_threshold = 0.05f;
+    // also provide the motion mask packed to a bit per pixel
+    bool packed_mask = false;
+};
+
+struct motion_reference_config_t
+{
+    // keep a compact reference plane instead of holding the previous frame buffer until the next frame
+    bool enabled = false;
+    // the reference is downscaled by this factor in each dimension
+    uint32_t downscale = 2;
+    // store the reference with 4 bits per pixel, not applied to a running average background
+    bool quantize = false;
+    // weight of each frame in a running average background, 0 compares each frame with the previous one
+    float background_learning_rate = 0.0f;
+};
+
 struct motion_detection_config_t
 {
     bool enabled;
@@ -392,8 +433,38 @@ struct motion_detection_config_t
     motion_detection_sensitivity_levels_t sensitivity_level;
     float threshold;
     uint32_t buffer_pool_size;
+    motion_map_config_t motion_map;
+    motion_reference_config_t compact_reference;
+    // run on a dedicated thread instead of the multi-resize thread
+    bool asynchronous = false;
+    // time the multi-resize waits for the result of its frame before attaching the latest one, 0 never waits
+    uint32_t result_deadline_ms = 0;
 };
 
+/**
+ * @brief Where motion was detected in a frame, on a grid of cells covering the motion detection frame
+ */
+struct motion_map_t
+{
+    uint32_t columns;
+    uint32_t rows;
+    /** Moving pixels of each cell as a fraction of the cell scaled to 0-255, row major */
+    std::vector<uint8_t> energy;
+    /** A bit per cell set for the cells with motion, row major, least significant bit first */
+    std::vector<uint8_t> cell_mask;
+    /** Motion mask with a bit per pixel, least significant bit first, empty unless packed_mask is enabled */
+    std::vector<uint8_t> packed_mask;
+    uint32_t packed_mask_stride;
+
+    bool cell_has_motion(uint32_t column, uint32_t row) const
+    {
+        uint32_t index = row * columns + column;
+        return cell_mask[index / 8] & (1 << (index % 8));
+    }
+};
+
+using MotionMapPtr = std::shared_ptr<motion_map_t>;
+
 struct config_application_input_streams_t
 {
     dsp_interpolation_type_t interpolation_type;
@@ -515,6 +586,9 @@ struct multi_resize_config_t
             output_resolution_t &new_res = mresize_config.application_input_streams_config.resolutions[i];
             current_res.framerate = new_res.framerate;
             current_res.dimensions = new_res.dimensions;
+            current_res.priority = new_res.priority;
+            current_res.drop_policy = new_res.drop_policy;
+            current_res.drop_timeout_ms = new_res.drop_timeout_ms;
         }
 
         // rotate if necessary
@@ -857,6 +931,54 @@ struct OverrideParameters
     bool discard_on_profile_change;
 };
 
+enum thread_sched_policy_t
+{
+    THREAD_SCHED_POLICY_OTHER = 0,
+    THREAD_SCHED_POLICY_FIFO,
+    THREAD_SCHED_POLICY_RR,
+
+    /** Max enum value to maintain ABI Integrity */
+    THREAD_SCHED_POLICY_MAX = INT_MAX
+};
+
+/** Scheduling of a named library thread, see threading_manager.hpp for the thread names */
+struct thread_config_t
+{
+    std::string name;
+    thread_sched_policy_t policy;
+    /** Real-time priority (1-99) for THREAD_SCHED_POLICY_FIFO and THREAD_SCHED_POLICY_RR, 0 otherwise */
+    int priority;
+    /** Nice value (-20-19) for THREAD_SCHED_POLICY_OTHER */
+    int nice;
+    /** CPUs the thread may run on, empty for no restriction */
+    std::vector<int> cpus;
+};
+
+enum dma_budget_policy_t
+{
+    /** Refuse a profile that does not fit in the budget */
+    DMA_BUDGET_POLICY_REFUSE = 0,
+    /** Reduce the multi-resize output pools of a profile that does not fit, down to the minimal pool size */
+    DMA_BUDGET_POLICY_DEGRADE,
+
+    /** Max enum value to maintain ABI Integrity */
+    DMA_BUDGET_POLICY_MAX = INT_MAX
+};
+
+/** DMA memory budget of the buffer pools of the process, see dma_budget_manager.hpp */
+struct dma_budget_config_t
+{
+    static constexpr uint32_t DEFAULT_MIN_POOL_BUFFERS = 2;
+
+    /** Budget in MB on top of the free CMA memory, 0 for no limit other than the CMA */
+    uint32_t budget_mb;
+    dma_budget_policy_t policy;
+    /** Number of buffers a pool keeps when degraded or shrunk while idle */
+    uint32_t min_pool_buffers;
+    /** Period of shrinking the idle pools down to their usage, 0 to never shrink them */
+    uint32_t idle_shrink_interval_ms;
+};
+
 struct profile_t
 {
     std::string name;
@@ -870,6 +992,8 @@ struct medialib_config_t
 {
     std::string default_profile;
     std::vector<profile_t> profiles;
+    std::vector<thread_config_t> threading;
+    dma_budget_config_t dma_budget;
 
     // get_profile(std::string name)
     tl::expected<profile_t, media_library_return> get_profile(const std::string &name) const
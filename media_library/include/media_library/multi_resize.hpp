@@ -181,6 +181,14 @@ class MediaLibraryMultiResize
      * @return The status of the operation.
      */
     media_library_return set_image_enhancement_status(bool status);
+
+    /**
+     * @brief Gets the number of frames each output dropped because its buffer pool was exhausted.
+     * A frame skipped to match the output framerate is not counted.
+     *
+     * @return std::vector<uint64_t> - drop count per output, in the order of the configured resolutions
+     */
+    std::vector<uint64_t> get_output_drop_counts();
 };
 
 /** @} */ // end of multi_resize_type_definitions
@@ -52,7 +52,7 @@ class MediaLibraryPostIspDenoise final : public MediaLibraryDenoise
     bool network_changed(const denoise_config_t &denoise_configs, const hailort_t &hailort_configs) override;
     media_library_return create_and_initialize_buffer_pools(const input_video_config_t &input_video_configs) override;
     media_library_return free_buffer_pools() override;
-    media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr output_buffer) override;
+    media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr &output_buffer) override;
     bool process_inference(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr loopback_buffer,
                            HailoMediaLibraryBufferPtr output_buffer) override;
     void copy_meta(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr output_buffer) override;
@@ -64,15 +64,15 @@ class MediaLibraryPreIspDenoise final : public MediaLibraryDenoise
     // dgain buffer pool
     static constexpr const char *BUFFER_POOL_NAME_DGAIN = "dgain_pool";
     std::shared_ptr<MediaLibraryBufferPool> m_dgain_buffer_pool;
-    static constexpr int DGAIN_WIDTH = 1;
-    static constexpr int DGAIN_HEIGHT = 1;
+    static constexpr int DGAIN_WIDTH = denoise_common::DGAIN_WIDTH;
+    static constexpr int DGAIN_HEIGHT = denoise_common::DGAIN_HEIGHT;
     static constexpr float DGAIN_FACTOR = 255.99225734;
     static constexpr uint16_t DGAIN_DIVISOR = 100;
     // bls buffer pool
     static constexpr const char *BUFFER_POOL_NAME_BLS = "bls_pool";
     std::shared_ptr<MediaLibraryBufferPool> m_bls_buffer_pool;
-    static constexpr int BLS_WIDTH = 4;
-    static constexpr int BLS_HEIGHT = 1;
+    static constexpr int BLS_WIDTH = denoise_common::BLS_WIDTH;
+    static constexpr int BLS_HEIGHT = denoise_common::BLS_HEIGHT;
 
     static constexpr int RAW_CAPTURE_BUFFERS_COUNT = 5;
     static constexpr int ISP_IN_BUFFERS_COUNT = 3;
@@ -108,9 +108,9 @@ class MediaLibraryPreIspDenoise final : public MediaLibraryDenoise
     bool network_changed(const denoise_config_t &denoise_configs, const hailort_t &hailort_configs) override;
     media_library_return create_and_initialize_buffer_pools(const input_video_config_t &input_video_configs) override;
     media_library_return free_buffer_pools() override;
-    media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr output_buffer) override;
-    media_library_return acquire_dgain_buffer(HailoMediaLibraryBufferPtr dgain_buffer);
-    media_library_return acquire_bls_buffer(HailoMediaLibraryBufferPtr bls_buffer);
+    media_library_return acquire_output_buffer(HailoMediaLibraryBufferPtr &output_buffer) override;
+    media_library_return acquire_dgain_buffer(HailoMediaLibraryBufferPtr &dgain_buffer);
+    media_library_return acquire_bls_buffer(HailoMediaLibraryBufferPtr &bls_buffer);
     bool process_inference(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr loopback_buffer,
                            HailoMediaLibraryBufferPtr output_buffer) override;
     void copy_meta(HailoMediaLibraryBufferPtr input_buffer, HailoMediaLibraryBufferPtr output_buffer) override;
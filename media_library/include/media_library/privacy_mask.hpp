@@ -36,6 +36,7 @@
 #include "media_library_types.hpp"
 #include "privacy_mask_types.hpp"
 #include "buffer_pool.hpp"
+#include "buffer_pool_registry.hpp"
 
 /** @defgroup privacy_mask_definitions MediaLibrary Privacy Mask CPP
  * API definitions
@@ -257,6 +258,18 @@ class PrivacyMaskBlender : public std::enable_shared_from_this<PrivacyMaskBlende
      */
     media_library_return configure(const std::unique_ptr<privacy_mask_config_t> &config);
 
+    /** Number of buffers in the mask buffer pool */
+    static constexpr size_t BUFFER_POOL_MAX_BUFFERS = 1;
+
+    /**
+     * @brief Gets the buffer pool key of the masks of a frame, one bit per 4x4 pixels block
+     *
+     * @param frame_width - frame width
+     * @param frame_height - frame height
+     * @return buffer_pool_key_t - the dimensions and format of the mask buffers
+     */
+    static buffer_pool_key_t get_buffer_pool_key(uint frame_width, uint frame_height);
+
   private:
     std::vector<PolygonPtr> m_static_privacy_masks;
 
@@ -65,7 +65,8 @@ struct static_privacy_mask_data_t
     roi_t rois[MAX_NUM_OF_STATIC_PRIVACY_MASKS];
     uint rois_count;
 
-    static_privacy_mask_data_t() : bitmask(std::make_shared<hailo_media_library_buffer>()) {};
+    // The bitmask is acquired from the privacy mask buffer pool when there are masks to draw
+    static_privacy_mask_data_t() : bitmask(nullptr), rois_count(0) {};
 };
 using StaticPrivacyMaskDataPtr = std::shared_ptr<static_privacy_mask_data_t>;
 
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file profiled_mutex.hpp
+ * @brief Named mutexes that record lock contention when built with the lock_profiling option
+ **/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/** Contention statistics of all the mutexes sharing a name */
+struct lock_stats_t
+{
+    std::string name;
+    /** Number of live mutexes with this name */
+    uint64_t instances;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t total_wait_us;
+    uint64_t max_wait_us;
+    uint64_t total_hold_us;
+    /** Bin i counts waits of [2^(i-1), 2^i) us, the first bin is under 1 us and the last everything above */
+    std::vector<uint64_t> wait_histogram;
+    /** Same bins as wait_histogram, for the time the mutex was held exclusively */
+    std::vector<uint64_t> hold_histogram;
+};
+
+/**
+ * @class LockProfiler
+ * @brief Collects the statistics of the ProfiledMutex and ProfiledSharedMutex instances, per mutex name.
+ *
+ * Statistics are only recorded when the library is built with -Dlock_profiling=true (MEDIALIB_LOCK_PROFILING),
+ * otherwise the profiled mutexes only wrap std::mutex and std::shared_mutex and the profiler reports nothing.
+ * Contended acquisitions are also exported as Perfetto counters of the wait time, on the Locks track.
+ */
+class LockProfiler
+{
+  public:
+    static constexpr size_t TIME_BINS = 16;
+    static constexpr const char *DUMP_COMMAND = "locks";
+
+    struct Counters
+    {
+        const char *name;
+        std::atomic<uint64_t> instances;
+        std::atomic<uint64_t> acquisitions;
+        std::atomic<uint64_t> contended;
+        std::atomic<uint64_t> total_wait_ns;
+        std::atomic<uint64_t> max_wait_ns;
+        std::atomic<uint64_t> total_hold_ns;
+        std::array<std::atomic<uint64_t>, TIME_BINS> wait_histogram;
+        std::array<std::atomic<uint64_t>, TIME_BINS> hold_histogram;
+
+        void on_acquire()
+        {
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+        void on_contended_acquire(uint64_t wait_ns);
+        void on_release(uint64_t hold_ns)
+        {
+            total_hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+            hold_histogram[time_bin(hold_ns)].fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+  private:
+    std::mutex m_profiler_mutex;
+    // Counters are never erased, the mutexes keep a pointer to them
+    std::map<std::string, std::unique_ptr<Counters>> m_counters;
+
+    LockProfiler() = default;
+    ~LockProfiler() = default;
+
+  public:
+    static LockProfiler &get_instance()
+    {
+        static LockProfiler instance;
+        return instance;
+    }
+
+    LockProfiler(LockProfiler const &) = delete;
+    void operator=(LockProfiler const &) = delete;
+
+    static constexpr bool is_enabled()
+    {
+#ifdef MEDIALIB_LOCK_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static size_t time_bin(uint64_t ns)
+    {
+        size_t bin = 0;
+        for (uint64_t us = ns / 1000; us > 0 && bin < TIME_BINS - 1; us >>= 1)
+        {
+            bin++;
+        }
+        return bin;
+    }
+
+    /**
+     * @brief Gets the counters of a mutex name, creating them on first use
+     *
+     * @param[in] name - name of the mutex, a string literal since it is also the name of its Perfetto counter
+     * @return Counters* - the counters, valid for the lifetime of the process
+     */
+    Counters *register_lock(const char *name);
+
+    /**
+     * @brief Gets the statistics of all the mutex names
+     *
+     * @return std::vector<lock_stats_t> - per name statistics
+     */
+    std::vector<lock_stats_t> get_lock_stats();
+    void reset();
+    /**
+     * @brief Formats the statistics of all the mutex names, the most contended first
+     *
+     * @return std::string - the statistics
+     */
+    std::string dump();
+};
+
+#ifdef MEDIALIB_LOCK_PROFILING
+
+/**
+ * @class ProfiledMutex
+ * @brief Mutex that records acquisitions, contention, wait and hold times under its name.
+ * Lock it through std::unique_lock<ProfiledMutex> / std::lock_guard<ProfiledMutex>, and wait on it with
+ * std::condition_variable_any so that the re-acquisitions after a wait are recorded as well.
+ */
+class ProfiledMutex
+{
+  public:
+    explicit ProfiledMutex(const char *name) : m_counters(LockProfiler::get_instance().register_lock(name))
+    {
+    }
+
+    ~ProfiledMutex()
+    {
+        m_counters->instances.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock()
+    {
+        if (!m_mutex.try_lock())
+        {
+            auto wait_start = std::chrono::steady_clock::now();
+            m_mutex.lock();
+            m_acquire_time = std::chrono::steady_clock::now();
+            m_counters->on_contended_acquire(elapsed_ns(wait_start, m_acquire_time));
+            return;
+        }
+        m_acquire_time = std::chrono::steady_clock::now();
+        m_counters->on_acquire();
+    }
+
+    bool try_lock()
+    {
+        if (!m_mutex.try_lock())
+            return false;
+        m_acquire_time = std::chrono::steady_clock::now();
+        m_counters->on_acquire();
+        return true;
+    }
+
+    void unlock()
+    {
+        uint64_t hold_ns = elapsed_ns(m_acquire_time, std::chrono::steady_clock::now());
+        m_mutex.unlock();
+        m_counters->on_release(hold_ns);
+    }
+
+  private:
+    std::mutex m_mutex;
+    LockProfiler::Counters *m_counters;
+    std::chrono::steady_clock::time_point m_acquire_time;
+
+    static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+};
+
+/**
+ * @class ProfiledSharedMutex
+ * @brief Shared mutex that records acquisitions, contention and wait times under its name.
+ * Hold times are recorded for exclusive locks only.
+ */
+class ProfiledSharedMutex
+{
+  public:
+    explicit ProfiledSharedMutex(const char *name) : m_counters(LockProfiler::get_instance().register_lock(name))
+    {
+    }
+
+    ~ProfiledSharedMutex()
+    {
+        m_counters->instances.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    ProfiledSharedMutex(const ProfiledSharedMutex &) = delete;
+    ProfiledSharedMutex &operator=(const ProfiledSharedMutex &) = delete;
+
+    void lock()
+    {
+        if (!m_mutex.try_lock())
+        {
+            auto wait_start = std::chrono::steady_clock::now();
+            m_mutex.lock();
+            m_acquire_time = std::chrono::steady_clock::now();
+            m_counters->on_contended_acquire(elapsed_ns(wait_start, m_acquire_time));
+            return;
+        }
+        m_acquire_time = std::chrono::steady_clock::now();
+        m_counters->on_acquire();
+    }
+
+    bool try_lock()
+    {
+        if (!m_mutex.try_lock())
+            return false;
+        m_acquire_time = std::chrono::steady_clock::now();
+        m_counters->on_acquire();
+        return true;
+    }
+
+    void unlock()
+    {
+        uint64_t hold_ns = elapsed_ns(m_acquire_time, std::chrono::steady_clock::now());
+        m_mutex.unlock();
+        m_counters->on_release(hold_ns);
+    }
+
+    void lock_shared()
+    {
+        if (!m_mutex.try_lock_shared())
+        {
+            auto wait_start = std::chrono::steady_clock::now();
+            m_mutex.lock_shared();
+            m_counters->on_contended_acquire(elapsed_ns(wait_start, std::chrono::steady_clock::now()));
+            return;
+        }
+        m_counters->on_acquire();
+    }
+
+    bool try_lock_shared()
+    {
+        if (!m_mutex.try_lock_shared())
+            return false;
+        m_counters->on_acquire();
+        return true;
+    }
+
+    void unlock_shared()
+    {
+        m_mutex.unlock_shared();
+    }
+
+  private:
+    std::shared_mutex m_mutex;
+    LockProfiler::Counters *m_counters;
+    std::chrono::steady_clock::time_point m_acquire_time;
+
+    static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+};
+
+#else // no MEDIALIB_LOCK_PROFILING
+
+/* Without lock profiling the named mutexes only wrap the std mutexes, the name is dropped. They do not expose the
+ * std mutexes either, so code that waits on them uses std::condition_variable_any in both builds. */
+class ProfiledMutex
+{
+  public:
+    explicit ProfiledMutex(const char *)
+    {
+    }
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock()
+    {
+        m_mutex.lock();
+    }
+
+    bool try_lock()
+    {
+        return m_mutex.try_lock();
+    }
+
+    void unlock()
+    {
+        m_mutex.unlock();
+    }
+
+  private:
+    std::mutex m_mutex;
+};
+
+class ProfiledSharedMutex
+{
+  public:
+    explicit ProfiledSharedMutex(const char *)
+    {
+    }
+
+    ProfiledSharedMutex(const ProfiledSharedMutex &) = delete;
+    ProfiledSharedMutex &operator=(const ProfiledSharedMutex &) = delete;
+
+    void lock()
+    {
+        m_mutex.lock();
+    }
+
+    bool try_lock()
+    {
+        return m_mutex.try_lock();
+    }
+
+    void unlock()
+    {
+        m_mutex.unlock();
+    }
+
+    void lock_shared()
+    {
+        m_mutex.lock_shared();
+    }
+
+    bool try_lock_shared()
+    {
+        return m_mutex.try_lock_shared();
+    }
+
+    void unlock_shared()
+    {
+        m_mutex.unlock_shared();
+    }
+
+  private:
+    std::shared_mutex m_mutex;
+};
+
+#endif // MEDIALIB_LOCK_PROFILING
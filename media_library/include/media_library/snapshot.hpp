@@ -51,6 +51,7 @@ class SnapshotManager
     static constexpr const char *RESPONSE_PIPE_PATH = "/tmp/medialib_snapshot_response_pipe";
     static constexpr const char *SNAPSHOT_COMMAND = "snapshot";
     static constexpr const char *LIST_STAGES_COMMAND = "list_stages";
+    static constexpr const char *SNAPSHOT_THREAD_POOL_NAME = "medialib_io";
 
     static SnapshotManager &get_instance();
 
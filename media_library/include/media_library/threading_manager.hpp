@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file threading_manager.hpp
+ * @brief Scheduling policy, priority and CPU placement of the long-lived library threads
+ **/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "media_library_types.hpp"
+
+// Names of the library threads that can be configured in the threading section of the medialib config
+#define MEDIALIB_THREAD_HDR "hdr"
+#define MEDIALIB_THREAD_DENOISE_CALLBACK "denoise_callback"
+#define MEDIALIB_THREAD_DENOISE_ISP "denoise_isp"
+#define MEDIALIB_THREAD_GYRO "gyro"
+#define MEDIALIB_THREAD_ISP_PARAMS "isp_params"
+#define MEDIALIB_THREAD_FRONTEND_LOOP "frontend_loop"
+#define MEDIALIB_THREAD_ENCODER_LOOP "encoder_loop"
+#define MEDIALIB_THREAD_PIPE_HANDLER "pipe_handler"
+#define MEDIALIB_THREAD_THROTTLING_TIMER "throttling_timer"
+#define MEDIALIB_THREAD_DSP_ASYNC "dsp_async"
+#define MEDIALIB_THREAD_MOTION_DETECTION "motion_detection"
+#define MEDIALIB_THREAD_DMA_BUDGET "dma_budget"
+
+/** Scheduling and placement of a live library thread, as reported by the kernel */
+struct thread_placement_t
+{
+    std::string name;
+    pid_t tid;
+    thread_sched_policy_t policy;
+    int priority;
+    int nice;
+    /** CPUs the thread may run on */
+    std::vector<int> cpus;
+    /** CPU the thread last ran on */
+    int last_cpu;
+};
+
+/**
+ * @class ThreadingManager
+ * @brief Applies the threading section of the medialib config to the named library threads.
+ *
+ * Each long-lived thread registers itself by name when it starts, and gets the scheduling configured for its name.
+ * A configuration set after a thread started is applied to it as well, so threads created before the medialib config
+ * was loaded are covered too. Threads without a configuration keep the default scheduling.
+ */
+class ThreadingManager
+{
+  private:
+    std::mutex m_mutex;
+    std::map<std::string, thread_config_t> m_configs;
+    // live registered threads, by thread id
+    std::map<pid_t, std::string> m_threads;
+
+    ThreadingManager() = default;
+    ~ThreadingManager() = default;
+
+    media_library_return apply(pid_t tid, const thread_config_t &config);
+
+  public:
+    static ThreadingManager &get_instance()
+    {
+        static ThreadingManager instance;
+        return instance;
+    }
+
+    ThreadingManager(ThreadingManager const &) = delete;
+    void operator=(ThreadingManager const &) = delete;
+
+    /**
+     * @brief Sets the scheduling of the named threads and applies it to the live ones.
+     * Threads whose name is not configured keep their current scheduling.
+     *
+     * @param[in] configs - the threading section of the medialib config
+     * @return media_library_return - MEDIA_LIBRARY_ERROR if a live thread could not be configured
+     */
+    media_library_return configure(const std::vector<thread_config_t> &configs);
+
+    /**
+     * @brief Registers the calling thread under a name and applies the scheduling configured for it.
+     * The thread name is also set as the kernel thread name, and the thread is unregistered when it exits.
+     *
+     * @param[in] name - one of the MEDIALIB_THREAD_* names
+     * @return media_library_return - MEDIA_LIBRARY_ERROR if the configured scheduling could not be applied
+     */
+    media_library_return register_current_thread(const std::string &name);
+    void unregister_thread(pid_t tid);
+
+    /**
+     * @brief Gets the actual scheduling and placement of the live registered threads
+     *
+     * @return std::vector<thread_placement_t> - per thread placement
+     */
+    std::vector<thread_placement_t> get_thread_placements();
+};
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -9,6 +8,12 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <new>
+#include <cstddef>
 
 /*
     The reason we need this wrapper in the first place is that OpenCV has a serious memory leak, as detailed here:
@@ -21,64 +26,282 @@
 
     Our workaround is to create a wrapper that handles calls to OpenCV functions from a single thread. This single
    thread is part of a static instance, and therefore, we keep it alive as long as the process is alive.
+
+    Each worker owns a ring of task slots per priority. Tasks are pushed to the ring of the submitting worker, or
+   spread round robin when submitted from outside the pool, and an idle worker steals from the others - high priority
+   tasks of all the workers always run before normal ones.
 */
 
 #ifndef MEDIALIB_THREADPOOL_DEFAULT_SIZE
 #define MEDIALIB_THREADPOOL_DEFAULT_SIZE 3
 #endif
 
+#define MEDIALIB_THREADPOOL_DEFAULT_NAME "medialib_pool"
+
+// Size of the inline storage of a task, a posted callable (with its captures) must fit in it
+#ifndef MEDIALIB_THREADPOOL_TASK_SIZE
+#define MEDIALIB_THREADPOOL_TASK_SIZE 128
+#endif
+
+// Initial number of task slots of each worker ring, a ring doubles when it fills up
+#ifndef MEDIALIB_THREADPOOL_RING_SIZE
+#define MEDIALIB_THREADPOOL_RING_SIZE 64
+#endif
+
+enum class ThreadPoolPriority
+{
+    High = 0,
+    Normal,
+};
+
+/**
+ * @brief Move-only nullary callable stored inline, so that queueing a task does not allocate.
+ * Callables larger than MEDIALIB_THREADPOOL_TASK_SIZE are rejected at compile time.
+ */
+class InplaceTask
+{
+  public:
+    static constexpr size_t CAPACITY = MEDIALIB_THREADPOOL_TASK_SIZE;
+
+    InplaceTask() noexcept : m_ops(nullptr)
+    {
+    }
+
+    template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceTask>>> InplaceTask(F &&f)
+    {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= CAPACITY, "Task does not fit in MEDIALIB_THREADPOOL_TASK_SIZE");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Task is over-aligned");
+        static_assert(std::is_nothrow_move_constructible_v<Callable>, "Task must be nothrow move constructible");
+        new (m_storage) Callable(std::forward<F>(f));
+        m_ops = &OPS<Callable>;
+    }
+
+    InplaceTask(InplaceTask &&other) noexcept : m_ops(other.m_ops)
+    {
+        if (m_ops != nullptr)
+        {
+            m_ops->move(m_storage, other.m_storage);
+            other.reset();
+        }
+    }
+
+    InplaceTask &operator=(InplaceTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops != nullptr)
+            {
+                m_ops->move(m_storage, other.m_storage);
+                other.reset();
+            }
+        }
+        return *this;
+    }
+
+    InplaceTask(const InplaceTask &) = delete;
+    InplaceTask &operator=(const InplaceTask &) = delete;
+
+    ~InplaceTask()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        m_ops->invoke(m_storage);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_ops != nullptr;
+    }
+
+  private:
+    struct Ops
+    {
+        void (*invoke)(void *callable);
+        void (*move)(void *destination, void *source);
+        void (*destroy)(void *callable);
+    };
+
+    template <class Callable>
+    static constexpr Ops OPS = {
+        [](void *callable) { (*static_cast<Callable *>(callable))(); },
+        [](void *destination, void *source) {
+            new (destination) Callable(std::move(*static_cast<Callable *>(source)));
+        },
+        [](void *callable) { static_cast<Callable *>(callable)->~Callable(); }};
+
+    void reset() noexcept
+    {
+        if (m_ops != nullptr)
+        {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[CAPACITY];
+    const Ops *m_ops;
+};
+
+/**
+ * @brief Ring of preallocated task slots, taken from the front by its owner and from the back by thieves
+ */
+class TaskRing
+{
+  public:
+    explicit TaskRing(size_t capacity = MEDIALIB_THREADPOOL_RING_SIZE) : m_slots(capacity), m_head(0), m_count(0)
+    {
+    }
+
+    bool empty() const
+    {
+        return m_count == 0;
+    }
+
+    void push_back(InplaceTask &&task)
+    {
+        if (m_count == m_slots.size())
+            grow();
+        m_slots[(m_head + m_count) % m_slots.size()] = std::move(task);
+        m_count++;
+    }
+
+    InplaceTask pop_front()
+    {
+        InplaceTask task = std::move(m_slots[m_head]);
+        m_head = (m_head + 1) % m_slots.size();
+        m_count--;
+        return task;
+    }
+
+    InplaceTask pop_back()
+    {
+        m_count--;
+        return std::move(m_slots[(m_head + m_count) % m_slots.size()]);
+    }
+
+  private:
+    std::vector<InplaceTask> m_slots;
+    size_t m_head;
+    size_t m_count;
+
+    void grow()
+    {
+        std::vector<InplaceTask> slots(m_slots.size() * 2);
+        for (size_t i = 0; i < m_count; i++)
+            slots[i] = std::move(m_slots[(m_head + i) % m_slots.size()]);
+        m_slots.swap(slots);
+        m_head = 0;
+    }
+};
+
 class ThreadPool
 {
   public:
     ThreadPool();
     ThreadPool(size_t);
+    /**
+     * @brief Constructor of ThreadPool
+     *
+     * @param[in] threads - number of worker threads
+     * @param[in] name - prefix of the worker thread names, truncated to the 15 characters the kernel keeps
+     * @param[in] cpu_affinity - CPUs the workers may run on, empty for no restriction
+     */
+    ThreadPool(size_t threads, const std::string &name, const std::vector<int> &cpu_affinity = {});
     ~ThreadPool();
     template <class F, class... Args>
-    auto enqueue(F &&f, Args &&...args) -> std::future<typename std::result_of<F(Args...)>::type>; // async call
+    auto enqueue(F &&f, Args &&...args) -> std::future<std::invoke_result_t<F, Args...>>; // async call
     template <class F, class... Args>
-    auto invoke(F &&f, Args &&...args) -> std::result_of<F(Args...)>::type; // sync call
+    auto enqueue_priority(ThreadPoolPriority priority, F &&f, Args &&...args)
+        -> std::future<std::invoke_result_t<F, Args...>>; // async call with priority
+    template <class F> void post(F &&f, ThreadPoolPriority priority = ThreadPoolPriority::Normal); // fire and forget
+    template <class F, class... Args>
+    auto invoke(F &&f, Args &&...args) -> std::invoke_result_t<F, Args...>; // sync call
     static std::shared_ptr<ThreadPool> GetInstance();
+    /**
+     * @brief Gets a named pool, creating it on first use. Separate pools keep slow background work (such as disk
+     * I/O) from delaying the tasks of the frame path.
+     *
+     * @param[in] name - name of the pool, also the prefix of its thread names
+     * @param[in] threads - number of worker threads, used only when the pool is created
+     * @param[in] cpu_affinity - CPUs the workers may run on, used only when the pool is created
+     * @return std::shared_ptr<ThreadPool> - the pool
+     */
+    static std::shared_ptr<ThreadPool> GetInstance(const std::string &name,
+                                                   size_t threads = MEDIALIB_THREADPOOL_DEFAULT_SIZE,
+                                                   const std::vector<int> &cpu_affinity = {});
 
   private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    static constexpr size_t PRIORITIES_COUNT = static_cast<size_t>(ThreadPoolPriority::Normal) + 1;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        TaskRing tasks[PRIORITIES_COUNT];
+        std::thread thread;
+    };
+
+    std::string m_name;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_next_worker;
 
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop;
+    // Idle workers sleep until a task is queued anywhere in the pool
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_condition;
+    size_t m_pending_tasks;
+    bool m_stop;
 
     static std::shared_ptr<ThreadPool> instance;
     static std::mutex instance_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<ThreadPool>> named_instances;
+
+    void submit(InplaceTask &&task, ThreadPoolPriority priority);
+    bool pop_task(size_t worker_index, InplaceTask &task);
+    void worker_loop(size_t worker_index);
+    void set_worker_attributes(size_t worker_index, const std::vector<int> &cpu_affinity);
 };
 
 // enqueue a task that will be executed by a worker thread
 // the return value is a future that will be set once the task is completed
 template <class F, class... Args>
-auto ThreadPool::enqueue(F &&f, Args &&...args) -> std::future<typename std::result_of<F(Args...)>::type>
+auto ThreadPool::enqueue(F &&f, Args &&...args) -> std::future<std::invoke_result_t<F, Args...>>
+{
+    return enqueue_priority(ThreadPoolPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+// enqueue a task that will be executed by a worker thread before any task of a lower priority
+// the return value is a future that will be set once the task is completed
+template <class F, class... Args>
+auto ThreadPool::enqueue_priority(ThreadPoolPriority priority, F &&f, Args &&...args)
+    -> std::future<std::invoke_result_t<F, Args...>>
 {
-    using return_type = typename std::result_of<F(Args...)>::type;
+    using return_type = std::invoke_result_t<F, Args...>;
 
     auto task =
         std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
     std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-
-        // don't allow enqueueing after stopping the pool
-        if (stop)
-            throw std::runtime_error("enqueue on stopped ThreadPool");
-
-        tasks.emplace([task]() { (*task)(); });
-    }
-    condition.notify_one();
+    submit([task]() { (*task)(); }, priority);
     return res;
 }
 
+// post a task that will be executed by a worker thread, without a future to report its completion
+// the callable is stored inline in a preallocated task slot, so posting does not allocate
+// an exception thrown by the task is dropped
+template <class F> void ThreadPool::post(F &&f, ThreadPoolPriority priority)
+{
+    submit(InplaceTask(std::forward<F>(f)), priority);
+}
+
 // enqueue a task that will be executed by a worker thread
 // the function will block until the execution is complete
 // the return value is the result of the function
-template <class F, class... Args> auto ThreadPool::invoke(F &&f, Args &&...args) -> std::result_of<F(Args...)>::type
+template <class F, class... Args> auto ThreadPool::invoke(F &&f, Args &&...args) -> std::invoke_result_t<F, Args...>
 {
     return enqueue(std::forward<F>(f), std::forward<Args>(args)...).get();
 }
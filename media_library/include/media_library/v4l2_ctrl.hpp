@@ -17,6 +17,7 @@
 #include <thread>
 
 #include "files_utils.hpp"
+#include "profiled_mutex.hpp"
 
 #ifndef CTRL_REPOSITORY_TTL_MS
 #define CTRL_REPOSITORY_TTL_MS 5000 // 5 sec
@@ -169,7 +170,7 @@ class v4l2ControlManager
     size_t m_sensor_index;
     uint64_t m_ttl;
     bool m_async_refresh = false;
-    std::mutex m_cache_mutex;
+    ProfiledMutex m_cache_mutex{"v4l2_ctrl_cache"};
     bool m_during_ctrl_cache_refresh = false;
     std::map<Device, std::map<uint32_t, std::pair<uint64_t, uint64_t>>>
         m_ctrl_cache; // cache of Device to ctrl_id to timestamp and value
@@ -184,7 +185,7 @@ class v4l2ControlManager
 
     void set_sensor_index(size_t sensor_index)
     {
-        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        std::lock_guard<ProfiledMutex> lock(m_cache_mutex);
         if (m_sensor_index == sensor_index)
         {
             return;
@@ -224,7 +225,7 @@ class v4l2ControlManager
 
     std::optional<files_utils::SharedFd> get_fd(Device device)
     {
-        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        std::lock_guard<ProfiledMutex> lock(m_cache_mutex);
 
         // Get the map for the current sensor_index
         auto it = m_device_fd_cache.find(device);
@@ -386,7 +387,7 @@ class v4l2ControlManager
         }
 
         {
-            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            std::lock_guard<ProfiledMutex> lock(m_cache_mutex);
             if (!m_ctrl_cache.contains(device_type))
             {
 
@@ -424,7 +425,7 @@ class v4l2ControlManager
         if (force_refresh || !m_ctrl_cache[device_type].contains(ctrl_id_val) || !m_async_refresh)
         {
 
-            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            std::lock_guard<ProfiledMutex> lock(m_cache_mutex);
             auto tmp_val = ext_ctrl_get<T>(ctrl_id_val, fd);
             if (!tmp_val.has_value())
             {
@@ -438,7 +439,7 @@ class v4l2ControlManager
         else // in cache but expired -> async fetch from ioctl
         {
             val = m_ctrl_cache[device_type][ctrl_id_val].second;
-            std::lock_guard<std::mutex> lock(m_cache_mutex);
+            std::lock_guard<ProfiledMutex> lock(m_cache_mutex);
             if (!m_during_ctrl_cache_refresh)
             {
                 m_during_ctrl_cache_refresh = true;
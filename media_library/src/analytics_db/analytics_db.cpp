@@ -25,7 +25,7 @@ media_library_return AnalyticsDB::add_entry(MapT &db, const std::string &analyti
     }
     LOGGER__MODULE__DEBUG(MODULE_NAME, "Adding analytics entry for ID: {} at timestamp: {}", analytics_id,
                           data.ts.time_since_epoch().count());
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
     auto db_it = db.find(analytics_id);
     if (db_it == db.end())
     {
@@ -59,7 +59,7 @@ media_library_return AnalyticsDB::add_instance_segmentation_entry(const std::str
 
 void AnalyticsDB::clear_db()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "Resetting AnalyticsDB instance.");
     m_detection_entries_db.clear();
     m_instance_segmentation_entries_db.clear();
@@ -69,7 +69,7 @@ void AnalyticsDB::clear_db()
 
 void AnalyticsDB::add_configuration(application_analytics_config_t application_analytics_config)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
 
     size_t new_detection_ids = 0;
     size_t updated_detection_ids = 0;
@@ -137,7 +137,7 @@ void AnalyticsDB::add_configuration(application_analytics_config_t application_a
 
 application_analytics_config_t AnalyticsDB::get_application_analytics_config()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
     return m_application_analytics_config;
 }
 
@@ -254,7 +254,7 @@ tl::expected<DataT, media_library_return> AnalyticsDB::query_entry(const MapT &d
 {
     LOGGER__MODULE__DEBUG(MODULE_NAME, "[query_entry] Waiting for analytics_id: {} with query type {} at ts: {}",
                           analytics_id, static_cast<int>(options.m_type), options.m_ts.time_since_epoch().count());
-    std::unique_lock<std::mutex> lock(m_mutex);
+    std::unique_lock<ProfiledMutex> lock(m_mutex);
     auto deadline = std::chrono::steady_clock::now() + options.m_timeout;
     bool found = false;
     tl::expected<DataT, media_library_return> result = tl::unexpected(MEDIA_LIBRARY_ERROR);
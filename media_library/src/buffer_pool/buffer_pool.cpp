@@ -21,15 +21,44 @@
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <sys/user.h>
 #include "buffer_pool.hpp"
+#include "common/index_free_list.hpp"
+#include "dma_budget_manager.hpp"
+#include "threadpool.hpp"
 #include "media_library_logger.hpp"
 #include "hailo_media_library_perfetto.hpp"
 
 #define MODULE_NAME LoggerType::BufferPool
 
+// Buffers are allocated from the dma-heap in whole pages
+static size_t page_align(size_t size)
+{
+    return (size + PAGE_SIZE - 1) & ~((size_t)PAGE_SIZE - 1);
+}
+
+/**
+ * A single buffer slot of a HailoBucket.
+ * The slot state packs the acquire generation and an in-use bit, so that a release is only honored when it comes
+ * from the holder of the current generation (a stale or double release is ignored).
+ */
+struct HailoBucketSlot
+{
+    intptr_t buffer_ptr = 0;
+    // Cached at allocation, so that acquiring does not need to query the dma allocator
+    int buffer_fd = -1;
+    size_t buffer_offset = 0;
+    std::atomic<uint32_t> state{0};
+};
+
 class HailoBucket
 {
   private:
+    static constexpr uint32_t INVALID_SLOT = IndexFreeList::INVALID_INDEX;
+    static constexpr uint32_t SLOT_IN_USE = 1;
+
     size_t m_buffer_size;
     size_t m_num_buffers;
     HailoMemoryType m_memory_type;
@@ -37,16 +66,34 @@ class HailoBucket
 #ifdef HAVE_PERFETTO
     perfetto::CounterTrack m_counter_track;
 #endif
-
-    // Keep track of used and free buffers
-    std::unordered_set<intptr_t> m_used_buffers;
-    std::deque<intptr_t> m_available_buffers;
-    std::shared_ptr<std::mutex> m_bucket_mutex;
-
+    // In arena mode all the buffers are carved out of a single dmabuf, allocated and freed at once
+    bool m_arena_mode;
+    void *m_arena;
+    // Device only buffers are not mapped to the CPU until first accessed, m_unmap_on_release drops the mapping again
+    bool m_device_only;
+    bool m_unmap_on_release;
+
+    // Fixed array of slots, the available ones are linked into a lock-free free list
+    std::unique_ptr<HailoBucketSlot[]> m_slots;
+    IndexFreeList m_free_slots;
+    std::atomic<size_t> m_allocated_buffers;
+    std::atomic<size_t> m_used_buffers;
+    std::atomic<size_t> m_used_high_water_mark;
+    // Number of slots that may hold a buffer, up to m_num_buffers - lets a shared pool be sized by its leases
+    std::atomic<size_t> m_buffers_limit;
+    // Guards allocation and free of the bucket, the acquire/release path is lock-free
+    std::shared_ptr<ProfiledMutex> m_bucket_mutex;
+
+    media_library_return allocate_slot(uint32_t slot);
+    media_library_return free_slot(uint32_t slot);
+    media_library_return allocate_arena();
+    media_library_return free_arena(bool used_buffers_exist);
     media_library_return allocate();
+    media_library_return grow();
+    size_t shrink(size_t min_buffers);
     media_library_return free(bool fail_on_used_buffers = true);
-    media_library_return acquire(intptr_t *buffer_ptr);
-    media_library_return release(intptr_t buffer_ptr);
+    media_library_return acquire(intptr_t *buffer_ptr, int *buffer_fd, size_t *buffer_offset, uint64_t *handle);
+    media_library_return release(uint64_t handle);
 
   public:
     HailoBucket(size_t buffer_size, size_t num_buffers, HailoMemoryType memory_type, std::string name);
@@ -70,87 +117,262 @@ HailoBucket::HailoBucket(size_t buffer_size, size_t num_buffers, HailoMemoryType
       ,
       m_counter_track(perfetto::DynamicString(m_name), BUFFER_POOLS_TRACK)
 #endif
+      ,
+      m_arena_mode(false), m_arena(nullptr), m_device_only(false), m_unmap_on_release(false),
+      m_slots(std::make_unique<HailoBucketSlot[]>(num_buffers)), m_free_slots(num_buffers), m_allocated_buffers(0),
+      m_used_buffers(0), m_used_high_water_mark(0), m_buffers_limit(num_buffers)
 {
-    m_bucket_mutex = std::make_shared<std::mutex>();
-    m_used_buffers.reserve(m_num_buffers);
+    m_bucket_mutex = std::make_shared<ProfiledMutex>("buffer_pool_bucket");
 }
 
 HailoBucket::~HailoBucket()
 {
 }
 
+media_library_return HailoBucket::allocate_slot(uint32_t slot)
+{
+    if (m_device_only && !m_arena_mode)
+    {
+        if (DmaMemoryAllocator::get_instance().allocate_device_dma_buffer(m_buffer_size, m_slots[slot].buffer_fd) !=
+            MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to create device buffer", m_name);
+            m_slots[slot].buffer_fd = -1;
+            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+        }
+        return MEDIA_LIBRARY_SUCCESS;
+    }
+
+    void *buffer = NULL;
+    media_library_return result = DmaMemoryAllocator::get_instance().allocate_dma_buffer(m_buffer_size, &buffer);
+    if (result != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to create buffer with status code {}", m_name, result);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    if (DmaMemoryAllocator::get_instance().get_fd(buffer, m_slots[slot].buffer_fd, false) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: CMA memory not supported", m_name);
+        DmaMemoryAllocator::get_instance().free_dma_buffer(buffer);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+    m_slots[slot].buffer_ptr = (intptr_t)buffer;
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return HailoBucket::free_slot(uint32_t slot)
+{
+    media_library_return result;
+    if (m_device_only && !m_arena_mode)
+        result = DmaMemoryAllocator::get_instance().free_device_dma_buffer(m_slots[slot].buffer_fd);
+    else
+        result = DmaMemoryAllocator::get_instance().free_dma_buffer(reinterpret_cast<void *>(m_slots[slot].buffer_ptr));
+    if (result != MEDIA_LIBRARY_SUCCESS)
+        return result;
+
+    m_slots[slot].buffer_ptr = 0;
+    m_slots[slot].buffer_fd = -1;
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return HailoBucket::allocate_arena()
+{
+    std::vector<void *> buffers;
+    media_library_return result =
+        DmaMemoryAllocator::get_instance().allocate_dma_arena(m_buffer_size, m_num_buffers, buffers);
+    if (result != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to create arena with status code {}", m_name, result);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    for (uint32_t i = 0; i < m_num_buffers; i++)
+    {
+        DmaMemoryAllocator::get_instance().get_fd_offset(buffers[i], m_slots[i].buffer_fd, m_slots[i].buffer_offset);
+        m_slots[i].buffer_ptr = (intptr_t)buffers[i];
+        m_free_slots.push(i);
+    }
+    m_arena = buffers[0];
+    m_allocated_buffers = m_num_buffers;
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return HailoBucket::free_arena(bool used_buffers_exist)
+{
+    if (m_arena == nullptr)
+        return MEDIA_LIBRARY_SUCCESS;
+
+    if (used_buffers_exist || m_used_buffers.load() > 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Arena still has used buffers, keeping it", m_name);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    media_library_return result = DmaMemoryAllocator::get_instance().free_dma_arena(m_arena);
+    if (result != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to release arena. status code {}", m_name, result);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    while (m_free_slots.pop() != INVALID_SLOT)
+    {
+    }
+    for (uint32_t i = 0; i < m_num_buffers; i++)
+    {
+        m_slots[i].buffer_ptr = 0;
+        m_slots[i].buffer_fd = -1;
+        m_slots[i].buffer_offset = 0;
+    }
+    m_arena = nullptr;
+    m_allocated_buffers = 0;
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
 media_library_return HailoBucket::allocate()
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
-    if (m_available_buffers.size() >= m_num_buffers)
+    std::unique_lock<ProfiledMutex> lock(*m_bucket_mutex);
+    if (m_allocated_buffers.load() >= m_num_buffers)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Exeeded max buffers", m_name);
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
-    size_t buffers_to_allocate = m_num_buffers - m_available_buffers.size();
-    std::vector<intptr_t> tmp_allocated_buffers;
-    for (size_t i = 0; i < buffers_to_allocate; i++)
+    if (m_arena_mode)
+    {
+        if (m_allocated_buffers.load() > 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Arena is partially allocated", m_name);
+            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+        }
+        return allocate_arena();
+    }
+
+    std::vector<uint32_t> tmp_allocated_slots;
+    for (uint32_t i = 0; i < m_num_buffers; i++)
     {
-        void *buffer = NULL;
-        media_library_return result = DmaMemoryAllocator::get_instance().allocate_dma_buffer(m_buffer_size, &buffer);
+        if (m_allocated_buffers.load() + tmp_allocated_slots.size() >= m_buffers_limit.load())
+            break;
+        if (m_slots[i].buffer_fd != -1)
+            continue;
 
-        if (result != MEDIA_LIBRARY_SUCCESS)
+        if (allocate_slot(i) != MEDIA_LIBRARY_SUCCESS)
         {
-            for (intptr_t buffer : tmp_allocated_buffers)
+            for (uint32_t slot : tmp_allocated_slots)
             {
-                media_library_return result =
-                    DmaMemoryAllocator::get_instance().free_dma_buffer(reinterpret_cast<void *>(buffer));
+                media_library_return result = free_slot(slot);
                 if (result != MEDIA_LIBRARY_SUCCESS)
                 {
                     LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to release buffer. status code {}", m_name, result);
                 }
+                m_slots[slot].buffer_ptr = 0;
+                m_slots[slot].buffer_fd = -1;
             }
-            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to create buffer with status code {}", m_name, result);
             return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
-        tmp_allocated_buffers.push_back((intptr_t)buffer);
+        tmp_allocated_slots.push_back(i);
     }
-    for (intptr_t buffer : tmp_allocated_buffers)
+    for (uint32_t slot : tmp_allocated_slots)
     {
-        m_available_buffers.push_front((intptr_t)buffer);
+        m_free_slots.push(slot);
     }
+    m_allocated_buffers += tmp_allocated_slots.size();
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
+media_library_return HailoBucket::grow()
+{
+    std::unique_lock<ProfiledMutex> lock(*m_bucket_mutex);
+    for (uint32_t i = 0; i < m_num_buffers; i++)
+    {
+        if (m_slots[i].buffer_fd != -1)
+            continue;
+
+        if (allocate_slot(i) != MEDIA_LIBRARY_SUCCESS)
+            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+
+        m_allocated_buffers++;
+        m_free_slots.push(i);
+        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Grew bucket to {} buffers", m_name, m_allocated_buffers.load());
+        return MEDIA_LIBRARY_SUCCESS;
+    }
+
+    return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+}
+
+size_t HailoBucket::shrink(size_t min_buffers)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_bucket_mutex);
+    size_t freed_bytes = 0;
+    // Buffers of an arena can not be returned to the heap one by one
+    if (m_arena_mode)
+        return freed_bytes;
+
+    while (m_allocated_buffers.load() > min_buffers)
+    {
+        uint32_t slot = m_free_slots.pop();
+        if (slot == INVALID_SLOT)
+            break;
+
+        if (free_slot(slot) != MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to release buffer while shrinking", m_name);
+            m_free_slots.push(slot);
+            break;
+        }
+        m_allocated_buffers--;
+        freed_bytes += page_align(m_buffer_size);
+    }
+
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Shrunk bucket to {} buffers", m_name, m_allocated_buffers.load());
+    return freed_bytes;
+}
+
 media_library_return HailoBucket::free(bool fail_on_used_buffers)
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_bucket_mutex);
 
-    bool used_buffers_exist = !m_used_buffers.empty();
+    bool used_buffers_exist = m_used_buffers.load() > 0;
     if (used_buffers_exist)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "{}: There are still {} used buffers in the bucket, {} are free", m_name,
-                              m_used_buffers.size(), m_available_buffers.size());
-        for (intptr_t buffer_ptr : m_used_buffers)
+                              m_used_buffers.load(), m_allocated_buffers.load() - m_used_buffers.load());
+        for (uint32_t i = 0; i < m_num_buffers; i++)
         {
-            LOGGER__MODULE__INFO(MODULE_NAME, "{}: Freeing bucket: buffer {} still used", m_name, (void *)buffer_ptr);
-            if (!fail_on_used_buffers)
-                m_available_buffers.push_front(buffer_ptr);
+            uint32_t state = m_slots[i].state.load();
+            if (!(state & SLOT_IN_USE))
+                continue;
+
+            LOGGER__MODULE__INFO(MODULE_NAME, "{}: Freeing bucket: buffer {} still used", m_name,
+                                 (void *)m_slots[i].buffer_ptr);
+            // Reclaim the slot - bumping the generation makes the holder's later release a no-op
+            if (!fail_on_used_buffers && m_slots[i].state.compare_exchange_strong(state, state + 1))
+            {
+                m_used_buffers--;
+                m_free_slots.push(i);
+            }
         }
-        if (!fail_on_used_buffers)
-            m_used_buffers.clear();
     }
 
-    while (!m_available_buffers.empty())
-    {
-        intptr_t buffer_ptr = m_available_buffers.front();
-        media_library_return result =
-            DmaMemoryAllocator::get_instance().free_dma_buffer(reinterpret_cast<void *>(buffer_ptr));
+    if (m_arena_mode)
+        return free_arena(used_buffers_exist && fail_on_used_buffers);
 
+    for (uint32_t slot = m_free_slots.pop(); slot != INVALID_SLOT; slot = m_free_slots.pop())
+    {
+        media_library_return result = free_slot(slot);
         if (result != MEDIA_LIBRARY_SUCCESS)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to release buffer. status code {}", m_name, result);
+            m_free_slots.push(slot);
             return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
 
-        m_available_buffers.pop_front();
+        m_allocated_buffers--;
     }
 
     if (fail_on_used_buffers && used_buffers_exist)
@@ -160,58 +382,196 @@ media_library_return HailoBucket::free(bool fail_on_used_buffers)
 
     LOGGER__MODULE__DEBUG(MODULE_NAME,
                           "{}: After freeing bucket of size {} num of buffers {}, used buffers {} available buffers {}",
-                          m_name, m_buffer_size, m_num_buffers, m_used_buffers.size(), m_available_buffers.size());
+                          m_name, m_buffer_size, m_num_buffers, m_used_buffers.load(),
+                          m_allocated_buffers.load() - m_used_buffers.load());
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
-media_library_return HailoBucket::acquire(intptr_t *buffer_ptr)
+media_library_return HailoBucket::acquire(intptr_t *buffer_ptr, int *buffer_fd, size_t *buffer_offset,
+                                          uint64_t *handle)
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
-
-    if (m_available_buffers.empty())
+    uint32_t slot = m_free_slots.pop();
+    // A bucket that was shrunk while idle allocates its buffers back on demand
+    if (slot == INVALID_SLOT && m_allocated_buffers.load() > 0 &&
+        m_allocated_buffers.load() < m_buffers_limit.load() && grow() == MEDIA_LIBRARY_SUCCESS)
     {
-        LOGGER__MODULE__ERROR(MODULE_NAME,
-                              "{}: Buffer acquire failed - no available buffers remaining, "
-                              "please validate the max buffers size you set ({})",
-                              m_name, m_num_buffers);
+        slot = m_free_slots.pop();
+    }
+    if (slot == INVALID_SLOT)
+    {
+        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Buffer acquire failed - no available buffers remaining", m_name);
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
-    *buffer_ptr = m_available_buffers.front();
-    m_available_buffers.pop_front();
-    m_used_buffers.insert(*buffer_ptr);
+    // The slot is exclusively ours once popped, advance to the next generation and mark it as used
+    uint32_t state = m_slots[slot].state.load(std::memory_order_relaxed);
+    uint32_t generation = (state >> 1) + 1;
+    m_slots[slot].state.store((generation << 1) | SLOT_IN_USE, std::memory_order_release);
+    size_t used_buffers = ++m_used_buffers;
+    size_t high_water_mark = m_used_high_water_mark.load(std::memory_order_relaxed);
+    while (used_buffers > high_water_mark &&
+           !m_used_high_water_mark.compare_exchange_weak(high_water_mark, used_buffers, std::memory_order_relaxed))
+    {
+    }
+
+    *buffer_ptr = m_slots[slot].buffer_ptr;
+    *buffer_fd = m_slots[slot].buffer_fd;
+    *buffer_offset = m_slots[slot].buffer_offset;
+    *handle = (static_cast<uint64_t>(slot) << 32) | generation;
 
-    HAILO_MEDIA_LIBRARY_TRACE_CUSTOM_COUNTER(m_used_buffers.size(), m_counter_track);
+    HAILO_MEDIA_LIBRARY_TRACE_CUSTOM_COUNTER(used_buffers, m_counter_track);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: After acquiring buffer {}, available_buffers={} used_buffers={}", m_name,
-                          *buffer_ptr, m_available_buffers.size(), m_used_buffers.size());
+                          *buffer_ptr, m_allocated_buffers.load() - used_buffers, used_buffers);
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
-media_library_return HailoBucket::release(intptr_t buffer_ptr)
+media_library_return HailoBucket::release(uint64_t handle)
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
+    uint32_t slot = static_cast<uint32_t>(handle >> 32);
+    uint32_t generation = static_cast<uint32_t>(handle);
+    if (slot >= m_num_buffers)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Release of invalid slot {}", m_name, slot);
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
 
-    auto num_erased = m_used_buffers.erase(buffer_ptr);
-    if (!(num_erased == 0))
+    uint32_t expected = (generation << 1) | SLOT_IN_USE;
+    bool released = m_slots[slot].state.compare_exchange_strong(expected, generation << 1, std::memory_order_acq_rel);
+    size_t used_buffers = m_used_buffers.load();
+    if (released)
     {
-        m_available_buffers.push_front(buffer_ptr);
+        // The slot is still exclusively ours until pushed back, drop the mapping before another holder gets it
+        if (m_device_only && m_unmap_on_release && !m_arena_mode)
+            DmaMemoryAllocator::get_instance().unmap_device_dma_buffer(m_slots[slot].buffer_fd);
+        used_buffers = --m_used_buffers;
+        m_free_slots.push(slot);
     }
 
-    HAILO_MEDIA_LIBRARY_TRACE_CUSTOM_COUNTER(m_used_buffers.size(), m_counter_track);
+    HAILO_MEDIA_LIBRARY_TRACE_CUSTOM_COUNTER(used_buffers, m_counter_track);
     LOGGER__MODULE__DEBUG(
         MODULE_NAME, "{}: After release buffer {}, total_buffers={}  available_buffers={} used_buffers={}, removed={}",
-        m_name, buffer_ptr, m_num_buffers, m_available_buffers.size(), m_used_buffers.size(), num_erased);
+        m_name, m_slots[slot].buffer_ptr, m_num_buffers, m_allocated_buffers.load() - used_buffers, used_buffers,
+        released);
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
+/**
+ * A preconstructed buffer of the pool, together with the storage of the shared_ptr control block that is handed
+ * out for it. The record is returned to the pool free list only once the control block is deallocated, since only
+ * then the storage can be reused.
+ */
+struct BufferPoolRecord
+{
+    static constexpr size_t CONTROL_BLOCK_STORAGE_SIZE = 128;
+
+    MediaLibraryBufferPool *pool = nullptr;
+    uint32_t index = 0;
+    hailo_media_library_buffer buffer;
+    HailoBufferDataPtr buffer_data;
+    // Keeps the pool alive between the buffer recycle and the control block deallocation
+    MediaLibraryBufferPoolPtr pending_owner;
+    alignas(std::max_align_t) unsigned char control_block_storage[CONTROL_BLOCK_STORAGE_SIZE];
+
+    void recycle()
+    {
+        pending_owner = buffer.owner;
+        buffer.recycle();
+    }
+
+    void count_allocating_acquire()
+    {
+        pool->m_allocating_acquires++;
+    }
+
+    void release();
+};
+
+class BufferPoolRecords
+{
+  public:
+    explicit BufferPoolRecords(size_t count) : m_records(std::make_unique<BufferPoolRecord[]>(count)), m_free(count)
+    {
+    }
+
+    std::unique_ptr<BufferPoolRecord[]> m_records;
+    IndexFreeList m_free;
+};
+
+/**
+ * Places the shared_ptr control block of a pooled buffer in its record storage, so that handing out the buffer does
+ * not allocate. Falls back to the heap if the control block does not fit.
+ */
+template <typename T> struct BufferPoolRecordAllocator
+{
+    using value_type = T;
+    BufferPoolRecord *record;
+
+    explicit BufferPoolRecordAllocator(BufferPoolRecord *record) : record(record)
+    {
+    }
+    template <typename U> BufferPoolRecordAllocator(const BufferPoolRecordAllocator<U> &other) : record(other.record)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        if (n * sizeof(T) <= BufferPoolRecord::CONTROL_BLOCK_STORAGE_SIZE && alignof(T) <= alignof(std::max_align_t))
+        {
+            return reinterpret_cast<T *>(record->control_block_storage);
+        }
+        record->count_allocating_acquire();
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t)
+    {
+        if (reinterpret_cast<unsigned char *>(ptr) != record->control_block_storage)
+        {
+            ::operator delete(ptr);
+        }
+        record->release();
+    }
+
+    template <typename U> bool operator==(const BufferPoolRecordAllocator<U> &other) const
+    {
+        return record == other.record;
+    }
+    template <typename U> bool operator!=(const BufferPoolRecordAllocator<U> &other) const
+    {
+        return record != other.record;
+    }
+};
+
+struct BufferPoolRecordDeleter
+{
+    BufferPoolRecord *record;
+
+    void operator()(hailo_media_library_buffer *)
+    {
+        record->recycle();
+    }
+};
+
+void BufferPoolRecord::release()
+{
+    // The last reference to the pool may be the one held by this record, release it only after the record is back
+    MediaLibraryBufferPoolPtr owner = std::move(pending_owner);
+    pool->m_records->m_free.push(index);
+    pool->notify_buffer_released();
+}
+
 MediaLibraryBufferPool::MediaLibraryBufferPool(uint width, uint height, HailoFormat format, size_t max_buffers,
                                                HailoMemoryType memory_type, uint bytes_per_line, std::string owner_name)
-    : m_width(width), m_height(height), m_bytes_per_line(bytes_per_line), m_format(format), m_max_buffers(max_buffers)
+    : m_width(width), m_height(height), m_bytes_per_line(bytes_per_line), m_format(format), m_max_buffers(max_buffers),
+      m_memory_type(memory_type), m_contiguous_planes(false), m_arena_mode(false), m_device_only(false),
+      m_unmap_on_release(false), m_buffers_limit(max_buffers), m_init_duration(0)
 {
     m_buffer_index = 0;
+    m_pool_waiters = 0;
+    m_allocating_acquires = 0;
     m_name = "";
     if (m_name.empty())
     {
@@ -225,35 +585,60 @@ MediaLibraryBufferPool::MediaLibraryBufferPool(uint width, uint height, HailoFor
 
     LOGGER__MODULE__INFO(MODULE_NAME, "Creating buffer pool with name {}", m_name);
 
-    m_buffer_pool_mutex = std::make_shared<std::mutex>();
+    m_buffer_pool_mutex = std::make_shared<ProfiledMutex>("buffer_pool");
 
-    switch (format)
+    create_buckets();
+
+    m_records = std::make_unique<BufferPoolRecords>(max_buffers);
+    for (uint32_t i = 0; i < max_buffers; i++)
     {
-    case HAILO_FORMAT_NV12:
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * height, max_buffers, memory_type, m_name + "_y"));
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * (height / 2), max_buffers, memory_type, m_name + "_uv"));
-        break;
-    case HAILO_FORMAT_RGB:
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * height * 3, max_buffers, memory_type, m_name));
-        break;
-    case HAILO_FORMAT_GRAY8:
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * height, max_buffers, memory_type, m_name));
-        break;
-    case HAILO_FORMAT_GRAY12:
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * height * 1.5, max_buffers, memory_type, m_name));
-        break;
-    case HAILO_FORMAT_GRAY16:
-        m_buckets.emplace_back(
-            std::make_shared<HailoBucket>(bytes_per_line * height * 2, max_buffers, memory_type, m_name));
-        break;
-    default:
-        // TODO: error
-        break;
+        BufferPoolRecord &record = m_records->m_records[i];
+        record.pool = this;
+        record.index = i;
+        record.buffer_data = std::make_shared<hailo_buffer_data_t>(
+            (size_t)m_width, (size_t)m_height, m_planes_count, m_format, HAILO_MEMORY_TYPE_DMABUF,
+            std::vector<hailo_data_plane_t>(m_planes_count));
+        m_records->m_free.push(i);
+    }
+
+    DmaBudgetManager::get_instance().register_pool(this);
+}
+
+void MediaLibraryBufferPool::create_buckets()
+{
+    std::vector<size_t> planes_sizes = get_planes_sizes(m_height, m_format, m_bytes_per_line);
+    m_planes_count = planes_sizes.size();
+    m_plane_offsets.assign(m_planes_count, 0);
+    m_buckets.clear();
+
+    if (m_contiguous_planes)
+    {
+        size_t buffer_size = 0;
+        for (size_t i = 0; i < m_planes_count; i++)
+        {
+            m_plane_offsets[i] = buffer_size;
+            buffer_size += planes_sizes[i];
+        }
+        m_buckets.emplace_back(std::make_shared<HailoBucket>(buffer_size, m_max_buffers, m_memory_type, m_name));
+    }
+    else
+    {
+        for (size_t i = 0; i < m_planes_count; i++)
+        {
+            std::string bucket_name = m_name;
+            if (m_format == HAILO_FORMAT_NV12)
+                bucket_name += (i == 0) ? "_y" : "_uv";
+            m_buckets.emplace_back(
+                std::make_shared<HailoBucket>(planes_sizes[i], m_max_buffers, m_memory_type, bucket_name));
+        }
+    }
+
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        bucket->m_arena_mode = m_arena_mode;
+        bucket->m_device_only = m_device_only;
+        bucket->m_unmap_on_release = m_device_only && m_unmap_on_release;
+        bucket->m_buffers_limit = m_buffers_limit;
     }
 }
 
@@ -266,12 +651,16 @@ MediaLibraryBufferPool::MediaLibraryBufferPool(uint width, uint height, HailoFor
 MediaLibraryBufferPool::~MediaLibraryBufferPool()
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "Destroying buffer pool with name {}", m_name);
+    DmaBudgetManager::get_instance().unregister_pool(this);
     free();
 }
 
 media_library_return MediaLibraryBufferPool::wait_for_used_buffers(const std::chrono::milliseconds &timeout_ms)
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+    m_pool_waiters++;
+    // Pairs with the fence of notify_buffer_released()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     for (uint8_t i = 0; i < m_buckets.size(); i++)
     {
         HailoBucketPtr &bucket = m_buckets[i];
@@ -280,16 +669,20 @@ media_library_return MediaLibraryBufferPool::wait_for_used_buffers(const std::ch
 
         if (!m_pool_cv.wait_for(lock, timeout_ms, [&bucket]() { return bucket->used_buffers_count() == 0; }))
         {
+            m_pool_waiters--;
             LOGGER__MODULE__INFO(MODULE_NAME, "{}: Timeout waiting for used buffers to be released", m_name);
+            if (BufferTracker::get_instance().is_enabled())
+                LOGGER__MODULE__INFO(MODULE_NAME, "{}", BufferTracker::get_instance().dump(m_name));
             return MEDIA_LIBRARY_ERROR;
         }
     }
+    m_pool_waiters--;
     return MEDIA_LIBRARY_SUCCESS;
 }
 
 media_library_return MediaLibraryBufferPool::free(bool fail_on_used_buffers)
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Starting free operation, DMA free memory: {} MB", m_name,
                           DmaMemoryAllocator::get_instance().get_free_memory_mb());
 
@@ -301,9 +694,13 @@ media_library_return MediaLibraryBufferPool::free(bool fail_on_used_buffers)
         if (bucket->free(fail_on_used_buffers) != MEDIA_LIBRARY_SUCCESS)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "{}: failed to free bucket {}", m_name, i);
+            if (BufferTracker::get_instance().is_enabled())
+                LOGGER__MODULE__ERROR(MODULE_NAME, "{}", BufferTracker::get_instance().dump(m_name));
             return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
     }
+    if (BufferTracker::get_instance().is_enabled())
+        BufferTracker::get_instance().on_pool_freed(this);
 
     LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Finished free operation, DMA free memory: {} MB", m_name,
                           DmaMemoryAllocator::get_instance().get_free_memory_mb());
@@ -313,55 +710,113 @@ media_library_return MediaLibraryBufferPool::free(bool fail_on_used_buffers)
 
 media_library_return MediaLibraryBufferPool::init()
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
-    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Starting init operation, DMA free memory: {} MB", m_name,
-                          DmaMemoryAllocator::get_instance().get_free_memory_mb());
+    return init_pools(std::vector<MediaLibraryBufferPool *>{this});
+}
 
-    for (HailoBucketPtr &bucket : m_buckets)
+media_library_return MediaLibraryBufferPool::init_pools(const std::vector<MediaLibraryBufferPoolPtr> &pools)
+{
+    std::vector<MediaLibraryBufferPool *> raw_pools;
+    for (const MediaLibraryBufferPoolPtr &pool : pools)
     {
-        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: allocating bucket of size {} num of buffers {}", m_name,
-                              bucket->m_buffer_size, bucket->m_num_buffers);
-        if (bucket->allocate() != MEDIA_LIBRARY_SUCCESS)
+        raw_pools.push_back(pool.get());
+    }
+    return init_pools(raw_pools);
+}
+
+media_library_return MediaLibraryBufferPool::init_pools(std::vector<MediaLibraryBufferPool *> pools)
+{
+    // Lock in address order, so that concurrent callers with overlapping pools can not deadlock
+    std::sort(pools.begin(), pools.end());
+    pools.erase(std::unique(pools.begin(), pools.end()), pools.end());
+    std::vector<std::unique_lock<ProfiledMutex>> locks;
+    std::vector<std::pair<MediaLibraryBufferPool *, HailoBucket *>> allocations;
+    for (MediaLibraryBufferPool *pool : pools)
+    {
+        locks.emplace_back(*pool->m_buffer_pool_mutex);
+        pool->m_init_duration = std::chrono::microseconds(0);
+        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Starting init operation, DMA free memory: {} MB", pool->m_name,
+                              DmaMemoryAllocator::get_instance().get_free_memory_mb());
+        for (HailoBucketPtr &bucket : pool->m_buckets)
         {
-            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: failed to allocate bucket", m_name);
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+            LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: allocating bucket of size {} num of buffers {}", pool->m_name,
+                                  bucket->m_buffer_size, bucket->m_num_buffers);
+            allocations.emplace_back(pool, bucket.get());
         }
     }
 
-    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Finished init operation, DMA free memory: {} MB", m_name,
-                          DmaMemoryAllocator::get_instance().get_free_memory_mb());
+    // Each bucket is allocated by its own task - the dma-heap allocation and the populating mmap of one buffer do
+    // not block the others, so the init time follows the largest bucket rather than the sum of them all
+    auto start_time = std::chrono::steady_clock::now();
+    auto allocate_bucket = [start_time](HailoBucket *bucket) {
+        media_library_return result = bucket->allocate();
+        auto duration = std::chrono::steady_clock::now() - start_time;
+        return std::make_pair(result, std::chrono::duration_cast<std::chrono::microseconds>(duration));
+    };
+    std::vector<std::pair<media_library_return, std::chrono::microseconds>> results;
+    if (allocations.size() == 1)
+    {
+        results.push_back(allocate_bucket(allocations[0].second));
+    }
+    else if (allocations.size() > 1)
+    {
+        ThreadPool allocation_threads(std::min(allocations.size(), MAX_ALLOCATION_THREADS), "medialib_alloc");
+        std::vector<std::future<std::pair<media_library_return, std::chrono::microseconds>>> futures;
+        for (auto &[pool, bucket] : allocations)
+        {
+            futures.push_back(allocation_threads.enqueue(allocate_bucket, bucket));
+        }
+        for (auto &future : futures)
+        {
+            results.push_back(future.get());
+        }
+    }
 
-    return MEDIA_LIBRARY_SUCCESS;
+    media_library_return ret = MEDIA_LIBRARY_SUCCESS;
+    for (size_t i = 0; i < allocations.size(); i++)
+    {
+        MediaLibraryBufferPool *pool = allocations[i].first;
+        pool->m_init_duration = std::max(pool->m_init_duration, results[i].second);
+        if (results[i].first != MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: failed to allocate bucket", pool->m_name);
+            ret = MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+        }
+    }
+
+    for (MediaLibraryBufferPool *pool : pools)
+    {
+        LOGGER__MODULE__INFO(MODULE_NAME, "{}: Allocated {} bytes in {} us", pool->m_name,
+                             pool->get_allocated_bytes(), pool->m_init_duration.count());
+        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Finished init operation, DMA free memory: {} MB", pool->m_name,
+                              DmaMemoryAllocator::get_instance().get_free_memory_mb());
+    }
+
+    return ret;
 }
 
 media_library_return MediaLibraryBufferPool::for_each_buffer(std::function<bool(int, size_t)> func)
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
 
     for (HailoBucketPtr &bucket : m_buckets)
     {
-        std::unique_lock<std::mutex> bucket_lock(*bucket->m_bucket_mutex);
-        for (intptr_t buffer_ptr : bucket->m_available_buffers)
+        std::unique_lock<ProfiledMutex> bucket_lock(*bucket->m_bucket_mutex);
+        // All the buffers of an arena share its dmabuf, report it once
+        if (bucket->m_arena_mode)
         {
-            int fd;
-            if (DmaMemoryAllocator::get_instance().get_fd((void *)buffer_ptr, fd) != MEDIA_LIBRARY_SUCCESS)
-            {
-                return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
-            }
-
-            if (!func(fd, bucket->m_buffer_size))
+            if (bucket->m_arena != nullptr &&
+                !func(bucket->m_slots[0].buffer_fd, page_align(bucket->m_buffer_size) * bucket->m_num_buffers))
             {
                 return MEDIA_LIBRARY_ERROR;
             }
+            continue;
         }
 
-        for (intptr_t buffer_ptr : bucket->m_used_buffers)
+        for (uint32_t i = 0; i < bucket->m_num_buffers; i++)
         {
-            int fd;
-            if (DmaMemoryAllocator::get_instance().get_fd((void *)buffer_ptr, fd) != MEDIA_LIBRARY_SUCCESS)
-            {
-                return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
-            }
+            int fd = bucket->m_slots[i].buffer_fd;
+            if (fd == -1)
+                continue;
 
             if (!func(fd, bucket->m_buffer_size))
             {
@@ -373,9 +828,80 @@ media_library_return MediaLibraryBufferPool::for_each_buffer(std::function<bool(
     return MEDIA_LIBRARY_SUCCESS;
 }
 
+media_library_return MediaLibraryBufferPool::set_arena_mode(bool arena_mode)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        std::unique_lock<ProfiledMutex> bucket_lock(*bucket->m_bucket_mutex);
+        if (bucket->m_allocated_buffers.load() > 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Arena mode can only be changed before init", m_name);
+            return MEDIA_LIBRARY_ERROR;
+        }
+    }
+
+    m_arena_mode = arena_mode;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        bucket->m_arena_mode = arena_mode;
+    }
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return MediaLibraryBufferPool::set_device_only(bool device_only, bool unmap_on_release)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        std::unique_lock<ProfiledMutex> bucket_lock(*bucket->m_bucket_mutex);
+        if (bucket->m_allocated_buffers.load() > 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Device only mode can only be changed before init", m_name);
+            return MEDIA_LIBRARY_ERROR;
+        }
+    }
+
+    m_device_only = device_only;
+    m_unmap_on_release = unmap_on_release;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        bucket->m_device_only = device_only;
+        bucket->m_unmap_on_release = device_only && unmap_on_release;
+    }
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return MediaLibraryBufferPool::set_contiguous_planes(bool contiguous_planes)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        std::unique_lock<ProfiledMutex> bucket_lock(*bucket->m_bucket_mutex);
+        if (bucket->m_allocated_buffers.load() > 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Contiguous planes can only be changed before init", m_name);
+            return MEDIA_LIBRARY_ERROR;
+        }
+    }
+
+    if (m_contiguous_planes != contiguous_planes)
+    {
+        m_contiguous_planes = contiguous_planes;
+        create_buckets();
+    }
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
 media_library_return MediaLibraryBufferPool::swap_width_and_height()
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
 
     uint temp = m_width;
     m_width = m_height;
@@ -384,248 +910,416 @@ media_library_return MediaLibraryBufferPool::swap_width_and_height()
     return MEDIA_LIBRARY_SUCCESS;
 }
 
-media_library_return MediaLibraryBufferPool::acquire_buffer(HailoMediaLibraryBufferPtr buffer)
+media_library_return MediaLibraryBufferPool::fill_planes_layout(hailo_data_plane_t *planes)
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
-    m_buffer_index++;
-    if (m_buffer_index > m_max_buffers)
-        m_buffer_index = 1;
-    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Acquiring buffer number {}", m_name, m_buffer_index);
-    media_library_return ret = MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     switch (m_format)
     {
-    case HAILO_FORMAT_NV12: {
-        size_t y_channel_stride = m_bytes_per_line;
-        size_t y_channel_size = y_channel_stride * m_height;
-        size_t uv_channel_stride = m_bytes_per_line;
-        size_t uv_channel_size = uv_channel_stride * m_height / 2;
-        intptr_t y_channel_ptr;
+    case HAILO_FORMAT_NV12:
+        planes[0].bytesperline = m_bytes_per_line;
+        planes[0].bytesused = m_bytes_per_line * m_height;
+        planes[1].bytesperline = m_bytes_per_line;
+        planes[1].bytesused = m_bytes_per_line * m_height / 2;
+        break;
+    case HAILO_FORMAT_RGB:
+        planes[0].bytesperline = m_bytes_per_line * 3;
+        planes[0].bytesused = planes[0].bytesperline * m_height;
+        break;
+    case HAILO_FORMAT_GRAY8:
+        planes[0].bytesperline = m_bytes_per_line;
+        planes[0].bytesused = planes[0].bytesperline * m_height;
+        break;
+    case HAILO_FORMAT_GRAY12:
+        planes[0].bytesperline = m_bytes_per_line * 1.5;
+        planes[0].bytesused = planes[0].bytesperline * m_height;
+        break;
+    case HAILO_FORMAT_GRAY16:
+        planes[0].bytesperline = m_bytes_per_line * 2;
+        planes[0].bytesused = planes[0].bytesperline * m_height;
+        break;
+    default:
+        // TODO: error
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
 
-        ret = m_buckets[0]->acquire(&y_channel_ptr);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return MediaLibraryBufferPool::acquire_planes(hailo_data_plane_t *planes, uint64_t *handles)
+{
+    for (uint32_t i = 0; i < m_buckets.size(); i++)
+    {
+        intptr_t plane_ptr;
+        int plane_fd;
+        size_t plane_offset;
+        if (m_buckets[i]->acquire(&plane_ptr, &plane_fd, &plane_offset, &handles[i]) != MEDIA_LIBRARY_SUCCESS)
         {
-            // GST_ERROR_OBJECT(pool, "Failed to create buffer with status code %d", result);
+            // Roll back the planes that were already acquired
+            for (uint32_t j = 0; j < i; j++)
+            {
+                m_buckets[j]->release(handles[j]);
+            }
             return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
 
-        hailo_data_plane_t y_plane_data;
-        y_plane_data.bytesperline = y_channel_stride;
-        y_plane_data.bytesused = y_channel_size;
-
-        int y_channel_fd;
-        ret = DmaMemoryAllocator::get_instance().get_fd((void *)y_channel_ptr, y_channel_fd);
+        planes[i].userptr = (void *)plane_ptr;
+        planes[i].fd = plane_fd;
+        planes[i].offset = plane_offset;
+    }
 
-        y_plane_data.userptr = (void *)y_channel_ptr;
-        if (ret == MEDIA_LIBRARY_SUCCESS)
+    // All the planes were acquired as a single buffer of the first bucket, carve them out of it
+    if (m_contiguous_planes)
+    {
+        for (uint32_t i = 1; i < m_planes_count; i++)
         {
-            y_plane_data.fd = y_channel_fd;
-        }
-        else
-        {
-            LOGGER__MODULE__ERROR(MODULE_NAME, "CMA memory not supported");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+            // Planes of device only buffers are mapped on first access
+            planes[i].userptr =
+                planes[0].userptr ? static_cast<uint8_t *>(planes[0].userptr) + m_plane_offsets[i] : nullptr;
+            planes[i].fd = planes[0].fd;
+            planes[i].offset = planes[0].offset + m_plane_offsets[i];
+            handles[i] = MEDIA_LIBRARY_BUFFER_POOL_INVALID_HANDLE;
         }
+    }
 
-        // Gather uv channel info
-        intptr_t uv_channel_ptr;
-        ret = m_buckets[1]->acquire(&uv_channel_ptr);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
-        {
-            // log Failed to create buffer with status code
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-        }
+    return MEDIA_LIBRARY_SUCCESS;
+}
 
-        hailo_data_plane_t uv_plane_data;
-        uv_plane_data.bytesperline = uv_channel_stride;
-        uv_plane_data.bytesused = uv_channel_size;
+uint32_t MediaLibraryBufferPool::next_buffer_index()
+{
+    uint32_t buffer_index = m_buffer_index.load(std::memory_order_relaxed);
+    uint32_t next_buffer_index;
+    do
+    {
+        next_buffer_index = (buffer_index >= m_max_buffers) ? 1 : buffer_index + 1;
+    } while (!m_buffer_index.compare_exchange_weak(buffer_index, next_buffer_index, std::memory_order_relaxed));
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Acquiring buffer number {}", m_name, next_buffer_index);
+    return next_buffer_index;
+}
 
-        int uv_channel_fd;
-        ret = DmaMemoryAllocator::get_instance().get_fd((void *)uv_channel_ptr, uv_channel_fd);
+media_library_return MediaLibraryBufferPool::try_acquire_buffer(HailoMediaLibraryBufferPtr buffer)
+{
+    uint32_t buffer_index = next_buffer_index();
 
-        HailoMemoryType memory_type;
-        uv_plane_data.userptr = (void *)uv_channel_ptr;
-        if (ret == MEDIA_LIBRARY_SUCCESS)
-        {
-            uv_plane_data.fd = uv_channel_fd;
-            memory_type = HAILO_MEMORY_TYPE_DMABUF;
-        }
-        else
+    std::vector<hailo_data_plane_t> planes(m_planes_count);
+    uint64_t handles[MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES];
+    if (fill_planes_layout(planes.data()) != MEDIA_LIBRARY_SUCCESS ||
+        acquire_planes(planes.data(), handles) != MEDIA_LIBRARY_SUCCESS)
+    {
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    // Fill in buffer_data values
+    size_t planes_count = planes.size();
+    HailoBufferDataPtr buffer_data = std::make_shared<hailo_buffer_data_t>(
+        (size_t)m_width, (size_t)m_height, planes_count, m_format, HAILO_MEMORY_TYPE_DMABUF, std::move(planes));
+    m_allocating_acquires++;
+
+    media_library_return ret = buffer->create(shared_from_this(), buffer_data);
+    if (ret != MEDIA_LIBRARY_SUCCESS)
+    {
+        for (uint32_t i = 0; i < m_buckets.size(); i++)
         {
-            memory_type = HAILO_MEMORY_TYPE_CMA;
-            LOGGER__MODULE__ERROR(MODULE_NAME, "CMA memory not supported");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+            m_buckets[i]->release(handles[i]);
         }
+        return ret;
+    }
+    for (uint32_t i = 0; i < planes_count; i++)
+    {
+        buffer->m_pool_plane_handles[i] = handles[i];
+    }
+    buffer->set_buffer_index(buffer_index);
+    if (BufferTracker::get_instance().is_enabled())
+        BufferTracker::get_instance().on_acquire(this, m_name, handles[0]);
 
-        LOGGER__MODULE__DEBUG(MODULE_NAME,
-                              "{}: Buffers acquired: buffer for y_channel (size = {}), and "
-                              "uv_channel (size = {})",
-                              m_name, y_channel_size, uv_channel_size);
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Buffer of format {} width {} height {} acquired", m_name, m_format,
+                          buffer->buffer_data->width, buffer->buffer_data->height);
+    return MEDIA_LIBRARY_SUCCESS;
+}
 
-        // Fill in buffer_data values
-        HailoBufferDataPtr buffer_data = std::make_shared<hailo_buffer_data_t>(
-            (size_t)m_width, (size_t)m_height, (size_t)2, HAILO_FORMAT_NV12, memory_type,
-            std::vector<hailo_data_plane_t>{y_plane_data, uv_plane_data});
+tl::expected<HailoMediaLibraryBufferPtr, media_library_return> MediaLibraryBufferPool::try_acquire_pooled_buffer()
+{
+    uint32_t record_index = m_records->m_free.pop();
+    if (record_index == IndexFreeList::INVALID_INDEX)
+    {
+        return tl::make_unexpected(MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR);
+    }
+    BufferPoolRecord &record = m_records->m_records[record_index];
 
-        ret = buffer->create(shared_from_this(), buffer_data);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
-            return ret;
-        buffer->set_buffer_index(m_buffer_index);
-        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: NV12 Buffer width {} height {} acquired", m_name,
-                              buffer->buffer_data->width, buffer->buffer_data->height);
-        break;
+    // A previous holder may still reference the buffer data of this record - never overwrite it under its feet
+    if (record.buffer_data.use_count() > 1)
+    {
+        record.buffer_data = std::make_shared<hailo_buffer_data_t>(
+            (size_t)m_width, (size_t)m_height, m_planes_count, m_format, HAILO_MEMORY_TYPE_DMABUF,
+            std::vector<hailo_data_plane_t>(m_planes_count));
+        m_allocating_acquires++;
     }
-    case HAILO_FORMAT_RGB: {
-        size_t rgb_stride = m_bytes_per_line * 3;
-        size_t rgb_size = rgb_stride * m_height;
-        intptr_t rgb_ptr;
+    hailo_buffer_data_t &buffer_data = *record.buffer_data;
+    buffer_data.width = m_width;
+    buffer_data.height = m_height;
 
-        ret = m_buckets[0]->acquire(&rgb_ptr);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
+    uint64_t handles[MEDIA_LIBRARY_BUFFER_POOL_MAX_PLANES];
+    if (fill_planes_layout(buffer_data.planes.data()) != MEDIA_LIBRARY_SUCCESS ||
+        acquire_planes(buffer_data.planes.data(), handles) != MEDIA_LIBRARY_SUCCESS)
+    {
+        m_records->m_free.push(record_index);
+        return tl::make_unexpected(MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR);
+    }
+
+    uint32_t buffer_index = next_buffer_index();
+    record.buffer.create(shared_from_this(), record.buffer_data);
+    for (uint32_t i = 0; i < m_planes_count; i++)
+    {
+        record.buffer.m_pool_plane_handles[i] = handles[i];
+    }
+    record.buffer.set_buffer_index(buffer_index);
+    if (BufferTracker::get_instance().is_enabled())
+        BufferTracker::get_instance().on_acquire(this, m_name, handles[0]);
+
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: Pooled buffer {} of format {} width {} height {} acquired", m_name,
+                          record_index, m_format, buffer_data.width, buffer_data.height);
+    return HailoMediaLibraryBufferPtr(&record.buffer, BufferPoolRecordDeleter{&record},
+                                      BufferPoolRecordAllocator<hailo_media_library_buffer>(&record));
+}
+
+media_library_return MediaLibraryBufferPool::acquire_buffer(HailoMediaLibraryBufferPtr buffer)
+{
+    if (try_acquire_buffer(buffer) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME,
+                              "{}: Buffer acquire failed - no available buffers remaining, "
+                              "please validate the max buffers size you set ({})",
+                              m_name, m_max_buffers);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return MediaLibraryBufferPool::acquire_buffer(HailoMediaLibraryBufferPtr buffer,
+                                                            const std::chrono::milliseconds &timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout_ms;
+    while (try_acquire_buffer(buffer) != MEDIA_LIBRARY_SUCCESS)
+    {
+        std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+        m_pool_waiters++;
+        // Pairs with the fence of notify_buffer_released()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool available = m_pool_cv.wait_until(lock, deadline, [this]() {
+            for (HailoBucketPtr &bucket : m_buckets)
+            {
+                if (bucket->available_buffers_count() == 0)
+                    return false;
+            }
+            return true;
+        });
+        m_pool_waiters--;
+
+        if (!available)
         {
+            LOGGER__MODULE__ERROR(MODULE_NAME,
+                                  "{}: Buffer acquire failed - no buffer was released within {} ms, "
+                                  "please validate the max buffers size you set ({})",
+                                  m_name, timeout_ms.count(), m_max_buffers);
             return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
+    }
 
-        hailo_data_plane_t plane_data;
-        plane_data.bytesperline = rgb_stride;
-        plane_data.bytesused = rgb_size;
+    return MEDIA_LIBRARY_SUCCESS;
+}
 
-        int rgb_fd;
-        ret = DmaMemoryAllocator::get_instance().get_fd((void *)rgb_ptr, rgb_fd);
+bool MediaLibraryBufferPool::buffers_available()
+{
+    if (m_records->m_free.empty())
+        return false;
 
-        HailoMemoryType memory_type;
-        plane_data.userptr = (void *)rgb_ptr;
-        if (ret == MEDIA_LIBRARY_SUCCESS)
-        {
-            plane_data.fd = rgb_fd;
-            memory_type = HAILO_MEMORY_TYPE_DMABUF;
-        }
-        else
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        if (bucket->available_buffers_count() == 0)
+            return false;
+    }
+    return true;
+}
+
+tl::expected<HailoMediaLibraryBufferPtr, media_library_return> MediaLibraryBufferPool::acquire_buffer()
+{
+    auto buffer = try_acquire_pooled_buffer();
+    if (!buffer.has_value())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME,
+                              "{}: Buffer acquire failed - no available buffers remaining, "
+                              "please validate the max buffers size you set ({})",
+                              m_name, m_max_buffers);
+    }
+
+    return buffer;
+}
+
+tl::expected<HailoMediaLibraryBufferPtr, media_library_return> MediaLibraryBufferPool::acquire_buffer(
+    const std::chrono::milliseconds &timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout_ms;
+    auto buffer = try_acquire_pooled_buffer();
+    while (!buffer.has_value())
+    {
+        std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+        m_pool_waiters++;
+        // Pairs with the fence of notify_buffer_released()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool available = m_pool_cv.wait_until(lock, deadline, [this]() { return buffers_available(); });
+        m_pool_waiters--;
+        lock.unlock();
+
+        if (!available)
         {
-            memory_type = HAILO_MEMORY_TYPE_CMA;
-            LOGGER__MODULE__ERROR(MODULE_NAME, "CMA memory not supported");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+            LOGGER__MODULE__ERROR(MODULE_NAME,
+                                  "{}: Buffer acquire failed - no buffer was released within {} ms, "
+                                  "please validate the max buffers size you set ({})",
+                                  m_name, timeout_ms.count(), m_max_buffers);
+            return buffer;
         }
+        buffer = try_acquire_pooled_buffer();
+    }
 
-        // Fill in buffer_data values
-        HailoBufferDataPtr buffer_data =
-            std::make_shared<hailo_buffer_data_t>((size_t)m_width, (size_t)m_height, (size_t)1, HAILO_FORMAT_RGB,
-                                                  memory_type, std::vector<hailo_data_plane_t>{plane_data});
+    return buffer;
+}
 
-        ret = buffer->create(shared_from_this(), buffer_data);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
-            return ret;
-        buffer->set_buffer_index(m_buffer_index);
+int HailoBucket::available_buffers_count()
+{
+    return m_allocated_buffers.load() - m_used_buffers.load();
+}
 
-        LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: RGB Buffer width {} height {} acquired", m_name,
-                              buffer->buffer_data->width, buffer->buffer_data->height);
-        break;
-    }
+int HailoBucket::used_buffers_count()
+{
+    return m_used_buffers.load();
+}
+
+std::vector<size_t> MediaLibraryBufferPool::get_planes_sizes(uint height, HailoFormat format, uint bytes_per_line)
+{
+    switch (format)
+    {
+    case HAILO_FORMAT_NV12:
+        return {(size_t)bytes_per_line * height, (size_t)bytes_per_line * (height / 2)};
+    case HAILO_FORMAT_RGB:
+        return {(size_t)bytes_per_line * height * 3};
     case HAILO_FORMAT_GRAY8:
+        return {(size_t)bytes_per_line * height};
     case HAILO_FORMAT_GRAY12:
-    case HAILO_FORMAT_GRAY16: {
-        size_t image_stride;
-        if (m_format == HAILO_FORMAT_GRAY8)
-        {
-            image_stride = m_bytes_per_line;
-        }
-        else if (m_format == HAILO_FORMAT_GRAY12)
-        {
-            image_stride = m_bytes_per_line * 1.5;
-        }
-        else
-        {
-            image_stride = m_bytes_per_line * 2;
-        }
-        size_t image_size = image_stride * m_height;
-        intptr_t data_ptr;
+        return {(size_t)(bytes_per_line * height * 1.5)};
+    case HAILO_FORMAT_GRAY16:
+        return {(size_t)bytes_per_line * height * 2};
+    default:
+        // TODO: error
+        return {};
+    }
+}
 
-        ret = m_buckets[0]->acquire(&data_ptr);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
-        {
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-        }
+size_t MediaLibraryBufferPool::get_dma_footprint(uint height, HailoFormat format, size_t max_buffers,
+                                                 uint bytes_per_line)
+{
+    size_t buffer_bytes = 0;
+    for (size_t plane_size : get_planes_sizes(height, format, bytes_per_line))
+    {
+        buffer_bytes += page_align(plane_size);
+    }
+    return buffer_bytes * max_buffers;
+}
 
-        hailo_data_plane_t plane_data;
-        plane_data.bytesperline = image_stride;
-        plane_data.bytesused = image_size;
+size_t MediaLibraryBufferPool::get_allocated_bytes()
+{
+    size_t allocated_bytes = 0;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        allocated_bytes += page_align(bucket->m_buffer_size) * bucket->m_allocated_buffers.load();
+    }
+    return allocated_bytes;
+}
 
-        int channel_fd;
-        ret = DmaMemoryAllocator::get_instance().get_fd((void *)data_ptr, channel_fd);
+size_t MediaLibraryBufferPool::get_used_buffers_high_water_mark()
+{
+    size_t high_water_mark = 0;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        high_water_mark = std::max(high_water_mark, bucket->m_used_high_water_mark.load());
+    }
+    return high_water_mark;
+}
 
-        HailoMemoryType memory_type = HAILO_MEMORY_TYPE_DMABUF;
-        plane_data.userptr = (void *)data_ptr;
-        if (ret == MEDIA_LIBRARY_SUCCESS)
-        {
-            plane_data.fd = channel_fd;
-            memory_type = HAILO_MEMORY_TYPE_DMABUF;
-        }
-        else
-        {
-            memory_type = HAILO_MEMORY_TYPE_CMA;
-            LOGGER__MODULE__ERROR(MODULE_NAME, "CMA memory not supported");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-        }
+void MediaLibraryBufferPool::reset_used_buffers_high_water_mark()
+{
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        bucket->m_used_high_water_mark = bucket->m_used_buffers.load();
+    }
+}
 
-        // Fill in buffer_data values
-        HailoBufferDataPtr buffer_data;
-        if (m_format == HAILO_FORMAT_GRAY8)
-        {
-            buffer_data =
-                std::make_shared<hailo_buffer_data_t>((size_t)m_width, (size_t)m_height, (size_t)1, HAILO_FORMAT_GRAY8,
-                                                      memory_type, std::vector<hailo_data_plane_t>{plane_data});
-        }
-        else if (m_format == HAILO_FORMAT_GRAY12)
-        {
-            buffer_data =
-                std::make_shared<hailo_buffer_data_t>((size_t)m_width, (size_t)m_height, (size_t)1, HAILO_FORMAT_GRAY12,
-                                                      memory_type, std::vector<hailo_data_plane_t>{plane_data});
-        }
-        else
-        {
-            buffer_data =
-                std::make_shared<hailo_buffer_data_t>((size_t)m_width, (size_t)m_height, (size_t)1, HAILO_FORMAT_GRAY16,
-                                                      memory_type, std::vector<hailo_data_plane_t>{plane_data});
-        }
+media_library_return MediaLibraryBufferPool::set_buffers_limit(size_t buffers_limit)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+    if (buffers_limit == 0 || buffers_limit > m_max_buffers)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Buffers limit {} is out of range 1-{}", m_name, buffers_limit,
+                              m_max_buffers);
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+    if (m_arena_mode)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: The buffers of an arena can not be limited", m_name);
+        return MEDIA_LIBRARY_ERROR;
+    }
 
-        ret = buffer->create(shared_from_this(), buffer_data);
-        if (ret != MEDIA_LIBRARY_SUCCESS)
-            return ret;
+    m_buffers_limit = buffers_limit;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        bucket->m_buffers_limit = buffers_limit;
+    }
+    return MEDIA_LIBRARY_SUCCESS;
+}
 
-        if (m_format == HAILO_FORMAT_GRAY8)
-        {
-            LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: GRAY8 Buffer width {} height {} acquired", m_name,
-                                  buffer->buffer_data->width, buffer->buffer_data->height);
-        }
-        else if (m_format == HAILO_FORMAT_GRAY12)
-        {
-            LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: GRAY12 Buffer width {} height {} acquired", m_name,
-                                  buffer->buffer_data->width, buffer->buffer_data->height);
-        }
-        else
+media_library_return MediaLibraryBufferPool::reserve(size_t buffers)
+{
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+    if (buffers > m_buffers_limit)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Can not reserve {} buffers, above the limit of {}", m_name, buffers,
+                              m_buffers_limit);
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        while (bucket->m_allocated_buffers.load() < buffers)
         {
-            LOGGER__MODULE__DEBUG(MODULE_NAME, "{}: GRAY16 Buffer width {} height {} acquired", m_name,
-                                  buffer->buffer_data->width, buffer->buffer_data->height);
+            if (bucket->grow() != MEDIA_LIBRARY_SUCCESS)
+            {
+                LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to reserve {} buffers", m_name, buffers);
+                return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+            }
         }
-        break;
     }
-    default: {
-        // TODO: error
-        break;
-    }
-    }
-    return ret;
+    return MEDIA_LIBRARY_SUCCESS;
 }
 
-int HailoBucket::available_buffers_count()
+size_t MediaLibraryBufferPool::get_buffers_limit()
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
-    return m_available_buffers.size();
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+    return m_buffers_limit;
 }
 
-int HailoBucket::used_buffers_count()
+size_t MediaLibraryBufferPool::shrink(size_t min_buffers)
 {
-    std::unique_lock<std::mutex> lock(*m_bucket_mutex);
-    return m_used_buffers.size();
+    std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+    size_t freed_bytes = 0;
+    for (HailoBucketPtr &bucket : m_buckets)
+    {
+        freed_bytes += bucket->shrink(min_buffers);
+    }
+
+    if (freed_bytes > 0)
+    {
+        LOGGER__MODULE__INFO(MODULE_NAME, "{}: Shrunk to {} buffers, freed {} bytes", m_name, min_buffers,
+                             freed_bytes);
+    }
+    return freed_bytes;
 }
 
 int MediaLibraryBufferPool::get_available_buffers_count()
@@ -633,36 +1327,61 @@ int MediaLibraryBufferPool::get_available_buffers_count()
     return m_buckets[0]->available_buffers_count();
 }
 
+void MediaLibraryBufferPool::notify_buffer_released()
+{
+    // Waiters check the pool state under the pool mutex - take it before notifying so the wakeup is not lost.
+    // When nobody is waiting the release path stays lock-free. A waiter registers in m_pool_waiters before checking
+    // the free lists, and the release has published the buffer before reading m_pool_waiters - the seq_cst fences on
+    // both sides make sure that either the waiter sees the buffer or the release sees the waiter.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_pool_waiters.load(std::memory_order_relaxed) > 0)
+    {
+        {
+            std::unique_lock<ProfiledMutex> lock(*m_buffer_pool_mutex);
+        }
+        m_pool_cv.notify_all();
+    }
+}
+
 media_library_return MediaLibraryBufferPool::release_plane(hailo_media_library_buffer *buffer, uint32_t plane_index)
 {
-    auto bucket = m_buckets[plane_index];
+    if (plane_index >= m_planes_count)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Invalid plane index {}", m_name, plane_index);
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+
+    auto &bucket = m_buckets[m_contiguous_planes ? 0 : plane_index];
     LOGGER__MODULE__DEBUG(
         MODULE_NAME,
         "{}: Releasing plane {} of buffer with index {} of bucket of size {} num buffers {} used buffers {}", m_name,
         plane_index, buffer->buffer_index, bucket->m_buffer_size, bucket->m_num_buffers,
-        bucket->m_used_buffers.size() - 1);
+        bucket->used_buffers_count() - 1);
 
-    if (buffer->is_dmabuf())
+    uint64_t handle = buffer->m_pool_plane_handles[plane_index];
+    if (handle == MEDIA_LIBRARY_BUFFER_POOL_INVALID_HANDLE)
     {
-        return bucket->release((intptr_t)buffer->get_plane_ptr(plane_index));
+        return MEDIA_LIBRARY_SUCCESS;
     }
+    buffer->m_pool_plane_handles[plane_index] = MEDIA_LIBRARY_BUFFER_POOL_INVALID_HANDLE;
+    // The first plane identifies the buffer for the tracker
+    if (plane_index == 0 && BufferTracker::get_instance().is_enabled())
+        BufferTracker::get_instance().on_release(this, handle);
 
-    return bucket->release((intptr_t)buffer->buffer_data->planes[plane_index].userptr);
+    media_library_return ret = bucket->release(handle);
+    notify_buffer_released();
+    return ret;
 }
 
 media_library_return MediaLibraryBufferPool::release_buffer(HailoMediaLibraryBufferPtr buffer)
 {
-    std::unique_lock<std::mutex> lock(*m_buffer_pool_mutex);
-    for (uint32_t i = 0; i < m_buckets.size(); i++)
+    for (uint32_t i = 0; i < m_planes_count; i++)
     {
-        if (m_buckets[i]->m_used_buffers.size() > 0)
+        media_library_return ret = release_plane(buffer.get(), i);
+        if (ret != MEDIA_LIBRARY_SUCCESS)
         {
-            media_library_return ret = release_plane(buffer.get(), i);
-            if (ret != MEDIA_LIBRARY_SUCCESS)
-            {
-                LOGGER__MODULE__ERROR(MODULE_NAME, "{}: failed to release plane number {}", m_name, i);
-                return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-            }
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: failed to release plane number {}", m_name, i);
+            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
         }
     }
 
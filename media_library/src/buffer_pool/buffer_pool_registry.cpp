@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "buffer_pool_registry.hpp"
+#include "media_library_logger.hpp"
+#include <algorithm>
+#include <iterator>
+
+#define MODULE_NAME LoggerType::BufferPool
+
+/**
+ * Control block of a leased pool pointer - returns the leased depth to the registry when the last copy of the pointer
+ * handed to the consumer is released
+ */
+class BufferPoolLease
+{
+  public:
+    buffer_pool_key_t m_key;
+    size_t m_depth;
+    MediaLibraryBufferPoolPtr m_pool;
+
+    BufferPoolLease(const buffer_pool_key_t &key, size_t depth, MediaLibraryBufferPoolPtr pool)
+        : m_key(key), m_depth(depth), m_pool(pool)
+    {
+    }
+
+    ~BufferPoolLease()
+    {
+        BufferPoolRegistry::get_instance().return_lease(m_key, m_depth);
+    }
+};
+
+BufferPoolRegistry::BufferPoolRegistry()
+    : m_registry_mutex(std::make_shared<std::mutex>()), m_shared_pool_capacity(DEFAULT_SHARED_POOL_CAPACITY)
+{
+}
+
+void BufferPoolRegistry::set_shared_pool_capacity(size_t capacity)
+{
+    std::unique_lock<std::mutex> lock(*m_registry_mutex);
+    m_shared_pool_capacity = capacity;
+}
+
+size_t BufferPoolRegistry::get_in_flight_depth(const std::multiset<size_t> &lease_depths)
+{
+    if (lease_depths.empty())
+        return 0;
+
+    // The deepest lease is counted in full, every other lease adds half of its depth rounded up
+    auto deepest = std::prev(lease_depths.end());
+    size_t depth = *deepest;
+    for (auto it = lease_depths.begin(); it != deepest; it++)
+    {
+        depth += (*it + 1) / 2;
+    }
+    return depth;
+}
+
+tl::expected<MediaLibraryBufferPoolPtr, media_library_return> BufferPoolRegistry::lease(const buffer_pool_key_t &key,
+                                                                                        size_t depth,
+                                                                                        const std::string &consumer)
+{
+    if (depth == 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Can not lease a pool with no buffers", consumer);
+        return tl::make_unexpected(MEDIA_LIBRARY_INVALID_ARGUMENT);
+    }
+
+    std::unique_lock<std::mutex> lock(*m_registry_mutex);
+    auto it = m_pools.find(key);
+    if (it == m_pools.end())
+    {
+        // Slots are cheap, only the in-flight depth of the leases is allocated
+        size_t capacity = std::max(m_shared_pool_capacity, depth);
+        MediaLibraryBufferPoolPtr pool =
+            std::make_shared<MediaLibraryBufferPool>(key.width, key.height, key.format, capacity, key.memory_type,
+                                                     key.bytes_per_line, "shared_" + consumer);
+        if (pool->set_buffers_limit(depth) != MEDIA_LIBRARY_SUCCESS || pool->init() != MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to init shared pool", consumer);
+            return tl::make_unexpected(MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR);
+        }
+        it = m_pools.emplace(key, SharedPool{pool, 0, 0, {}}).first;
+    }
+    else
+    {
+        SharedPool &shared_pool = it->second;
+        std::multiset<size_t> lease_depths = shared_pool.lease_depths;
+        lease_depths.insert(depth);
+        size_t in_flight_buffers = get_in_flight_depth(lease_depths);
+        if (in_flight_buffers > shared_pool.pool->get_size())
+        {
+            LOGGER__MODULE__WARNING(MODULE_NAME, "{}: Shared pool {} needs {} buffers in flight, capped at {}",
+                                    consumer, shared_pool.pool->get_name(), in_flight_buffers,
+                                    shared_pool.pool->get_size());
+            in_flight_buffers = shared_pool.pool->get_size();
+        }
+        // Allocate now, so that the consumer does not grow the pool on the frame path
+        size_t buffers_limit = shared_pool.pool->get_buffers_limit();
+        if (in_flight_buffers > buffers_limit &&
+            (shared_pool.pool->set_buffers_limit(in_flight_buffers) != MEDIA_LIBRARY_SUCCESS ||
+             shared_pool.pool->reserve(in_flight_buffers) != MEDIA_LIBRARY_SUCCESS))
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "{}: Failed to grow shared pool {} to {} buffers", consumer,
+                                  shared_pool.pool->get_name(), in_flight_buffers);
+            shared_pool.pool->set_buffers_limit(buffers_limit);
+            shared_pool.pool->shrink(buffers_limit);
+            return tl::make_unexpected(MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR);
+        }
+    }
+
+    SharedPool &shared_pool = it->second;
+    shared_pool.leases++;
+    shared_pool.leased_buffers += depth;
+    shared_pool.lease_depths.insert(depth);
+    LOGGER__MODULE__INFO(MODULE_NAME,
+                         "{}: Leased {} buffers of shared pool {}, {} leases of {} buffers, {} buffers in flight",
+                         consumer, depth, shared_pool.pool->get_name(), shared_pool.leases, shared_pool.leased_buffers,
+                         shared_pool.pool->get_buffers_limit());
+
+    // The consumer gets the pool through the lease, so that dropping its pointer returns the lease
+    std::shared_ptr<BufferPoolLease> pool_lease = std::make_shared<BufferPoolLease>(key, depth, shared_pool.pool);
+    return MediaLibraryBufferPoolPtr(pool_lease, pool_lease->m_pool.get());
+}
+
+void BufferPoolRegistry::return_lease(const buffer_pool_key_t &key, size_t depth)
+{
+    MediaLibraryBufferPoolPtr released_pool;
+    {
+        std::unique_lock<std::mutex> lock(*m_registry_mutex);
+        auto it = m_pools.find(key);
+        if (it == m_pools.end())
+            return;
+
+        SharedPool &shared_pool = it->second;
+        shared_pool.leases--;
+        shared_pool.leased_buffers -= std::min(depth, shared_pool.leased_buffers);
+        auto depth_it = shared_pool.lease_depths.find(depth);
+        if (depth_it != shared_pool.lease_depths.end())
+            shared_pool.lease_depths.erase(depth_it);
+        if (shared_pool.leases == 0)
+        {
+            // Buffers still held keep the pool alive, it is freed with the last of them
+            released_pool = std::move(shared_pool.pool);
+            m_pools.erase(it);
+        }
+        else
+        {
+            size_t in_flight_buffers =
+                std::min<size_t>(get_in_flight_depth(shared_pool.lease_depths), shared_pool.pool->get_size());
+            shared_pool.pool->set_buffers_limit(in_flight_buffers);
+            shared_pool.pool->shrink(in_flight_buffers);
+        }
+    }
+
+    if (released_pool != nullptr)
+    {
+        LOGGER__MODULE__INFO(MODULE_NAME, "Last lease of shared pool {} returned", released_pool->get_name());
+    }
+}
+
+std::vector<shared_pool_usage_t> BufferPoolRegistry::get_shared_pools_usage()
+{
+    std::unique_lock<std::mutex> lock(*m_registry_mutex);
+    std::vector<shared_pool_usage_t> usage;
+    for (auto &[key, shared_pool] : m_pools)
+    {
+        usage.push_back({shared_pool.pool->get_name(), shared_pool.leases, shared_pool.leased_buffers,
+                         shared_pool.pool->get_buffers_limit(), shared_pool.pool->get_allocated_bytes()});
+    }
+    return usage;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "buffer_tracker.hpp"
+#include "common.hpp"
+#include "env_vars.hpp"
+#include "media_library_logger.hpp"
+#include <sstream>
+
+#define MODULE_NAME LoggerType::BufferPool
+
+BufferTracker::BufferTracker()
+    : m_enabled(is_env_variable_on(MEDIALIB_BUFFER_TRACKING_ENABLE_ENV_VAR)),
+      m_tracker_mutex(std::make_shared<std::mutex>())
+{
+}
+
+void BufferTracker::enable(bool enable)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    m_enabled = enable;
+    if (!enable)
+    {
+        m_buffers.clear();
+        m_hold_times.clear();
+    }
+    LOGGER__MODULE__INFO(MODULE_NAME, "Buffer tracking {}", enable ? "enabled" : "disabled");
+}
+
+size_t BufferTracker::hold_time_bin(std::chrono::milliseconds hold_time)
+{
+    size_t bin = 0;
+    for (int64_t ms = hold_time.count(); ms > 0 && bin < HOLD_TIME_BINS - 1; ms >>= 1)
+    {
+        bin++;
+    }
+    return bin;
+}
+
+void BufferTracker::on_acquire(const MediaLibraryBufferPool *pool, const std::string &pool_name, uint64_t handle)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    if (!is_enabled())
+        return;
+
+    m_buffers[{pool, handle}] = TrackedBuffer{pool_name, std::chrono::steady_clock::now(), ""};
+}
+
+void BufferTracker::on_touch(const MediaLibraryBufferPool *pool, uint64_t handle, const std::string &stage)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    auto it = m_buffers.find({pool, handle});
+    if (it == m_buffers.end())
+        return;
+
+    it->second.last_stage = stage;
+}
+
+void BufferTracker::on_release(const MediaLibraryBufferPool *pool, uint64_t handle)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    auto it = m_buffers.find({pool, handle});
+    if (it == m_buffers.end())
+        return;
+
+    auto hold_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                           it->second.acquire_time);
+    auto [hold_times_it, inserted] = m_hold_times.try_emplace(it->second.pool_name);
+    PoolHoldTimes &hold_times = hold_times_it->second;
+    if (inserted)
+    {
+        hold_times.bins.fill(0);
+        hold_times.max_hold_time = std::chrono::milliseconds(0);
+    }
+    hold_times.bins[hold_time_bin(hold_time)]++;
+    hold_times.max_hold_time = std::max(hold_times.max_hold_time, hold_time);
+    m_buffers.erase(it);
+}
+
+void BufferTracker::on_pool_freed(const MediaLibraryBufferPool *pool)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    for (auto it = m_buffers.lower_bound({pool, 0}); it != m_buffers.end() && it->first.first == pool;)
+    {
+        it = m_buffers.erase(it);
+    }
+}
+
+std::string BufferTracker::dump(const std::string &pool_name)
+{
+    std::unique_lock<std::mutex> lock(*m_tracker_mutex);
+    if (!is_enabled())
+        return "Buffer tracking is disabled";
+
+    std::stringstream ss;
+    auto now = std::chrono::steady_clock::now();
+    ss << "Held buffers:\n";
+    for (const auto &[key, buffer] : m_buffers)
+    {
+        if (!pool_name.empty() && buffer.pool_name != pool_name)
+            continue;
+
+        auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - buffer.acquire_time);
+        ss << "- " << buffer.pool_name << " slot " << (key.second >> 32) << ": held " << age.count()
+           << " ms, last stage " << (buffer.last_stage.empty() ? "none" : buffer.last_stage) << "\n";
+    }
+
+    ss << "Hold times (ms):\n";
+    for (const auto &[name, hold_times] : m_hold_times)
+    {
+        if (!pool_name.empty() && name != pool_name)
+            continue;
+
+        ss << "- " << name << ":";
+        for (size_t bin = 0; bin < HOLD_TIME_BINS; bin++)
+        {
+            if (hold_times.bins[bin] == 0)
+                continue;
+            if (bin == 0)
+                ss << " <1:";
+            else if (bin == HOLD_TIME_BINS - 1)
+                ss << " >=" << (1 << (bin - 1)) << ":";
+            else
+                ss << " " << (1 << (bin - 1)) << "-" << (1 << bin) << ":";
+            ss << hold_times.bins[bin];
+        }
+        ss << " max " << hold_times.max_hold_time.count() << "\n";
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "dma_budget_manager.hpp"
+#include "buffer_pool.hpp"
+#include "denoise_common.hpp"
+#include "dewarp.hpp"
+#include "dma_memory_allocator.hpp"
+#include "dsp_utils.hpp"
+#include "encoder_class.hpp"
+#include "media_library_logger.hpp"
+#include "privacy_mask.hpp"
+#include "threading_manager.hpp"
+#include <algorithm>
+#include <variant>
+
+#define MODULE_NAME LoggerType::BufferPool
+
+// Footprint of the pools created by the modules, sized with the constants the modules export
+namespace dma_footprint
+{
+static uint round_up(uint value, uint multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+static dma_pool_footprint_t pool_footprint(const std::string &name, uint width, uint height, HailoFormat format,
+                                           size_t max_buffers, uint bytes_per_line)
+{
+    return dma_pool_footprint_t{
+        .name = name,
+        .width = width,
+        .height = height,
+        .format = format,
+        .max_buffers = max_buffers,
+        .bytes = MediaLibraryBufferPool::get_dma_footprint(height, format, max_buffers, bytes_per_line)};
+}
+
+static bool is_portrait_rotation(const rotation_config_t &rotation)
+{
+    rotation_angle_t angle = rotation.effective_value();
+    return angle == ROTATION_ANGLE_90 || angle == ROTATION_ANGLE_270;
+}
+
+// multi_resize_config_t::set_output_dimensions_rotation
+static void rotate_dimensions(const rotation_config_t &rotation, uint &width, uint &height)
+{
+    if (is_portrait_rotation(rotation) && width >= height)
+    {
+        std::swap(width, height);
+    }
+}
+
+static void plan_frontend(const config_profile_t &profile, std::vector<dma_pool_footprint_t> &pools)
+{
+    const config_application_settings_t &app_settings = profile.application_settings;
+    const motion_detection_config_t &motion_detection = app_settings.motion_detection;
+    HailoFormat format = app_settings.application_input_streams.format;
+
+    // multi_resize.cpp - create_and_initialize_buffer_pools
+    std::vector<output_resolution_t> outputs = app_settings.application_input_streams.resolutions;
+    if (motion_detection.enabled)
+    {
+        outputs.push_back(motion_detection.resolution);
+    }
+    size_t max_pool_size = 0;
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        max_pool_size = std::max(max_pool_size, (size_t)outputs[i].pool_max_buffers);
+        size_t pool_max_buffers = outputs[i].pool_max_buffers;
+        if (motion_detection.enabled && pool_max_buffers == 0)
+        {
+            pool_max_buffers = max_pool_size;
+        }
+
+        uint width = outputs[i].dimensions.destination_width;
+        uint height = outputs[i].dimensions.destination_height;
+        if (i < app_settings.application_input_streams.resolutions.size())
+        {
+            rotate_dimensions(app_settings.rotation, width, height);
+        }
+        pools.emplace_back(pool_footprint("multi_resize_output_" + std::to_string(i), width, height, format,
+                                          pool_max_buffers, dsp_utils::get_dsp_desired_stride_from_width(width)));
+    }
+
+    // motion_detection.cpp - allocate_motion_detection
+    if (motion_detection.enabled)
+    {
+        size_t pool_size = motion_detection.buffer_pool_size > 0 ? motion_detection.buffer_pool_size : max_pool_size;
+        uint width = motion_detection.resolution.dimensions.destination_width;
+        uint height = motion_detection.resolution.dimensions.destination_height;
+        pools.emplace_back(pool_footprint("motion_detection_bitmask", width, height, HAILO_FORMAT_GRAY8, pool_size,
+                                          dsp_utils::get_dsp_desired_stride_from_width(width)));
+    }
+
+    uint input_width = profile.sensor_config.input_video.resolution.width;
+    uint input_height = profile.sensor_config.input_video.resolution.height;
+
+    // dewarp.cpp - create_and_initialize_buffer_pools, the output is the input frame rotated
+    bool dewarp_enabled = profile.iq_settings.dewarp.enabled || profile.stabilizer_settings.dis.enabled ||
+                          profile.stabilizer_settings.eis.enabled || profile.stabilizer_settings.gyro.enabled ||
+                          app_settings.optical_zoom.enabled || app_settings.rotation.enabled ||
+                          app_settings.flip.enabled;
+    if (dewarp_enabled)
+    {
+        uint width = input_width;
+        uint height = input_height;
+        rotate_dimensions(app_settings.rotation, width, height);
+        pools.emplace_back(pool_footprint("dewarp_output", width, height, HAILO_FORMAT_NV12,
+                                          MediaLibraryDewarp::OUTPUT_POOL_MAX_BUFFERS,
+                                          dsp_utils::get_dsp_desired_stride_from_width(width)));
+    }
+
+    const denoise_config_t &denoise = profile.iq_settings.denoise;
+    if (denoise.enabled && denoise.bayer)
+    {
+        // pre_isp_denoise.cpp - create_and_initialize_buffer_pools
+        pools.emplace_back(pool_footprint("dgain_pool", denoise_common::DGAIN_WIDTH, denoise_common::DGAIN_HEIGHT,
+                                          HAILO_FORMAT_GRAY16, denoise_common::BUFFER_POOL_MAX_BUFFERS,
+                                          denoise_common::DGAIN_WIDTH));
+        pools.emplace_back(pool_footprint("bls_pool", denoise_common::BLS_WIDTH, denoise_common::BLS_HEIGHT,
+                                          HAILO_FORMAT_GRAY16, denoise_common::BUFFER_POOL_MAX_BUFFERS,
+                                          denoise_common::BLS_WIDTH));
+    }
+    else if (denoise.enabled)
+    {
+        // post_isp_denoise.cpp - create_and_initialize_buffer_pools
+        uint width = round_up(input_width, denoise_common::RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK);
+        uint height = round_up(input_height, denoise_common::RESOULTION_MULTIPLE_REQUIRED_BY_DENOISE_NETWORK);
+        pools.emplace_back(pool_footprint("denoise_output", width, height, HAILO_FORMAT_NV12,
+                                          denoise_common::BUFFER_POOL_MAX_BUFFERS, width));
+    }
+}
+
+static void plan_encoders(const config_profile_t &profile, std::vector<dma_pool_footprint_t> &pools)
+{
+    for (const config_encoded_output_stream_t &stream : profile.encoded_output_streams)
+    {
+        const input_config_t &input_stream = std::visit(
+            [](auto &&config) -> const input_config_t & { return config.input_stream; }, stream.encoding);
+        size_t max_pool_size =
+            input_stream.max_pool_size ? input_stream.max_pool_size : input_config_t::DEFAULT_MAX_POOL_SIZE;
+
+        if (std::holds_alternative<jpeg_encoder_config_t>(stream.encoding))
+        {
+            // api encoder.cpp - init_buffer_pool of JPEG encoders
+            pools.emplace_back(pool_footprint(stream.stream_id + "_jpeg_encoder", input_stream.width,
+                                              input_stream.height, HAILO_FORMAT_GRAY8, max_pool_size,
+                                              input_stream.width));
+        }
+        else
+        {
+            // hailo_encoder/encoder.cpp - init_buffer_pool
+            pools.emplace_back(pool_footprint(stream.stream_id + "_encoder_output", input_stream.width,
+                                              input_stream.height, HAILO_FORMAT_GRAY8,
+                                              Encoder::OUTPUT_POOL_MAX_BUFFERS, input_stream.width));
+        }
+
+        // privacy_mask.cpp - init_buffer_pool
+        buffer_pool_key_t mask_key = PrivacyMaskBlender::get_buffer_pool_key(input_stream.width, input_stream.height);
+        pools.emplace_back(pool_footprint(stream.stream_id + "_privacy_mask", mask_key.width, mask_key.height,
+                                          mask_key.format, PrivacyMaskBlender::BUFFER_POOL_MAX_BUFFERS,
+                                          mask_key.bytes_per_line));
+    }
+}
+} // namespace dma_footprint
+
+DmaBudgetManager::DmaBudgetManager()
+{
+    m_budget_mutex = std::make_shared<std::mutex>();
+    m_budget_bytes = 0;
+    m_min_pool_buffers = dma_budget_config_t::DEFAULT_MIN_POOL_BUFFERS;
+    m_policy = DMA_BUDGET_POLICY_REFUSE;
+    m_shrink_interval = std::chrono::milliseconds(0);
+    m_shrink_stop = false;
+    // The shrinking thread unregisters from the threading manager on exit, construct it first to outlive this instance
+    ThreadingManager::get_instance();
+}
+
+DmaBudgetManager::~DmaBudgetManager()
+{
+    stop_shrink_thread();
+}
+
+void DmaBudgetManager::register_pool(MediaLibraryBufferPool *pool)
+{
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    m_pools.insert(pool);
+}
+
+void DmaBudgetManager::unregister_pool(MediaLibraryBufferPool *pool)
+{
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    m_pools.erase(pool);
+}
+
+void DmaBudgetManager::configure(const dma_budget_config_t &config)
+{
+    stop_shrink_thread();
+
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    m_budget_bytes = (size_t)config.budget_mb * BYTES_PER_MB;
+    m_policy = config.policy;
+    m_min_pool_buffers = std::max((size_t)config.min_pool_buffers, (size_t)1);
+    m_shrink_interval = std::chrono::milliseconds(config.idle_shrink_interval_ms);
+    LOGGER__MODULE__INFO(MODULE_NAME, "DMA budget {} MB, policy {}, min pool buffers {}, idle shrink interval {} ms",
+                         config.budget_mb, config.policy, m_min_pool_buffers, config.idle_shrink_interval_ms);
+    if (m_shrink_interval.count() > 0)
+    {
+        m_shrink_stop = false;
+        m_shrink_thread = std::thread(&DmaBudgetManager::shrink_idle_pools_loop, this);
+    }
+}
+
+void DmaBudgetManager::stop_shrink_thread()
+{
+    {
+        std::unique_lock<std::mutex> lock(*m_budget_mutex);
+        m_shrink_stop = true;
+    }
+    m_shrink_cv.notify_all();
+    if (m_shrink_thread.joinable())
+    {
+        m_shrink_thread.join();
+    }
+}
+
+void DmaBudgetManager::shrink_idle_pools_loop()
+{
+    ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_DMA_BUDGET);
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    while (!m_shrink_cv.wait_for(lock, m_shrink_interval, [this] { return m_shrink_stop; }))
+    {
+        lock.unlock();
+        shrink_idle_pools();
+        lock.lock();
+    }
+}
+
+dma_footprint_plan_t DmaBudgetManager::plan_profile(const config_profile_t &profile)
+{
+    dma_footprint_plan_t plan = {.pools = {}, .total_bytes = 0, .available_bytes = 0, .degraded = false};
+    dma_footprint::plan_frontend(profile, plan.pools);
+    dma_footprint::plan_encoders(profile, plan.pools);
+    for (const dma_pool_footprint_t &pool : plan.pools)
+    {
+        plan.total_bytes += pool.bytes;
+    }
+
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    plan.available_bytes = get_available_bytes_locked();
+    return plan;
+}
+
+size_t DmaBudgetManager::get_available_bytes_locked()
+{
+    size_t held_bytes = 0;
+    for (MediaLibraryBufferPool *pool : m_pools)
+    {
+        held_bytes += pool->get_allocated_bytes();
+    }
+
+    size_t free_bytes = DmaMemoryAllocator::get_instance().get_free_memory_mb() * BYTES_PER_MB;
+    if (free_bytes == 0 && m_budget_bytes == 0)
+    {
+        // CMA statistics are not available and no budget was set - nothing to enforce
+        return SIZE_MAX;
+    }
+
+    size_t available_bytes = (free_bytes == 0) ? SIZE_MAX : free_bytes + held_bytes;
+    if (m_budget_bytes > 0)
+    {
+        available_bytes = std::min(available_bytes, m_budget_bytes);
+    }
+    return available_bytes;
+}
+
+bool DmaBudgetManager::degrade_profile(config_profile_t &profile)
+{
+    // Take a buffer from the multi-resize output with the largest footprint that is still above the minimum
+    std::vector<output_resolution_t> &resolutions = profile.application_settings.application_input_streams.resolutions;
+    output_resolution_t *largest = nullptr;
+    size_t largest_bytes = 0;
+    for (output_resolution_t &resolution : resolutions)
+    {
+        if (resolution.pool_max_buffers <= m_min_pool_buffers)
+            continue;
+
+        uint width = resolution.dimensions.destination_width;
+        size_t bytes = MediaLibraryBufferPool::get_dma_footprint(
+            resolution.dimensions.destination_height, profile.application_settings.application_input_streams.format,
+            resolution.pool_max_buffers, dsp_utils::get_dsp_desired_stride_from_width(width));
+        if (bytes > largest_bytes)
+        {
+            largest = &resolution;
+            largest_bytes = bytes;
+        }
+    }
+
+    if (largest == nullptr)
+        return false;
+
+    largest->pool_max_buffers--;
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "Degraded output {}x{} to {} buffers", largest->dimensions.destination_width,
+                          largest->dimensions.destination_height, largest->pool_max_buffers);
+    return true;
+}
+
+tl::expected<dma_footprint_plan_t, media_library_return> DmaBudgetManager::admit_profile(config_profile_t &profile)
+{
+    dma_footprint_plan_t plan = plan_profile(profile);
+    if (plan.available_bytes == SIZE_MAX)
+    {
+        LOGGER__MODULE__INFO(MODULE_NAME, "Profile {} requires {} MB of DMA memory in {} pools, no budget to enforce",
+                             profile.name, plan.total_bytes / BYTES_PER_MB, plan.pools.size());
+        return plan;
+    }
+    LOGGER__MODULE__INFO(MODULE_NAME, "Profile {} requires {} MB of DMA memory in {} pools, {} MB available",
+                         profile.name, plan.total_bytes / BYTES_PER_MB, plan.pools.size(),
+                         plan.available_bytes / BYTES_PER_MB);
+
+    bool degraded = false;
+    while (plan.total_bytes > plan.available_bytes)
+    {
+        bool can_degrade;
+        {
+            std::unique_lock<std::mutex> lock(*m_budget_mutex);
+            can_degrade = (m_policy == DMA_BUDGET_POLICY_DEGRADE) && degrade_profile(profile);
+        }
+        if (!can_degrade)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME,
+                                  "Profile {} does not fit in DMA memory - requires {} bytes, {} bytes available",
+                                  profile.name, plan.total_bytes, plan.available_bytes);
+            for (const dma_pool_footprint_t &pool : plan.pools)
+            {
+                LOGGER__MODULE__INFO(MODULE_NAME, "  {} {}x{} format {} x{} buffers: {} bytes", pool.name, pool.width,
+                                     pool.height, pool.format, pool.max_buffers, pool.bytes);
+            }
+            return tl::make_unexpected(MEDIA_LIBRARY_OUT_OF_RESOURCES);
+        }
+        degraded = true;
+        plan = plan_profile(profile);
+    }
+
+    if (degraded)
+    {
+        LOGGER__MODULE__WARNING(MODULE_NAME, "Profile {} was degraded to fit in DMA memory, requires {} MB",
+                                profile.name, plan.total_bytes / BYTES_PER_MB);
+    }
+    plan.degraded = degraded;
+    return plan;
+}
+
+size_t DmaBudgetManager::shrink_idle_pools()
+{
+    std::unique_lock<std::mutex> lock(*m_budget_mutex);
+    size_t freed_bytes = 0;
+    for (MediaLibraryBufferPool *pool : m_pools)
+    {
+        size_t keep_buffers = std::max(pool->get_used_buffers_high_water_mark(), m_min_pool_buffers);
+        freed_bytes += pool->shrink(keep_buffers);
+        pool->reset_used_buffers_high_water_mark();
+    }
+
+    if (freed_bytes > 0)
+    {
+        LOGGER__MODULE__INFO(MODULE_NAME, "Shrinking idle pools freed {} MB of DMA memory", freed_bytes / BYTES_PER_MB);
+    }
+    return freed_bytes;
+}
@@ -45,7 +45,10 @@
 DmaMemoryAllocator::DmaMemoryAllocator()
 {
     fd_count = 0;
-    m_allocator_mutex = std::make_shared<std::mutex>();
+    m_syncs_issued = 0;
+    m_syncs_elided = 0;
+    m_allocator_mutex = std::make_shared<ProfiledMutex>("dma_allocator");
+    m_index_mutex = std::make_shared<ProfiledSharedMutex>("dma_allocator_index");
     m_dma_heap_fd_open = false;
     if (dmabuf_fd_open() != MEDIA_LIBRARY_SUCCESS)
     {
@@ -67,9 +70,13 @@ DmaMemoryAllocator::~DmaMemoryAllocator()
 
 media_library_return DmaMemoryAllocator::dmabuf_fd_open()
 {
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+    // Buffers of the CPU DSP backend are memfds, there is no dma heap to open
+    return MEDIA_LIBRARY_SUCCESS;
+#else
     static constexpr const char *DEVPATH = "/dev/dma_heap/hailo_media_buf,cma";
 
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    std::unique_lock<ProfiledMutex> lock(*m_allocator_mutex);
     if (m_dma_heap_fd_open)
     {
         return MEDIA_LIBRARY_SUCCESS;
@@ -88,17 +95,22 @@ media_library_return DmaMemoryAllocator::dmabuf_fd_open()
     LOGGER__MODULE__DEBUG(MODULE_NAME, "dmabuf_fd_open function-end");
 
     return MEDIA_LIBRARY_SUCCESS;
+#endif
 }
 
 media_library_return DmaMemoryAllocator::dmabuf_fd_close()
 {
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
-    if (m_allocated_buffers.size() > 0)
     {
-        LOGGER__MODULE__INFO(MODULE_NAME, "allocated buffers not freed");
-        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+        std::shared_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+        if (m_allocated_buffers.size() > 0 || m_arenas.size() > 0 || m_device_buffers.size() > 0)
+        {
+            LOGGER__MODULE__INFO(MODULE_NAME, "allocated buffers not freed");
+            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+        }
     }
 
+    std::unique_lock<ProfiledMutex> lock(*m_allocator_mutex);
+
     if (m_dma_heap_fd_open)
     {
         LOGGER__MODULE__DEBUG(MODULE_NAME, "fd is open, closing");
@@ -122,7 +134,19 @@ media_library_return DmaMemoryAllocator::dmabuf_heap_alloc(dma_heap_allocation_d
         .heap_flags = 0,
     };
 
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+    // A memfd is mapped and shared by fd like a dmabuf, without the contiguous memory of the dma heap
+    int ret = memfd_create("medialib_buffer", MFD_CLOEXEC);
+    if (ret >= 0)
+    {
+        heap_data.fd = ret;
+        ret = ftruncate(heap_data.fd, size);
+        if (ret < 0)
+            close(heap_data.fd);
+    }
+#else
     int ret = ioctl(m_dma_heap_fd, DMA_HEAP_IOCTL_ALLOC, &heap_data);
+#endif
     if (ret < 0)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "ioctl DMA_HEAP_IOCTL_ALLOC failed!");
@@ -160,21 +184,26 @@ media_library_return DmaMemoryAllocator::dmabuf_heap_alloc(dma_heap_allocation_d
 media_library_return DmaMemoryAllocator::unmap_external_dma_buffer(void *buffer)
 {
     LOGGER__MODULE__DEBUG(MODULE_NAME, "unmap external dma buffer function-start: buffer = {}", fmt::ptr(buffer));
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
 
-    if (m_external_buffers.find(buffer) == m_external_buffers.end())
+    auto it = m_external_buffers.find(buffer);
+    if (it == m_external_buffers.end())
     {
         LOGGER__MODULE__DEBUG(MODULE_NAME, "buffer {} not found in m_external_buffers", fmt::ptr(buffer));
         return MEDIA_LIBRARY_SUCCESS;
     }
 
-    auto length = m_external_buffers[buffer].len;
-    if (munmap(buffer, length) == -1)
+    if (munmap(buffer, it->second.len) == -1)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "munmap failed for external buffer = {}!", fmt::ptr(buffer));
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
-    m_external_buffers.erase(buffer);
+    auto fd_it = m_external_fds.find(it->second.fd);
+    if (fd_it != m_external_fds.end() && fd_it->second == buffer)
+    {
+        m_external_fds.erase(fd_it);
+    }
+    m_external_buffers.erase(it);
     return MEDIA_LIBRARY_SUCCESS;
 }
 
@@ -188,7 +217,15 @@ media_library_return DmaMemoryAllocator::map_external_dma_buffer(uint size, uint
         return MEDIA_LIBRARY_SUCCESS;
     }
 
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+
+    // Another thread may have mapped the same fd since the lookup above
+    auto fd_it = m_external_fds.find(fd);
+    if (fd_it != m_external_fds.end())
+    {
+        *buffer = fd_it->second;
+        return MEDIA_LIBRARY_SUCCESS;
+    }
 
     dma_heap_allocation_data heap_data = {
         .len = size,
@@ -204,6 +241,7 @@ media_library_return DmaMemoryAllocator::map_external_dma_buffer(uint size, uint
     }
 
     m_external_buffers[*buffer] = heap_data;
+    m_external_fds[heap_data.fd] = *buffer;
 
     LOGGER__MODULE__DEBUG(MODULE_NAME, "map_dma_buffer function-end: buffer = {}, size = {}", fmt::ptr(*buffer), size);
     return MEDIA_LIBRARY_SUCCESS;
@@ -219,7 +257,6 @@ media_library_return DmaMemoryAllocator::dmabuf_map(dma_heap_allocation_data &he
     if (*mapped_memory == MAP_FAILED)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf map failed, errno = {}", strerror(errno));
-        close(heap_data.fd);
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
@@ -231,17 +268,13 @@ media_library_return DmaMemoryAllocator::dmabuf_map(dma_heap_allocation_data &he
 
 media_library_return DmaMemoryAllocator::allocate_dma_buffer(uint size, void **buffer)
 {
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating dma buffer function-start: buffer = {}, size = {}",
                           fmt::ptr(*buffer), size);
 
-    if (!m_dma_heap_fd_open)
+    if (dmabuf_fd_open() != MEDIA_LIBRARY_SUCCESS)
     {
-        if (dmabuf_fd_open() != MEDIA_LIBRARY_SUCCESS)
-        {
-            LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_fd_open failed!");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-        }
+        LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_fd_open failed!");
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
     dma_heap_allocation_data heap_data;
@@ -255,9 +288,11 @@ media_library_return DmaMemoryAllocator::allocate_dma_buffer(uint size, void **b
     if (dmabuf_map(heap_data, buffer) != MEDIA_LIBRARY_SUCCESS)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_map failed!");
+        close(heap_data.fd);
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
     if (m_allocated_buffers.find(*buffer) != m_allocated_buffers.end())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "DMABUF *buffer already exists in m_allocated_buffers");
@@ -265,10 +300,12 @@ media_library_return DmaMemoryAllocator::allocate_dma_buffer(uint size, void **b
     }
 
     m_allocated_buffers[*buffer] = heap_data;
+    m_allocated_fds[heap_data.fd] = *buffer;
 
-    fd_count++;
+    uint current_fd_count = ++fd_count;
+    index_lock.unlock();
     LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating dma buffer function-end: buffer = {}, size = {}, fd_count = {}",
-                          fmt::ptr(*buffer), size, fd_count);
+                          fmt::ptr(*buffer), size, current_fd_count);
 
     return MEDIA_LIBRARY_SUCCESS;
 }
@@ -276,17 +313,27 @@ media_library_return DmaMemoryAllocator::free_dma_buffer(void *buffer)
 {
     LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing dma buffer function-start: buffer = {}", fmt::ptr(buffer));
 
-    int fd;
-    if (get_fd(buffer, fd, false) != MEDIA_LIBRARY_SUCCESS)
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    auto it = m_allocated_buffers.find(buffer);
+    if (it == m_allocated_buffers.end())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Buffer not found - get_fd failed for buffer = {}", fmt::ptr(buffer));
         return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
     }
 
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
-
-    auto length = m_allocated_buffers[buffer].len;
-    m_allocated_buffers.erase(buffer);
+    int fd = it->second.fd;
+    auto length = it->second.len;
+    if (m_device_buffers.find(fd) != m_device_buffers.end())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Buffer = {} is a device buffer, it must be freed by its fd",
+                              fmt::ptr(buffer));
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+    m_allocated_fds.erase(fd);
+    m_allocated_buffers.erase(it);
+    uint remaining_fd_count = --fd_count;
+    // The entry is no longer reachable, unmap and close without blocking lookups of other buffers
+    index_lock.unlock();
 
     if (munmap(buffer, length) == -1)
     {
@@ -297,13 +344,253 @@ media_library_return DmaMemoryAllocator::free_dma_buffer(void *buffer)
 
     close(fd);
 
-    fd_count--;
     LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing dma buffer function-end: buffer = {}, size = {}, fd_count = {}",
-                          fmt::ptr(buffer), length, fd_count);
+                          fmt::ptr(buffer), length, remaining_fd_count);
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return DmaMemoryAllocator::allocate_dma_arena(uint buffer_size, uint num_buffers,
+                                                            std::vector<void *> &buffers)
+{
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating dma arena function-start: buffer size = {}, num buffers = {}",
+                          buffer_size, num_buffers);
+
+    if (num_buffers == 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Dma arena allocation failed - no buffers requested");
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+
+    if (dmabuf_fd_open() != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_fd_open failed!");
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    // Every sub-buffer starts on a page boundary, as a standalone dmabuf would
+    size_t stride = (static_cast<size_t>(buffer_size) + PAGE_SIZE - 1) & ~(static_cast<size_t>(PAGE_SIZE) - 1);
+    size_t arena_size = stride * num_buffers;
+    if (arena_size > UINT32_MAX)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Dma arena of {} bytes exceeds the maximal dmabuf size", arena_size);
+        return MEDIA_LIBRARY_INVALID_ARGUMENT;
+    }
+
+    dma_heap_allocation_data heap_data;
+    if (dmabuf_heap_alloc(heap_data, arena_size) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Dma arena allocation failed on dmabuf_heap_alloc with arena size = {}",
+                              arena_size);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    void *arena = NULL;
+    if (dmabuf_map(heap_data, &arena) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_map failed!");
+        close(heap_data.fd);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    m_arenas[arena] = heap_data;
+    m_allocated_fds[heap_data.fd] = arena;
+    buffers.clear();
+    buffers.reserve(num_buffers);
+    for (uint i = 0; i < num_buffers; i++)
+    {
+        void *buffer = static_cast<uint8_t *>(arena) + i * stride;
+        m_arena_buffers[buffer] = {static_cast<int>(heap_data.fd), i * stride, arena};
+        buffers.push_back(buffer);
+    }
+
+    uint current_fd_count = ++fd_count;
+    index_lock.unlock();
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating dma arena function-end: arena = {}, size = {}, fd_count = {}",
+                          fmt::ptr(arena), arena_size, current_fd_count);
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return DmaMemoryAllocator::free_dma_arena(void *arena)
+{
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing dma arena function-start: arena = {}", fmt::ptr(arena));
+
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    auto it = m_arenas.find(arena);
+    if (it == m_arenas.end())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Arena not found for buffer = {}", fmt::ptr(arena));
+        return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
+    }
+
+    int fd = it->second.fd;
+    size_t length = it->second.len;
+    for (auto buffer_it = m_arena_buffers.begin(); buffer_it != m_arena_buffers.end();)
+    {
+        if (buffer_it->second.arena == arena)
+            buffer_it = m_arena_buffers.erase(buffer_it);
+        else
+            ++buffer_it;
+    }
+    m_allocated_fds.erase(fd);
+    m_arenas.erase(it);
+    uint remaining_fd_count = --fd_count;
+    index_lock.unlock();
+
+    if (munmap(arena, length) == -1)
+    {
+        close(fd);
+        LOGGER__MODULE__ERROR(MODULE_NAME, "munmap failed!");
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    close(fd);
+
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing dma arena function-end: arena = {}, size = {}, fd_count = {}",
+                          fmt::ptr(arena), length, remaining_fd_count);
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return DmaMemoryAllocator::allocate_device_dma_buffer(uint size, int &fd)
+{
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating device dma buffer function-start: size = {}", size);
+
+    if (dmabuf_fd_open() != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf_fd_open failed!");
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    dma_heap_allocation_data heap_data;
+    if (dmabuf_heap_alloc(heap_data, size) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Dma buffer allocation failed on dmabuf_heap_alloc with buffer size = {}",
+                              size);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    fd = heap_data.fd;
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    m_device_buffers[fd] = heap_data;
+    uint current_fd_count = ++fd_count;
+    index_lock.unlock();
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "allocating device dma buffer function-end: fd = {}, size = {}, fd_count = {}",
+                          fd, size, current_fd_count);
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return DmaMemoryAllocator::map_device_dma_buffer(int fd, void **buffer)
+{
+    {
+        std::shared_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+        auto it = m_allocated_fds.find(fd);
+        if (it != m_allocated_fds.end())
+        {
+            *buffer = it->second;
+            return MEDIA_LIBRARY_SUCCESS;
+        }
+    }
+
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    // Another thread may have mapped the buffer since the lookup above
+    auto fd_it = m_allocated_fds.find(fd);
+    if (fd_it != m_allocated_fds.end())
+    {
+        *buffer = fd_it->second;
+        return MEDIA_LIBRARY_SUCCESS;
+    }
+
+    auto it = m_device_buffers.find(fd);
+    if (it == m_device_buffers.end())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Device buffer not found for fd = {}", fd);
+        return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
+    }
+
+    void *mapped_memory = mmap(NULL, it->second.len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (mapped_memory == MAP_FAILED)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "dmabuf map failed for fd = {}, errno = {}", fd, strerror(errno));
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    m_allocated_buffers[mapped_memory] = it->second;
+    m_allocated_fds[fd] = mapped_memory;
+    *buffer = mapped_memory;
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "mapped device dma buffer: fd = {}, buffer = {}", fd, fmt::ptr(mapped_memory));
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
+media_library_return DmaMemoryAllocator::unmap_device_dma_buffer(int fd)
+{
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    auto fd_it = m_allocated_fds.find(fd);
+    if (fd_it == m_allocated_fds.end() || m_device_buffers.find(fd) == m_device_buffers.end())
+    {
+        // Not mapped
+        return MEDIA_LIBRARY_SUCCESS;
+    }
+
+    void *buffer = fd_it->second;
+    auto it = m_allocated_buffers.find(buffer);
+    size_t length = it->second.len;
+    m_allocated_buffers.erase(it);
+    m_allocated_fds.erase(fd_it);
+    index_lock.unlock();
+
+    if (munmap(buffer, length) == -1)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "munmap failed for device buffer fd = {}!", fd);
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+media_library_return DmaMemoryAllocator::free_device_dma_buffer(int fd)
+{
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing device dma buffer function-start: fd = {}", fd);
+
+    std::unique_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+    auto it = m_device_buffers.find(fd);
+    if (it == m_device_buffers.end())
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Device buffer not found for fd = {}", fd);
+        return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
+    }
+
+    size_t length = it->second.len;
+    void *buffer = nullptr;
+    auto fd_it = m_allocated_fds.find(fd);
+    if (fd_it != m_allocated_fds.end())
+    {
+        buffer = fd_it->second;
+        m_allocated_buffers.erase(buffer);
+        m_allocated_fds.erase(fd_it);
+    }
+    m_device_buffers.erase(it);
+    uint remaining_fd_count = --fd_count;
+    index_lock.unlock();
+
+    media_library_return ret = MEDIA_LIBRARY_SUCCESS;
+    if (buffer != nullptr && munmap(buffer, length) == -1)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "munmap failed!");
+        ret = MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+    close(fd);
+
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "freeing device dma buffer function-end: fd = {}, size = {}, fd_count = {}", fd,
+                          length, remaining_fd_count);
+
+    return ret;
+}
+
 size_t DmaMemoryAllocator::get_free_memory_mb()
 {
     static constexpr const char *CMA_PATH_BASE = "/sys/kernel/debug/cma/cma-hailo_media";
@@ -335,7 +622,13 @@ size_t DmaMemoryAllocator::get_free_memory_mb()
 
 media_library_return DmaMemoryAllocator::dmabuf_sync(int fd, dma_buf_sync &sync)
 {
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+    // Memfd buffers are only accessed by the CPU, there are no caches to sync
+    (void)fd;
+    (void)sync;
+    return MEDIA_LIBRARY_SUCCESS;
+#else
+    m_syncs_issued.fetch_add(1, std::memory_order_relaxed);
     int ret = ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
 
     if (ret < 0)
@@ -348,13 +641,16 @@ media_library_return DmaMemoryAllocator::dmabuf_sync(int fd, dma_buf_sync &sync)
     LOGGER__MODULE__DEBUG(MODULE_NAME, "dmabuf_sync function-end: fd = {}, start_stop = {}", fd, sync.flags);
 
     return MEDIA_LIBRARY_SUCCESS;
+#endif
 }
 
 media_library_return DmaMemoryAllocator::dmabuf_sync(void *buffer, dma_buf_sync &sync)
 {
     LOGGER__MODULE__DEBUG(MODULE_NAME, "dmabuf_sync function-start: buffer = {}, start_stop = {}", fmt::ptr(buffer),
                           sync.flags);
-
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+    return MEDIA_LIBRARY_SUCCESS;
+#else
     int fd;
     if (get_fd(buffer, fd) != MEDIA_LIBRARY_SUCCESS)
     {
@@ -362,7 +658,7 @@ media_library_return DmaMemoryAllocator::dmabuf_sync(void *buffer, dma_buf_sync
         return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
     }
 
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    m_syncs_issued.fetch_add(1, std::memory_order_relaxed);
     int ret = ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
 
     if (ret < 0)
@@ -376,96 +672,141 @@ media_library_return DmaMemoryAllocator::dmabuf_sync(void *buffer, dma_buf_sync
                           sync.flags);
 
     return MEDIA_LIBRARY_SUCCESS;
+#endif
 }
 
 media_library_return DmaMemoryAllocator::dmabuf_sync_start(int fd)
 {
     // Read the cache from device and start the sync
+    return dmabuf_sync_start(fd, DMA_SYNC_ACCESS_READ);
+}
+
+media_library_return DmaMemoryAllocator::dmabuf_sync_start(void *buffer)
+{
+    // Read the cache from device and start the sync
+    return dmabuf_sync_start(buffer, DMA_SYNC_ACCESS_READ);
+}
+
+media_library_return DmaMemoryAllocator::dmabuf_sync_end(void *buffer)
+{
+    // Write the cache to the device and finish the sync
+    return dmabuf_sync_end(buffer, DMA_SYNC_ACCESS_WRITE);
+}
+
+media_library_return DmaMemoryAllocator::dmabuf_sync_end(int fd)
+{
+    // Write the cache to the device and finish the sync
+    return dmabuf_sync_end(fd, DMA_SYNC_ACCESS_WRITE);
+}
+
+media_library_return DmaMemoryAllocator::dmabuf_sync_start(int fd, dma_sync_access_t access)
+{
     struct dma_buf_sync sync = {
-        .flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ,
+        .flags = DMA_BUF_SYNC_START | static_cast<__u64>(access),
     };
 
     return dmabuf_sync(fd, sync);
 }
 
-media_library_return DmaMemoryAllocator::dmabuf_sync_start(void *buffer)
+media_library_return DmaMemoryAllocator::dmabuf_sync_start(void *buffer, dma_sync_access_t access)
 {
-    // Read the cache from device and start the sync
     struct dma_buf_sync sync = {
-        .flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ,
+        .flags = DMA_BUF_SYNC_START | static_cast<__u64>(access),
     };
 
     return dmabuf_sync(buffer, sync);
 }
 
-media_library_return DmaMemoryAllocator::dmabuf_sync_end(void *buffer)
+media_library_return DmaMemoryAllocator::dmabuf_sync_end(int fd, dma_sync_access_t access)
 {
-    // Write the cache to the device and finish the sync
     struct dma_buf_sync sync = {
-        .flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE,
+        .flags = DMA_BUF_SYNC_END | static_cast<__u64>(access),
     };
 
-    return dmabuf_sync(buffer, sync);
+    return dmabuf_sync(fd, sync);
 }
 
-media_library_return DmaMemoryAllocator::dmabuf_sync_end(int fd)
+media_library_return DmaMemoryAllocator::dmabuf_sync_end(void *buffer, dma_sync_access_t access)
 {
-    // Write the cache to the device and finish the sync
     struct dma_buf_sync sync = {
-        .flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE,
+        .flags = DMA_BUF_SYNC_END | static_cast<__u64>(access),
     };
 
-    return dmabuf_sync(fd, sync);
+    return dmabuf_sync(buffer, sync);
 }
 
 media_library_return DmaMemoryAllocator::get_fd(void *buffer, int &fd, bool include_external)
 {
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    std::shared_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "get_fd function-start: buffer = {}", fmt::ptr(buffer));
 
-    if (m_allocated_buffers.find(buffer) == m_allocated_buffers.end())
+    auto it = m_allocated_buffers.find(buffer);
+    if (it == m_allocated_buffers.end())
     {
-        // TOOD: Change to error once userptr is not supported anymore
-        if (include_external && m_external_buffers.find(buffer) != m_external_buffers.end())
+        auto arena_it = m_arena_buffers.find(buffer);
+        if (arena_it != m_arena_buffers.end())
         {
-            fd = m_external_buffers[buffer].fd;
+            fd = arena_it->second.fd;
             return MEDIA_LIBRARY_SUCCESS;
         }
+        // TOOD: Change to error once userptr is not supported anymore
+        if (include_external)
+        {
+            auto external_it = m_external_buffers.find(buffer);
+            if (external_it != m_external_buffers.end())
+            {
+                fd = external_it->second.fd;
+                return MEDIA_LIBRARY_SUCCESS;
+            }
+        }
         LOGGER__MODULE__DEBUG(MODULE_NAME, "buffer not found in pre allocated or external buffers (ptr = {})",
                               fmt::ptr(buffer));
         return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
     }
 
-    fd = m_allocated_buffers[buffer].fd;
+    fd = it->second.fd;
     return MEDIA_LIBRARY_SUCCESS;
 }
 
 media_library_return DmaMemoryAllocator::get_ptr(uint fd, void **buffer, bool include_external)
 {
-    std::unique_lock<std::mutex> lock(*m_allocator_mutex);
+    std::shared_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "get_ptr function-start: fd = {}", fd);
 
-    for (auto const &[key, val] : m_allocated_buffers)
+    auto it = m_allocated_fds.find(fd);
+    if (it != m_allocated_fds.end())
     {
-        if (val.fd == fd)
-        {
-            *buffer = key;
-            return MEDIA_LIBRARY_SUCCESS;
-        }
+        *buffer = it->second;
+        return MEDIA_LIBRARY_SUCCESS;
     }
 
     if (include_external)
     {
-        for (auto const &[key, val] : m_external_buffers)
+        it = m_external_fds.find(fd);
+        if (it != m_external_fds.end())
         {
-            if (val.fd == fd)
-            {
-                *buffer = key;
-                return MEDIA_LIBRARY_SUCCESS;
-            }
+            *buffer = it->second;
+            return MEDIA_LIBRARY_SUCCESS;
         }
     }
 
     LOGGER__MODULE__DEBUG(MODULE_NAME, "buffer not found in allocated or external buffers");
     return MEDIA_LIBRARY_BUFFER_NOT_FOUND;
 }
+
+media_library_return DmaMemoryAllocator::get_fd_offset(void *buffer, int &fd, size_t &offset)
+{
+    {
+        std::shared_lock<ProfiledSharedMutex> index_lock(*m_index_mutex);
+        auto it = m_arena_buffers.find(buffer);
+        if (it != m_arena_buffers.end())
+        {
+            fd = it->second.fd;
+            offset = it->second.offset;
+            return MEDIA_LIBRARY_SUCCESS;
+        }
+    }
+
+    offset = 0;
+    return get_fd(buffer, fd);
+}
@@ -962,6 +962,18 @@ static const nlohmann::json api_multi_resize_application_input_streams_config_sc
                 "scaling_mode": { 
                   "type": "string",
                   "enum": ["STRETCH", "LETTERBOX_MIDDLE", "LETTERBOX_UP_LEFT", "SCALE_AND_CROP"]
+                },
+                "priority": {
+                  "type": "number",
+                  "minimum": 0
+                },
+                "drop_policy": {
+                  "type": "string",
+                  "enum": ["DROP", "BLOCK"]
+                },
+                "drop_timeout_ms": {
+                  "type": "number",
+                  "minimum": 0
                 }
               },
               "additionalProperties": false,
@@ -1028,6 +1040,18 @@ static const nlohmann::json multi_resize_application_input_streams_config_schema
                   "scaling_mode": { 
                     "type": "string",
                     "enum": ["STRETCH", "LETTERBOX_MIDDLE", "LETTERBOX_UP_LEFT", "SCALE_AND_CROP"]
+                  },
+                  "priority": {
+                    "type": "number",
+                    "minimum": 0
+                  },
+                  "drop_policy": {
+                    "type": "string",
+                    "enum": ["DROP", "BLOCK"]
+                  },
+                  "drop_timeout_ms": {
+                    "type": "number",
+                    "minimum": 0
                   }
                 },
                 "additionalProperties": false,
@@ -1199,6 +1223,68 @@ static const nlohmann::json multi_resize_motion_detection_config_schema = R"(
             "type": "number",
             "minimum": 0,
             "default": 8
+          },
+          "motion_map": {
+            "type": "object",
+            "properties": {
+              "enabled": {
+                "type": "boolean"
+              },
+              "columns": {
+                "type": "number",
+                "minimum": 1
+              },
+              "rows": {
+                "type": "number",
+                "minimum": 1
+              },
+              "cell_threshold": {
+                "type": "number",
+                "minimum": 0,
+                "maximum": 1
+              },
+              "packed_mask": {
+                "type": "boolean"
+              }
+            },
+            "additionalProperties": false,
+            "required": [
+              "enabled"
+            ]
+          },
+          "compact_reference": {
+            "type": "object",
+            "properties": {
+              "enabled": {
+                "type": "boolean"
+              },
+              "downscale": {
+                "type": "number",
+                "minimum": 1,
+                "maximum": 16
+              },
+              "quantize": {
+                "type": "boolean"
+              },
+              "background_learning_rate": {
+                "type": "number",
+                "minimum": 0,
+                "maximum": 1
+              }
+            },
+            "additionalProperties": false,
+            "required": [
+              "enabled"
+            ]
+          },
+          "asynchronous": {
+            "type": "boolean",
+            "default": false
+          },
+          "result_deadline_ms": {
+            "type": "number",
+            "minimum": 0,
+            "default": 0
           }
         },
         "additionalProperties": false,
@@ -2037,6 +2123,30 @@ static const nlohmann::json medialib_config_schema = R"(
         },
         "required": ["name", "config_file"]
       }
+    },
+    "threading": {
+      "type": "array",
+      "items": {
+        "type": "object",
+        "properties": {
+          "name": { "type": "string" },
+          "policy": { "type": "string", "enum": ["SCHED_OTHER", "SCHED_FIFO", "SCHED_RR"] },
+          "priority": { "type": "integer", "minimum": 0, "maximum": 99 },
+          "nice": { "type": "integer", "minimum": -20, "maximum": 19 },
+          "cpus": { "type": "array", "items": { "type": "integer", "minimum": 0 } }
+        },
+        "required": ["name"]
+      }
+    },
+    "dma_budget": {
+      "type": "object",
+      "properties": {
+        "budget_mb": { "type": "integer", "minimum": 0 },
+        "policy": { "type": "string", "enum": ["REFUSE", "DEGRADE"] },
+        "min_pool_buffers": { "type": "integer", "minimum": 1 },
+        "idle_shrink_interval_ms": { "type": "integer", "minimum": 0 }
+      },
+      "additionalProperties": false
     }
   },
   "required": [
@@ -120,6 +120,12 @@ MEDIALIB_JSON_SERIALIZE_ENUM(denoise_method_t, {
                                                    {DENOISE_METHOD_VD3, "HIGH_PERFORMANCE"},
                                                })
 
+MEDIALIB_JSON_SERIALIZE_ENUM(thread_sched_policy_t, {
+                                                        {THREAD_SCHED_POLICY_OTHER, "SCHED_OTHER"},
+                                                        {THREAD_SCHED_POLICY_FIFO, "SCHED_FIFO"},
+                                                        {THREAD_SCHED_POLICY_RR, "SCHED_RR"},
+                                                    })
+
 MEDIALIB_JSON_SERIALIZE_ENUM(codec_t, {
                                           {CODEC_TYPE_H264, "CODEC_TYPE_H264"},
                                           {CODEC_TYPE_HEVC, "CODEC_TYPE_HEVC"},
@@ -144,6 +150,11 @@ MEDIALIB_JSON_SERIALIZE_ENUM(hdr_dol_t, {
                                             {HDR_DOL_3, 3},
                                         })
 
+MEDIALIB_JSON_SERIALIZE_ENUM(dma_budget_policy_t, {
+                                                      {DMA_BUDGET_POLICY_REFUSE, "REFUSE"},
+                                                      {DMA_BUDGET_POLICY_DEGRADE, "DEGRADE"},
+                                                  })
+
 MEDIALIB_JSON_SERIALIZE_ENUM(zoom_bitrate_adjuster_mode_t,
                              {
                                  {ZOOM_BITRATE_ADJUSTER_DISABLED, "DISABLED"},
@@ -178,6 +189,11 @@ MEDIALIB_JSON_SERIALIZE_ENUM(dsp_scaling_mode_t, {
                                                      {DSP_SCALING_MODE_SCALE_AND_CROP, "SCALE_AND_CROP"},
                                                  })
 
+MEDIALIB_JSON_SERIALIZE_ENUM(output_drop_policy_t, {
+                                                       {OUTPUT_DROP_POLICY_DROP, "DROP"},
+                                                       {OUTPUT_DROP_POLICY_BLOCK, "BLOCK"},
+                                                   })
+
 MEDIALIB_JSON_SERIALIZE_ENUM(AnalyticsType, {
                                                 {AnalyticsType::DETECTION, "DETECTION"},
                                                 {AnalyticsType::INSTANCE_SEGMENTATION, "INSTANCE_SEGMENTATION"},
@@ -1090,6 +1106,15 @@ void to_json(nlohmann::json &j, const output_resolution_t &out_res)
     {
         j["stream_id"] = out_res.stream_id;
     }
+    if (out_res.priority != 0)
+    {
+        j["priority"] = out_res.priority;
+    }
+    if (out_res.drop_policy != OUTPUT_DROP_POLICY_DROP)
+    {
+        j["drop_policy"] = out_res.drop_policy;
+        j["drop_timeout_ms"] = out_res.drop_timeout_ms;
+    }
 }
 
 void from_json(const nlohmann::json &j, output_resolution_t &out_res)
@@ -1102,6 +1127,9 @@ void from_json(const nlohmann::json &j, output_resolution_t &out_res)
     out_res.pool_max_buffers = j.value("pool_max_buffers", 0); // not a mandatory property for input video
     out_res.dimensions.perform_crop = false;
     out_res.stream_id = j.value("stream_id", "");
+    out_res.priority = j.value("priority", 0);
+    out_res.drop_policy = j.value("drop_policy", OUTPUT_DROP_POLICY_DROP);
+    out_res.drop_timeout_ms = j.value("drop_timeout_ms", 0);
 }
 
 //------------------------ config_application_input_streams_t ------------------------
@@ -1168,6 +1196,50 @@ void from_json(const nlohmann::json &j, input_video_config_t &in_conf)
     in_conf.source_type = j2.value("source_type", frontend_src_element_t::V4L2SRC);
 }
 
+//------------------------ motion_map_config_t ------------------------
+
+void to_json(nlohmann::json &j, const motion_map_config_t &map_conf)
+{
+    j = nlohmann::json{
+        {"enabled", map_conf.enabled},
+        {"columns", map_conf.columns},
+        {"rows", map_conf.rows},
+        {"cell_threshold", map_conf.cell_threshold},
+        {"packed_mask", map_conf.packed_mask},
+    };
+}
+
+void from_json(const nlohmann::json &j, motion_map_config_t &map_conf)
+{
+    motion_map_config_t defaults;
+    j.at("enabled").get_to(map_conf.enabled);
+    map_conf.columns = j.value("columns", defaults.columns);
+    map_conf.rows = j.value("rows", defaults.rows);
+    map_conf.cell_threshold = j.value("cell_threshold", defaults.cell_threshold);
+    map_conf.packed_mask = j.value("packed_mask", defaults.packed_mask);
+}
+
+//------------------------ motion_reference_config_t ------------------------
+
+void to_json(nlohmann::json &j, const motion_reference_config_t &reference_conf)
+{
+    j = nlohmann::json{
+        {"enabled", reference_conf.enabled},
+        {"downscale", reference_conf.downscale},
+        {"quantize", reference_conf.quantize},
+        {"background_learning_rate", reference_conf.background_learning_rate},
+    };
+}
+
+void from_json(const nlohmann::json &j, motion_reference_config_t &reference_conf)
+{
+    motion_reference_config_t defaults;
+    j.at("enabled").get_to(reference_conf.enabled);
+    reference_conf.downscale = j.value("downscale", defaults.downscale);
+    reference_conf.quantize = j.value("quantize", defaults.quantize);
+    reference_conf.background_learning_rate = j.value("background_learning_rate", defaults.background_learning_rate);
+}
+
 //------------------------ motion_detection_config_t ------------------------
 
 void to_json(nlohmann::json &j, const motion_detection_config_t &md_conf)
@@ -1179,6 +1251,10 @@ void to_json(nlohmann::json &j, const motion_detection_config_t &md_conf)
         {"sensitivity_level", md_conf.sensitivity_level},
         {"threshold", md_conf.threshold},
         {"buffer_pool_size", md_conf.buffer_pool_size},
+        {"motion_map", md_conf.motion_map},
+        {"compact_reference", md_conf.compact_reference},
+        {"asynchronous", md_conf.asynchronous},
+        {"result_deadline_ms", md_conf.result_deadline_ms},
     };
 }
 
@@ -1190,6 +1266,10 @@ void from_json(const nlohmann::json &j, motion_detection_config_t &md_conf)
     j.at("sensitivity_level").get_to(md_conf.sensitivity_level);
     j.at("threshold").get_to(md_conf.threshold);
     j.at("buffer_pool_size").get_to(md_conf.buffer_pool_size);
+    md_conf.motion_map = j.value("motion_map", motion_map_config_t()); // not a mandatory property, disabled by default
+    md_conf.compact_reference = j.value("compact_reference", motion_reference_config_t()); // disabled by default
+    md_conf.asynchronous = j.value("asynchronous", false);
+    md_conf.result_deadline_ms = j.value("result_deadline_ms", 0u);
 }
 
 //------------------------ multi_resize_config_t ------------------------
@@ -1562,10 +1642,47 @@ void from_json(const json &j, profile_t &p)
     LOGGER__MODULE__INFO(MODULE_NAME, "Successfully converted and validated profile: {}", p.name);
 }
 
+//------------------------ thread_config_t ------------------------
+void to_json(json &j, const thread_config_t &t)
+{
+    j = json{{"name", t.name}, {"policy", t.policy}, {"priority", t.priority}, {"nice", t.nice}, {"cpus", t.cpus}};
+}
+
+void from_json(const json &j, thread_config_t &t)
+{
+    j.at("name").get_to(t.name);
+    // the scheduling properties are optional, a thread keeps the default scheduling for the ones not set
+    t.policy = j.value("policy", THREAD_SCHED_POLICY_OTHER);
+    t.priority = j.value("priority", 0);
+    t.nice = j.value("nice", 0);
+    t.cpus = j.value("cpus", std::vector<int>());
+}
+
+//------------------------ dma_budget_config_t ------------------------
+void to_json(json &j, const dma_budget_config_t &d)
+{
+    j = json{{"budget_mb", d.budget_mb},
+             {"policy", d.policy},
+             {"min_pool_buffers", d.min_pool_buffers},
+             {"idle_shrink_interval_ms", d.idle_shrink_interval_ms}};
+}
+
+void from_json(const json &j, dma_budget_config_t &d)
+{
+    // all the properties are optional, by default profiles are only checked against the free CMA memory
+    d.budget_mb = j.value("budget_mb", 0u);
+    d.policy = j.value("policy", DMA_BUDGET_POLICY_REFUSE);
+    d.min_pool_buffers = j.value("min_pool_buffers", dma_budget_config_t::DEFAULT_MIN_POOL_BUFFERS);
+    d.idle_shrink_interval_ms = j.value("idle_shrink_interval_ms", 0u);
+}
+
 void to_json(json &j, const medialib_config_t &m)
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "Converting medialib_config_t to JSON");
     j = json{{"default_profile", m.default_profile}, {"profiles", m.profiles}};
+    if (!m.threading.empty())
+        j["threading"] = m.threading;
+    j["dma_budget"] = m.dma_budget;
     LOGGER__MODULE__DEBUG(MODULE_NAME, "Successfully converted medialib_config_t with {} profiles", m.profiles.size());
 }
 
@@ -1575,6 +1692,9 @@ void from_json(const json &j, medialib_config_t &m)
     LOGGER__MODULE__INFO(MODULE_NAME, "Converting JSON to medialib_config_t Default profile: {}", m.default_profile);
     j.at("profiles").get_to(m.profiles);
     LOGGER__MODULE__DEBUG(MODULE_NAME, "Successfully converted {} profiles", m.profiles.size());
+    if (j.contains("threading"))
+        j.at("threading").get_to(m.threading);
+    j.value("dma_budget", json::object()).get_to(m.dma_budget);
 }
 
 //------------------------ codec_config_t ------------------------
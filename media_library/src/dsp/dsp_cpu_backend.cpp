@@ -0,0 +1,1432 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "dsp_cpu_backend.hpp"
+#include "dma_memory_allocator.hpp"
+#include "media_library_logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define MODULE_NAME LoggerType::Dsp
+
+namespace dsp_cpu
+{
+/*
+  Fixed point precision of the bilinear kernels. The horizontal pass produces Q7 rows that fit in int16, the vertical
+  pass multiplies them by Q14 weights keeping the high 16 bits of the products, which leaves Q5 results.
+*/
+static constexpr int HORIZONTAL_BITS = 7;
+static constexpr int HORIZONTAL_ONE = 1 << HORIZONTAL_BITS;
+static constexpr int VERTICAL_BITS = 14;
+static constexpr int VERTICAL_ONE = 1 << VERTICAL_BITS;
+static constexpr int VERTICAL_SHIFT = HORIZONTAL_BITS + VERTICAL_BITS - 16;
+
+// The bicubic kernels use Q11 weights, the horizontal pass keeps Q7 rows in int32
+static constexpr int BICUBIC_BITS = 11;
+static constexpr int BICUBIC_ONE = 1 << BICUBIC_BITS;
+static constexpr int BICUBIC_ROW_SHIFT = BICUBIC_BITS - HORIZONTAL_BITS;
+static constexpr int BICUBIC_SHIFT = HORIZONTAL_BITS + BICUBIC_BITS;
+static constexpr float BICUBIC_A = -0.75f;
+
+// Dewarp meshes hold Q16 source coordinates of a grid of MESH_CELL_SIZE x MESH_CELL_SIZE output cells
+static constexpr int MESH_FRACTION_BITS = 16;
+static constexpr int MESH_CELL_SIZE = 64;
+
+// A bit of the static privacy mask bitmask covers PRIVACY_MASK_CELL_SIZE x PRIVACY_MASK_CELL_SIZE pixels
+static constexpr size_t PRIVACY_MASK_CELL_SIZE = 4;
+
+static int s_device_tag;
+
+dsp_device device()
+{
+    return reinterpret_cast<dsp_device>(&s_device_tag);
+}
+
+bool is_cpu_device(dsp_device dsp)
+{
+    return dsp == device();
+}
+
+/* A plane of an image. Its size is in samples, each made of channels interleaved bytes. */
+struct plane_t
+{
+    uint8_t *data;
+    size_t stride;
+    size_t width;
+    size_t height;
+    size_t channels;
+    // subsampling of the plane relative to the image, as shifts
+    int x_shift;
+    int y_shift;
+
+    uint8_t *row(size_t y) const
+    {
+        return data + y * stride;
+    }
+};
+
+struct rect_t
+{
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+};
+
+/* The planes of an image accessible by the CPU */
+struct image_view_t
+{
+    dsp_image_format_t format;
+    size_t width;
+    size_t height;
+    plane_t planes[4];
+    size_t planes_count;
+};
+
+/**
+ * Fill the geometry of the planes of an image format, leaving the data pointers and strides unset
+ *
+ * @return false if the format is not supported by the CPU backend
+ */
+static bool describe_planes(dsp_image_format_t format, size_t width, size_t height, image_view_t &view)
+{
+    view.format = format;
+    view.width = width;
+    view.height = height;
+    switch (format)
+    {
+    case DSP_IMAGE_FORMAT_GRAY8:
+        view.planes[0] = {nullptr, 0, width, height, 1, 0, 0};
+        view.planes_count = 1;
+        return true;
+    case DSP_IMAGE_FORMAT_NV12:
+        view.planes[0] = {nullptr, 0, width, height, 1, 0, 0};
+        view.planes[1] = {nullptr, 0, width / 2, height / 2, 2, 1, 1};
+        view.planes_count = 2;
+        return true;
+    case DSP_IMAGE_FORMAT_A420:
+        view.planes[0] = {nullptr, 0, width, height, 1, 0, 0};
+        view.planes[1] = {nullptr, 0, width / 2, height / 2, 1, 1, 1};
+        view.planes[2] = {nullptr, 0, width / 2, height / 2, 1, 1, 1};
+        view.planes[3] = {nullptr, 0, width, height, 1, 0, 0};
+        view.planes_count = 4;
+        return true;
+    case DSP_IMAGE_FORMAT_RGB:
+        view.planes[0] = {nullptr, 0, width, height, 3, 0, 0};
+        view.planes_count = 1;
+        return true;
+    case DSP_IMAGE_FORMAT_ARGB:
+        view.planes[0] = {nullptr, 0, width, height, 4, 0, 0};
+        view.planes_count = 1;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Resolves the planes of a DSP image for CPU access. Dmabuf planes are owned by the CPU for the lifetime of the
+ * object.
+ */
+class ImageAccess
+{
+  public:
+    ImageAccess(const dsp_image_properties_t *image) : m_view(), m_valid(false), m_synced_fds_count(0)
+    {
+        if (image == nullptr || image->planes == nullptr)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend got an image without planes");
+            return;
+        }
+        if (!describe_planes(image->format, image->width, image->height, m_view))
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend does not support image format {}", image->format);
+            return;
+        }
+
+        // A single plane NV12 image holds its chroma right after the luma
+        size_t planes_count = std::min(image->planes_count, m_view.planes_count);
+        if (planes_count == 0 ||
+            (planes_count < m_view.planes_count && !(image->format == DSP_IMAGE_FORMAT_NV12 && planes_count == 1)))
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend got {} planes for image format {}",
+                                  image->planes_count, image->format);
+            return;
+        }
+
+        for (size_t i = 0; i < planes_count; i++)
+        {
+            m_view.planes[i].data = resolve_plane(image, i);
+            m_view.planes[i].stride = image->planes[i].bytesperline;
+            if (m_view.planes[i].data == nullptr)
+                return;
+        }
+        if (planes_count < m_view.planes_count)
+        {
+            m_view.planes[1].data = m_view.planes[0].data + m_view.planes[0].stride * m_view.height;
+            m_view.planes[1].stride = m_view.planes[0].stride;
+        }
+        m_valid = true;
+    }
+
+    ~ImageAccess()
+    {
+        for (size_t i = 0; i < m_synced_fds_count; i++)
+            DmaMemoryAllocator::get_instance().dmabuf_sync_end(m_synced_fds[i], DMA_SYNC_ACCESS_READ_WRITE);
+    }
+
+    ImageAccess(const ImageAccess &) = delete;
+    ImageAccess &operator=(const ImageAccess &) = delete;
+
+    bool valid() const
+    {
+        return m_valid;
+    }
+
+    image_view_t &view()
+    {
+        return m_view;
+    }
+
+  private:
+    image_view_t m_view;
+    bool m_valid;
+    int m_synced_fds[4];
+    size_t m_synced_fds_count;
+
+    uint8_t *resolve_plane(const dsp_image_properties_t *image, size_t index)
+    {
+        const dsp_data_plane_t &plane = image->planes[index];
+        if (image->memory == DSP_MEMORY_TYPE_USERPTR)
+            return static_cast<uint8_t *>(plane.userptr);
+
+        DmaMemoryAllocator &allocator = DmaMemoryAllocator::get_instance();
+        void *buffer = nullptr;
+        if (allocator.get_ptr(plane.fd, &buffer) != MEDIA_LIBRARY_SUCCESS &&
+            allocator.map_external_dma_buffer(plane.bytesused, plane.fd, &buffer) != MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend failed to map plane {} (fd {})", index, plane.fd);
+            return nullptr;
+        }
+
+        if (std::find(m_synced_fds, m_synced_fds + m_synced_fds_count, plane.fd) == m_synced_fds + m_synced_fds_count)
+        {
+            allocator.dmabuf_sync_start(plane.fd, DMA_SYNC_ACCESS_READ_WRITE);
+            m_synced_fds[m_synced_fds_count++] = plane.fd;
+        }
+        return static_cast<uint8_t *>(buffer);
+    }
+};
+
+/**
+ * Scratch image owned by the calling thread, reused between operations
+ */
+static image_view_t scratch_image(dsp_image_format_t format, size_t width, size_t height)
+{
+    thread_local std::vector<uint8_t> storage;
+    image_view_t view;
+    describe_planes(format, width, height, view);
+
+    size_t size = 0;
+    for (size_t i = 0; i < view.planes_count; i++)
+        size += view.planes[i].width * view.planes[i].channels * view.planes[i].height;
+    if (storage.size() < size)
+        storage.resize(size);
+
+    uint8_t *data = storage.data();
+    for (size_t i = 0; i < view.planes_count; i++)
+    {
+        view.planes[i].data = data;
+        view.planes[i].stride = view.planes[i].width * view.planes[i].channels;
+        data += view.planes[i].stride * view.planes[i].height;
+    }
+    return view;
+}
+
+/* The value of each channel of a plane for a YUV color */
+static void plane_color(const image_view_t &view, size_t plane_index, const dsp_color_t &color, uint8_t value[4])
+{
+    switch (view.format)
+    {
+    case DSP_IMAGE_FORMAT_NV12:
+        if (plane_index == 0)
+        {
+            value[0] = color.y;
+        }
+        else
+        {
+            value[0] = color.u;
+            value[1] = color.v;
+        }
+        return;
+    case DSP_IMAGE_FORMAT_A420: {
+        const uint8_t values[] = {color.y, color.u, color.v, 255};
+        value[0] = values[plane_index];
+        return;
+    }
+    case DSP_IMAGE_FORMAT_RGB:
+    case DSP_IMAGE_FORMAT_ARGB: {
+        // BT.601 limited range
+        float y = 1.164f * (color.y - 16);
+        auto clamp = [](float v) { return static_cast<uint8_t>(std::clamp(std::lround(v), 0L, 255L)); };
+        uint8_t r = clamp(y + 1.596f * (color.v - 128));
+        uint8_t g = clamp(y - 0.392f * (color.u - 128) - 0.813f * (color.v - 128));
+        uint8_t b = clamp(y + 2.017f * (color.u - 128));
+        size_t first = view.format == DSP_IMAGE_FORMAT_ARGB ? 1 : 0;
+        value[0] = 255;
+        value[first] = r;
+        value[first + 1] = g;
+        value[first + 2] = b;
+        return;
+    }
+    default:
+        value[0] = color.y;
+        return;
+    }
+}
+
+/* The rect of a plane covering a rect of its image */
+static rect_t plane_rect(const plane_t &plane, const rect_t &rect)
+{
+    size_t x = rect.x >> plane.x_shift;
+    size_t y = rect.y >> plane.y_shift;
+    size_t end_x = std::min((rect.x + rect.width) >> plane.x_shift, plane.width);
+    size_t end_y = std::min((rect.y + rect.height) >> plane.y_shift, plane.height);
+    return {x, y, std::max(end_x, x + 1) - x, std::max(end_y, y + 1) - y};
+}
+
+static void fill_rect(plane_t &plane, const rect_t &rect, const uint8_t value[4])
+{
+    if (rect.width == 0 || rect.height == 0)
+        return;
+
+    thread_local std::vector<uint8_t> pattern;
+    size_t row_size = rect.width * plane.channels;
+    pattern.resize(row_size);
+    for (size_t i = 0; i < row_size; i++)
+        pattern[i] = value[i % plane.channels];
+
+    for (size_t y = rect.y; y < rect.y + rect.height; y++)
+        memcpy(plane.row(y) + rect.x * plane.channels, pattern.data(), row_size);
+}
+
+// Fill the parts of the image outside of a rect, the letterbox of a resize
+static void fill_outside(image_view_t &view, const rect_t &inner, const dsp_color_t &color)
+{
+    if (inner.x == 0 && inner.y == 0 && inner.width == view.width && inner.height == view.height)
+        return;
+
+    for (size_t i = 0; i < view.planes_count; i++)
+    {
+        plane_t &plane = view.planes[i];
+        uint8_t value[4];
+        plane_color(view, i, color, value);
+        rect_t r = plane_rect(plane, inner);
+        fill_rect(plane, {0, 0, plane.width, r.y}, value);
+        fill_rect(plane, {0, r.y + r.height, plane.width, plane.height - (r.y + r.height)}, value);
+        fill_rect(plane, {0, r.y, r.x, r.height}, value);
+        fill_rect(plane, {r.x + r.width, r.y, plane.width - (r.x + r.width), r.height}, value);
+    }
+}
+
+/**
+ * Blend the two Q7 rows around an output row with Q14 weights into 8 bit samples
+ */
+static void vertical_bilinear(const int16_t *row0, const int16_t *row1, int16_t weight0, int16_t weight1,
+                              uint8_t *dst, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i w0 = _mm_set1_epi16(weight0);
+    const __m128i w1 = _mm_set1_epi16(weight1);
+    const __m128i delta = _mm_set1_epi16(1 << (VERTICAL_SHIFT - 1));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i lo = _mm_add_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i *)(row0 + i)), w0),
+                                   _mm_mulhi_epi16(_mm_loadu_si128((const __m128i *)(row1 + i)), w1));
+        __m128i hi = _mm_add_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i *)(row0 + i + 8)), w0),
+                                   _mm_mulhi_epi16(_mm_loadu_si128((const __m128i *)(row1 + i + 8)), w1));
+        lo = _mm_srai_epi16(_mm_add_epi16(lo, delta), VERTICAL_SHIFT);
+        hi = _mm_srai_epi16(_mm_add_epi16(hi, delta), VERTICAL_SHIFT);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    const int16x4_t w0 = vdup_n_s16(weight0);
+    const int16x4_t w1 = vdup_n_s16(weight1);
+    for (; i + 8 <= count; i += 8)
+    {
+        int16x8_t a = vld1q_s16(row0 + i);
+        int16x8_t b = vld1q_s16(row1 + i);
+        int16x4_t lo = vadd_s16(vshrn_n_s32(vmull_s16(vget_low_s16(a), w0), 16),
+                                vshrn_n_s32(vmull_s16(vget_low_s16(b), w1), 16));
+        int16x4_t hi = vadd_s16(vshrn_n_s32(vmull_s16(vget_high_s16(a), w0), 16),
+                                vshrn_n_s32(vmull_s16(vget_high_s16(b), w1), 16));
+        vst1_u8(dst + i, vqrshrun_n_s16(vcombine_s16(lo, hi), VERTICAL_SHIFT));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        int value = ((row0[i] * weight0) >> 16) + ((row1[i] * weight1) >> 16);
+        value = (value + (1 << (VERTICAL_SHIFT - 1))) >> VERTICAL_SHIFT;
+        dst[i] = static_cast<uint8_t>(std::clamp(value, 0, 255));
+    }
+}
+
+/**
+ * Alpha blend a row of samples over dst, dividing by 255 with exact rounding
+ */
+static void blend_row(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), zero);
+        __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(dst + i)), zero);
+        __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(alpha + i)), zero);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(max, a)));
+        t = _mm_add_epi16(t, half);
+        t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(t, zero));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8_t a = vld1_u8(alpha + i);
+        uint16x8_t t = vmlal_u8(vmull_u8(vld1_u8(src + i), a), vld1_u8(dst + i), vmvn_u8(a));
+        t = vaddq_u16(t, vdupq_n_u16(128));
+        vst1_u8(dst + i, vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint32_t t = src[i] * alpha[i] + dst[i] * (255 - alpha[i]) + 128;
+        dst[i] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+    }
+}
+
+/* Source position of the center of an output sample, clamped to the source */
+static float source_position(size_t dst_index, float scale)
+{
+    return std::max((dst_index + 0.5f) * scale - 0.5f, 0.0f);
+}
+
+static void resize_nearest(const plane_t &src, const rect_t &s, plane_t &dst, const rect_t &d)
+{
+    const size_t channels = src.channels;
+    thread_local std::vector<size_t> x_offsets;
+    x_offsets.resize(d.width);
+    float scale_x = static_cast<float>(s.width) / d.width;
+    float scale_y = static_cast<float>(s.height) / d.height;
+    for (size_t dx = 0; dx < d.width; dx++)
+        x_offsets[dx] = (s.x + std::min(static_cast<size_t>((dx + 0.5f) * scale_x), s.width - 1)) * channels;
+
+    for (size_t dy = 0; dy < d.height; dy++)
+    {
+        const uint8_t *src_row = src.row(s.y + std::min(static_cast<size_t>((dy + 0.5f) * scale_y), s.height - 1));
+        uint8_t *dst_row = dst.row(d.y + dy) + d.x * channels;
+        for (size_t dx = 0; dx < d.width; dx++)
+            for (size_t c = 0; c < channels; c++)
+                dst_row[dx * channels + c] = src_row[x_offsets[dx] + c];
+    }
+}
+
+static void resize_bilinear(const plane_t &src, const rect_t &s, plane_t &dst, const rect_t &d)
+{
+    const size_t channels = src.channels;
+    const size_t row_size = d.width * channels;
+    thread_local std::vector<size_t> x_offsets0, x_offsets1;
+    thread_local std::vector<int16_t> x_weights;
+    thread_local std::vector<int16_t> rows[2];
+    x_offsets0.resize(d.width);
+    x_offsets1.resize(d.width);
+    x_weights.resize(d.width);
+    rows[0].resize(row_size);
+    rows[1].resize(row_size);
+
+    float scale_x = static_cast<float>(s.width) / d.width;
+    float scale_y = static_cast<float>(s.height) / d.height;
+    for (size_t dx = 0; dx < d.width; dx++)
+    {
+        float fx = source_position(dx, scale_x);
+        size_t x0 = std::min(static_cast<size_t>(fx), s.width - 1);
+        size_t x1 = std::min(x0 + 1, s.width - 1);
+        x_offsets0[dx] = (s.x + x0) * channels;
+        x_offsets1[dx] = (s.x + x1) * channels;
+        x_weights[dx] = static_cast<int16_t>(std::lround((fx - x0) * HORIZONTAL_ONE));
+    }
+
+    auto horizontal = [&](size_t y, int16_t *out) {
+        const uint8_t *src_row = src.row(s.y + y);
+        for (size_t dx = 0; dx < d.width; dx++)
+        {
+            int weight1 = x_weights[dx];
+            int weight0 = HORIZONTAL_ONE - weight1;
+            for (size_t c = 0; c < channels; c++)
+            {
+                out[dx * channels + c] = static_cast<int16_t>(src_row[x_offsets0[dx] + c] * weight0 +
+                                                              src_row[x_offsets1[dx] + c] * weight1);
+            }
+        }
+    };
+
+    // Consecutive output rows mostly share source rows, keep the last two horizontally interpolated ones
+    size_t cached[2] = {SIZE_MAX, SIZE_MAX};
+    for (size_t dy = 0; dy < d.height; dy++)
+    {
+        float fy = source_position(dy, scale_y);
+        size_t y0 = std::min(static_cast<size_t>(fy), s.height - 1);
+        size_t y1 = std::min(y0 + 1, s.height - 1);
+        if (cached[0] != y0)
+        {
+            if (cached[1] == y0)
+            {
+                std::swap(rows[0], rows[1]);
+                std::swap(cached[0], cached[1]);
+            }
+            else
+            {
+                horizontal(y0, rows[0].data());
+                cached[0] = y0;
+            }
+        }
+        if (cached[1] != y1)
+        {
+            horizontal(y1, rows[1].data());
+            cached[1] = y1;
+        }
+
+        int16_t weight1 = static_cast<int16_t>(std::lround((fy - y0) * VERTICAL_ONE));
+        int16_t weight0 = static_cast<int16_t>(VERTICAL_ONE - weight1);
+        vertical_bilinear(rows[0].data(), rows[1].data(), weight0, weight1, dst.row(d.y + dy) + d.x * channels,
+                          row_size);
+    }
+}
+
+/* Q11 weights of the 4 taps around a fractional position, summing exactly to one */
+static void bicubic_weights(float t, int weights[4])
+{
+    auto kernel = [](float x) {
+        x = std::fabs(x);
+        if (x <= 1.0f)
+            return ((BICUBIC_A + 2) * x - (BICUBIC_A + 3)) * x * x + 1;
+        if (x < 2.0f)
+            return ((BICUBIC_A * x - 5 * BICUBIC_A) * x + 8 * BICUBIC_A) * x - 4 * BICUBIC_A;
+        return 0.0f;
+    };
+    int sum = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        weights[i] = static_cast<int>(std::lround(kernel(t - (i - 1)) * BICUBIC_ONE));
+        sum += weights[i];
+    }
+    weights[1] += BICUBIC_ONE - sum;
+}
+
+static void resize_bicubic(const plane_t &src, const rect_t &s, plane_t &dst, const rect_t &d)
+{
+    const size_t channels = src.channels;
+    const size_t row_size = d.width * channels;
+    thread_local std::vector<size_t> x_offsets;
+    thread_local std::vector<int> x_weights;
+    thread_local std::vector<int32_t> rows[4];
+    x_offsets.resize(d.width * 4);
+    x_weights.resize(d.width * 4);
+    for (std::vector<int32_t> &row : rows)
+        row.resize(row_size);
+
+    auto clamp_index = [](long index, size_t size) {
+        return static_cast<size_t>(std::clamp(index, 0L, static_cast<long>(size) - 1));
+    };
+
+    float scale_x = static_cast<float>(s.width) / d.width;
+    float scale_y = static_cast<float>(s.height) / d.height;
+    for (size_t dx = 0; dx < d.width; dx++)
+    {
+        float fx = (dx + 0.5f) * scale_x - 0.5f;
+        long x = static_cast<long>(std::floor(fx));
+        bicubic_weights(fx - x, &x_weights[dx * 4]);
+        for (int i = 0; i < 4; i++)
+            x_offsets[dx * 4 + i] = (s.x + clamp_index(x + i - 1, s.width)) * channels;
+    }
+
+    auto horizontal = [&](size_t y, int32_t *out) {
+        const uint8_t *src_row = src.row(s.y + y);
+        for (size_t dx = 0; dx < d.width; dx++)
+        {
+            const size_t *offsets = &x_offsets[dx * 4];
+            const int *weights = &x_weights[dx * 4];
+            for (size_t c = 0; c < channels; c++)
+            {
+                int32_t value = 0;
+                for (int i = 0; i < 4; i++)
+                    value += src_row[offsets[i] + c] * weights[i];
+                out[dx * channels + c] = (value + (1 << (BICUBIC_ROW_SHIFT - 1))) >> BICUBIC_ROW_SHIFT;
+            }
+        }
+    };
+
+    // Four consecutive source rows always land in distinct slots, clamped duplicates are the same row
+    size_t cached[4] = {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+    for (size_t dy = 0; dy < d.height; dy++)
+    {
+        float fy = (dy + 0.5f) * scale_y - 0.5f;
+        long y = static_cast<long>(std::floor(fy));
+        int y_weights[4];
+        bicubic_weights(fy - y, y_weights);
+
+        const int32_t *taps[4];
+        for (int i = 0; i < 4; i++)
+        {
+            size_t source_y = clamp_index(y + i - 1, s.height);
+            size_t slot = source_y % 4;
+            if (cached[slot] != source_y)
+            {
+                horizontal(source_y, rows[slot].data());
+                cached[slot] = source_y;
+            }
+            taps[i] = rows[slot].data();
+        }
+
+        uint8_t *dst_row = dst.row(d.y + dy) + d.x * channels;
+        for (size_t i = 0; i < row_size; i++)
+        {
+            int32_t value = taps[0][i] * y_weights[0] + taps[1][i] * y_weights[1] + taps[2][i] * y_weights[2] +
+                            taps[3][i] * y_weights[3];
+            value = (value + (1 << (BICUBIC_SHIFT - 1))) >> BICUBIC_SHIFT;
+            dst_row[i] = static_cast<uint8_t>(std::clamp(value, 0, 255));
+        }
+    }
+}
+
+static void resize_plane(const plane_t &src, const rect_t &src_rect, plane_t &dst, const rect_t &dst_rect,
+                         dsp_interpolation_type_t interpolation)
+{
+    if (src_rect.width == 0 || src_rect.height == 0 || dst_rect.width == 0 || dst_rect.height == 0)
+        return;
+
+    switch (interpolation)
+    {
+    case INTERPOLATION_TYPE_NEAREST_NEIGHBOR:
+        resize_nearest(src, src_rect, dst, dst_rect);
+        break;
+    case INTERPOLATION_TYPE_BICUBIC:
+        resize_bicubic(src, src_rect, dst, dst_rect);
+        break;
+    default:
+        resize_bilinear(src, src_rect, dst, dst_rect);
+        break;
+    }
+}
+
+/**
+ * Place a crop in an output image according to a scaling mode
+ *
+ * @param[in] crop - the crop of the source image
+ * @param[in] width - width of the output image
+ * @param[in] height - height of the output image
+ * @param[in] scaling_mode - the scaling mode
+ * @param[out] src_rect - the part of the crop that is resized
+ * @param[out] dst_rect - the part of the output image it is resized to, the rest is letterbox
+ */
+static void place_crop(const rect_t &crop, size_t width, size_t height, dsp_scaling_mode_t scaling_mode,
+                       rect_t &src_rect, rect_t &dst_rect)
+{
+    src_rect = crop;
+    dst_rect = {0, 0, width, height};
+    float scale_x = static_cast<float>(width) / crop.width;
+    float scale_y = static_cast<float>(height) / crop.height;
+    auto even = [](float value, size_t max) { return std::clamp<size_t>(std::lround(value) & ~1L, 2, max); };
+
+    switch (scaling_mode)
+    {
+    case DSP_SCALING_MODE_LETTERBOX_MIDDLE:
+    case DSP_SCALING_MODE_LETTERBOX_UP_LEFT: {
+        float scale = std::min(scale_x, scale_y);
+        dst_rect.width = even(crop.width * scale, width);
+        dst_rect.height = even(crop.height * scale, height);
+        if (scaling_mode == DSP_SCALING_MODE_LETTERBOX_MIDDLE)
+        {
+            dst_rect.x = ((width - dst_rect.width) / 2) & ~1UL;
+            dst_rect.y = ((height - dst_rect.height) / 2) & ~1UL;
+        }
+        break;
+    }
+    case DSP_SCALING_MODE_SCALE_AND_CROP: {
+        float scale = std::max(scale_x, scale_y);
+        src_rect.width = even(width / scale, crop.width);
+        src_rect.height = even(height / scale, crop.height);
+        src_rect.x = crop.x + (((crop.width - src_rect.width) / 2) & ~1UL);
+        src_rect.y = crop.y + (((crop.height - src_rect.height) / 2) & ~1UL);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+ * Crop and resize an image into another of the same format, letterboxing with a color
+ */
+static dsp_status resize_image(image_view_t &src, const rect_t &crop, image_view_t &dst,
+                               dsp_scaling_mode_t scaling_mode, const dsp_color_t &color,
+                               dsp_interpolation_type_t interpolation)
+{
+    if (src.format != dst.format)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend cannot resize format {} into format {}", src.format,
+                              dst.format);
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    rect_t src_rect, dst_rect;
+    place_crop(crop, dst.width, dst.height, scaling_mode, src_rect, dst_rect);
+    fill_outside(dst, dst_rect, color);
+    for (size_t i = 0; i < src.planes_count; i++)
+    {
+        resize_plane(src.planes[i], plane_rect(src.planes[i], src_rect), dst.planes[i],
+                     plane_rect(dst.planes[i], dst_rect), interpolation);
+    }
+    return DSP_SUCCESS;
+}
+
+/**
+ * Copy an image into another, flipped and then rotated clockwise
+ */
+static void flip_rotate_image(const image_view_t &src, image_view_t &dst, dsp_flip_direction_t flip,
+                              dsp_rotation_angle_t rotation)
+{
+    bool flip_x = (flip == DSP_FLIP_HORIZONTAL || flip == DSP_FLIP_BOTH);
+    bool flip_y = (flip == DSP_FLIP_VERTICAL || flip == DSP_FLIP_BOTH);
+    for (size_t i = 0; i < src.planes_count; i++)
+    {
+        const plane_t &in = src.planes[i];
+        plane_t &out = dst.planes[i];
+        const size_t channels = in.channels;
+        for (size_t y = 0; y < out.height; y++)
+        {
+            uint8_t *out_row = out.row(y);
+            for (size_t x = 0; x < out.width; x++)
+            {
+                // Position in the flipped source of the output sample
+                size_t sx, sy;
+                switch (rotation)
+                {
+                case DSP_ROTATION_90:
+                    sx = y;
+                    sy = in.height - 1 - x;
+                    break;
+                case DSP_ROTATION_180:
+                    sx = in.width - 1 - x;
+                    sy = in.height - 1 - y;
+                    break;
+                case DSP_ROTATION_270:
+                    sx = in.width - 1 - y;
+                    sy = x;
+                    break;
+                default:
+                    sx = x;
+                    sy = y;
+                    break;
+                }
+                sx = std::min(flip_x ? in.width - 1 - sx : sx, in.width - 1);
+                sy = std::min(flip_y ? in.height - 1 - sy : sy, in.height - 1);
+                memcpy(out_row + x * channels, in.row(sy) + sx * channels, channels);
+            }
+        }
+    }
+}
+
+static rect_t roi_rect(const dsp_roi_t *roi, const image_view_t &view)
+{
+    if (roi == nullptr)
+        return {0, 0, view.width, view.height};
+
+    size_t start_x = std::min(roi->start_x, view.width);
+    size_t start_y = std::min(roi->start_y, view.height);
+    size_t end_x = std::clamp(roi->end_x, start_x, view.width);
+    size_t end_y = std::clamp(roi->end_y, start_y, view.height);
+    return {start_x, start_y, end_x - start_x, end_y - start_y};
+}
+
+/**
+ * Histogram of the luma of a rect, sampled every x_step/y_step pixels
+ * Four partial histograms are counted in turns, so that consecutive equal samples do not serialize on one counter.
+ */
+static void luma_histogram(const plane_t &luma, const rect_t &rect, size_t x_step, size_t y_step,
+                           uint32_t histogram[DSP_HISTOGRAM_SIZE])
+{
+    uint32_t partial[4][DSP_HISTOGRAM_SIZE] = {};
+    x_step = std::max<size_t>(x_step, 1);
+    y_step = std::max<size_t>(y_step, 1);
+    for (size_t y = rect.y; y < rect.y + rect.height; y += y_step)
+    {
+        const uint8_t *row = luma.row(y);
+        size_t x = rect.x;
+        const size_t end = rect.x + rect.width;
+        for (; x + 3 * x_step < end; x += 4 * x_step)
+        {
+            partial[0][row[x]]++;
+            partial[1][row[x + x_step]]++;
+            partial[2][row[x + 2 * x_step]]++;
+            partial[3][row[x + 3 * x_step]]++;
+        }
+        for (; x < end; x += x_step)
+            partial[0][row[x]]++;
+    }
+
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+        histogram[i] = partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+}
+
+/* Lookup tables applying the color adjustments and histogram equalization of the image enhancement */
+struct enhancement_luts_t
+{
+    uint8_t y[256];
+    uint8_t u[256];
+    uint8_t v[256];
+};
+
+static void build_enhancement_luts(const dsp_image_enhancement_params_t &params, enhancement_luts_t &luts)
+{
+    auto clamp = [](float value) { return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L)); };
+    for (int i = 0; i < 256; i++)
+    {
+        int y = params.histogram_equalization_params ? params.histogram_equalization_params->lut[i] : i;
+        luts.y[i] = clamp((y - 128) * static_cast<float>(params.color.contrast) + 128 + params.color.brightness);
+        luts.u[i] =
+            clamp((i - 128) * static_cast<float>(params.color.saturation_u_a) + 128 + params.color.saturation_u_b);
+        luts.v[i] =
+            clamp((i - 128) * static_cast<float>(params.color.saturation_v_a) + 128 + params.color.saturation_v_b);
+    }
+}
+
+/* The tables of the last parameters of the calling thread, rebuilt only when the parameters or the LUT change */
+static const enhancement_luts_t &cached_enhancement_luts(const dsp_image_enhancement_params_t &params)
+{
+    struct cache_t
+    {
+        bool valid = false;
+        decltype(params.color) color;
+        bool equalization;
+        uint8_t lut[DSP_HISTOGRAM_SIZE];
+        enhancement_luts_t luts;
+    };
+    thread_local cache_t cache;
+
+    const dsp_histogram_equalization_params_t *equalization = params.histogram_equalization_params;
+    bool same = cache.valid && cache.color.contrast == params.color.contrast &&
+                cache.color.brightness == params.color.brightness &&
+                cache.color.saturation_u_a == params.color.saturation_u_a &&
+                cache.color.saturation_u_b == params.color.saturation_u_b &&
+                cache.color.saturation_v_a == params.color.saturation_v_a &&
+                cache.color.saturation_v_b == params.color.saturation_v_b &&
+                cache.equalization == (equalization != nullptr) &&
+                (equalization == nullptr || memcmp(cache.lut, equalization->lut, sizeof(cache.lut)) == 0);
+    if (!same)
+    {
+        build_enhancement_luts(params, cache.luts);
+        cache.color = params.color;
+        cache.equalization = equalization != nullptr;
+        if (equalization != nullptr)
+            memcpy(cache.lut, equalization->lut, sizeof(cache.lut));
+        cache.valid = true;
+    }
+    return cache.luts;
+}
+
+static void apply_lut(plane_t &plane, const uint8_t *lut_even, const uint8_t *lut_odd)
+{
+    const size_t row_size = plane.width * plane.channels;
+    for (size_t y = 0; y < plane.height; y++)
+    {
+        uint8_t *row = plane.row(y);
+        if (plane.channels == 2)
+        {
+            for (size_t x = 0; x < row_size; x += 2)
+            {
+                row[x] = lut_even[row[x]];
+                row[x + 1] = lut_odd[row[x + 1]];
+            }
+        }
+        else
+        {
+            for (size_t x = 0; x < row_size; x++)
+                row[x] = lut_even[row[x]];
+        }
+    }
+}
+
+static void apply_enhancement_luts(image_view_t &image, const enhancement_luts_t &luts)
+{
+    switch (image.format)
+    {
+    case DSP_IMAGE_FORMAT_NV12:
+        apply_lut(image.planes[0], luts.y, luts.y);
+        apply_lut(image.planes[1], luts.u, luts.v);
+        break;
+    case DSP_IMAGE_FORMAT_A420:
+        apply_lut(image.planes[0], luts.y, luts.y);
+        apply_lut(image.planes[1], luts.u, luts.u);
+        apply_lut(image.planes[2], luts.v, luts.v);
+        break;
+    case DSP_IMAGE_FORMAT_GRAY8:
+        apply_lut(image.planes[0], luts.y, luts.y);
+        break;
+    default:
+        break;
+    }
+}
+
+dsp_status create_buffer(size_t size, void **buffer)
+{
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    if (posix_memalign(buffer, page_size, size) != 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend failed to allocate a buffer of {} bytes", size);
+        return DSP_OUT_OF_MEMORY;
+    }
+    return DSP_SUCCESS;
+}
+
+dsp_status release_buffer(void *buffer)
+{
+    free(buffer);
+    return DSP_SUCCESS;
+}
+
+dsp_status crop_and_resize_letterbox(dsp_resize_params_t *resize_params, dsp_crop_api_t *crop_params,
+                                     dsp_letterbox_properties_t *letterbox_params)
+{
+    ImageAccess src(resize_params->src);
+    ImageAccess dst(resize_params->dst);
+    if (!src.valid() || !dst.valid())
+        return DSP_INVALID_ARGUMENT;
+
+    dsp_scaling_mode_t scaling_mode = DSP_SCALING_MODE_STRETCH;
+    dsp_color_t color = {0, 128, 128};
+    if (letterbox_params != nullptr)
+    {
+        color = letterbox_params->color;
+        if (letterbox_params->alignment == DSP_LETTERBOX_MIDDLE)
+            scaling_mode = DSP_SCALING_MODE_LETTERBOX_MIDDLE;
+        else if (letterbox_params->alignment == DSP_LETTERBOX_UP_LEFT)
+            scaling_mode = DSP_SCALING_MODE_LETTERBOX_UP_LEFT;
+    }
+
+    return resize_image(src.view(), roi_rect(crop_params, src.view()), dst.view(), scaling_mode, color,
+                        resize_params->interpolation);
+}
+
+/**
+ * Produce a single output of a multi crop and resize, flipped and rotated if requested
+ */
+static dsp_status resize_output(image_view_t &src, const rect_t &crop, dsp_image_properties_t *output,
+                                const dsp_scaling_params_t &scaling_params, dsp_interpolation_type_t interpolation,
+                                const dsp_flip_rotate_params_t *flip_rotate_params,
+                                const enhancement_luts_t *enhancement_luts)
+{
+    ImageAccess dst(output);
+    if (!dst.valid())
+        return DSP_INVALID_ARGUMENT;
+
+    bool transform = flip_rotate_params != nullptr &&
+                     (flip_rotate_params->flip_dir != DSP_FLIP_NONE || flip_rotate_params->rot_ang != DSP_ROTATION_0);
+    dsp_status status;
+    if (transform)
+    {
+        // Resize to the unrotated output in a scratch image, then flip and rotate it into the output
+        bool swap_sides =
+            flip_rotate_params->rot_ang == DSP_ROTATION_90 || flip_rotate_params->rot_ang == DSP_ROTATION_270;
+        size_t width = swap_sides ? dst.view().height : dst.view().width;
+        size_t height = swap_sides ? dst.view().width : dst.view().height;
+        image_view_t scratch = scratch_image(dst.view().format, width, height);
+        status = resize_image(src, crop, scratch, scaling_params.scaling_mode, scaling_params.color, interpolation);
+        if (status == DSP_SUCCESS)
+            flip_rotate_image(scratch, dst.view(), flip_rotate_params->flip_dir, flip_rotate_params->rot_ang);
+    }
+    else
+    {
+        status = resize_image(src, crop, dst.view(), scaling_params.scaling_mode, scaling_params.color, interpolation);
+    }
+
+    if (status == DSP_SUCCESS && enhancement_luts != nullptr)
+        apply_enhancement_luts(dst.view(), *enhancement_luts);
+    return status;
+}
+
+/*
+  The DSP resizes the outputs of a group telescopically, each from the previous one. Each output is resized directly
+  from the crop here, which reads more source pixels but keeps the quality of every output independent.
+*/
+static dsp_status multi_crop_and_resize(dsp_multi_crop_resize_params_t *params,
+                                        const dsp_image_enhancement_params_t *image_enhancement_params,
+                                        const dsp_flip_rotate_params_t *flip_rotate_params)
+{
+    if (params == nullptr)
+        return DSP_INVALID_ARGUMENT;
+
+    ImageAccess src(params->src);
+    if (!src.valid())
+        return DSP_INVALID_ARGUMENT;
+
+    const enhancement_luts_t *enhancement_luts = nullptr;
+    if (image_enhancement_params != nullptr)
+    {
+        dsp_image_enhancement_histogram_t *histogram_params = image_enhancement_params->histogram_params;
+        if (histogram_params != nullptr && params->crop_resize_params_count > 0)
+        {
+            luma_histogram(src.view().planes[0], roi_rect(params->crop_resize_params[0].crop, src.view()),
+                           histogram_params->x_sample_step, histogram_params->y_sample_step,
+                           histogram_params->histogram);
+        }
+        enhancement_luts = &cached_enhancement_luts(*image_enhancement_params);
+    }
+
+    for (size_t p = 0; p < params->crop_resize_params_count; p++)
+    {
+        dsp_crop_resize_params_t &crop_resize_params = params->crop_resize_params[p];
+        rect_t crop = roi_rect(crop_resize_params.crop, src.view());
+        if (crop.width == 0 || crop.height == 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend got an empty crop");
+            return DSP_INVALID_ARGUMENT;
+        }
+
+        for (size_t i = 0; i < DSP_MULTI_RESIZE_OUTPUTS_COUNT && crop_resize_params.dst[i] != nullptr; i++)
+        {
+            dsp_status status =
+                resize_output(src.view(), crop, crop_resize_params.dst[i], crop_resize_params.scaling_params[i],
+                              params->interpolation, flip_rotate_params, enhancement_luts);
+            if (status != DSP_SUCCESS)
+                return status;
+        }
+    }
+    return DSP_SUCCESS;
+}
+
+dsp_status multi_crop_and_resize(dsp_multi_crop_resize_params_t *multi_crop_resize_params)
+{
+    return multi_crop_and_resize(multi_crop_resize_params, nullptr, nullptr);
+}
+
+dsp_status frontend_process(const dsp_frontend_params_t *frontend_params)
+{
+    if (frontend_params->privacy_mask_params != nullptr)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend does not support privacy masks in the frontend process");
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    return multi_crop_and_resize(frontend_params->multi_crop_resize_params,
+                                 frontend_params->image_enhancement_params, frontend_params->flip_rotate_params);
+}
+
+/* Bitmask of the static privacy masks, a bit per cell of PRIVACY_MASK_CELL_SIZE pixels, most significant bit first */
+struct static_bitmask_t
+{
+    const uint8_t *bits;
+    size_t bits_per_line;
+
+    static_bitmask_t(const uint8_t *bitmask, size_t image_width) : bits(bitmask)
+    {
+        // As packed by write_polygons_to_privacy_mask_data, lines are padded to 8 bytes
+        size_t bytes_per_line = ((image_width / (8 * PRIVACY_MASK_CELL_SIZE)) + 7) & ~7UL;
+        bits_per_line = bytes_per_line * 8;
+    }
+
+    bool operator()(size_t x, size_t y) const
+    {
+        size_t index = (y / PRIVACY_MASK_CELL_SIZE) * bits_per_line + x / PRIVACY_MASK_CELL_SIZE;
+        return bits[index / 8] & (0x80 >> (index % 8));
+    }
+};
+
+/* Every pixel of a dynamic privacy mask box is masked */
+struct full_mask_t
+{
+    bool operator()(size_t, size_t) const
+    {
+        return true;
+    }
+};
+
+/**
+ * Fill the masked pixels of a rect of an NV12 image with a color
+ */
+template <typename Mask>
+static void fill_masked(image_view_t &image, const rect_t &rect, const dsp_color_t &color, const Mask &mask)
+{
+    plane_t &luma = image.planes[0];
+    plane_t &chroma = image.planes[1];
+    for (size_t y = rect.y; y < rect.y + rect.height; y++)
+    {
+        uint8_t *luma_row = luma.row(y);
+        uint8_t *chroma_row = (y % 2 == 0) ? chroma.row(y / 2) : nullptr;
+        size_t x = rect.x;
+        const size_t end = rect.x + rect.width;
+        while (x < end)
+        {
+            if (!mask(x, y))
+            {
+                x++;
+                continue;
+            }
+            size_t run_end = x + 1;
+            while (run_end < end && mask(run_end, y))
+                run_end++;
+
+            memset(luma_row + x, color.y, run_end - x);
+            if (chroma_row != nullptr)
+            {
+                for (size_t cx = x / 2; cx < (run_end + 1) / 2; cx++)
+                {
+                    chroma_row[cx * 2] = color.u;
+                    chroma_row[cx * 2 + 1] = color.v;
+                }
+            }
+            x = run_end;
+        }
+    }
+}
+
+/**
+ * Pixelize the masked pixels of a rect of an NV12 image, each block of block_size pixels takes its mean color
+ */
+template <typename Mask>
+static void pixelize_masked(image_view_t &image, const rect_t &rect, size_t block_size, const Mask &mask)
+{
+    plane_t &luma = image.planes[0];
+    plane_t &chroma = image.planes[1];
+    block_size = std::max<size_t>(block_size & ~1UL, 2);
+    for (size_t block_y = rect.y & ~1UL; block_y < rect.y + rect.height; block_y += block_size)
+    {
+        size_t end_y = std::min(block_y + block_size, image.height);
+        for (size_t block_x = rect.x & ~1UL; block_x < rect.x + rect.width; block_x += block_size)
+        {
+            size_t end_x = std::min(block_x + block_size, image.width);
+            uint32_t sum_y = 0, sum_u = 0, sum_v = 0;
+            for (size_t y = block_y; y < end_y; y++)
+                for (size_t x = block_x; x < end_x; x++)
+                    sum_y += luma.row(y)[x];
+            for (size_t y = block_y / 2; y < end_y / 2; y++)
+            {
+                for (size_t x = block_x / 2; x < end_x / 2; x++)
+                {
+                    sum_u += chroma.row(y)[x * 2];
+                    sum_v += chroma.row(y)[x * 2 + 1];
+                }
+            }
+            size_t luma_count = (end_y - block_y) * (end_x - block_x);
+            size_t chroma_count = std::max<size_t>(((end_y - block_y) / 2) * ((end_x - block_x) / 2), 1);
+            dsp_color_t mean = {static_cast<uint8_t>(sum_y / luma_count), static_cast<uint8_t>(sum_u / chroma_count),
+                                static_cast<uint8_t>(sum_v / chroma_count)};
+
+            rect_t block = {block_x, block_y, end_x - block_x, end_y - block_y};
+            fill_masked(image, block, mean, mask);
+        }
+    }
+}
+
+template <typename Mask>
+static void apply_privacy_mask(image_view_t &image, const rect_t &rect, const unified_dsp_privacy_mask_t &params,
+                               const Mask &mask)
+{
+    if (params.type == DSP_PRIVACY_MASK_BLUR)
+        pixelize_masked(image, rect, params.pixelization_size, mask);
+    else
+        fill_masked(image, rect, params.color, mask);
+}
+
+dsp_status privacy_mask(dsp_image_properties_t *image, const unified_dsp_privacy_mask_t *privacy_mask_params)
+{
+    ImageAccess access(image);
+    if (!access.valid())
+        return DSP_INVALID_ARGUMENT;
+    image_view_t &view = access.view();
+    if (view.format != DSP_IMAGE_FORMAT_NV12)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend supports privacy masks on NV12 images only");
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    const dsp_static_privacy_mask_t *static_params = privacy_mask_params->static_privacy_mask_params;
+    if (static_params != nullptr && static_params->bitmask != nullptr)
+    {
+        static_bitmask_t bitmask(static_params->bitmask, view.width);
+        for (size_t i = 0; i < static_params->rois_count; i++)
+            apply_privacy_mask(view, roi_rect(&static_params->rois[i], view), *privacy_mask_params, bitmask);
+    }
+
+    const dsp_dynamic_privacy_mask_t *dynamic_params = privacy_mask_params->dynamic_privacy_mask_params;
+    if (dynamic_params != nullptr)
+    {
+        for (size_t i = 0; i < dynamic_params->masks_count; i++)
+        {
+            // The box is in the coordinates of the network input, stretched over the image
+            const dsp_dynamic_privacy_mask_roi_t &mask = dynamic_params->masks[i];
+            if (mask.input_frame_net_width == 0 || mask.input_frame_net_height == 0)
+                continue;
+            float scale_x = static_cast<float>(view.width) / mask.input_frame_net_width;
+            float scale_y = static_cast<float>(view.height) / mask.input_frame_net_height;
+            dsp_roi_t roi = {
+                .start_x = static_cast<size_t>(mask.roi.start_x * scale_x),
+                .start_y = static_cast<size_t>(mask.roi.start_y * scale_y),
+                .end_x = static_cast<size_t>(std::ceil(mask.roi.end_x * scale_x)),
+                .end_y = static_cast<size_t>(std::ceil(mask.roi.end_y * scale_y)),
+            };
+            apply_privacy_mask(view, roi_rect(&roi, view), *privacy_mask_params, full_mask_t());
+        }
+    }
+    return DSP_SUCCESS;
+}
+
+/* Bilinear sample of a plane at Q16 coordinates, clamped to the plane */
+static inline void sample_bilinear(const plane_t &plane, int64_t x, int64_t y, uint8_t *out)
+{
+    const int64_t max_x = static_cast<int64_t>(plane.width - 1) << MESH_FRACTION_BITS;
+    const int64_t max_y = static_cast<int64_t>(plane.height - 1) << MESH_FRACTION_BITS;
+    x = std::clamp<int64_t>(x, 0, max_x);
+    y = std::clamp<int64_t>(y, 0, max_y);
+    size_t x0 = x >> MESH_FRACTION_BITS;
+    size_t y0 = y >> MESH_FRACTION_BITS;
+    size_t x1 = std::min(x0 + 1, plane.width - 1);
+    size_t y1 = std::min(y0 + 1, plane.height - 1);
+    uint32_t fx = (x >> (MESH_FRACTION_BITS - 8)) & 0xff;
+    uint32_t fy = (y >> (MESH_FRACTION_BITS - 8)) & 0xff;
+    const uint8_t *row0 = plane.row(y0);
+    const uint8_t *row1 = plane.row(y1);
+    for (size_t c = 0; c < plane.channels; c++)
+    {
+        uint32_t top = row0[x0 * plane.channels + c] * (256 - fx) + row0[x1 * plane.channels + c] * fx;
+        uint32_t bottom = row1[x0 * plane.channels + c] * (256 - fx) + row1[x1 * plane.channels + c] * fx;
+        out[c] = static_cast<uint8_t>((top * (256 - fy) + bottom * fy + (1 << 15)) >> 16);
+    }
+}
+
+static inline void sample_nearest(const plane_t &plane, int64_t x, int64_t y, uint8_t *out)
+{
+    const int64_t half = 1 << (MESH_FRACTION_BITS - 1);
+    size_t sx = std::clamp<int64_t>((x + half) >> MESH_FRACTION_BITS, 0, plane.width - 1);
+    size_t sy = std::clamp<int64_t>((y + half) >> MESH_FRACTION_BITS, 0, plane.height - 1);
+    memcpy(out, plane.row(sy) + sx * plane.channels, plane.channels);
+}
+
+/**
+ * Remap a plane through a dewarp mesh. The mesh vertices are in luma pixels, a subsampled plane scales them down.
+ */
+static void dewarp_plane(const plane_t &src, plane_t &dst, const dsp_dewarp_mesh_t &mesh, bool nearest)
+{
+    const size_t mesh_width = mesh.mesh_width;
+    const size_t mesh_height = mesh.mesh_height;
+    const int32_t *table = reinterpret_cast<const int32_t *>(mesh.mesh_table);
+    thread_local std::vector<int64_t> column_x, column_y;
+    column_x.resize(mesh_width);
+    column_y.resize(mesh_width);
+
+    for (size_t y = 0; y < dst.height; y++)
+    {
+        // Vertical interpolation of every mesh column at the luma row of this output row
+        size_t luma_y = y << dst.y_shift;
+        size_t cell_y = std::min(luma_y / MESH_CELL_SIZE, mesh_height - 1);
+        size_t next_y = std::min(cell_y + 1, mesh_height - 1);
+        int64_t t = luma_y - cell_y * MESH_CELL_SIZE;
+        for (size_t j = 0; j < mesh_width; j++)
+        {
+            const int32_t *top = &table[(cell_y * mesh_width + j) * 2];
+            const int32_t *bottom = &table[(next_y * mesh_width + j) * 2];
+            column_x[j] = (top[0] * (MESH_CELL_SIZE - t) + bottom[0] * t) / MESH_CELL_SIZE;
+            column_y[j] = (top[1] * (MESH_CELL_SIZE - t) + bottom[1] * t) / MESH_CELL_SIZE;
+        }
+
+        uint8_t *dst_row = dst.row(y);
+        for (size_t x = 0; x < dst.width; x++)
+        {
+            size_t luma_x = x << dst.x_shift;
+            size_t cell_x = std::min(luma_x / MESH_CELL_SIZE, mesh_width - 1);
+            size_t next_x = std::min(cell_x + 1, mesh_width - 1);
+            int64_t s = luma_x - cell_x * MESH_CELL_SIZE;
+            int64_t source_x = (column_x[cell_x] * (MESH_CELL_SIZE - s) + column_x[next_x] * s) / MESH_CELL_SIZE;
+            int64_t source_y = (column_y[cell_x] * (MESH_CELL_SIZE - s) + column_y[next_x] * s) / MESH_CELL_SIZE;
+            source_x >>= src.x_shift;
+            source_y >>= src.y_shift;
+            if (nearest)
+                sample_nearest(src, source_x, source_y, dst_row + x * dst.channels);
+            else
+                sample_bilinear(src, source_x, source_y, dst_row + x * dst.channels);
+        }
+    }
+}
+
+dsp_status dewarp(dsp_image_properties_t *input_image, dsp_image_properties_t *output_image, dsp_dewarp_mesh_t *mesh,
+                  dsp_interpolation_type_t interpolation)
+{
+    if (mesh == nullptr || mesh->mesh_table == nullptr || mesh->mesh_width == 0 || mesh->mesh_height == 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend got an empty dewarp mesh");
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    ImageAccess src(input_image);
+    ImageAccess dst(output_image);
+    if (!src.valid() || !dst.valid())
+        return DSP_INVALID_ARGUMENT;
+    if (src.view().format != dst.view().format)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend cannot dewarp format {} into format {}",
+                              src.view().format, dst.view().format);
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    for (size_t i = 0; i < src.view().planes_count; i++)
+    {
+        dewarp_plane(src.view().planes[i], dst.view().planes[i], *mesh,
+                     interpolation == INTERPOLATION_TYPE_NEAREST_NEIGHBOR);
+    }
+    return DSP_SUCCESS;
+}
+
+dsp_status rot_dis_dewarp(dsp_dewarp_angular_dis_params_t *dewarp_params)
+{
+    return dewarp(dewarp_params->src, dewarp_params->dst, dewarp_params->mesh, dewarp_params->interpolation);
+}
+
+/* BT.601 limited range conversion of an ARGB pixel */
+static inline void argb_to_yuv(const uint8_t *pixel, uint8_t &y, uint8_t &u, uint8_t &v)
+{
+    int r = pixel[1], g = pixel[2], b = pixel[3];
+    y = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    u = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    v = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+/**
+ * Blend an A420 or ARGB overlay over a region of an NV12 image
+ */
+static dsp_status blend_overlay(image_view_t &image, const dsp_overlay_properties_t &overlay_properties)
+{
+    ImageAccess access(&overlay_properties.overlay);
+    if (!access.valid())
+        return DSP_INVALID_ARGUMENT;
+    image_view_t &overlay = access.view();
+    if (overlay.format != DSP_IMAGE_FORMAT_A420 && overlay.format != DSP_IMAGE_FORMAT_ARGB)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend cannot blend overlays of format {}", overlay.format);
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    // Chroma is shared by 2x2 pixels, the overlay is placed on even coordinates
+    size_t x_offset = overlay_properties.x_offset & ~1UL;
+    size_t y_offset = overlay_properties.y_offset & ~1UL;
+    if (x_offset >= image.width || y_offset >= image.height)
+        return DSP_SUCCESS;
+    size_t width = std::min(overlay.width, image.width - x_offset) & ~1UL;
+    size_t height = std::min(overlay.height, image.height - y_offset) & ~1UL;
+
+    thread_local std::vector<uint8_t> luma, luma_alpha, chroma, chroma_alpha;
+    luma.resize(width);
+    luma_alpha.resize(width);
+    chroma.resize(width);
+    chroma_alpha.resize(width);
+
+    plane_t &image_luma = image.planes[0];
+    plane_t &image_chroma = image.planes[1];
+    for (size_t y = 0; y < height; y++)
+    {
+        bool chroma_row = (y % 2 == 0);
+        if (overlay.format == DSP_IMAGE_FORMAT_A420)
+        {
+            const uint8_t *alpha = overlay.planes[3].row(y);
+            blend_row(image_luma.row(y_offset + y) + x_offset, overlay.planes[0].row(y), alpha, width);
+            if (chroma_row)
+            {
+                const uint8_t *u = overlay.planes[1].row(y / 2);
+                const uint8_t *v = overlay.planes[2].row(y / 2);
+                for (size_t i = 0; i < width / 2; i++)
+                {
+                    chroma[i * 2] = u[i];
+                    chroma[i * 2 + 1] = v[i];
+                    chroma_alpha[i * 2] = chroma_alpha[i * 2 + 1] = alpha[i * 2];
+                }
+            }
+        }
+        else
+        {
+            const uint8_t *pixels = overlay.planes[0].row(y);
+            for (size_t i = 0; i < width; i++)
+            {
+                uint8_t u, v;
+                argb_to_yuv(pixels + i * 4, luma[i], u, v);
+                luma_alpha[i] = pixels[i * 4];
+                if (chroma_row && i % 2 == 0)
+                {
+                    chroma[i] = u;
+                    chroma[i + 1] = v;
+                    chroma_alpha[i] = chroma_alpha[i + 1] = luma_alpha[i];
+                }
+            }
+            blend_row(image_luma.row(y_offset + y) + x_offset, luma.data(), luma_alpha.data(), width);
+        }
+
+        if (chroma_row)
+        {
+            blend_row(image_chroma.row((y_offset + y) / 2) + x_offset, chroma.data(), chroma_alpha.data(),
+                      width);
+        }
+    }
+    return DSP_SUCCESS;
+}
+
+dsp_status blend(dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlays, size_t overlays_count)
+{
+    ImageAccess access(image_frame);
+    if (!access.valid())
+        return DSP_INVALID_ARGUMENT;
+    if (access.view().format != DSP_IMAGE_FORMAT_NV12)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend blends on NV12 images only");
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    for (size_t i = 0; i < overlays_count; i++)
+    {
+        dsp_status status = blend_overlay(access.view(), overlays[i]);
+        if (status != DSP_SUCCESS)
+            return status;
+    }
+    return DSP_SUCCESS;
+}
+} // namespace dsp_cpu
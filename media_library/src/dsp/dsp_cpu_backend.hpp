@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file dsp_cpu_backend.hpp
+ * @brief Software implementation of the DSP operations used by dsp_utils
+ **/
+
+#pragma once
+
+#include "hailo/hailodsp.h"
+
+/**
+ * The CPU backend executes the libhailodsp operations used by the media library on the CPU, with SSE2/NEON kernels
+ * for the hot loops. It operates on the same parameter structs, so the frontend, OSD and privacy mask code run
+ * unchanged without a DSP. It is the only backend when built with MEDIALIB_DSP_CPU_BACKEND, and otherwise serves as
+ * the fallback of an overloaded DSP (see dsp_utils::set_cpu_fallback).
+ *
+ * Differences from the DSP:
+ * - Area interpolation is executed as bilinear, and dewarp interpolates bilinearly
+ * - Image enhancement applies the color adjustments, histogram and equalization, blur/sharpness/bilateral are skipped
+ * - Dewarp applies the mesh only, DIS angular correction and VSM are not emulated
+ * - Dynamic privacy masks cover the bounding box of the mask
+ */
+namespace dsp_cpu
+{
+/**
+ * @brief Handle of the CPU device, accepted by dsp_utils wherever a dsp_device is expected
+ */
+dsp_device device();
+
+bool is_cpu_device(dsp_device dsp);
+
+/**
+ * @brief Allocate a page aligned heap buffer, in place of a DSP buffer
+ */
+dsp_status create_buffer(size_t size, void **buffer);
+dsp_status release_buffer(void *buffer);
+
+dsp_status crop_and_resize_letterbox(dsp_resize_params_t *resize_params, dsp_crop_api_t *crop_params,
+                                     dsp_letterbox_properties_t *letterbox_params);
+dsp_status multi_crop_and_resize(dsp_multi_crop_resize_params_t *multi_crop_resize_params);
+dsp_status frontend_process(const dsp_frontend_params_t *frontend_params);
+dsp_status privacy_mask(dsp_image_properties_t *image, const unified_dsp_privacy_mask_t *privacy_mask_params);
+dsp_status dewarp(dsp_image_properties_t *input_image, dsp_image_properties_t *output_image, dsp_dewarp_mesh_t *mesh,
+                  dsp_interpolation_type_t interpolation);
+dsp_status rot_dis_dewarp(dsp_dewarp_angular_dis_params_t *dewarp_params);
+dsp_status blend(dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlays, size_t overlays_count);
+} // namespace dsp_cpu
@@ -21,10 +21,18 @@
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include "dsp_utils.hpp"
+#include "dsp_cpu_backend.hpp"
 #include "media_library_logger.hpp"
 #include "media_library_types.hpp"
 #include "dma_memory_allocator.hpp"
 #include "hailo_media_library_perfetto.hpp"
+#include "threading_manager.hpp"
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #define MODULE_NAME LoggerType::Dsp
 
@@ -82,7 +90,12 @@ hailo_dsp_buffer_data_t::hailo_dsp_buffer_data_t(size_t width, size_t height, si
     switch (memory)
     {
     case HAILO_MEMORY_TYPE_DMABUF:
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+        // The CPU backend reads the planes through their mapping, which also covers planes carved out of an arena
+        properties.memory = hailo_data_planes[0].userptr != nullptr ? DSP_MEMORY_TYPE_USERPTR : DSP_MEMORY_TYPE_DMABUF;
+#else
         properties.memory = DSP_MEMORY_TYPE_DMABUF;
+#endif
         break;
     default:
         LOGGER__MODULE__ERROR(MODULE_NAME, "Unsupported memory type {}", memory);
@@ -95,7 +108,10 @@ hailo_dsp_buffer_data_t::hailo_dsp_buffer_data_t(size_t width, size_t height, si
 
     for (uint32_t i = 0; i < planes_count; i++)
     {
-        planes[i].fd = hailo_data_planes[i].fd;
+        if (properties.memory == DSP_MEMORY_TYPE_USERPTR)
+            planes[i].userptr = hailo_data_planes[i].userptr;
+        else
+            planes[i].fd = hailo_data_planes[i].fd;
         planes[i].bytesperline = hailo_data_planes[i].bytesperline;
         planes[i].bytesused = hailo_data_planes[i].bytesused;
     }
@@ -106,7 +122,88 @@ namespace dsp_utils
 {
 static dsp_device device = NULL;
 static uint dsp_device_refcount = 0;
+// Guards the device and its refcount against the asynchronous DSP workers
+static std::mutex device_mutex;
 static const int DSP_VISION_PRIORITY = 100;
+// Run asynchronous jobs that find the queue full on the CPU backend instead of waiting for the DSP
+static std::atomic<bool> cpu_fallback_enabled = false;
+
+/*
+  A CPU backend build does not link libhailodsp, its only device is the CPU one. A hardware build runs an operation on
+  the CPU backend when it is given dsp_cpu::device(), which the asynchronous job queue does as an overload fallback.
+*/
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+#define HAILODSP_CALL(call) DSP_UNINITIALIZED
+#else
+#define HAILODSP_CALL(call) call
+#endif
+
+static dsp_status backend_crop_and_resize_letterbox(dsp_device dsp, dsp_resize_params_t *resize_params,
+                                                    dsp_crop_api_t *crop_params,
+                                                    dsp_letterbox_properties_t *letterbox_params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::crop_and_resize_letterbox(resize_params, crop_params, letterbox_params);
+    return HAILODSP_CALL(dsp_crop_and_resize_letterbox(dsp, resize_params, crop_params, letterbox_params));
+}
+
+static dsp_status backend_multi_crop_and_resize(dsp_device dsp, dsp_multi_crop_resize_params_t *params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::multi_crop_and_resize(params);
+    return HAILODSP_CALL(dsp_multi_crop_and_resize(dsp, params));
+}
+
+static dsp_status backend_multi_crop_and_resize_privacy_mask(dsp_device dsp,
+                                                             [[maybe_unused]] dsp_multi_crop_resize_params_t *params,
+                                                             [[maybe_unused]] dsp_privacy_mask_t *privacy_mask_params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "CPU DSP backend does not support privacy masks in multi resize");
+        return DSP_INVALID_ARGUMENT;
+    }
+    return HAILODSP_CALL(dsp_multi_crop_and_resize_privacy_mask(dsp, params, privacy_mask_params));
+}
+
+static dsp_status backend_frontend_process(dsp_device dsp, const dsp_frontend_params_t *frontend_params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::frontend_process(frontend_params);
+    return HAILODSP_CALL(dsp_frontend_process(dsp, frontend_params));
+}
+
+static dsp_status backend_privacy_mask(dsp_device dsp, dsp_image_properties_t *image_properties,
+                                       const unified_dsp_privacy_mask_t *privacy_mask_params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::privacy_mask(image_properties, privacy_mask_params);
+    return HAILODSP_CALL(dsp_privacy_mask(dsp, image_properties, privacy_mask_params));
+}
+
+static dsp_status backend_dewarp(dsp_device dsp, dsp_image_properties_t *input_image_properties,
+                                 dsp_image_properties_t *output_image_properties, dsp_dewarp_mesh_t *mesh,
+                                 dsp_interpolation_type_t interpolation)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::dewarp(input_image_properties, output_image_properties, mesh, interpolation);
+    return HAILODSP_CALL(dsp_dewarp(dsp, input_image_properties, output_image_properties, mesh, interpolation));
+}
+
+static dsp_status backend_rot_dis_dewarp(dsp_device dsp, dsp_dewarp_angular_dis_params_t *dewarp_params)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::rot_dis_dewarp(dewarp_params);
+    return HAILODSP_CALL(dsp_rot_dis_dewarp(dsp, dewarp_params));
+}
+
+static dsp_status backend_blend(dsp_device dsp, dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlay,
+                                size_t overlays_count)
+{
+    if (dsp_cpu::is_cpu_device(dsp))
+        return dsp_cpu::blend(image_frame, overlay, overlays_count);
+    return HAILODSP_CALL(dsp_blend(dsp, image_frame, overlay, overlays_count));
+}
 
 /**
  * Create a DSP device and store it globally
@@ -118,6 +215,10 @@ static dsp_status create_device()
     // If the device is not initialized, initialize it, else return SUCCESS
     if (device == NULL)
     {
+#ifdef MEDIALIB_DSP_CPU_BACKEND
+        LOGGER__MODULE__INFO(MODULE_NAME, "Using the CPU DSP backend");
+        device = dsp_cpu::device();
+#else
         LOGGER__MODULE__INFO(MODULE_NAME, "Creating dsp device");
         dsp_status status = dsp_create_device(&device);
         if (status != DSP_SUCCESS)
@@ -132,6 +233,7 @@ static dsp_status create_device()
             LOGGER__MODULE__ERROR(MODULE_NAME, "Set DSP priority failed with status {}", status);
             return status;
         }
+#endif
     }
 
     return DSP_SUCCESS;
@@ -146,6 +248,7 @@ static dsp_status create_device()
  */
 dsp_status release_device()
 {
+    std::unique_lock<std::mutex> lock(device_mutex);
     if (device == NULL)
     {
         LOGGER__MODULE__WARNING(MODULE_NAME, "Release device skipped: Dsp device is already NULL");
@@ -160,7 +263,7 @@ dsp_status release_device()
     else
     {
         LOGGER__MODULE__DEBUG(MODULE_NAME, "Releasing dsp device, refcount is {}", dsp_device_refcount);
-        dsp_status status = dsp_release_device(device);
+        dsp_status status = dsp_cpu::is_cpu_device(device) ? DSP_SUCCESS : HAILODSP_CALL(dsp_release_device(device));
         if (status != DSP_SUCCESS)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Release device failed with status {}", status);
@@ -182,6 +285,7 @@ dsp_status release_device()
  */
 dsp_status acquire_device()
 {
+    std::unique_lock<std::mutex> lock(device_mutex);
     if (device == NULL)
     {
         dsp_status status = create_device();
@@ -220,7 +324,8 @@ dsp_status create_hailo_dsp_buffer(size_t size, void **buffer, bool dma)
         else
         {
             LOGGER__MODULE__DEBUG(MODULE_NAME, "Creating dsp buffer with size {}", size);
-            dsp_status status = dsp_create_buffer(device, size, buffer);
+            dsp_status status = dsp_cpu::is_cpu_device(device) ? dsp_cpu::create_buffer(size, buffer)
+                                                               : HAILODSP_CALL(dsp_create_buffer(device, size, buffer));
             if (status != DSP_SUCCESS)
             {
                 LOGGER__MODULE__ERROR(MODULE_NAME, "Create buffer failed with status {}", status);
@@ -251,7 +356,8 @@ void release_hailo_dsp_buffer(void *buffer)
     }
 
     LOGGER__MODULE__DEBUG(MODULE_NAME, "Releasing dsp buffer");
-    dsp_status status = dsp_release_buffer(device, buffer);
+    dsp_status status = dsp_cpu::is_cpu_device(device) ? dsp_cpu::release_buffer(buffer)
+                                                       : HAILODSP_CALL(dsp_release_buffer(device, buffer));
     if (status != DSP_SUCCESS)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "DSP release buffer failed with status {}", status);
@@ -262,6 +368,330 @@ void release_hailo_dsp_buffer(void *buffer)
     return;
 }
 
+/**
+ * Execute a DSP operation on the calling thread
+ * Both the synchronous perform_dsp_* functions and the asynchronous workers execute their operations through it.
+ *
+ * @param[in] dsp the device to execute the operation on
+ * @param[in] trace_name name of the operation in the DSP trace track
+ * @param[in] job the operation
+ * @return dsp_status
+ */
+template <typename Job>
+static dsp_status run_dsp_job(dsp_device dsp, [[maybe_unused]] const char *trace_name, Job &&job)
+{
+    dsp_status status;
+    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN(perfetto::StaticString(trace_name), DSP_THREADED_TRACK);
+    status = job(dsp);
+    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
+    return status;
+}
+
+/*
+  Jobs of the DSP operations, shared by the synchronous and asynchronous variants. The top level parameter structs and
+  image properties are copied into the job, what they point to (planes, crop and resize groups, meshes, overlays and
+  privacy mask params) is not.
+*/
+static auto frontend_process_job(const dsp_frontend_params_t &frontend_params)
+{
+    return [frontend_params](dsp_device dsp) { return backend_frontend_process(dsp, &frontend_params); };
+}
+
+static auto multi_resize_job(const dsp_multi_crop_resize_params_t *multi_crop_resize_params)
+{
+    return [multi_crop_resize_params = *multi_crop_resize_params](dsp_device dsp) mutable {
+        return backend_multi_crop_and_resize(dsp, &multi_crop_resize_params);
+    };
+}
+
+static auto privacy_mask_job(const dsp_image_properties_t *image_properties,
+                             const unified_dsp_privacy_mask_t *privacy_mask_params)
+{
+    return [image_properties = *image_properties, privacy_mask_params](dsp_device dsp) mutable {
+        return backend_privacy_mask(dsp, &image_properties, privacy_mask_params);
+    };
+}
+
+static auto dewarp_job(const dsp_image_properties_t *input_image_properties,
+                       const dsp_image_properties_t *output_image_properties, dsp_dewarp_mesh_t *mesh,
+                       dsp_interpolation_type_t interpolation)
+{
+    return [input_image_properties = *input_image_properties, output_image_properties = *output_image_properties,
+            mesh, interpolation](dsp_device dsp) mutable {
+        return backend_dewarp(dsp, &input_image_properties, &output_image_properties, mesh, interpolation);
+    };
+}
+
+static auto multiblend_job(const dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlay,
+                           size_t overlays_count)
+{
+    return [image_frame = *image_frame, overlay, overlays_count](dsp_device dsp) mutable {
+        return backend_blend(dsp, &image_frame, overlay, overlays_count);
+    };
+}
+
+DspFence::DspFence() : m_signaled(false), m_status(DSP_SUCCESS), m_fd(-1)
+{
+}
+
+DspFence::~DspFence()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+dsp_status DspFence::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_signaled; });
+    return m_status;
+}
+
+std::optional<dsp_status> DspFence::wait_for(const std::chrono::milliseconds &timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_cv.wait_for(lock, timeout, [this] { return m_signaled; }))
+        return std::nullopt;
+    return m_status;
+}
+
+bool DspFence::is_signaled()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_signaled;
+}
+
+int DspFence::fd()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+    {
+        // A fence signaled before its fd was requested starts readable
+        m_fd = eventfd(m_signaled ? 1 : 0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_fd < 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to create DSP fence eventfd, errno {}", errno);
+        }
+    }
+    return m_fd;
+}
+
+void DspFence::signal(dsp_status status)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_status = status;
+        m_signaled = true;
+        if (m_fd >= 0)
+        {
+            uint64_t value = 1;
+            if (write(m_fd, &value, sizeof(value)) != sizeof(value))
+            {
+                LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to signal DSP fence eventfd, errno {}", errno);
+            }
+        }
+    }
+    m_cv.notify_all();
+}
+
+/**
+ * Queue of the asynchronous DSP jobs
+ * The jobs are started in submission order by MEDIALIB_DSP_ASYNC_WORKERS threads, which are created with the first
+ * submission. The queue depth bounds the jobs submitted and not completed yet, a submission to a full queue blocks,
+ * unless the CPU fallback is enabled and the job can run on the CPU backend - it then runs on the submitting thread.
+ */
+class DspJobQueue
+{
+  public:
+    static DspJobQueue &get_instance()
+    {
+        static DspJobQueue instance;
+        return instance;
+    }
+
+    void set_depth(size_t depth)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_depth = depth;
+        }
+        m_slot_available.notify_all();
+    }
+
+    DspFencePtr submit(const char *trace_name, dsp_job_t job, bool cpu_capable)
+    {
+        DspFencePtr fence = std::make_shared<DspFence>();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_workers.empty())
+            {
+                for (int i = 0; i < MEDIALIB_DSP_ASYNC_WORKERS; i++)
+                    m_workers.emplace_back([this] { worker_loop(); });
+            }
+
+            if (m_pending >= m_depth && cpu_capable && cpu_fallback_enabled.load(std::memory_order_relaxed))
+            {
+                lock.unlock();
+                LOGGER__MODULE__DEBUG(MODULE_NAME, "DSP queue is full, running {} on the CPU", trace_name);
+                fence->signal(run_cpu_job(trace_name, job));
+                return fence;
+            }
+            m_slot_available.wait(lock, [this] { return m_pending < m_depth; });
+            m_pending++;
+            m_jobs.push_back({trace_name, std::move(job), fence});
+        }
+        m_job_available.notify_one();
+        return fence;
+    }
+
+  private:
+    struct queued_job_t
+    {
+        const char *trace_name;
+        dsp_job_t job;
+        DspFencePtr fence;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_job_available;
+    std::condition_variable m_slot_available;
+    std::deque<queued_job_t> m_jobs;
+    // jobs submitted and not completed yet, queued or executing
+    size_t m_pending = 0;
+    size_t m_depth = MEDIALIB_DSP_ASYNC_QUEUE_DEPTH;
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+
+    DspJobQueue()
+    {
+        // The workers unregister from the threading manager when they exit, it has to outlive the queue
+        ThreadingManager::get_instance();
+    }
+
+    ~DspJobQueue()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_job_available.notify_all();
+        for (std::thread &worker : m_workers)
+            worker.join();
+    }
+
+    static dsp_status run_cpu_job([[maybe_unused]] const char *trace_name, dsp_job_t &job)
+    {
+        dsp_status status;
+        HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN(perfetto::StaticString(trace_name), DSP_THREADED_TRACK);
+        status = job(dsp_cpu::device());
+        HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
+        return status;
+    }
+
+    void worker_loop()
+    {
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_DSP_ASYNC);
+
+        for (;;)
+        {
+            queued_job_t queued_job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_job_available.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                // Queued jobs are still executed when stopping, their submitters may wait on the fences
+                if (m_jobs.empty())
+                    return;
+                queued_job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            dsp_device dsp;
+            {
+                std::unique_lock<std::mutex> lock(device_mutex);
+                dsp = device;
+            }
+
+            dsp_status status;
+            if (dsp == NULL)
+            {
+                LOGGER__MODULE__ERROR(MODULE_NAME, "Asynchronous DSP job {} failed: device is NULL",
+                                      queued_job.trace_name);
+                status = DSP_UNINITIALIZED;
+            }
+            else
+            {
+                status = run_dsp_job(dsp, queued_job.trace_name, queued_job.job);
+            }
+            queued_job.fence->signal(status);
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_pending--;
+            }
+            m_slot_available.notify_one();
+        }
+    }
+};
+
+dsp_status set_async_queue_depth(size_t depth)
+{
+    if (depth == 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Invalid asynchronous DSP queue depth 0");
+        return DSP_INVALID_ARGUMENT;
+    }
+
+    LOGGER__MODULE__INFO(MODULE_NAME, "Setting asynchronous DSP queue depth to {}", depth);
+    DspJobQueue::get_instance().set_depth(depth);
+    return DSP_SUCCESS;
+}
+
+DspFencePtr submit_dsp_job(const char *trace_name, dsp_job_t job)
+{
+    return DspJobQueue::get_instance().submit(trace_name, std::move(job), false);
+}
+
+void set_cpu_fallback(bool enabled)
+{
+    LOGGER__MODULE__INFO(MODULE_NAME, "{} the CPU fallback of the asynchronous DSP queue",
+                         enabled ? "Enabling" : "Disabling");
+    cpu_fallback_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+DspFencePtr submit_dsp_frontend_process(const dsp_frontend_params_t &frontend_params)
+{
+    // The CPU backend does not support the privacy masks of the frontend process
+    return DspJobQueue::get_instance().submit("dsp_frontend_process", frontend_process_job(frontend_params),
+                                              frontend_params.privacy_mask_params == nullptr);
+}
+
+DspFencePtr submit_dsp_multi_resize(dsp_multi_crop_resize_params_t *multi_crop_resize_params)
+{
+    return DspJobQueue::get_instance().submit("dsp_multi_crop_and_resize", multi_resize_job(multi_crop_resize_params),
+                                              true);
+}
+
+DspFencePtr submit_dsp_privacy_mask(dsp_image_properties_t *image_properties,
+                                    const unified_dsp_privacy_mask_t *privacy_mask_params)
+{
+    return DspJobQueue::get_instance().submit("dsp_privacy_mask",
+                                              privacy_mask_job(image_properties, privacy_mask_params), true);
+}
+
+DspFencePtr submit_dsp_dewarp(dsp_image_properties_t *input_image_properties,
+                              dsp_image_properties_t *output_image_properties, dsp_dewarp_mesh_t *mesh,
+                              dsp_interpolation_type_t interpolation)
+{
+    return DspJobQueue::get_instance().submit(
+        "dsp_dewarp", dewarp_job(input_image_properties, output_image_properties, mesh, interpolation), true);
+}
+
+DspFencePtr submit_dsp_multiblend(dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlay,
+                                  size_t overlays_count)
+{
+    return DspJobQueue::get_instance().submit("dsp_blend", multiblend_job(image_frame, overlay, overlays_count), true);
+}
+
 /**
  * Perform DSP Resize
  * This function calls the DSP library to perform resize on a given buffer.
@@ -311,7 +741,7 @@ dsp_status perform_resize(dsp_image_properties_t *input_image_properties,
     }
 
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_crop_and_resize_letterbox", DSP_THREADED_TRACK);
-    dsp_status status = dsp_crop_and_resize_letterbox(device, &resize_params, &crop_params, &letterbox_params);
+    dsp_status status = backend_crop_and_resize_letterbox(device, &resize_params, &crop_params, &letterbox_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
 
     if (status != DSP_SUCCESS)
@@ -375,13 +805,13 @@ dsp_status perform_crop_and_resize(dsp_image_properties_t *input_image_propertie
             .end_y = args.crop_end_y,
         };
         HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_crop_and_resize_letterbox", DSP_THREADED_TRACK);
-        status = dsp_crop_and_resize_letterbox(device, &resize_params, &crop_params, &letterbox_params);
+        status = backend_crop_and_resize_letterbox(device, &resize_params, &crop_params, &letterbox_params);
         HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     }
     else
     {
         HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_crop_and_resize_letterbox", DSP_THREADED_TRACK);
-        status = dsp_crop_and_resize_letterbox(device, &resize_params, nullptr, &letterbox_params);
+        status = backend_crop_and_resize_letterbox(device, &resize_params, nullptr, &letterbox_params);
         HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     }
 
@@ -460,11 +890,7 @@ dsp_status perform_crop_and_resize(hailo_buffer_data_t *input_buffer_data, hailo
  */
 dsp_status perform_dsp_multi_resize(dsp_multi_crop_resize_params_t *multi_crop_resize_params)
 {
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_multi_crop_and_resize", DSP_THREADED_TRACK);
-    status = dsp_multi_crop_and_resize(device, multi_crop_resize_params);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return run_dsp_job(device, "dsp_multi_crop_and_resize", multi_resize_job(multi_crop_resize_params));
 }
 
 /**
@@ -481,7 +907,7 @@ dsp_status perform_dsp_multi_resize(dsp_multi_crop_resize_params_t *multi_crop_r
 {
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_multi_crop_and_resize_privacy_mask", DSP_THREADED_TRACK);
-    status = dsp_multi_crop_and_resize_privacy_mask(device, multi_crop_resize_params, privacy_mask_params);
+    status = backend_multi_crop_and_resize_privacy_mask(device, multi_crop_resize_params, privacy_mask_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -506,7 +932,7 @@ dsp_status perform_dsp_telescopic_multi_resize(dsp_multi_crop_resize_params_t *m
     };
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_telescopic_multi_resize", DSP_THREADED_TRACK);
-    status = dsp_frontend_process(device, &frontend_params);
+    status = backend_frontend_process(device, &frontend_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -532,7 +958,7 @@ dsp_status perform_dsp_telescopic_multi_resize(dsp_multi_crop_resize_params_t *m
     };
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_telescopic_multi_resize", DSP_THREADED_TRACK);
-    status = dsp_frontend_process(device, &frontend_params);
+    status = backend_frontend_process(device, &frontend_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -557,7 +983,7 @@ dsp_status perform_dsp_telescopic_multi_resize(dsp_multi_crop_resize_params_t *m
     };
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_telescopic_multi_resize", DSP_THREADED_TRACK);
-    status = dsp_frontend_process(device, &frontend_params);
+    status = backend_frontend_process(device, &frontend_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -580,7 +1006,7 @@ dsp_status perform_dsp_telescopic_multi_resize(dsp_multi_crop_resize_params_t *m
     };
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_telescopic_multi_resize", DSP_THREADED_TRACK);
-    status = dsp_frontend_process(device, &frontend_params);
+    status = backend_frontend_process(device, &frontend_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -597,11 +1023,7 @@ dsp_status perform_dsp_telescopic_multi_resize(dsp_multi_crop_resize_params_t *m
  */
 dsp_status perform_dsp_frontend_process(const dsp_frontend_params_t &frontend_params)
 {
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_frontend_process", DSP_THREADED_TRACK);
-    status = dsp_frontend_process(device, &frontend_params);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return run_dsp_job(device, "dsp_frontend_process", frontend_process_job(frontend_params));
 }
 
 /**
@@ -621,12 +1043,9 @@ dsp_status perform_dsp_privacy_mask(hailo_buffer_data_t *input_buffer_data,
         return DSP_SUCCESS;
     }
 
-    dsp_status status;
     hailo_dsp_buffer_data_t input_dsp_buffer_data = input_buffer_data->As<hailo_dsp_buffer_data_t>();
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_privacy_mask", DSP_THREADED_TRACK);
-    status = dsp_privacy_mask(device, &input_dsp_buffer_data.properties, privacy_mask_params);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return run_dsp_job(device, "dsp_privacy_mask",
+                       privacy_mask_job(&input_dsp_buffer_data.properties, privacy_mask_params));
 }
 
 dsp_status perform_dsp_dewarp(dsp_image_properties_t *input_image_properties,
@@ -655,7 +1074,7 @@ dsp_status perform_dsp_dewarp(dsp_image_properties_t *input_image_properties,
     };
     dsp_status status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_rot_dis_dewarp", DSP_THREADED_TRACK);
-    status = dsp_rot_dis_dewarp(device, &dewarp_params);
+    status = backend_rot_dis_dewarp(device, &dewarp_params);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
     return status;
 }
@@ -664,11 +1083,8 @@ dsp_status perform_dsp_dewarp(dsp_image_properties_t *input_image_properties,
                               dsp_image_properties_t *output_image_properties, dsp_dewarp_mesh_t *mesh,
                               dsp_interpolation_type_t interpolation)
 {
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_dewarp", DSP_THREADED_TRACK);
-    status = dsp_dewarp(device, input_image_properties, output_image_properties, mesh, interpolation);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return run_dsp_job(device, "dsp_dewarp",
+                       dewarp_job(input_image_properties, output_image_properties, mesh, interpolation));
 }
 
 /**
@@ -685,11 +1101,7 @@ dsp_status perform_dsp_dewarp(dsp_image_properties_t *input_image_properties,
 dsp_status perform_dsp_multiblend(dsp_image_properties_t *image_frame, dsp_overlay_properties_t *overlay,
                                   size_t overlays_count)
 {
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_blend", DSP_THREADED_TRACK);
-    status = dsp_blend(device, image_frame, overlay, overlays_count);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return run_dsp_job(device, "dsp_blend", multiblend_job(image_frame, overlay, overlays_count));
 }
 
 dsp_status perform_dsp_dewarp(hailo_buffer_data_t *input_buffer_data, hailo_buffer_data_t *output_buffer_data,
@@ -711,12 +1123,8 @@ dsp_status perform_dsp_dewarp(hailo_buffer_data_t *input_buffer_data, hailo_buff
 {
     hailo_dsp_buffer_data_t input_dsp_buffer_data = input_buffer_data->As<hailo_dsp_buffer_data_t>();
     hailo_dsp_buffer_data_t output_dsp_buffer_data = output_buffer_data->As<hailo_dsp_buffer_data_t>();
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_dewarp", DSP_THREADED_TRACK);
-    status =
-        dsp_dewarp(device, &input_dsp_buffer_data.properties, &output_dsp_buffer_data.properties, mesh, interpolation);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return perform_dsp_dewarp(&input_dsp_buffer_data.properties, &output_dsp_buffer_data.properties, mesh,
+                              interpolation);
 }
 
 /**
@@ -734,11 +1142,7 @@ dsp_status perform_dsp_multiblend(hailo_buffer_data_t *input_buffer_data, dsp_ov
                                   size_t overlays_count)
 {
     hailo_dsp_buffer_data_t input_dsp_buffer_data = input_buffer_data->As<hailo_dsp_buffer_data_t>();
-    dsp_status status;
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("dsp_blend", DSP_THREADED_TRACK);
-    status = dsp_blend(device, &input_dsp_buffer_data.properties, overlay, overlays_count);
-    HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
-    return status;
+    return perform_dsp_multiblend(&input_dsp_buffer_data.properties, overlay, overlays_count);
 }
 
 /**
@@ -166,7 +166,7 @@ void GyroDevice::dump_rec_samples(const std::string &file_path)
             continue;
         }
 
-        for (auto item = m_vector_samples->dequeue(); item.has_value(); item = m_vector_samples->dequeue())
+        for (auto item = m_vector_samples->pop(); item.has_value(); item = m_vector_samples->pop())
         {
             const auto &sample = item.value();
             file << std::left << std::setw(16) << idx << std::left << std::setw(16) << sample.vx << std::left
@@ -184,16 +184,16 @@ void GyroDevice::dump_rec_samples(const std::string &file_path)
 
 std::optional<gyro_sample_t> GyroDevice::get_closest_vsync_sample(uint64_t frame_timestamp)
 {
-    return m_vector_samples->find_last([frame_timestamp](const gyro_sample_t &sample) {
-        return IS_SAMPLE_VSYNC(sample) && sample.timestamp_ns <= frame_timestamp;
-    });
+    // Walk back from the newest sample not after the frame, the samples are ordered by timestamp
+    return m_vector_samples->find_last(frame_timestamp,
+                                       [](const gyro_sample_t &sample) { return IS_SAMPLE_VSYNC(sample); });
 }
 
 tl::expected<std::vector<gyro_sample_t>, gyro_status_t> GyroDevice::get_gyro_samples_by_threshold(
     uint64_t threshold_timestamp)
 {
-    auto samples = m_vector_samples->dequeue_many(
-        [&threshold_timestamp](const gyro_sample_t &sample) { return sample.timestamp_ns <= threshold_timestamp; });
+    std::vector<gyro_sample_t> samples;
+    m_vector_samples->pop_until(threshold_timestamp, samples);
 
     if (samples.empty())
     {
@@ -621,7 +621,13 @@ gyro_status_t GyroDevice::run()
         }
 
         iio_buffer_foreach_sample(m_iio_device_data.buf, rd_sample_demux, (void *)&samples);
-        m_vector_samples->enqueue_many(samples);
+        uint64_t dropped = m_vector_samples->dropped();
+        m_vector_samples->push_many(samples);
+        if (m_vector_samples->dropped() != dropped)
+        {
+            LOGGER__MODULE__DEBUG(MODULE_NAME, "Gyro samples buffer is full, dropped {} old samples so far",
+                                  m_vector_samples->dropped());
+        }
         samples.clear();
     }
 
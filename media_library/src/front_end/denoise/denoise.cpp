@@ -31,6 +31,7 @@
 #include "media_library_types.hpp"
 #include "media_library_utils.hpp"
 #include "hailo_media_library_perfetto.hpp"
+#include "threading_manager.hpp"
 
 #include <iostream>
 #include <linux/v4l2-controls.h>
@@ -327,10 +328,10 @@ media_library_return MediaLibraryDenoise::perform_subsequent_batches(HailoMediaL
  * the NN core
  *
  * @param[in] input_buffer - pointer to the input frame
- * @param[out] output_buffer - dewarp output buffer
+ * @param[out] output_buffer - set to the denoise output buffer
  */
 media_library_return MediaLibraryDenoise::perform_denoise(HailoMediaLibraryBufferPtr input_buffer,
-                                                          HailoMediaLibraryBufferPtr output_buffer)
+                                                          HailoMediaLibraryBufferPtr &output_buffer)
 {
     // Acquire buffer for denoise output
     if (acquire_output_buffer(output_buffer) != MEDIA_LIBRARY_SUCCESS)
@@ -346,6 +347,7 @@ media_library_return MediaLibraryDenoise::perform_denoise(HailoMediaLibraryBuffe
         LOGGER__MODULE__ERROR(MODULE_NAME, "input or output buffer is null");
         return media_library_return::MEDIA_LIBRARY_INVALID_ARGUMENT;
     }
+    copy_meta(input_buffer, output_buffer);
 
     if (m_loop_counter < m_loopback_limit)
     {
@@ -356,7 +358,7 @@ media_library_return MediaLibraryDenoise::perform_denoise(HailoMediaLibraryBuffe
 }
 
 media_library_return MediaLibraryDenoise::handle_frame(HailoMediaLibraryBufferPtr input_frame,
-                                                       HailoMediaLibraryBufferPtr output_frame)
+                                                       HailoMediaLibraryBufferPtr &output_frame)
 {
     if (!is_enabled())
     {
@@ -381,7 +383,6 @@ media_library_return MediaLibraryDenoise::handle_frame(HailoMediaLibraryBufferPt
     queue_timestamp_buffer(start_handle);
 
     // Denoise
-    copy_meta(input_frame, output_frame);
     media_library_return media_lib_ret = perform_denoise(input_frame, output_frame);
 
     if (media_lib_ret != MEDIA_LIBRARY_SUCCESS)
@@ -422,6 +423,7 @@ media_library_return MediaLibraryDenoise::observe(const MediaLibraryDenoise::cal
 void MediaLibraryDenoise::inference_callback_thread()
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "Inference callback thread started");
+    ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_DENOISE_CALLBACK);
 
     while (true)
     {
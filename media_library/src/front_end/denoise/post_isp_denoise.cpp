@@ -169,9 +169,13 @@ bool MediaLibraryPostIspDenoise::process_inference(HailoMediaLibraryBufferPtr in
         ->process(input_buffer, loopback_buffer, output_buffer);
 }
 
-media_library_return MediaLibraryPostIspDenoise::acquire_output_buffer(HailoMediaLibraryBufferPtr output_buffer)
+media_library_return MediaLibraryPostIspDenoise::acquire_output_buffer(HailoMediaLibraryBufferPtr &output_buffer)
 {
-    return m_output_buffer_pool->acquire_buffer(output_buffer);
+    auto output_buffer_expected = m_output_buffer_pool->acquire_buffer();
+    if (!output_buffer_expected.has_value())
+        return output_buffer_expected.error();
+    output_buffer = std::move(output_buffer_expected.value());
+    return media_library_return::MEDIA_LIBRARY_SUCCESS;
 }
 
 void MediaLibraryPostIspDenoise::copy_meta(HailoMediaLibraryBufferPtr input_buffer,
@@ -30,6 +30,7 @@
 #include "isp_utils.hpp"
 #include "sensor_registry.hpp"
 #include "video_device.hpp"
+#include "threading_manager.hpp"
 
 #include <linux/v4l2-controls.h>
 #include <linux/v4l2-subdev.h>
@@ -240,12 +241,13 @@ bool MediaLibraryPreIspDenoise::process_inference(HailoMediaLibraryBufferPtr inp
         }
 
         // DGAIN
-        HailoMediaLibraryBufferPtr dgain_buffer = std::make_shared<hailo_media_library_buffer>();
-        if (m_dgain_buffer_pool->acquire_buffer(dgain_buffer) != MEDIA_LIBRARY_SUCCESS)
+        auto dgain_buffer_expected = m_dgain_buffer_pool->acquire_buffer();
+        if (!dgain_buffer_expected.has_value())
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire DGAIN buffer for Pre-ISP denoise");
             return false;
         }
+        HailoMediaLibraryBufferPtr dgain_buffer = std::move(dgain_buffer_expected.value());
         if (DmaMemoryAllocator::get_instance().dmabuf_sync_start(dgain_buffer->get_plane_ptr(0)) !=
             MEDIA_LIBRARY_SUCCESS)
             return false;
@@ -254,12 +256,13 @@ bool MediaLibraryPreIspDenoise::process_inference(HailoMediaLibraryBufferPtr inp
             return false;
 
         // BLS
-        HailoMediaLibraryBufferPtr bls_buffer = std::make_shared<hailo_media_library_buffer>();
-        if (m_bls_buffer_pool->acquire_buffer(bls_buffer) != MEDIA_LIBRARY_SUCCESS)
+        auto bls_buffer_expected = m_bls_buffer_pool->acquire_buffer();
+        if (!bls_buffer_expected.has_value())
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire BLS buffer for Pre-ISP denoise");
             return false;
         }
+        HailoMediaLibraryBufferPtr bls_buffer = std::move(bls_buffer_expected.value());
         if (DmaMemoryAllocator::get_instance().dmabuf_sync_start(bls_buffer->get_plane_ptr(0)) != MEDIA_LIBRARY_SUCCESS)
             return false;
         *(reinterpret_cast<uint16_t *>(bls_buffer->get_plane_ptr(0))) = get_bls(v4l2::Video0Ctrl::BLS_RED);
@@ -279,7 +282,7 @@ bool MediaLibraryPreIspDenoise::process_inference(HailoMediaLibraryBufferPtr inp
         ->process(output_buffer, input_buffer, loopback_buffer);
 }
 
-media_library_return MediaLibraryPreIspDenoise::acquire_output_buffer(HailoMediaLibraryBufferPtr output_buffer)
+media_library_return MediaLibraryPreIspDenoise::acquire_output_buffer(HailoMediaLibraryBufferPtr &output_buffer)
 {
     LOGGER__MODULE__TRACE(MODULE_NAME, "Acquiring output buffer for Pre-ISP denoise");
 
@@ -306,7 +309,7 @@ media_library_return MediaLibraryPreIspDenoise::acquire_output_buffer(HailoMedia
     return media_library_return::MEDIA_LIBRARY_SUCCESS;
 }
 
-media_library_return MediaLibraryPreIspDenoise::acquire_dgain_buffer(HailoMediaLibraryBufferPtr dgain_buffer)
+media_library_return MediaLibraryPreIspDenoise::acquire_dgain_buffer(HailoMediaLibraryBufferPtr &dgain_buffer)
 {
     if (m_dgain_buffer_pool == nullptr)
     {
@@ -314,10 +317,14 @@ media_library_return MediaLibraryPreIspDenoise::acquire_dgain_buffer(HailoMediaL
         return media_library_return::MEDIA_LIBRARY_ERROR;
     }
     LOGGER__MODULE__TRACE(MODULE_NAME, "Acquiring DGAIN buffer");
-    return m_dgain_buffer_pool->acquire_buffer(dgain_buffer);
+    auto dgain_buffer_expected = m_dgain_buffer_pool->acquire_buffer();
+    if (!dgain_buffer_expected.has_value())
+        return dgain_buffer_expected.error();
+    dgain_buffer = std::move(dgain_buffer_expected.value());
+    return media_library_return::MEDIA_LIBRARY_SUCCESS;
 }
 
-media_library_return MediaLibraryPreIspDenoise::acquire_bls_buffer(HailoMediaLibraryBufferPtr bls_buffer)
+media_library_return MediaLibraryPreIspDenoise::acquire_bls_buffer(HailoMediaLibraryBufferPtr &bls_buffer)
 {
     if (m_bls_buffer_pool == nullptr)
     {
@@ -325,7 +332,11 @@ media_library_return MediaLibraryPreIspDenoise::acquire_bls_buffer(HailoMediaLib
         return media_library_return::MEDIA_LIBRARY_ERROR;
     }
     LOGGER__MODULE__TRACE(MODULE_NAME, "Acquiring BLS buffer");
-    return m_bls_buffer_pool->acquire_buffer(bls_buffer);
+    auto bls_buffer_expected = m_bls_buffer_pool->acquire_buffer();
+    if (!bls_buffer_expected.has_value())
+        return bls_buffer_expected.error();
+    bls_buffer = std::move(bls_buffer_expected.value());
+    return media_library_return::MEDIA_LIBRARY_SUCCESS;
 }
 
 void MediaLibraryPreIspDenoise::copy_meta(HailoMediaLibraryBufferPtr input_buffer,
@@ -596,6 +607,7 @@ media_library_return MediaLibraryPreIspDenoise::start_isp_thread()
     m_isp_thread_running = true;
     m_isp_thread = std::thread([this]() {
         LOGGER__MODULE__DEBUG(MODULE_NAME, "ISP thread started, waiting for stream start");
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_DENOISE_ISP);
 
         if (!wait_for_stream_start())
         {
@@ -30,6 +30,7 @@
 #include "media_library_logger.hpp"
 #include "media_library_utils.hpp"
 #include "snapshot.hpp"
+#include "profiled_mutex.hpp"
 #include <iostream>
 #include <linux/v4l2-controls.h>
 #include <linux/v4l2-subdev.h>
@@ -118,7 +119,7 @@ class MediaLibraryDewarp::Impl final
     media_library_return configure(ldc_config_t &ldc_configs);
 
     // Perform pre-processing on the input frame and return the output frames
-    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr output_frame);
+    media_library_return handle_frame(HailoMediaLibraryBufferPtr input_frame, HailoMediaLibraryBufferPtr &output_frame);
 
     // get the pre-processing configurations object
     ldc_config_t get_ldc_configs();
@@ -153,7 +154,7 @@ class MediaLibraryDewarp::Impl final
     // video fd
     int m_video_fd;
     // configuration mutex
-    std::shared_mutex rw_lock;
+    ProfiledSharedMutex rw_lock{"dewarp_config"};
 
     uint64_t m_curr_ae_integration_time;
     uint64_t m_curr_ae_integration_time_counter;
@@ -166,7 +167,7 @@ class MediaLibraryDewarp::Impl final
     media_library_return create_and_initialize_buffer_pools();
     media_library_return validate_input_frame(HailoMediaLibraryBufferPtr input_frame);
     media_library_return perform_dewarp(HailoMediaLibraryBufferPtr input_buffer,
-                                        HailoMediaLibraryBufferPtr dewarp_output_buffer);
+                                        HailoMediaLibraryBufferPtr &dewarp_output_buffer);
     media_library_return perform_angular_dis_dewarp(HailoMediaLibraryBufferPtr input_buffer,
                                                     HailoMediaLibraryBufferPtr dewarp_output_buffer,
                                                     dsp_dewarp_mesh_t *mesh);
@@ -202,7 +203,7 @@ media_library_return MediaLibraryDewarp::configure(ldc_config_t &ldc_configs)
 }
 
 media_library_return MediaLibraryDewarp::handle_frame(HailoMediaLibraryBufferPtr input_frame,
-                                                      HailoMediaLibraryBufferPtr output_frame)
+                                                      HailoMediaLibraryBufferPtr &output_frame)
 {
     media_library_return status;
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("MediaLibraryDewarp::handle_frame", DSP_THREADED_TRACK);
@@ -320,7 +321,7 @@ media_library_return MediaLibraryDewarp::Impl::configure(ldc_config_t &ldc_confi
 {
     // first check changes in ldc config relevant to multi resize (flip rotate)
     // and notify the multi resize element if needed
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     bool dsp_optimization = is_env_variable_on(MEDIALIB_DEWARP_DSP_OPTIMIZATION_ENV_VAR);
 
     auto prev_do_flip_rotate = !m_ldc_configs.check_ops_enabled(true);
@@ -470,7 +471,7 @@ media_library_return MediaLibraryDewarp::Impl::create_and_initialize_buffer_pool
 
     auto bytes_per_line = dsp_utils::get_dsp_desired_stride_from_width(width);
     // Forcing output video buffer pool to be max 5 buffers.
-    m_ldc_configs.application_input_streams_config.pool_max_buffers = 5;
+    m_ldc_configs.application_input_streams_config.pool_max_buffers = MediaLibraryDewarp::OUTPUT_POOL_MAX_BUFFERS;
     LOGGER__MODULE__INFO(
         MODULE_NAME,
         "Creating buffer pool named {} for output resolution: width {} height {} in buffers size of {} and "
@@ -539,20 +540,22 @@ media_library_return MediaLibraryDewarp::Impl::perform_angular_dis_dewarp(
  * the DSP
  *
  * @param[in] input_frame - pointer to the input frame
- * @param[out] dewarp_output_buffer - dewarp output buffer
+ * @param[out] dewarp_output_buffer - set to the dewarp output buffer, acquired from the output pool
  * @param[in] vsm - pointer to the vsm object
  */
 media_library_return MediaLibraryDewarp::Impl::perform_dewarp(HailoMediaLibraryBufferPtr input_buffer,
-                                                              HailoMediaLibraryBufferPtr dewarp_output_buffer)
+                                                              HailoMediaLibraryBufferPtr &dewarp_output_buffer)
 {
     struct timespec start_dewarp, end_dewarp;
 
     // Acquire buffer for dewarp output
-    if (m_output_buffer_pool->acquire_buffer(dewarp_output_buffer) != MEDIA_LIBRARY_SUCCESS)
+    auto output_buffer_expected = m_output_buffer_pool->acquire_buffer();
+    if (!output_buffer_expected.has_value())
     {
         // log: failed to acquire buffer for dewarp output
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
+    dewarp_output_buffer = std::move(output_buffer_expected.value());
 
     // Perform dewarp
     dsp_dewarp_mesh_t *mesh = m_dewarp_mesh_ctx->get();
@@ -612,9 +615,9 @@ media_library_return MediaLibraryDewarp::Impl::validate_input_frame(HailoMediaLi
     return MEDIA_LIBRARY_SUCCESS;
 }
 media_library_return MediaLibraryDewarp::Impl::handle_frame(HailoMediaLibraryBufferPtr input_frame,
-                                                            HailoMediaLibraryBufferPtr output_frame)
+                                                            HailoMediaLibraryBufferPtr &output_frame)
 {
-    std::shared_lock<std::shared_mutex> lock(rw_lock);
+    std::shared_lock<ProfiledSharedMutex> lock(rw_lock);
 
     // Stamp start time
     struct timespec start_handle, end_handle;
@@ -681,14 +684,14 @@ media_library_return MediaLibraryDewarp::Impl::handle_frame(HailoMediaLibraryBuf
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_BEGIN("perform_dewarp", DSP_THREADED_TRACK);
     media_lib_ret = perform_dewarp(input_frame, output_frame);
     HAILO_MEDIA_LIBRARY_TRACE_EVENT_END(DSP_THREADED_TRACK);
+    if (media_lib_ret != MEDIA_LIBRARY_SUCCESS)
+        return media_lib_ret;
+
     output_frame->copy_metadata_from(input_frame);
 
     output_frame->optical_zoom_magnification =
         m_ldc_configs.optical_zoom_config.enabled ? m_ldc_configs.optical_zoom_config.magnification : 1.0f;
 
-    if (media_lib_ret != MEDIA_LIBRARY_SUCCESS)
-        return media_lib_ret;
-
     increase_frame_counter();
 
     stamp_time_and_log_fps(start_handle, end_handle);
@@ -699,19 +702,19 @@ media_library_return MediaLibraryDewarp::Impl::handle_frame(HailoMediaLibraryBuf
 
 ldc_config_t MediaLibraryDewarp::Impl::get_ldc_configs()
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     return m_ldc_configs;
 }
 
 input_video_config_t MediaLibraryDewarp::Impl::get_input_video_config()
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     return m_ldc_configs.input_video_config;
 }
 
 output_resolution_t MediaLibraryDewarp::Impl::get_application_input_streams_config()
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     return m_ldc_configs.application_input_streams_config;
 }
 
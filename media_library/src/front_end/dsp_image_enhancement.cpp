@@ -4,6 +4,7 @@
 #include <cmath>
 #include <tuple>
 #include "media_library_logger.hpp"
+#include "threading_manager.hpp"
 
 #define MODULE_NAME LoggerType::Dsp
 
@@ -119,18 +120,18 @@ std::pair<uint8_t, uint8_t> DspImageEnhancement::find_percentile_pixels(const Hi
     uint32_t target_high_percent = static_cast<uint32_t>(total_pixels * percentile_high / 100.0);
 
     // Calculate the cumulative histogram
-    std::vector<uint32_t> cumulative_histogram(256);
-    std::partial_sum(std::begin(histogram), std::end(histogram), cumulative_histogram.begin());
+    uint32_t cumulative_histogram[DSP_HISTOGRAM_SIZE];
+    HistogramEqualizer::prefix_sum(histogram, cumulative_histogram);
 
     // Find the pixel values corresponding to these counts
     auto low_percent_it =
-        std::lower_bound(cumulative_histogram.begin(), cumulative_histogram.end(), target_low_percent);
+        std::lower_bound(std::begin(cumulative_histogram), std::end(cumulative_histogram), target_low_percent);
     auto high_percent_it =
-        std::lower_bound(cumulative_histogram.begin(), cumulative_histogram.end(), target_high_percent);
+        std::lower_bound(std::begin(cumulative_histogram), std::end(cumulative_histogram), target_high_percent);
 
     // Convert iterators to indices
-    return std::make_pair(std::distance(cumulative_histogram.begin(), low_percent_it),
-                          std::distance(cumulative_histogram.begin(), high_percent_it));
+    return std::make_pair(std::distance(std::begin(cumulative_histogram), low_percent_it),
+                          std::distance(std::begin(cumulative_histogram), high_percent_it));
 }
 
 void DspImageEnhancement::contrast_brightness_lowpass_filter(float contrast, int16_t brightness, float &new_contrast,
@@ -157,51 +158,12 @@ std::pair<float, int16_t> DspImageEnhancement::contrast_brightness_from_percenti
     return std::make_pair(contrast, brightness);
 }
 
-std::vector<double> DspImageEnhancement::clip_histogram(const Histogram &histogram, double clip_threshold)
-{
-    std::vector<double> clipped_hist(DSP_HISTOGRAM_SIZE);
-    std::transform(std::begin(histogram), std::end(histogram), clipped_hist.begin(),
-                   [](auto h) { return static_cast<double>(h); });
-
-    double sum_pixels_in_hist = std::accumulate(clipped_hist.begin(), clipped_hist.end(), 0.0);
-    double actual_clip_limit = clip_threshold * sum_pixels_in_hist / DSP_HISTOGRAM_SIZE;
-
-    double excess = 0;
-    for (auto &curr : clipped_hist)
-    {
-        if (curr > actual_clip_limit)
-        {
-            excess += curr - actual_clip_limit;
-            curr = actual_clip_limit;
-        }
-    }
-
-    /* Redistribute the excess between all the indeces in the histogram */
-    double redist = excess / DSP_HISTOGRAM_SIZE;
-    for (auto &curr : clipped_hist)
-    {
-        curr += redist;
-    }
-
-    return clipped_hist;
-}
-
 void DspImageEnhancement::update_lut(const Histogram &histogram)
 {
-    auto clipped_hist = clip_histogram(histogram, m_histogram_clip_thr);
-
-    /* Compute CDF */
-    std::vector<double> cdf(DSP_HISTOGRAM_SIZE);
-    /* cdf[i] = cdf[i - 1] + clipped_hist[i] */
-    std::partial_sum(clipped_hist.begin(), clipped_hist.end(), cdf.begin());
-
-    /* Normalize CDF and create LUT */
-    double cdf_max = cdf.back();
-    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+    /* Skipped while the histogram is steady, see HistogramEqualizer */
+    if (m_histogram_equalizer.update(histogram, m_histogram_clip_thr, m_histogram_alpha, m_histogram_eq_params.lut))
     {
-        m_histogram_eq_params.lut[i] =
-            static_cast<uint8_t>(m_histogram_alpha * m_histogram_eq_params.lut[i] +
-                                 (1 - m_histogram_alpha) * (((cdf[i] * 255.0) / cdf_max) + 0.5));
+        LOGGER__MODULE__TRACE(MODULE_NAME, "Histogram equalization LUT updated");
     }
 }
 
@@ -313,6 +275,8 @@ void DspImageEnhancement::update_dsp_params_from_isp()
 
 void DspImageEnhancement::read_params_from_isp()
 {
+    ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_ISP_PARAMS);
+
     struct mq_attr attr;
     attr.mq_flags = O_NONBLOCK;
     attr.mq_maxmsg = 10;
@@ -28,6 +28,7 @@
 #pragma once
 
 #include "dsp_utils.hpp"
+#include "histogram_equalizer.hpp"
 #include <mqueue.h>
 #include <functional>
 #include <shared_mutex>
@@ -69,7 +70,6 @@ class DspImageEnhancement
                                                                          uint32_t sample_size = histogram_sample_size);
     static std::pair<uint8_t, uint8_t> find_percentile_pixels(const Histogram &histogram, float percentile_low,
                                                               float percentile_high);
-    static std::vector<double> clip_histogram(const Histogram &histogram, double clip_threshold);
 
     DspImageEnhancement();
     ~DspImageEnhancement();
@@ -109,6 +109,8 @@ class DspImageEnhancement
     isp_image_enhancement_params_t m_isp_params;
     dsp_image_enhancement_histogram_t m_dsp_histogram_params;
     dsp_histogram_equalization_params_t m_histogram_eq_params;
+    // Fixed point LUT generation, the LUT above is rewritten only when it changes
+    HistogramEqualizer m_histogram_equalizer;
     dsp_image_enhancement_params_t m_dsp_params;
     bool m_do_histogram_equalization;
     double m_histogram_clip_thr;
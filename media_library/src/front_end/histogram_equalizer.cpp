@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "histogram_equalizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(DSP_HISTOGRAM_SIZE % 4 == 0, "The prefix sum processes the histogram 4 bins at a time");
+
+// The clipped bins are kept with 8 fractional bits in 32 bits
+static constexpr uint32_t MAX_TOTAL_BITS = 23;
+
+HistogramEqualizer::HistogramEqualizer()
+{
+    reset();
+}
+
+void HistogramEqualizer::reset()
+{
+    memset(m_histogram, 0, sizeof(m_histogram));
+    m_total = 0;
+    m_clip_threshold = 0;
+    m_alpha = 0;
+    m_converged = false;
+}
+
+void HistogramEqualizer::prefix_sum(const uint32_t *in, uint32_t *out)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i carry = _mm_setzero_si128();
+    for (; i < DSP_HISTOGRAM_SIZE; i += 4)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)(in + i));
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+        value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+        value = _mm_add_epi32(value, carry);
+        _mm_storeu_si128((__m128i *)(out + i), value);
+        carry = _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t carry = zero;
+    for (; i < DSP_HISTOGRAM_SIZE; i += 4)
+    {
+        uint32x4_t value = vld1q_u32(in + i);
+        value = vaddq_u32(value, vextq_u32(zero, value, 3));
+        value = vaddq_u32(value, vextq_u32(zero, value, 2));
+        value = vaddq_u32(value, carry);
+        vst1q_u32(out + i, value);
+        carry = vdupq_n_u32(vgetq_lane_u32(value, 3));
+    }
+#endif
+    uint32_t sum = i > 0 ? out[i - 1] : 0;
+    for (; i < DSP_HISTOGRAM_SIZE; i++)
+    {
+        sum += in[i];
+        out[i] = sum;
+    }
+}
+
+bool HistogramEqualizer::histogram_changed(const uint32_t *histogram, uint64_t total) const
+{
+    uint64_t distance = 0;
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+        distance += histogram[i] > m_histogram[i] ? histogram[i] - m_histogram[i] : m_histogram[i] - histogram[i];
+    return (distance << 16) > HYSTERESIS * std::max(total, m_total);
+}
+
+bool HistogramEqualizer::update(const uint32_t *histogram, double clip_threshold, double alpha, uint8_t *lut)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+        total += histogram[i];
+    if (total == 0)
+        return false;
+
+    if (m_converged && clip_threshold == m_clip_threshold && alpha == m_alpha && !histogram_changed(histogram, total))
+        return false;
+
+    memcpy(m_histogram, histogram, sizeof(m_histogram));
+    m_total = total;
+    m_clip_threshold = clip_threshold;
+    m_alpha = alpha;
+
+    // Large histograms are scaled down, the LUT depends only on the proportions of the bins
+    uint32_t shift = 0;
+    while ((total >> shift) >= (1u << MAX_TOTAL_BITS))
+        shift++;
+    uint32_t scaled_total = 0;
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+        scaled_total += histogram[i] >> shift;
+
+    // Clip the bins, with 8 fractional bits, the limit is clip_threshold * total / DSP_HISTOGRAM_SIZE
+    const uint64_t all_samples = static_cast<uint64_t>(scaled_total) << 8;
+    const uint32_t limit = static_cast<uint32_t>(
+        std::llround(std::clamp(clip_threshold * scaled_total, 0.0, static_cast<double>(all_samples))));
+    uint32_t excess = 0;
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+    {
+        uint32_t value = (histogram[i] >> shift) << 8;
+        m_clipped[i] = std::min(value, limit);
+        excess += value - m_clipped[i];
+    }
+    prefix_sum(m_clipped, m_cdf);
+
+    // The excess is spread evenly over the bins, so the cumulative sum of the clipped histogram with its share of the
+    // excess is 256 * m_cdf[i] + (i + 1) * excess with 16 fractional bits, and all_samples << 8 at the last bin
+    // The normalization divides by cdf_max through a multiplication by its 64 bit reciprocal
+    const uint64_t cdf_max = all_samples << 8;
+    const unsigned __int128 reciprocal = ((static_cast<unsigned __int128>(1) << 64) + cdf_max - 1) / cdf_max;
+    const uint64_t alpha_q16 = static_cast<uint64_t>(std::clamp(std::llround(alpha * 65536), 0LL, 65536LL));
+    bool changed = false;
+    for (size_t i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+    {
+        const uint64_t cdf = (static_cast<uint64_t>(m_cdf[i]) << 8) + (i + 1) * static_cast<uint64_t>(excess);
+        // The equalized value with 8 fractional bits, rounded before the blend with the previous LUT
+        const uint64_t target = static_cast<uint64_t>((cdf * 255 * 256 * reciprocal) >> 64) + 128;
+        const uint64_t value = (alpha_q16 * (static_cast<uint64_t>(lut[i]) << 8) + (65536 - alpha_q16) * target) >> 24;
+        m_lut[i] = static_cast<uint8_t>(std::min<uint64_t>(value, 255));
+        changed |= m_lut[i] != lut[i];
+    }
+
+    m_converged = !changed;
+    if (changed)
+        memcpy(lut, m_lut, sizeof(m_lut));
+    return changed;
+}
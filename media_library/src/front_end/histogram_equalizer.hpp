@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file histogram_equalizer.hpp
+ * @brief Fixed point histogram equalization of the DSP image enhancement
+ **/
+
+#pragma once
+#include "dsp_utils.hpp"
+
+/**
+ * @brief Computes the histogram equalization LUT of the DSP from its luma histograms.
+ *
+ * The histogram is clipped at a multiple of its mean and the excess is spread over all the bins, the LUT is the
+ * normalized cumulative sum of the clipped histogram blended with the previous LUT. The computation is in integers
+ * with 16 fractional bits and uses preallocated storage, and matches the former double implementation within 1 level.
+ *
+ * Once the LUT stops changing, it is regenerated only when the histogram moves by more than a fraction of its
+ * samples from the one the LUT was generated for, so a steady scene costs a comparison of the histograms per frame.
+ */
+class HistogramEqualizer
+{
+  public:
+    HistogramEqualizer();
+
+    /**
+     * @brief Forgets the histogram the LUT was generated for, the next update regenerates it
+     */
+    void reset();
+
+    /**
+     * @brief Moves a LUT toward the equalization of a histogram
+     *
+     * @param[in] histogram - luma histogram of DSP_HISTOGRAM_SIZE bins
+     * @param[in] clip_threshold - clip limit of the bins, relative to the mean of the histogram
+     * @param[in] alpha - weight of the previous LUT in the new one
+     * @param[in,out] lut - LUT of DSP_HISTOGRAM_SIZE entries, written only when it changes
+     * @return bool - true if the LUT changed
+     */
+    bool update(const uint32_t *histogram, double clip_threshold, double alpha, uint8_t *lut);
+
+    /**
+     * @brief Cumulative sum of DSP_HISTOGRAM_SIZE bins
+     */
+    static void prefix_sum(const uint32_t *in, uint32_t *out);
+
+  private:
+    // Change of the histogram below which a converged LUT is kept, in 1/65536 of the samples
+    static constexpr uint64_t HYSTERESIS = 1024;
+
+    bool histogram_changed(const uint32_t *histogram, uint64_t total) const;
+
+    alignas(16) uint32_t m_histogram[DSP_HISTOGRAM_SIZE];
+    alignas(16) uint32_t m_clipped[DSP_HISTOGRAM_SIZE];
+    alignas(16) uint32_t m_cdf[DSP_HISTOGRAM_SIZE];
+    uint8_t m_lut[DSP_HISTOGRAM_SIZE];
+    uint64_t m_total;
+    double m_clip_threshold;
+    double m_alpha;
+    // the LUT was generated for m_histogram with the same parameters, and did not change
+    bool m_converged;
+};
@@ -25,6 +25,7 @@
 #include "media_library_logger.hpp"
 #include "gyro_device.hpp"
 #include "common.hpp"
+#include "threading_manager.hpp"
 
 #define MODULE_NAME LoggerType::LdcMesh
 #define CALIBRATION_VECOTR_SIZE 1024
@@ -409,7 +410,10 @@ media_library_return LdcMeshContext::initialize_dis_context()
         set_handler(SIGTERM, &handle_sig);
         sigfillset(&set);
         pthread_sigmask(SIG_BLOCK, &set, &oldset);
-        gyroThread = std::thread(&GyroDevice::run, gyroApi.get());
+        gyroThread = std::thread([gyro = gyroApi.get()]() {
+            ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_GYRO);
+            gyro->run();
+        });
         m_gyro_initialized = true;
         pthread_sigmask(SIG_SETMASK, &oldset, NULL);
     }
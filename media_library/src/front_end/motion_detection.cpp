@@ -1,14 +1,13 @@
-#include "opencv2/imgproc.hpp"
-#include "opencv2/imgcodecs.hpp"
-#include "opencv2/highgui.hpp"
-#include "opencv2/core/core.hpp"
-
 #include "buffer_pool.hpp"
 #include "config_manager.hpp"
 #include "dsp_utils.hpp"
 #include "media_library_logger.hpp"
 #include "media_library_utils.hpp"
 #include "motion_detection.hpp"
+#include "threading_manager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <stdint.h>
 #include <string>
@@ -24,32 +23,65 @@ MotionDetection::MotionDetection()
     m_motion_detection_config = {};
     m_motion_detection_buffer_pool = nullptr;
     m_motion_detection_previous_buffer_ptr = nullptr;
-    m_motion_detection_roi = cv::Rect(0, 0, 0, 0);
+    m_motion_detection_roi = {};
+    m_motion_map_width = 0;
+    m_motion_map_height = 0;
+    m_worker_stop = false;
+    m_mailbox_frame_index = 0;
+    m_frame_index = 0;
+    m_processed_frame_index = 0;
+    m_motion_map_free_list = std::make_shared<motion_map_free_list_t>();
 }
 
-MotionDetection::MotionDetection(motion_detection_config_t &motion_detection_config)
+MotionDetection::MotionDetection(motion_detection_config_t &motion_detection_config) : MotionDetection()
 {
     m_motion_detection_config = motion_detection_config;
-    m_motion_detection_buffer_pool = nullptr;
-    m_motion_detection_previous_buffer_ptr = nullptr;
+}
+
+MotionDetection::~MotionDetection()
+{
+    stop_worker();
 }
 
 void MotionDetection::deinit()
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "MotionDetection deinit: releasing multi-resize refs");
 
-    m_motion_detection_previous_frame.release();
-    m_motion_detection_current_frame.release();
-    m_motion_detection_mask.release();
+    stop_worker();
 
     // this is the key: drop the last multi_resize output buffer ref
     m_motion_detection_previous_buffer_ptr.reset();
+    m_motion_reference.reset();
+    {
+        std::unique_lock<std::mutex> lock(m_motion_map_free_list->mutex);
+        m_motion_map_free_list->maps.clear();
+    }
 }
 
 media_library_return MotionDetection::allocate_motion_detection(uint32_t max_buffer_pool_size)
 {
-    m_motion_detection_roi = cv::Rect(m_motion_detection_config.roi.x, m_motion_detection_config.roi.y,
-                                      m_motion_detection_config.roi.width, m_motion_detection_config.roi.height);
+    if (m_motion_detection_config.asynchronous)
+    {
+        start_worker();
+    }
+    else
+    {
+        // Switched to synchronous, the idle worker would keep its last result and the buffers it holds
+        stop_worker();
+    }
+
+    std::unique_lock<std::mutex> processing_lock(m_processing_mutex);
+    m_motion_detection_roi = m_motion_detection_config.roi;
+
+    const motion_reference_config_t &compact_reference = m_motion_detection_config.compact_reference;
+    if (compact_reference.enabled && compact_reference.quantize && compact_reference.background_learning_rate <= 0 &&
+        m_motion_detection_config.sensitivity_level < motion_detection_sensitivity_levels_t::MEDIUM)
+    {
+        LOGGER__MODULE__WARNING(MODULE_NAME,
+                                "Motion detection reference quantized to 4 bits is off by up to 8 levels, close to "
+                                "the sensitivity threshold {}",
+                                static_cast<int>(m_motion_detection_config.sensitivity_level));
+    }
 
     // Decide actual pool size: config overrides, 0 means "use default"
     uint32_t pool_size = (m_motion_detection_config.buffer_pool_size > 0) ? m_motion_detection_config.buffer_pool_size
@@ -92,22 +124,147 @@ media_library_return MotionDetection::allocate_motion_detection(uint32_t max_buf
 
 media_library_return MotionDetection::perform_motion_detection(std::vector<HailoMediaLibraryBufferPtr> &output_frames)
 {
-    struct timespec start_resize, end_resize;
-    clock_gettime(CLOCK_MONOTONIC, &start_resize);
+    if (!is_frame_valid(output_frames.back()))
+    {
+        return MEDIA_LIBRARY_SUCCESS;
+    }
+
+    if (m_motion_detection_config.asynchronous)
+    {
+        return perform_motion_detection_async(output_frames);
+    }
+
+    motion_result_t result = {};
+    media_library_return ret = process_frame(output_frames.back(), result);
+    if (ret != MEDIA_LIBRARY_SUCCESS)
+    {
+        return ret;
+    }
+
+    if (result.bitmask_buffer != nullptr)
+    {
+        update_output_frames(output_frames, result, 0);
+    }
+    return MEDIA_LIBRARY_SUCCESS;
+}
 
-    HailoMediaLibraryBufferPtr motion_detection_current_buffer_ptr = output_frames.back();
-    if (!is_frame_valid(motion_detection_current_buffer_ptr))
+media_library_return
+MotionDetection::perform_motion_detection_async(std::vector<HailoMediaLibraryBufferPtr> &output_frames)
+{
+    std::unique_lock<std::mutex> lock(m_mailbox_mutex);
+    const uint64_t frame_index = ++m_frame_index;
+    if (m_mailbox_frame != nullptr)
+    {
+        LOGGER__MODULE__TRACE(MODULE_NAME, "Motion detection is busy, skipping frame {}", m_mailbox_frame_index);
+    }
+    m_mailbox_frame = output_frames.back();
+    m_mailbox_frame_index = frame_index;
+    m_mailbox_condition.notify_one();
+
+    // Wait for the result of this frame until the deadline, otherwise the latest result is attached
+    if (m_motion_detection_config.result_deadline_ms > 0)
+    {
+        m_result_condition.wait_for(lock, std::chrono::milliseconds(m_motion_detection_config.result_deadline_ms),
+                                    [this, frame_index] { return m_processed_frame_index >= frame_index; });
+    }
+
+    if (!m_latest_result.has_value())
     {
         return MEDIA_LIBRARY_SUCCESS;
     }
+    motion_result_t result = m_latest_result.value();
+    lock.unlock();
+
+    update_output_frames(output_frames, result, static_cast<uint32_t>(frame_index - result.frame_index));
+    return MEDIA_LIBRARY_SUCCESS;
+}
+
+void MotionDetection::start_worker()
+{
+    if (m_worker.joinable())
+    {
+        return;
+    }
+
+    m_worker_stop = false;
+    m_worker = std::thread(&MotionDetection::worker_loop, this);
+}
+
+void MotionDetection::stop_worker()
+{
+    if (!m_worker.joinable())
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mailbox_mutex);
+        m_worker_stop = true;
+    }
+    m_mailbox_condition.notify_all();
+    m_worker.join();
+
+    // Release the buffers held for the worker
+    std::unique_lock<std::mutex> lock(m_mailbox_mutex);
+    m_mailbox_frame = nullptr;
+    m_latest_result.reset();
+}
+
+void MotionDetection::worker_loop()
+{
+    ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_MOTION_DETECTION);
+
+    for (;;)
+    {
+        HailoMediaLibraryBufferPtr frame;
+        motion_result_t result = {};
+        {
+            std::unique_lock<std::mutex> lock(m_mailbox_mutex);
+            m_mailbox_condition.wait(lock, [this] { return m_worker_stop || m_mailbox_frame != nullptr; });
+            if (m_worker_stop)
+                return;
+            frame = std::move(m_mailbox_frame);
+            m_mailbox_frame = nullptr;
+            result.frame_index = m_mailbox_frame_index;
+        }
+
+        media_library_return ret;
+        {
+            std::unique_lock<std::mutex> processing_lock(m_processing_mutex);
+            ret = process_frame(frame, result);
+        }
+        // Without the previous frame held for the next one, the buffer returns to its pool now
+        frame = nullptr;
+        if (ret != MEDIA_LIBRARY_SUCCESS)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "Motion detection failed for frame {}, status {}", result.frame_index,
+                                  ret);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mailbox_mutex);
+            m_processed_frame_index = std::max(m_processed_frame_index, result.frame_index);
+            if (result.bitmask_buffer != nullptr)
+            {
+                m_latest_result = std::move(result);
+            }
+        }
+        m_result_condition.notify_all();
+    }
+}
+
+media_library_return
+MotionDetection::process_frame(const HailoMediaLibraryBufferPtr &motion_detection_current_buffer_ptr,
+                               motion_result_t &result)
+{
+    struct timespec start_resize, end_resize;
+    clock_gettime(CLOCK_MONOTONIC, &start_resize);
 
     if (!initialize_previous_frame(motion_detection_current_buffer_ptr))
     {
         return MEDIA_LIBRARY_SUCCESS;
     }
 
-    create_current_frame(motion_detection_current_buffer_ptr);
-
     HailoMediaLibraryBufferPtr bitmask_buffer = allocate_bitmask_buffer();
     if (bitmask_buffer == nullptr)
     {
@@ -115,11 +272,17 @@ media_library_return MotionDetection::perform_motion_detection(std::vector<Hailo
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
-    create_motion_mask();
+    MotionMapPtr motion_map = nullptr;
+    if (m_motion_detection_config.motion_map.enabled)
+    {
+        motion_map = acquire_motion_map(motion_detection_current_buffer_ptr);
+    }
 
-    bool motion_detected = detect_motion();
+    size_t moving_pixels = create_motion_mask(motion_detection_current_buffer_ptr, bitmask_buffer, motion_map);
 
-    update_output_frames(output_frames, bitmask_buffer, motion_detected);
+    result.bitmask_buffer = bitmask_buffer;
+    result.motion_detected = detect_motion(motion_detection_current_buffer_ptr, moving_pixels);
+    result.motion_map = motion_map;
 
     update_previous_frame(motion_detection_current_buffer_ptr);
 
@@ -138,56 +301,43 @@ bool MotionDetection::is_frame_valid(const HailoMediaLibraryBufferPtr &buffer_pt
 
 bool MotionDetection::initialize_previous_frame(const HailoMediaLibraryBufferPtr &buffer_ptr)
 {
+    if (m_motion_detection_config.compact_reference.enabled)
+    {
+        m_motion_reference.configure(m_motion_detection_config.compact_reference, buffer_ptr->buffer_data->width,
+                                     buffer_ptr->buffer_data->height);
+        m_motion_reference.set_current(static_cast<const uint8_t *>(buffer_ptr->get_plane_ptr(0)),
+                                       buffer_ptr->get_plane_stride(0));
+        if (!m_motion_reference.is_initialized())
+        {
+            m_motion_reference.update();
+            return false; // First frame, just initialized the reference
+        }
+        return true;
+    }
+
     if (m_motion_detection_previous_buffer_ptr == nullptr)
     {
-        m_motion_detection_previous_frame = cv::Mat(buffer_ptr->buffer_data->height, buffer_ptr->buffer_data->width,
-                                                    CV_8UC1, buffer_ptr->get_plane_ptr(0));
         m_motion_detection_previous_buffer_ptr = buffer_ptr;
         return false; // First frame, just initialized previous frame
     }
     return true;
 }
 
-void MotionDetection::create_current_frame(const HailoMediaLibraryBufferPtr &buffer_ptr)
-{
-    m_motion_detection_current_frame =
-        cv::Mat(buffer_ptr->buffer_data->height, buffer_ptr->buffer_data->width, CV_8UC1, buffer_ptr->get_plane_ptr(0));
-}
-
 HailoMediaLibraryBufferPtr MotionDetection::allocate_bitmask_buffer()
 {
-    HailoMediaLibraryBufferPtr bitmask_buffer = std::make_shared<hailo_media_library_buffer>();
-    if (m_motion_detection_buffer_pool->acquire_buffer(bitmask_buffer) != MEDIA_LIBRARY_SUCCESS)
+    auto bitmask_buffer_expected = m_motion_detection_buffer_pool->acquire_buffer();
+    if (!bitmask_buffer_expected.has_value())
     {
         return nullptr;
     }
-    m_motion_detection_mask = cv::Mat(bitmask_buffer->buffer_data->height, bitmask_buffer->buffer_data->width, CV_8UC1,
-                                      bitmask_buffer->get_plane_ptr(0));
-    return bitmask_buffer;
-}
-
-void MotionDetection::create_motion_mask()
-{
-    cv::absdiff(m_motion_detection_current_frame, m_motion_detection_previous_frame, m_motion_detection_mask);
-
-    auto kernel = getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
-    cv::morphologyEx(m_motion_detection_mask, m_motion_detection_mask, cv::MORPH_OPEN, kernel);
-
-    cv::threshold(m_motion_detection_mask, m_motion_detection_mask, m_motion_detection_config.sensitivity_level, 255,
-                  cv::THRESH_BINARY);
+    return std::move(bitmask_buffer_expected.value());
 }
 
-bool MotionDetection::detect_motion() const
+bool MotionDetection::is_roi_valid(const HailoMediaLibraryBufferPtr &buffer_ptr) const
 {
-    if (m_motion_detection_mask.empty())
-    {
-        LOGGER__MODULE__ERROR(MODULE_NAME, "Motion detection mask is empty. Skipping motion detection.");
-        return false;
-    }
-
-    const int cols = m_motion_detection_mask.cols;
-    const int rows = m_motion_detection_mask.rows;
-    if (m_motion_detection_roi.width <= 0 || m_motion_detection_roi.height <= 0)
+    const size_t cols = buffer_ptr->buffer_data->width;
+    const size_t rows = buffer_ptr->buffer_data->height;
+    if (m_motion_detection_roi.width == 0 || m_motion_detection_roi.height == 0)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME,
                               "Invalid motion_detection ROI size at runtime: width={} height={}. "
@@ -196,8 +346,7 @@ bool MotionDetection::detect_motion() const
         return false;
     }
 
-    if (m_motion_detection_roi.x < 0 || m_motion_detection_roi.y < 0 ||
-        m_motion_detection_roi.x + m_motion_detection_roi.width > cols ||
+    if (m_motion_detection_roi.x + m_motion_detection_roi.width > cols ||
         m_motion_detection_roi.y + m_motion_detection_roi.height > rows)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME,
@@ -208,12 +357,236 @@ bool MotionDetection::detect_motion() const
                               m_motion_detection_roi.height, cols, rows);
         return false;
     }
+    return true;
+}
+
+size_t MotionDetection::create_motion_mask(const HailoMediaLibraryBufferPtr &current_buffer_ptr,
+                                           HailoMediaLibraryBufferPtr &bitmask_buffer, const MotionMapPtr &motion_map)
+{
+    uint8_t *mask = static_cast<uint8_t *>(bitmask_buffer->get_plane_ptr(0));
+    const size_t mask_stride = bitmask_buffer->get_plane_stride(0);
+    const size_t width = current_buffer_ptr->buffer_data->width;
+    const size_t height = current_buffer_ptr->buffer_data->height;
+    if (!is_roi_valid(current_buffer_ptr))
+    {
+        for (size_t y = 0; y < height; y++)
+            memset(mask + y * mask_stride, 0, width);
+        if (motion_map != nullptr)
+        {
+            std::fill(m_motion_map_cell_counts.begin(), m_motion_map_cell_counts.end(), 0);
+            std::fill(motion_map->packed_mask.begin(), motion_map->packed_mask.end(), 0);
+            fill_motion_map(motion_map);
+        }
+        return 0;
+    }
+
+    motion_mask_plane_t current;
+    motion_mask_plane_t previous;
+    if (m_motion_detection_config.compact_reference.enabled)
+    {
+        if (m_motion_reference.downscale() > 1)
+        {
+            return create_downscaled_motion_mask(mask, mask_stride, width, height, motion_map);
+        }
+        current = m_motion_reference.current();
+        previous = m_motion_reference.reference();
+    }
+    else
+    {
+        current = {static_cast<const uint8_t *>(current_buffer_ptr->get_plane_ptr(0)),
+                   current_buffer_ptr->get_plane_stride(0), false};
+        previous = {static_cast<const uint8_t *>(m_motion_detection_previous_buffer_ptr->get_plane_ptr(0)),
+                    m_motion_detection_previous_buffer_ptr->get_plane_stride(0), false};
+    }
+
+    // The motion map is accumulated by the kernel in the same pass as the mask
+    motion_mask_outputs_t outputs = motion_map_outputs(motion_map, true);
+
+    // Only the ROI is processed, the mask is cleared outside of it
+    size_t moving_pixels = m_motion_mask_kernel.run(current, previous, width, height, m_motion_detection_roi,
+                                                    static_cast<uint8_t>(m_motion_detection_config.sensitivity_level),
+                                                    mask, mask_stride, motion_map != nullptr ? &outputs : nullptr);
+
+    if (motion_map != nullptr)
+    {
+        fill_motion_map(motion_map);
+    }
+    return moving_pixels;
+}
+
+size_t MotionDetection::create_downscaled_motion_mask(uint8_t *mask, size_t mask_stride, size_t width, size_t height,
+                                                      const MotionMapPtr &motion_map)
+{
+    // The mask is computed on the downscaled frames for the ROI scaled down to cover it, then scaled back up
+    const size_t downscale = m_motion_reference.downscale();
+    const size_t reduced_width = m_motion_reference.width();
+    const size_t reduced_height = m_motion_reference.height();
+    const roi_t &roi = m_motion_detection_roi;
+    roi_t reduced_roi;
+    reduced_roi.x = static_cast<uint32_t>(std::min<size_t>(roi.x / downscale, reduced_width - 1));
+    reduced_roi.y = static_cast<uint32_t>(std::min<size_t>(roi.y / downscale, reduced_height - 1));
+    reduced_roi.width = static_cast<uint32_t>(
+        std::clamp<size_t>((roi.x + roi.width + downscale - 1) / downscale, reduced_roi.x + 1, reduced_width) -
+        reduced_roi.x);
+    reduced_roi.height = static_cast<uint32_t>(
+        std::clamp<size_t>((roi.y + roi.height + downscale - 1) / downscale, reduced_roi.y + 1, reduced_height) -
+        reduced_roi.y);
+
+    // The packed mask is packed from the scaled up mask, the kernel only accumulates the cells
+    m_reduced_mask.resize(reduced_width * reduced_height);
+    motion_mask_outputs_t outputs = motion_map_outputs(motion_map, false);
+    size_t moving_pixels = m_motion_mask_kernel.run(
+        m_motion_reference.current(), m_motion_reference.reference(), reduced_width, reduced_height, reduced_roi,
+        static_cast<uint8_t>(m_motion_detection_config.sensitivity_level), m_reduced_mask.data(), reduced_width,
+        motion_map != nullptr ? &outputs : nullptr);
+
+    uint8_t *packed_mask =
+        motion_map != nullptr && !motion_map->packed_mask.empty() ? motion_map->packed_mask.data() : nullptr;
+    for (size_t y = 0; y < height; y++)
+    {
+        uint8_t *mask_row = mask + y * mask_stride;
+        if (y < roi.y || y >= roi.y + roi.height)
+        {
+            memset(mask_row, 0, width);
+        }
+        else
+        {
+            const uint8_t *reduced_row =
+                m_reduced_mask.data() + std::min(y / downscale, reduced_height - 1) * reduced_width;
+            memset(mask_row, 0, roi.x);
+            for (size_t x = roi.x; x < roi.x + roi.width; x++)
+                mask_row[x] = reduced_row[std::min(x / downscale, reduced_width - 1)];
+            memset(mask_row + roi.x + roi.width, 0, width - roi.x - roi.width);
+        }
+        if (packed_mask != nullptr)
+        {
+            pack_motion_mask_row(packed_mask + y * motion_map->packed_mask_stride, mask_row, width);
+        }
+    }
+
+    if (motion_map != nullptr)
+    {
+        fill_motion_map(motion_map);
+    }
+    // Each moving pixel of the downscaled frames stands for a block of the frame
+    return moving_pixels * downscale * downscale;
+}
 
-    const int total_pixels = static_cast<int>(m_motion_detection_mask.total());
+motion_mask_outputs_t MotionDetection::motion_map_outputs(const MotionMapPtr &motion_map, bool packed_mask)
+{
+    motion_mask_outputs_t outputs = {};
+    if (motion_map == nullptr)
+    {
+        return outputs;
+    }
+    outputs.cell_x = m_motion_map_cell_x.data();
+    outputs.cell_y = m_motion_map_cell_y.data();
+    outputs.columns = motion_map->columns;
+    outputs.rows = motion_map->rows;
+    outputs.cell_counts = m_motion_map_cell_counts.data();
+    if (packed_mask && !motion_map->packed_mask.empty())
+    {
+        outputs.packed_mask = motion_map->packed_mask.data();
+        outputs.packed_mask_stride = motion_map->packed_mask_stride;
+    }
+    return outputs;
+}
+
+void MotionDetection::update_motion_map_grid(size_t width, size_t height)
+{
+    const size_t columns = std::max<uint32_t>(m_motion_detection_config.motion_map.columns, 1);
+    const size_t rows = std::max<uint32_t>(m_motion_detection_config.motion_map.rows, 1);
+    if (width == m_motion_map_width && height == m_motion_map_height && m_motion_map_cell_x.size() == columns + 1 &&
+        m_motion_map_cell_y.size() == rows + 1)
+    {
+        return;
+    }
+
+    split_motion_map_cells(width, columns, m_motion_map_cell_x);
+    split_motion_map_cells(height, rows, m_motion_map_cell_y);
+    m_motion_map_cell_counts.assign(columns * rows, 0);
+    m_motion_map_width = width;
+    m_motion_map_height = height;
+}
+
+MotionMapPtr MotionDetection::acquire_motion_map(const HailoMediaLibraryBufferPtr &current_buffer_ptr)
+{
+    const size_t width = current_buffer_ptr->buffer_data->width;
+    const size_t height = current_buffer_ptr->buffer_data->height;
+    // The cells are counted on the frames the mask is computed on
+    if (m_motion_detection_config.compact_reference.enabled)
+    {
+        update_motion_map_grid(m_motion_reference.width(), m_motion_reference.height());
+    }
+    else
+    {
+        update_motion_map_grid(width, height);
+    }
+
+    // Reuse a map released by a previous frame, at most a map per buffer of the pool is kept for reuse
+    std::unique_ptr<motion_map_t> map;
+    {
+        std::unique_lock<std::mutex> lock(m_motion_map_free_list->mutex);
+        m_motion_map_free_list->capacity = m_motion_detection_buffer_pool->get_size();
+        if (!m_motion_map_free_list->maps.empty())
+        {
+            map = std::move(m_motion_map_free_list->maps.back());
+            m_motion_map_free_list->maps.pop_back();
+        }
+    }
+    if (map == nullptr)
+    {
+        map = std::make_unique<motion_map_t>();
+    }
+
+    // The last frame holding the map returns it to the free list, or deletes it if the list is full or gone
+    std::weak_ptr<motion_map_free_list_t> weak_free_list = m_motion_map_free_list;
+    MotionMapPtr motion_map(map.release(), [weak_free_list](motion_map_t *released_map) {
+        std::unique_ptr<motion_map_t> owned_map(released_map);
+        std::shared_ptr<motion_map_free_list_t> free_list = weak_free_list.lock();
+        if (free_list == nullptr)
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(free_list->mutex);
+        if (free_list->maps.size() < free_list->capacity)
+        {
+            free_list->maps.push_back(std::move(owned_map));
+        }
+    });
+
+    const uint32_t columns = static_cast<uint32_t>(m_motion_map_cell_x.size() - 1);
+    const uint32_t rows = static_cast<uint32_t>(m_motion_map_cell_y.size() - 1);
+    motion_map->columns = columns;
+    motion_map->rows = rows;
+    motion_map->energy.resize(columns * rows);
+    motion_map->cell_mask.resize((columns * rows + 7) / 8);
+    if (m_motion_detection_config.motion_map.packed_mask)
+    {
+        motion_map->packed_mask_stride = static_cast<uint32_t>((width + 7) / 8);
+        motion_map->packed_mask.resize(motion_map->packed_mask_stride * height);
+    }
+    else
+    {
+        motion_map->packed_mask_stride = 0;
+        motion_map->packed_mask.clear();
+    }
+    return motion_map;
+}
+
+void MotionDetection::fill_motion_map(const MotionMapPtr &motion_map)
+{
+    fill_motion_map_cells(*motion_map, m_motion_map_cell_x.data(), m_motion_map_cell_y.data(),
+                          m_motion_map_cell_counts.data(), m_motion_detection_config.motion_map.cell_threshold);
+}
+
+bool MotionDetection::detect_motion(const HailoMediaLibraryBufferPtr &current_buffer_ptr, size_t moving_pixels) const
+{
+    // The threshold is a fraction of the whole frame, compared with the sum of the mask values of the ROI
+    const size_t total_pixels = current_buffer_ptr->buffer_data->width * current_buffer_ptr->buffer_data->height;
     const int threshold = static_cast<int>(static_cast<double>(total_pixels) * m_motion_detection_config.threshold);
 
-    cv::Scalar sum = cv::sum(m_motion_detection_mask(m_motion_detection_roi));
-    bool motion_detected = (sum[0] > threshold);
+    bool motion_detected = (static_cast<double>(moving_pixels) * 255 > threshold);
 
     if (motion_detected)
     {
@@ -224,23 +597,38 @@ bool MotionDetection::detect_motion() const
 }
 
 void MotionDetection::update_output_frames(std::vector<HailoMediaLibraryBufferPtr> &output_frames,
-                                           HailoMediaLibraryBufferPtr &bitmask_buffer, bool motion_detected)
+                                           const motion_result_t &result, uint32_t result_age)
 {
     for (auto &frame : output_frames)
     {
-        frame->motion_detection_buffer = bitmask_buffer;
-        frame->motion_detected = motion_detected;
+        // Outputs skipped in this frame share an empty placeholder buffer that must stay untouched
+        if (!is_frame_valid(frame))
+        {
+            continue;
+        }
+        frame->motion_detection_buffer = result.bitmask_buffer;
+        frame->motion_detected = result.motion_detected;
+        frame->motion_map = result.motion_map;
+        frame->motion_result_age = result_age;
     }
 }
 
 void MotionDetection::update_previous_frame(const HailoMediaLibraryBufferPtr &current_buffer_ptr)
 {
-    m_motion_detection_previous_frame = m_motion_detection_current_frame;
+    if (m_motion_detection_config.compact_reference.enabled)
+    {
+        // The frame is copied into the reference, its buffer returns to the pool once the outputs are released
+        m_motion_reference.update();
+        return;
+    }
     m_motion_detection_previous_buffer_ptr = current_buffer_ptr;
 }
 
 void MotionDetection::log_execution_time(const timespec &start, const timespec &end) const
 {
-    [[maybe_unused]] long ms = static_cast<long>(media_library_difftimespec_ms(end, start));
-    LOGGER__MODULE__TRACE(MODULE_NAME, "perform_motion_detection took {} milliseconds ({} fps)", ms, 1000 / ms);
+    // A frame takes less than a millisecond, the arguments are evaluated even when tracing is disabled
+    [[maybe_unused]] double ms =
+        static_cast<double>(end.tv_sec - start.tv_sec) * 1000 + static_cast<double>(end.tv_nsec - start.tv_nsec) / 1e6;
+    LOGGER__MODULE__TRACE(MODULE_NAME, "perform_motion_detection took {:.3f} milliseconds ({:.0f} fps)", ms,
+                          ms > 0 ? 1000 / ms : 0);
 }
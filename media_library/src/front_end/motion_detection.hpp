@@ -26,26 +26,60 @@
  **/
 
 #pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
 #include "media_library_types.hpp"
+#include "motion_detection_kernel.hpp"
+#include "motion_reference.hpp"
 class MotionDetection
 {
   public:
     MotionDetection();
     MotionDetection(motion_detection_config_t &motion_detection_config);
+    ~MotionDetection();
+    // The asynchronous worker runs on this object
+    MotionDetection(const MotionDetection &) = delete;
+    MotionDetection &operator=(const MotionDetection &) = delete;
     void deinit();
 
     media_library_return perform_motion_detection(std::vector<HailoMediaLibraryBufferPtr> &output_frames);
     media_library_return allocate_motion_detection(uint32_t max_buffer_pool_size);
 
   private:
+    struct motion_result_t
+    {
+        HailoMediaLibraryBufferPtr bitmask_buffer;
+        bool motion_detected;
+        MotionMapPtr motion_map;
+        // index of the frame the result was computed on
+        uint64_t frame_index;
+    };
+
+    media_library_return process_frame(const HailoMediaLibraryBufferPtr &motion_detection_current_buffer_ptr,
+                                       motion_result_t &result);
+    media_library_return perform_motion_detection_async(std::vector<HailoMediaLibraryBufferPtr> &output_frames);
+    void start_worker();
+    void stop_worker();
+    void worker_loop();
     bool is_frame_valid(const HailoMediaLibraryBufferPtr &buffer_ptr) const;
     bool initialize_previous_frame(const HailoMediaLibraryBufferPtr &buffer_ptr);
-    void create_current_frame(const HailoMediaLibraryBufferPtr &buffer_ptr);
     HailoMediaLibraryBufferPtr allocate_bitmask_buffer();
-    void create_motion_mask();
-    bool detect_motion() const;
-    void update_output_frames(std::vector<HailoMediaLibraryBufferPtr> &output_frames,
-                              HailoMediaLibraryBufferPtr &bitmask_buffer, bool motion_detected);
+    bool is_roi_valid(const HailoMediaLibraryBufferPtr &buffer_ptr) const;
+    size_t create_motion_mask(const HailoMediaLibraryBufferPtr &current_buffer_ptr,
+                              HailoMediaLibraryBufferPtr &bitmask_buffer, const MotionMapPtr &motion_map);
+    size_t create_downscaled_motion_mask(uint8_t *mask, size_t mask_stride, size_t width, size_t height,
+                                         const MotionMapPtr &motion_map);
+    motion_mask_outputs_t motion_map_outputs(const MotionMapPtr &motion_map, bool packed_mask);
+    MotionMapPtr acquire_motion_map(const HailoMediaLibraryBufferPtr &current_buffer_ptr);
+    void update_motion_map_grid(size_t width, size_t height);
+    void fill_motion_map(const MotionMapPtr &motion_map);
+    bool detect_motion(const HailoMediaLibraryBufferPtr &current_buffer_ptr, size_t moving_pixels) const;
+    void update_output_frames(std::vector<HailoMediaLibraryBufferPtr> &output_frames, const motion_result_t &result,
+                              uint32_t result_age);
     void update_previous_frame(const HailoMediaLibraryBufferPtr &current_buffer_ptr);
     void log_execution_time(const timespec &start, const timespec &end) const;
 
@@ -54,13 +88,47 @@ class MotionDetection
     output_resolution_t m_motion_detection_output_resolution;
 
     MediaLibraryBufferPoolPtr m_motion_detection_buffer_pool;
-    // Previous buffer for motion detection
+    // Previous buffer for motion detection, not held when the compact reference is enabled
     HailoMediaLibraryBufferPtr m_motion_detection_previous_buffer_ptr;
-    // Previous frame for motion detection
-    cv::Mat m_motion_detection_previous_frame;
-    // Current buffer for motion detection
-    cv::Mat m_motion_detection_current_frame;
+    MotionReference m_motion_reference;
+    // Mask of the downscaled frames of the compact reference
+    std::vector<uint8_t> m_reduced_mask;
+
+    // Computes the motion mask of the ROI in a single pass over the frames
+    MotionMaskKernel m_motion_mask_kernel;
+    roi_t m_motion_detection_roi;
+
+    // Motion maps released by the frames, reused for the next ones. The deleters of the maps attached to the frames
+    // return them to the list, and may run on any thread after the motion detection is destroyed
+    struct motion_map_free_list_t
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<motion_map_t>> maps;
+        // maximal number of released maps kept
+        size_t capacity = 0;
+    };
+    std::shared_ptr<motion_map_free_list_t> m_motion_map_free_list;
+    // Cell boundaries of the motion map grid for the frame size it was computed for, and the cell counts
+    size_t m_motion_map_width;
+    size_t m_motion_map_height;
+    std::vector<uint32_t> m_motion_map_cell_x;
+    std::vector<uint32_t> m_motion_map_cell_y;
+    std::vector<uint32_t> m_motion_map_cell_counts;
+
+    // Held while a frame is processed, and while the processing state is reconfigured
+    std::mutex m_processing_mutex;
 
-    cv::Mat m_motion_detection_mask;
-    cv::Rect m_motion_detection_roi;
+    // Asynchronous mode: the frames are passed to the worker through a mailbox of a single frame, a frame that is
+    // still in the mailbox when the next one arrives is replaced by it
+    std::thread m_worker;
+    std::mutex m_mailbox_mutex;
+    std::condition_variable m_mailbox_condition;
+    std::condition_variable m_result_condition;
+    bool m_worker_stop;
+    HailoMediaLibraryBufferPtr m_mailbox_frame;
+    uint64_t m_mailbox_frame_index;
+    // frames are counted from 1, 0 before the first one
+    uint64_t m_frame_index;
+    uint64_t m_processed_frame_index;
+    std::optional<motion_result_t> m_latest_result;
 };
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "motion_detection_kernel.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// The opening reads 2 pixels around each pixel for the erosion and 2 more for the dilation
+static constexpr size_t PADDING = 2;
+static constexpr size_t MARGIN = 2 * PADDING;
+
+/* 255 where the absolute difference of the rows is above the threshold, 0 elsewhere */
+static void threshold_difference_row(const uint8_t *current, const uint8_t *previous, uint8_t *out, size_t count,
+                                     uint8_t threshold)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(current + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(previous + i));
+        __m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        __m128i still = _mm_cmpeq_epi8(_mm_subs_epu8(difference, limit), zero);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(still, ones));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t limit = vdupq_n_u8(threshold);
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(out + i, vcgtq_u8(vabdq_u8(vld1q_u8(current + i), vld1q_u8(previous + i)), limit));
+#endif
+    for (; i < count; i++)
+    {
+        int difference = current[i] - previous[i];
+        out[i] = (difference > threshold || -difference > threshold) ? 255 : 0;
+    }
+}
+
+/* out[i] is the minimum of in[i..i+4] */
+static void min5_row(uint8_t *out, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i value = _mm_min_epu8(_mm_loadu_si128((const __m128i *)(in + i)),
+                                     _mm_loadu_si128((const __m128i *)(in + i + 1)));
+        value = _mm_min_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 2)));
+        value = _mm_min_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 3)));
+        value = _mm_min_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 4)));
+        _mm_storeu_si128((__m128i *)(out + i), value);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t value = vminq_u8(vld1q_u8(in + i), vld1q_u8(in + i + 1));
+        value = vminq_u8(value, vld1q_u8(in + i + 2));
+        value = vminq_u8(value, vld1q_u8(in + i + 3));
+        vst1q_u8(out + i, vminq_u8(value, vld1q_u8(in + i + 4)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = std::min({in[i], in[i + 1], in[i + 2], in[i + 3], in[i + 4]});
+}
+
+/* out[i] is the maximum of in[i..i+4] */
+static void max5_row(uint8_t *out, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i value = _mm_max_epu8(_mm_loadu_si128((const __m128i *)(in + i)),
+                                     _mm_loadu_si128((const __m128i *)(in + i + 1)));
+        value = _mm_max_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 2)));
+        value = _mm_max_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 3)));
+        value = _mm_max_epu8(value, _mm_loadu_si128((const __m128i *)(in + i + 4)));
+        _mm_storeu_si128((__m128i *)(out + i), value);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t value = vmaxq_u8(vld1q_u8(in + i), vld1q_u8(in + i + 1));
+        value = vmaxq_u8(value, vld1q_u8(in + i + 2));
+        value = vmaxq_u8(value, vld1q_u8(in + i + 3));
+        vst1q_u8(out + i, vmaxq_u8(value, vld1q_u8(in + i + 4)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = std::max({in[i], in[i + 1], in[i + 2], in[i + 3], in[i + 4]});
+}
+
+static void min_row(uint8_t *inout, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i value = _mm_min_epu8(_mm_loadu_si128((const __m128i *)(inout + i)),
+                                     _mm_loadu_si128((const __m128i *)(in + i)));
+        _mm_storeu_si128((__m128i *)(inout + i), value);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(inout + i, vminq_u8(vld1q_u8(inout + i), vld1q_u8(in + i)));
+#endif
+    for (; i < count; i++)
+        inout[i] = std::min(inout[i], in[i]);
+}
+
+static void max_row(uint8_t *inout, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i value = _mm_max_epu8(_mm_loadu_si128((const __m128i *)(inout + i)),
+                                     _mm_loadu_si128((const __m128i *)(in + i)));
+        _mm_storeu_si128((__m128i *)(inout + i), value);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(inout + i, vmaxq_u8(vld1q_u8(inout + i), vld1q_u8(in + i)));
+#endif
+    for (; i < count; i++)
+        inout[i] = std::max(inout[i], in[i]);
+}
+
+/* Copy a row of 0/255 values and count the 255 ones */
+static size_t copy_and_count_row(uint8_t *out, const uint8_t *in, size_t count)
+{
+    size_t set = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i sums = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_si128((__m128i *)(out + i), value);
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_and_si128(value, one), _mm_setzero_si128()));
+    }
+    set = _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+#elif defined(__ARM_NEON)
+    uint16x8_t sums = vdupq_n_u16(0);
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t value = vld1q_u8(in + i);
+        vst1q_u8(out + i, value);
+        sums = vpadalq_u8(sums, vshrq_n_u8(value, 7));
+    }
+    uint64x2_t total = vpaddlq_u32(vpaddlq_u16(sums));
+    set = vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = in[i];
+        set += in[i] & 1;
+    }
+    return set;
+}
+
+void split_motion_map_cells(size_t size, size_t count, std::vector<uint32_t> &boundaries)
+{
+    boundaries.resize(count + 1);
+    for (size_t i = 0; i <= count; i++)
+        boundaries[i] = static_cast<uint32_t>(i * size / count);
+}
+
+void fill_motion_map_cells(motion_map_t &map, const uint32_t *cell_x, const uint32_t *cell_y,
+                           const uint32_t *cell_counts, float cell_threshold)
+{
+    std::fill(map.cell_mask.begin(), map.cell_mask.end(), 0);
+    for (uint32_t row = 0; row < map.rows; row++)
+    {
+        for (uint32_t column = 0; column < map.columns; column++)
+        {
+            const size_t index = row * map.columns + column;
+            const size_t area =
+                static_cast<size_t>(cell_x[column + 1] - cell_x[column]) * (cell_y[row + 1] - cell_y[row]);
+            const uint32_t count = cell_counts[index];
+            map.energy[index] = area > 0 ? static_cast<uint8_t>(static_cast<size_t>(count) * 255 / area) : 0;
+            if (count > 0 && count > area * cell_threshold)
+            {
+                map.cell_mask[index / 8] |= 1 << (index % 8);
+            }
+        }
+    }
+}
+
+void pack_motion_mask_row(uint8_t *out, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint16_t bits = static_cast<uint16_t>(_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(in + i))));
+        out[i / 8] = static_cast<uint8_t>(bits);
+        out[i / 8 + 1] = static_cast<uint8_t>(bits >> 8);
+    }
+#elif defined(__ARM_NEON)
+    static const uint8_t BIT_WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(BIT_WEIGHTS);
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t bits = vandq_u8(vld1q_u8(in + i), weights);
+        uint8x8_t sums = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+        sums = vpadd_u8(sums, sums);
+        sums = vpadd_u8(sums, sums);
+        out[i / 8] = vget_lane_u8(sums, 0);
+        out[i / 8 + 1] = vget_lane_u8(sums, 1);
+    }
+#endif
+    if (i < count)
+        memset(out + i / 8, 0, (count - i + 7) / 8);
+    for (; i < count; i++)
+        out[i / 8] |= (in[i] & 1) << (i % 8);
+}
+
+/* Unpack 4 bit pixels starting at a pixel, each one to the middle of the range of values it stands for */
+static void unpack_row(uint8_t *out, const uint8_t *in, size_t first, size_t count)
+{
+    size_t i = 0;
+    if (first % 2 != 0 && count > 0)
+    {
+        out[i++] = (in[first / 2] & 0xf0) | 0x08;
+    }
+    const uint8_t *pairs = in + (first + i) / 2;
+    for (; i + 2 <= count; i += 2, pairs++)
+    {
+        out[i] = static_cast<uint8_t>(*pairs << 4) | 0x08;
+        out[i + 1] = (*pairs & 0xf0) | 0x08;
+    }
+    if (i < count)
+        out[i] = static_cast<uint8_t>(*pairs << 4) | 0x08;
+}
+
+/* Pixels [first, first + count) of a row of a plane, unpacked to scratch when needed */
+static const uint8_t *plane_row(const motion_mask_plane_t &plane, size_t y, size_t first, size_t count,
+                                uint8_t *scratch)
+{
+    const uint8_t *row = plane.data + y * plane.stride;
+    if (!plane.packed)
+        return row + first;
+    unpack_row(scratch, row, first, count);
+    return scratch;
+}
+
+MotionMaskKernel::MotionMaskKernel()
+    : m_row_size(0), m_opening(nullptr), m_unpacked_current(nullptr), m_unpacked_previous(nullptr)
+{
+}
+
+MotionMaskKernel::MotionMaskKernel(const MotionMaskKernel &) : MotionMaskKernel()
+{
+}
+
+MotionMaskKernel &MotionMaskKernel::operator=(const MotionMaskKernel &)
+{
+    m_row_size = 0;
+    m_storage.clear();
+    m_opening = nullptr;
+    m_unpacked_current = nullptr;
+    m_unpacked_previous = nullptr;
+    return *this;
+}
+
+void MotionMaskKernel::allocate_rows(size_t width)
+{
+    if (width == m_row_size)
+        return;
+
+    const size_t padded_size = width + 2 * PADDING;
+    m_storage.resize(RING_SIZE * (2 * padded_size + 2 * width) + 3 * width);
+    uint8_t *row = m_storage.data();
+    for (size_t i = 0; i < RING_SIZE; i++)
+    {
+        // Pixels outside of the frame are ignored by the erosion, and by the dilation
+        m_difference[i] = row;
+        memset(row, 255, PADDING);
+        memset(row + PADDING + width, 255, PADDING);
+        row += padded_size;
+        m_erosion[i] = row;
+        memset(row, 0, PADDING);
+        memset(row + PADDING + width, 0, PADDING);
+        row += padded_size;
+        m_horizontal_erosion[i] = row;
+        row += width;
+        m_horizontal_dilation[i] = row;
+        row += width;
+    }
+    m_opening = row;
+    m_unpacked_current = row + width;
+    m_unpacked_previous = row + 2 * width;
+    m_row_size = width;
+}
+
+size_t MotionMaskKernel::run(const motion_mask_plane_t &current, const motion_mask_plane_t &previous, size_t width,
+                             size_t height, const roi_t &roi, uint8_t threshold, uint8_t *mask, size_t mask_stride,
+                             const motion_mask_outputs_t *outputs)
+{
+    // The processed region, the ROI with a margin that keeps the opening of its pixels exact
+    const size_t begin_x = roi.x > MARGIN ? roi.x - MARGIN : 0;
+    const size_t end_x = std::min<size_t>(roi.x + roi.width + MARGIN, width);
+    const size_t begin_y = roi.y > MARGIN ? roi.y - MARGIN : 0;
+    const size_t end_y = std::min<size_t>(roi.y + roi.height + MARGIN, height);
+    const size_t region_width = end_x - begin_x;
+    allocate_rows(region_width);
+
+    // Rows of a window around a center row, clipped to the region
+    auto first_row = [begin_y](size_t center, size_t radius) {
+        return center >= begin_y + radius ? center - radius : begin_y;
+    };
+    auto last_row = [end_y](size_t center, size_t radius) { return std::min(center + radius, end_y - 1); };
+
+    const bool packed = outputs != nullptr && outputs->packed_mask != nullptr;
+    for (size_t y = 0; y < height; y++)
+    {
+        if (y >= roi.y && y < roi.y + roi.height)
+            continue;
+        memset(mask + y * mask_stride, 0, width);
+        if (packed)
+            memset(outputs->packed_mask + y * outputs->packed_mask_stride, 0, (width + 7) / 8);
+    }
+    if (outputs != nullptr)
+        std::fill_n(outputs->cell_counts, outputs->columns * outputs->rows, 0);
+    size_t cell_row = 0;
+
+    size_t moving_pixels = 0;
+    for (size_t y = begin_y; y < end_y + MARGIN; y++)
+    {
+        if (y < end_y)
+        {
+            uint8_t *difference = m_difference[y % RING_SIZE];
+            threshold_difference_row(plane_row(current, y, begin_x, region_width, m_unpacked_current),
+                                     plane_row(previous, y, begin_x, region_width, m_unpacked_previous),
+                                     difference + PADDING, region_width, threshold);
+            min5_row(m_horizontal_erosion[y % RING_SIZE], difference, region_width);
+        }
+
+        // Erosion of the row 2 rows back: the 5x3 rectangle, then the 1x5 column
+        if (y >= begin_y + PADDING && y - PADDING < end_y)
+        {
+            const size_t row = y - PADDING;
+            uint8_t *erosion = m_erosion[row % RING_SIZE] + PADDING;
+            memcpy(erosion, m_horizontal_erosion[row % RING_SIZE], region_width);
+            for (size_t r = first_row(row, 1); r <= last_row(row, 1); r++)
+                min_row(erosion, m_horizontal_erosion[r % RING_SIZE], region_width);
+            for (size_t r = first_row(row, 2); r <= last_row(row, 2); r++)
+                min_row(erosion, m_difference[r % RING_SIZE] + PADDING, region_width);
+            max5_row(m_horizontal_dilation[row % RING_SIZE], m_erosion[row % RING_SIZE], region_width);
+        }
+
+        // Dilation of the row 4 rows back, only the ROI is needed
+        if (y >= begin_y + MARGIN && y - MARGIN >= roi.y && y - MARGIN < roi.y + roi.height)
+        {
+            const size_t row = y - MARGIN;
+            const size_t offset = roi.x - begin_x;
+            memcpy(m_opening, m_horizontal_dilation[row % RING_SIZE] + offset, roi.width);
+            for (size_t r = first_row(row, 1); r <= last_row(row, 1); r++)
+                max_row(m_opening, m_horizontal_dilation[r % RING_SIZE] + offset, roi.width);
+            for (size_t r = first_row(row, 2); r <= last_row(row, 2); r++)
+                max_row(m_opening, m_erosion[r % RING_SIZE] + PADDING + offset, roi.width);
+
+            uint8_t *mask_row = mask + row * mask_stride;
+            memset(mask_row, 0, roi.x);
+            if (outputs == nullptr)
+            {
+                moving_pixels += copy_and_count_row(mask_row + roi.x, m_opening, roi.width);
+            }
+            else
+            {
+                // Count the moving pixels of the row separately for each cell it crosses
+                while (cell_row + 1 < outputs->rows && outputs->cell_y[cell_row + 1] <= row)
+                    cell_row++;
+                uint32_t *counts = outputs->cell_counts + cell_row * outputs->columns;
+                size_t column = 0;
+                for (size_t x = roi.x; x < roi.x + roi.width;)
+                {
+                    while (column + 1 < outputs->columns && outputs->cell_x[column + 1] <= x)
+                        column++;
+                    const size_t segment_end = std::min<size_t>(outputs->cell_x[column + 1], roi.x + roi.width);
+                    const size_t moving = copy_and_count_row(mask_row + x, m_opening + x - roi.x, segment_end - x);
+                    counts[column] += static_cast<uint32_t>(moving);
+                    moving_pixels += moving;
+                    x = segment_end;
+                }
+            }
+            memset(mask_row + roi.x + roi.width, 0, width - roi.x - roi.width);
+            if (packed)
+                pack_motion_mask_row(outputs->packed_mask + row * outputs->packed_mask_stride, mask_row, width);
+        }
+    }
+
+    return moving_pixels;
+}
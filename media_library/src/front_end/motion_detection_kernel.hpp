@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file motion_detection_kernel.hpp
+ * @brief Fused motion mask kernel of the motion detection
+ **/
+
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "media_library_types.hpp"
+
+/**
+ * @brief A luma plane read by the kernel
+ */
+struct motion_mask_plane_t
+{
+    const uint8_t *data;
+    size_t stride;
+    // 4 bits per pixel, two pixels per byte with the first one in the low nibble
+    bool packed;
+};
+
+/**
+ * @brief Pack a row of 0/255 mask values to a bit per value, least significant bit first
+ */
+void pack_motion_mask_row(uint8_t *out, const uint8_t *in, size_t count);
+
+/**
+ * @brief Split a frame dimension evenly between cells, the remainder of the division is spread between them
+ *
+ * @param[in] size - the frame dimension
+ * @param[in] count - number of cells, at least 1
+ * @param[out] boundaries - count + 1 increasing boundaries from 0 to size
+ */
+void split_motion_map_cells(size_t size, size_t count, std::vector<uint32_t> &boundaries);
+
+/**
+ * @brief Fill the energy and cell mask of a motion map from the moving pixels of its cells
+ *
+ * @param[in,out] map - the map, its columns and rows set and its energy and cell mask sized for them
+ * @param[in] cell_x - columns + 1 boundaries of the cells
+ * @param[in] cell_y - rows + 1 boundaries of the cells
+ * @param[in] cell_counts - moving pixels of each cell, row major
+ * @param[in] cell_threshold - fraction of the pixels of a cell that must move for the cell to be marked
+ */
+void fill_motion_map_cells(motion_map_t &map, const uint32_t *cell_x, const uint32_t *cell_y,
+                           const uint32_t *cell_counts, float cell_threshold);
+
+/**
+ * @brief Optional outputs computed by the kernel along with the motion mask
+ */
+struct motion_mask_outputs_t
+{
+    // Grid of cells covering the frame, columns + 1 and rows + 1 increasing boundaries from 0 to the frame size
+    const uint32_t *cell_x;
+    const uint32_t *cell_y;
+    size_t columns;
+    size_t rows;
+    // Moving pixels of each cell, row major
+    uint32_t *cell_counts;
+    // Mask with a bit per pixel, least significant bit first, not computed when null
+    uint8_t *packed_mask;
+    size_t packed_mask_stride;
+};
+
+/**
+ * @brief Computes the motion mask of a ROI in a single pass over the current and previous luma planes.
+ *
+ * The result equals thresholding the opening of the absolute difference of the frames with a 5x5 ellipse, as done by
+ * cv::absdiff, cv::morphologyEx(MORPH_OPEN) and cv::threshold. Thresholding commutes with the min and max filters of
+ * the opening, so the difference is thresholded first and the opening runs on a binary mask. The 5x5 ellipse is the
+ * union of a 5x3 rectangle and a 1x5 column, which makes both of its filters combinations of separable ones.
+ *
+ * Rows are processed as they are read, with a margin of 4 pixels around the ROI that keeps its mask exact, and the
+ * intermediate rows stay in rings of 5 rows that fit in the cache.
+ */
+class MotionMaskKernel
+{
+  public:
+    MotionMaskKernel();
+    // The rows are scratch memory pointing into the storage, a copy allocates its own on its first run
+    MotionMaskKernel(const MotionMaskKernel &other);
+    MotionMaskKernel &operator=(const MotionMaskKernel &other);
+
+    /**
+     * @brief Computes the motion mask of a ROI
+     *
+     * @param[in] current - luma plane of the current frame
+     * @param[in] previous - luma plane of the previous frame, of the same size
+     * @param[in] width - width of the frames
+     * @param[in] height - height of the frames
+     * @param[in] roi - the ROI, must be inside the frames
+     * @param[in] threshold - minimal difference of a moving pixel, exclusive
+     * @param[out] mask - mask of the size of the frames, 255 for moving pixels of the ROI and 0 elsewhere
+     * @param[in] mask_stride - bytes per line of the mask
+     * @param[in,out] outputs - optional outputs to compute in the same pass, null for none
+     * @return size_t - number of moving pixels in the ROI
+     */
+    size_t run(const motion_mask_plane_t &current, const motion_mask_plane_t &previous, size_t width, size_t height,
+               const roi_t &roi, uint8_t threshold, uint8_t *mask, size_t mask_stride,
+               const motion_mask_outputs_t *outputs = nullptr);
+
+  private:
+    static constexpr size_t RING_SIZE = 5;
+
+    // Rows of the processed region, the thresholded difference and the erosion are padded by 2 pixels on each side
+    size_t m_row_size;
+    std::vector<uint8_t> m_storage;
+    uint8_t *m_difference[RING_SIZE];
+    uint8_t *m_horizontal_erosion[RING_SIZE];
+    uint8_t *m_erosion[RING_SIZE];
+    uint8_t *m_horizontal_dilation[RING_SIZE];
+    uint8_t *m_opening;
+    // Rows of the planes unpacked to a byte per pixel
+    uint8_t *m_unpacked_current;
+    uint8_t *m_unpacked_previous;
+
+    void allocate_rows(size_t width);
+};
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "motion_reference.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* Quantize a row to 4 bits per pixel, two pixels per byte with the first one in the low nibble */
+static void quantize_row(uint8_t *out, const uint8_t *in, size_t count)
+{
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+        out[i / 2] = (in[i] >> 4) | (in[i + 1] & 0xf0);
+    if (i < count)
+        out[i / 2] = in[i] >> 4;
+}
+
+/* Move a background row towards a row of the current frame, the background has 8 fractional bits */
+static void accumulate_row(uint8_t *background, uint8_t *fraction, const uint8_t *in, size_t count, int32_t weight)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        int32_t value = (background[i] << 8) | fraction[i];
+        value += (((in[i] << 8) - value) * weight) >> 8;
+        background[i] = static_cast<uint8_t>(value >> 8);
+        fraction[i] = static_cast<uint8_t>(value);
+    }
+}
+
+MotionReference::MotionReference()
+    : m_config(), m_frame_width(0), m_frame_height(0), m_downscale(1), m_width(0), m_height(0), m_packed(false),
+      m_background_weight(0), m_initialized(false), m_frame(nullptr), m_frame_stride(0)
+{
+}
+
+void MotionReference::configure(const motion_reference_config_t &config, size_t frame_width, size_t frame_height)
+{
+    const size_t downscale =
+        std::clamp<size_t>(config.downscale, 1, std::max<size_t>(std::min(frame_width, frame_height), 1));
+    const uint32_t background_weight =
+        config.background_learning_rate > 0
+            ? std::clamp<uint32_t>(static_cast<uint32_t>(std::lround(config.background_learning_rate * 256)), 1, 256)
+            : 0;
+    // The averaging needs more than 4 bits, the background is never quantized
+    const bool packed = config.quantize && background_weight == 0;
+
+    m_config = config;
+    m_background_weight = background_weight;
+    if (frame_width == m_frame_width && frame_height == m_frame_height && downscale == m_downscale &&
+        packed == m_packed && (background_weight > 0) == !m_background_fraction.empty())
+    {
+        return;
+    }
+
+    m_frame_width = frame_width;
+    m_frame_height = frame_height;
+    m_downscale = downscale;
+    m_width = frame_width / downscale;
+    m_height = frame_height / downscale;
+    m_packed = packed;
+    m_current.assign(downscale > 1 ? m_width * m_height : 0, 0);
+    m_row_sums.assign(downscale > 1 ? m_width : 0, 0);
+    m_reference.assign(packed ? (m_width + 1) / 2 * m_height : m_width * m_height, 0);
+    m_background_fraction.assign(background_weight > 0 ? m_width * m_height : 0, 0);
+    m_initialized = false;
+}
+
+void MotionReference::reset()
+{
+    m_initialized = false;
+    m_frame = nullptr;
+}
+
+void MotionReference::set_current(const uint8_t *frame, size_t frame_stride)
+{
+    if (m_downscale == 1)
+    {
+        m_frame = frame;
+        m_frame_stride = frame_stride;
+        return;
+    }
+    downscale_current(frame, frame_stride);
+}
+
+void MotionReference::downscale_current(const uint8_t *frame, size_t frame_stride)
+{
+    // Box filter, each pixel is the rounded average of a block of downscale x downscale pixels
+    const size_t area = m_downscale * m_downscale;
+    uint32_t *sums = m_row_sums.data();
+    for (size_t y = 0; y < m_height; y++)
+    {
+        std::fill_n(sums, m_width, 0);
+        for (size_t dy = 0; dy < m_downscale; dy++)
+        {
+            const uint8_t *in = frame + (y * m_downscale + dy) * frame_stride;
+            for (size_t x = 0; x < m_width; x++)
+            {
+                for (size_t dx = 0; dx < m_downscale; dx++)
+                    sums[x] += in[x * m_downscale + dx];
+            }
+        }
+        uint8_t *out = m_current.data() + y * m_width;
+        for (size_t x = 0; x < m_width; x++)
+            out[x] = static_cast<uint8_t>((sums[x] + area / 2) / area);
+    }
+}
+
+motion_mask_plane_t MotionReference::current() const
+{
+    if (m_downscale == 1)
+        return {m_frame, m_frame_stride, false};
+    return {m_current.data(), m_width, false};
+}
+
+motion_mask_plane_t MotionReference::reference() const
+{
+    return {m_reference.data(), m_packed ? (m_width + 1) / 2 : m_width, m_packed};
+}
+
+void MotionReference::update()
+{
+    const motion_mask_plane_t frame = current();
+    const size_t stride = reference().stride;
+    for (size_t y = 0; y < m_height; y++)
+    {
+        const uint8_t *in = frame.data + y * frame.stride;
+        uint8_t *out = m_reference.data() + y * stride;
+        if (m_packed)
+        {
+            quantize_row(out, in, m_width);
+        }
+        else if (m_background_weight == 0 || !m_initialized)
+        {
+            memcpy(out, in, m_width);
+            if (!m_background_fraction.empty())
+                memset(m_background_fraction.data() + y * m_width, 0, m_width);
+        }
+        else
+        {
+            accumulate_row(out, m_background_fraction.data() + y * m_width, in, m_width,
+                           static_cast<int32_t>(m_background_weight));
+        }
+    }
+    m_initialized = true;
+    m_frame = nullptr;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file motion_reference.hpp
+ * @brief Compact reference plane of the motion detection
+ **/
+
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "media_library_types.hpp"
+#include "motion_detection_kernel.hpp"
+
+/**
+ * @brief Reference the motion detection compares each frame with, kept in its own memory so that the previous frame
+ * buffer can return to its pool as soon as it is processed.
+ *
+ * Both the frames and the reference are downscaled by a box filter. The reference is either the previous frame,
+ * optionally quantized to 4 bits per pixel, or a running average background that follows slow changes such as
+ * flicker. The background is kept with 8 fractional bits in a separate plane, so that slow learning rates still move
+ * it, and its integer plane is compared with the frames directly.
+ */
+class MotionReference
+{
+  public:
+    MotionReference();
+
+    /**
+     * @brief Configures the reference for a frame size, the content is dropped when the geometry changes
+     *
+     * @param[in] config - the compact reference configuration
+     * @param[in] frame_width - width of the frames
+     * @param[in] frame_height - height of the frames
+     */
+    void configure(const motion_reference_config_t &config, size_t frame_width, size_t frame_height);
+
+    /**
+     * @brief Drops the content, the next frame initializes the reference
+     */
+    void reset();
+
+    bool is_initialized() const
+    {
+        return m_initialized;
+    }
+
+    /**
+     * @brief Sets the luma plane of the current frame, it must stay valid until update() returns
+     */
+    void set_current(const uint8_t *frame, size_t frame_stride);
+
+    /**
+     * @brief Updates the reference with the current frame
+     */
+    void update();
+
+    motion_mask_plane_t current() const;
+    motion_mask_plane_t reference() const;
+
+    // Size of the downscaled planes
+    size_t width() const
+    {
+        return m_width;
+    }
+    size_t height() const
+    {
+        return m_height;
+    }
+    size_t downscale() const
+    {
+        return m_downscale;
+    }
+
+  private:
+    void downscale_current(const uint8_t *frame, size_t frame_stride);
+
+    motion_reference_config_t m_config;
+    size_t m_frame_width;
+    size_t m_frame_height;
+    size_t m_downscale;
+    size_t m_width;
+    size_t m_height;
+    bool m_packed;
+    // weight of the current frame in the background, in 1/256 units, 0 without a background
+    uint32_t m_background_weight;
+    bool m_initialized;
+
+    // The current frame, directly from its buffer when it is not downscaled
+    const uint8_t *m_frame;
+    size_t m_frame_stride;
+    std::vector<uint8_t> m_current;
+    std::vector<uint32_t> m_row_sums;
+    std::vector<uint8_t> m_reference;
+    std::vector<uint8_t> m_background_fraction;
+};
@@ -32,12 +32,18 @@
 #include "media_library_logger.hpp"
 #include "media_library_utils.hpp"
 #include "motion_detection.hpp"
+#include "multi_resize_plan.hpp"
 #include "multi_resize.hpp"
 #include "privacy_mask.hpp"
 #include "snapshot.hpp"
+#include "profiled_mutex.hpp"
 
 #include "dsp_image_enhancement.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <stdint.h>
@@ -59,12 +65,6 @@
     ((multi_resize_config.application_input_streams_config.resolutions.size()) +                                       \
      (multi_resize_config.motion_detection_config.enabled ? 1 : 0))
 
-/* Simple struct to aggregate output data and configuration together */
-struct output_data_and_config
-{
-    hailo_dsp_buffer_data_t data;
-    output_resolution_t *config;
-};
 struct timestamp_metadata
 {
     uint64_t last_timestamp;
@@ -119,6 +119,9 @@ class MediaLibraryMultiResize::Impl final
     // set the callbacks object
     media_library_return observe(const MediaLibraryMultiResize::callbacks_t &callbacks);
 
+    // get the number of frames dropped by each output because its buffer pool was exhausted
+    std::vector<uint64_t> get_output_drop_counts();
+
   private:
     static constexpr int max_frames_jitter_multiplier = 3;
     static constexpr int max_frames_latency_multiplier = 20;
@@ -146,13 +149,34 @@ class MediaLibraryMultiResize::Impl final
     std::vector<MediaLibraryMultiResize::callbacks_t> m_callbacks;
     // output buffer pools
     std::vector<MediaLibraryBufferPoolPtr> m_buffer_pools;
+    // output indices in descending priority, the order in which output buffers are acquired
+    std::vector<uint8_t> m_output_order;
+    // frames dropped by each output because its buffer pool was exhausted
+    std::unique_ptr<std::atomic<uint64_t>[]> m_output_drops;
+    // incremented on every successful configuration change, invalidates the cached DSP parameters
+    uint64_t m_config_generation = 0;
+    // DSP parameters cached between configuration changes, frames running in parallel share the published plan
+    std::shared_ptr<const multi_resize_plan_t> m_plan;
+    // guards publishing and loading m_plan, frames only hold the shared read/write lock
+    std::mutex m_plan_mutex;
+    // Storage of the DSP parameters of the current frame, sized for the configured outputs
+    struct multi_resize_frame_t
+    {
+        // DSP view of the output buffers by output index, the image is nullptr for skipped outputs
+        std::vector<hailo_dsp_buffer_data_t> output_dsp_buffer_data;
+        std::vector<dsp_image_properties_t *> output_dsp_images;
+        std::vector<dsp_crop_resize_params_t> crop_resize_params;
+    };
+    multi_resize_frame_t m_frame;
+    // held while a frame uses m_frame
+    std::mutex m_frame_mutex;
     // Timestamps in ms.
     std::vector<timestamp_metadata> m_timestamps;
     // read/write lock for configuration manipulation/reading
-    std::shared_mutex rw_lock;
+    ProfiledSharedMutex rw_lock{"multi_resize_config"};
     uint32_t m_max_buffer_pool_size;
 
-    MotionDetection m_motion_detection;
+    std::unique_ptr<MotionDetection> m_motion_detection;
     std::unique_ptr<DspImageEnhancement> m_dsp_image_enhancement;
 
     media_library_return decode_config_json_string(multi_resize_config_t &mresize_config, std::string config_string);
@@ -164,7 +188,10 @@ class MediaLibraryMultiResize::Impl final
     bool should_push_frame_timestamp_logic(uint32_t output_framerate, uint8_t output_index, uint64_t isp_timestamp_ns,
                                            std::vector<timestamp_metadata> &timestamps);
     media_library_return create_and_initialize_buffer_pools();
+    void update_output_order();
     media_library_return validate_output_frames(std::vector<HailoMediaLibraryBufferPtr> &output_frames);
+    tl::expected<std::shared_ptr<const multi_resize_plan_t>, media_library_return> build_multi_resize_plan();
+    tl::expected<std::shared_ptr<const multi_resize_plan_t>, media_library_return> get_multi_resize_plan();
     media_library_return perform_multi_resize(HailoMediaLibraryBufferPtr input_buffer,
                                               std::vector<HailoMediaLibraryBufferPtr> &output_frames);
     media_library_return configure_internal(multi_resize_config_t &mresize_config);
@@ -251,6 +278,11 @@ media_library_return MediaLibraryMultiResize::observe(const MediaLibraryMultiRes
     return m_impl->observe(callbacks);
 }
 
+std::vector<uint64_t> MediaLibraryMultiResize::get_output_drop_counts()
+{
+    return m_impl->get_output_drop_counts();
+}
+
 //------------------------ MediaLibraryMultiResize::Impl ------------------------
 
 tl::expected<std::shared_ptr<MediaLibraryMultiResize::Impl>, media_library_return> MediaLibraryMultiResize::Impl::
@@ -297,7 +329,7 @@ MediaLibraryMultiResize::Impl::Impl(media_library_return &status, std::string co
 
     multi_resize_config_t mresize_config;
     mresize_config = m_multi_resize_config;
-    m_motion_detection = MotionDetection(m_multi_resize_config.motion_detection_config);
+    m_motion_detection = std::make_unique<MotionDetection>(m_multi_resize_config.motion_detection_config);
 
     // revert the rotation to 0, so when we update the configuration we will correctly detect 90 degree rotation
     // and flip the output dimensions
@@ -314,9 +346,9 @@ MediaLibraryMultiResize::Impl::Impl(media_library_return &status, std::string co
 
 MediaLibraryMultiResize::Impl::~Impl()
 {
-    if (m_multi_resize_config.motion_detection_config.enabled)
+    if (m_multi_resize_config.motion_detection_config.enabled && m_motion_detection != nullptr)
     {
-        m_motion_detection.deinit();
+        m_motion_detection->deinit();
     }
 
     m_multi_resize_config.application_input_streams_config.resolutions.clear();
@@ -359,9 +391,10 @@ media_library_return MediaLibraryMultiResize::Impl::configure(std::string config
 
 media_library_return MediaLibraryMultiResize::Impl::set_do_flip_rotate(bool do_flip_rotate)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     if (!m_do_flip_rotate_override)
         m_do_flip_rotate = do_flip_rotate;
+    m_config_generation++;
     return MEDIA_LIBRARY_SUCCESS;
 }
 
@@ -369,8 +402,9 @@ media_library_return MediaLibraryMultiResize::Impl::set_output_flip(flip_directi
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "Setting output flip from {} to {}", m_flip_config.direction, direction);
     flip_config_t new_flip = {true, direction};
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     m_flip_config = new_flip;
+    m_config_generation++;
     return MEDIA_LIBRARY_SUCCESS;
 }
 
@@ -387,9 +421,10 @@ media_library_return MediaLibraryMultiResize::Impl::set_output_rotation(rotation
     LOGGER__MODULE__INFO(MODULE_NAME, "Setting output rotation from {} to {}", current_rotation.angle,
                          new_rotation.angle);
 
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
 
     m_multi_resize_config.set_output_dimensions_rotation(new_rotation);
+    m_config_generation++;
     auto output_res_expected = m_multi_resize_config.get_output_resolution_by_index(0);
     if (!output_res_expected.has_value())
     {
@@ -419,7 +454,7 @@ media_library_return MediaLibraryMultiResize::Impl::set_output_rotation(rotation
 
 media_library_return MediaLibraryMultiResize::Impl::set_image_enhancement_status(bool status)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     m_dsp_image_enhancement->m_denoise_element_enabled = status;
     return MEDIA_LIBRARY_SUCCESS;
 }
@@ -427,7 +462,7 @@ media_library_return MediaLibraryMultiResize::Impl::set_image_enhancement_status
 media_library_return MediaLibraryMultiResize::Impl::configure(multi_resize_config_t &mresize_config)
 {
     LOGGER__MODULE__INFO(MODULE_NAME, "Configuring multi-resize with new configurations");
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
 
     // Create and initialize buffer pools
     auto ret = m_multi_resize_config.update(mresize_config);
@@ -436,13 +471,14 @@ media_library_return MediaLibraryMultiResize::Impl::configure(multi_resize_confi
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to update multi-resize configurations (prohibited) {}", ret);
         return MEDIA_LIBRARY_CONFIGURATION_ERROR;
     }
+    m_config_generation++;
 
     // Create and initialize buffer pools
     ret = create_and_initialize_buffer_pools();
     if (ret != MEDIA_LIBRARY_SUCCESS)
         return ret;
 
-    ret = m_motion_detection.allocate_motion_detection(m_max_buffer_pool_size);
+    ret = m_motion_detection->allocate_motion_detection(m_max_buffer_pool_size);
     if (ret != MEDIA_LIBRARY_SUCCESS)
         return ret;
 
@@ -465,19 +501,37 @@ media_library_return MediaLibraryMultiResize::Impl::configure_internal(multi_res
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to update multi-resize configurations (prohibited) {}", ret);
         return MEDIA_LIBRARY_CONFIGURATION_ERROR;
     }
+    m_config_generation++;
 
     // recreate buffer pools if needed
     ret = create_and_initialize_buffer_pools();
     if (ret != MEDIA_LIBRARY_SUCCESS)
         return ret;
 
-    ret = m_motion_detection.allocate_motion_detection(m_max_buffer_pool_size);
+    ret = m_motion_detection->allocate_motion_detection(m_max_buffer_pool_size);
     if (ret != MEDIA_LIBRARY_SUCCESS)
         return ret;
 
     return MEDIA_LIBRARY_SUCCESS;
 }
 
+void MediaLibraryMultiResize::Impl::update_output_order()
+{
+    size_t num_of_outputs = GET_NUM_OF_OUTPUTS(m_multi_resize_config);
+    if (num_of_outputs != m_output_order.size())
+    {
+        // Drop counters are kept across reconfigurations that do not change the outputs
+        m_output_drops = std::make_unique<std::atomic<uint64_t>[]>(num_of_outputs);
+    }
+
+    std::vector<uint32_t> priorities(num_of_outputs);
+    for (uint8_t i = 0; i < num_of_outputs; i++)
+    {
+        priorities[i] = m_multi_resize_config.get_output_resolution_by_index(i)->get().priority;
+    }
+    m_output_order = order_outputs_by_priority(priorities);
+}
+
 media_library_return MediaLibraryMultiResize::Impl::create_and_initialize_buffer_pools()
 {
     uint num_of_outputs = GET_NUM_OF_OUTPUTS(m_multi_resize_config);
@@ -489,6 +543,7 @@ media_library_return MediaLibraryMultiResize::Impl::create_and_initialize_buffer
         first = true;
     }
 
+    std::vector<std::pair<uint, MediaLibraryBufferPoolPtr>> new_pools;
     for (uint i = 0; i < num_of_outputs; i++)
     {
         auto output_res_expected = m_multi_resize_config.get_output_resolution_by_index(i);
@@ -526,11 +581,24 @@ media_library_return MediaLibraryMultiResize::Impl::create_and_initialize_buffer
         MediaLibraryBufferPoolPtr buffer_pool = std::make_shared<MediaLibraryBufferPool>(
             width, height, m_multi_resize_config.application_input_streams_config.format, output_res.pool_max_buffers,
             HAILO_MEMORY_TYPE_DMABUF, bytes_per_line, name);
-        if (buffer_pool->init() != MEDIA_LIBRARY_SUCCESS)
-        {
-            LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to init buffer pool");
-            return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
-        }
+        // The DSP writes the outputs through their fd, a CPU mapping is created only if a consumer asks for it
+        buffer_pool->set_device_only(true);
+        new_pools.emplace_back(i, buffer_pool);
+    }
+
+    // The outputs are allocated together, so the init time follows the largest output rather than their sum
+    std::vector<MediaLibraryBufferPoolPtr> pools_to_init;
+    for (auto &[i, buffer_pool] : new_pools)
+    {
+        pools_to_init.push_back(buffer_pool);
+    }
+    if (MediaLibraryBufferPool::init_pools(pools_to_init) != MEDIA_LIBRARY_SUCCESS)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to init buffer pool");
+        return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
+    }
+    for (auto &[i, buffer_pool] : new_pools)
+    {
         if (first)
         {
             m_buffer_pools.emplace_back(buffer_pool);
@@ -542,6 +610,8 @@ media_library_return MediaLibraryMultiResize::Impl::create_and_initialize_buffer
     }
     LOGGER__MODULE__DEBUG(MODULE_NAME, "multi-resize holding {} buffer pools", m_buffer_pools.size());
 
+    update_output_order();
+
     return MEDIA_LIBRARY_SUCCESS;
 }
 
@@ -702,8 +772,21 @@ bool MediaLibraryMultiResize::Impl::should_push_frame_logic(uint32_t output_fram
     }
 }
 
+/**
+ * @brief Shared empty buffer handed out for the outputs that are not produced in a frame
+ * Consumers recognize it by its null buffer_data and never modify it, so a single instance serves all the outputs
+ * without allocating per frame.
+ */
+static const HailoMediaLibraryBufferPtr &empty_output_buffer()
+{
+    static const HailoMediaLibraryBufferPtr empty_buffer = std::make_shared<hailo_media_library_buffer>();
+    return empty_buffer;
+}
+
 /**
  * @brief Acquire output buffers from buffer pools
+ * Outputs are served in descending priority. An output whose pool is exhausted is skipped (and counted as dropped)
+ * while the other outputs of the frame are still produced, so that one slow consumer only degrades its own stream.
  *
  * @param[in] input_frame - pointer to the input frame
  * @param[in] buffers - vector of output buffers
@@ -711,11 +794,11 @@ bool MediaLibraryMultiResize::Impl::should_push_frame_logic(uint32_t output_fram
 media_library_return MediaLibraryMultiResize::Impl::acquire_output_buffers(
     HailoMediaLibraryBufferPtr input_buffer, std::vector<HailoMediaLibraryBufferPtr> &buffers)
 {
-    uint8_t num_of_outputs = GET_NUM_OF_OUTPUTS(m_multi_resize_config);
+    auto acquire_start = std::chrono::steady_clock::now();
 
-    for (uint8_t i = 0; i < num_of_outputs; i++)
+    buffers.resize(m_output_order.size());
+    for (uint8_t i : m_output_order)
     {
-        HailoMediaLibraryBufferPtr buffer = std::make_shared<hailo_media_library_buffer>();
         auto output_res_expected = m_multi_resize_config.get_output_resolution_by_index(i);
         if (!output_res_expected.has_value())
         {
@@ -730,25 +813,53 @@ media_library_return MediaLibraryMultiResize::Impl::acquire_output_buffers(
             LOGGER__MODULE__DEBUG(MODULE_NAME,
                                   "Skipping current frame [framerate {}], no need to acquire buffer {}, counter is {}",
                                   output_res.framerate, i, m_frame_counter);
-            buffers.emplace_back(buffer);
+            buffers[i] = empty_output_buffer();
             continue;
         }
 
-        if (m_buffer_pools[i]->acquire_buffer(buffer) != MEDIA_LIBRARY_SUCCESS)
+        tl::expected<HailoMediaLibraryBufferPtr, media_library_return> buffer_expected;
+        if (output_res.drop_policy == OUTPUT_DROP_POLICY_BLOCK)
+        {
+            // The deadlines of the blocking outputs all start with the frame, so their waits overlap
+            auto deadline = acquire_start + std::chrono::milliseconds(output_res.drop_timeout_ms);
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::max(deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero()));
+            buffer_expected = m_buffer_pools[i]->acquire_buffer(remaining);
+        }
+        else
+        {
+            buffer_expected = m_buffer_pools[i]->acquire_buffer();
+        }
+
+        if (!buffer_expected.has_value())
         {
-            LOGGER__MODULE__WARNING(MODULE_NAME, "Failed to acquire buffer, skipping buffer");
-            buffers.emplace_back(buffer);
+            uint64_t drops = m_output_drops[i].fetch_add(1, std::memory_order_relaxed) + 1;
+            LOGGER__MODULE__WARNING(MODULE_NAME, "Failed to acquire buffer, dropping output {} ({} drops so far)", i,
+                                    drops);
+            buffers[i] = empty_output_buffer();
             continue;
         }
 
+        HailoMediaLibraryBufferPtr buffer = std::move(buffer_expected.value());
         buffer->copy_metadata_from(input_buffer);
-        buffers.emplace_back(buffer);
+        buffers[i] = buffer;
         LOGGER__MODULE__DEBUG(MODULE_NAME, "buffer acquired successfully");
     }
 
     return MEDIA_LIBRARY_SUCCESS;
 };
 
+std::vector<uint64_t> MediaLibraryMultiResize::Impl::get_output_drop_counts()
+{
+    std::shared_lock<ProfiledSharedMutex> lock(rw_lock);
+    std::vector<uint64_t> drops(m_output_order.size());
+    for (size_t i = 0; i < drops.size(); i++)
+    {
+        drops[i] = m_output_drops[i].load(std::memory_order_relaxed);
+    }
+    return drops;
+}
+
 cv::Size expand_to_aspect_ratio(float target_aspect_ratio, const cv::Size &size)
 {
     float aspect_ratio = static_cast<float>(size.width) / size.height;
@@ -817,29 +928,34 @@ cv::Size adjust_to_aspect_ratio(float target_aspect_ratio, const cv::Size &size,
 
 /* The telescopic multi-resize function in the DSP requires that the resolutions on each dsp_crop_resize_params_t
  * will be in descending order (for both width and height).
- * This function splits the output resolutions into groups of resolutions that can be resized together.
+ * This function splits the output resolutions into groups of resolutions that can be resized together. The groups are
+ * built without destination images, the output of each destination slot is recorded in the plan so that the images of
+ * a frame can be patched in.
  */
-static std::vector<dsp_crop_resize_params_t> split_to_crop_resize_params(std::vector<output_data_and_config> &outputs,
-                                                                         const dsp_roi_t &input_roi)
+static void split_to_crop_resize_params(std::vector<std::pair<uint8_t, const output_resolution_t *>> outputs,
+                                        multi_resize_plan_t &plan)
 {
-    std::vector<dsp_crop_resize_params_t> params;
-    auto src_width = input_roi.end_x - input_roi.start_x;
-    auto src_height = input_roi.end_y - input_roi.start_y;
+    plan.crop_resize_params.clear();
+    plan.slot_outputs.clear();
+    std::vector<std::vector<cv::Size>> group_scaled_sizes;
+    auto src_width = plan.input_roi.end_x - plan.input_roi.start_x;
+    auto src_height = plan.input_roi.end_y - plan.input_roi.start_y;
     float src_aspect_ratio = static_cast<float>(src_width) / src_height;
 
     // Sort output resolutions (by width) from largest to smallest - after adjusting to aspect ratio
     std::sort(outputs.begin(), outputs.end(),
-              [src_aspect_ratio](const output_data_and_config &a, const output_data_and_config &b) {
-                  cv::Size size_a(a.config->dimensions.destination_width, a.config->dimensions.destination_height);
-                  cv::Size size_b(b.config->dimensions.destination_width, b.config->dimensions.destination_height);
-                  auto scaling_mode_a = a.config->scaling_mode;
-                  auto scaling_mode_b = b.config->scaling_mode;
+              [src_aspect_ratio](const std::pair<uint8_t, const output_resolution_t *> &a,
+                                 const std::pair<uint8_t, const output_resolution_t *> &b) {
+                  cv::Size size_a(a.second->dimensions.destination_width, a.second->dimensions.destination_height);
+                  cv::Size size_b(b.second->dimensions.destination_width, b.second->dimensions.destination_height);
+                  auto scaling_mode_a = a.second->scaling_mode;
+                  auto scaling_mode_b = b.second->scaling_mode;
                   cv::Size scaled_size_a = adjust_to_aspect_ratio(src_aspect_ratio, size_a, scaling_mode_a);
                   cv::Size scaled_size_b = adjust_to_aspect_ratio(src_aspect_ratio, size_b, scaling_mode_b);
                   return scaled_size_a.width > scaled_size_b.width;
               });
 
-    for (auto &[output, output_config] : outputs)
+    for (auto &[output_index, output_config] : outputs)
     {
         cv::Size curr_size(output_config->dimensions.destination_width, output_config->dimensions.destination_height);
         auto curr_scaling_mode = output_config->scaling_mode;
@@ -847,34 +963,30 @@ static std::vector<dsp_crop_resize_params_t> split_to_crop_resize_params(std::ve
 
         // Try to find a suitable crop_resize_param for the current output
         bool found = false;
-        for (auto &crop_resize_param : params)
+        for (size_t p = 0; p < plan.crop_resize_params.size(); p++)
         {
-            // Find the first empty slot (the first slot can be skipped since it's always initialized)
-            size_t i = 1;
-            while (i < DSP_MULTI_RESIZE_OUTPUTS_COUNT && crop_resize_param.dst[i] != nullptr)
-            {
-                i++;
-            }
+            dsp_crop_resize_params_t &crop_resize_param = plan.crop_resize_params[p];
+            std::vector<uint8_t> &slots = plan.slot_outputs[p];
 
-            // If no empty slot is found, continue to the next crop_resize_param
+            // The first empty slot follows the used ones, if no empty slot is found continue to the next one
+            size_t i = slots.size();
             if (i == DSP_MULTI_RESIZE_OUTPUTS_COUNT)
             {
                 continue;
             }
 
             // Check if the current buffer can be added based on the width and height of the previous buffer
-            // (a previous buffer exists since crop_resize_param is never added with an empty dst)
-            cv::Size prev_size(crop_resize_param.dst[i - 1]->width, crop_resize_param.dst[i - 1]->height);
-            auto prev_scaling_mode = crop_resize_param.scaling_params[i - 1].scaling_mode;
-            cv::Size prev_scaled_size = adjust_to_aspect_ratio(src_aspect_ratio, prev_size, prev_scaling_mode);
+            // (a previous buffer exists since crop_resize_param is never added with an empty slot list)
+            cv::Size prev_scaled_size = group_scaled_sizes[p].back();
 
             if (prev_scaled_size.width >= curr_scaled_size.width && prev_scaled_size.height >= curr_scaled_size.height)
             {
-                crop_resize_param.dst[i] = &output.properties;
                 crop_resize_param.scaling_params[i].scaling_mode = curr_scaling_mode;
                 crop_resize_param.scaling_params[i].color.y = 0;
                 crop_resize_param.scaling_params[i].color.u = 128;
                 crop_resize_param.scaling_params[i].color.v = 128;
+                slots.push_back(output_index);
+                group_scaled_sizes[p].push_back(curr_scaled_size);
                 found = true;
                 break;
             }
@@ -886,16 +998,16 @@ static std::vector<dsp_crop_resize_params_t> split_to_crop_resize_params(std::ve
         if (!found)
         {
             dsp_crop_resize_params_t new_param = {};
-            new_param.dst[0] = &output.properties;
+            new_param.crop = &plan.input_roi;
             new_param.scaling_params[0].scaling_mode = curr_scaling_mode;
             new_param.scaling_params[0].color.y = 0;
             new_param.scaling_params[0].color.u = 128;
             new_param.scaling_params[0].color.v = 128;
-            params.push_back(new_param);
+            plan.crop_resize_params.push_back(new_param);
+            plan.slot_outputs.push_back({output_index});
+            group_scaled_sizes.push_back({curr_scaled_size});
         }
     }
-
-    return params;
 }
 
 tl::expected<dsp_roi_t, media_library_return> MediaLibraryMultiResize::Impl::get_input_roi()
@@ -963,8 +1075,94 @@ tl::expected<dsp_roi_t, media_library_return> MediaLibraryMultiResize::Impl::get
     };
 }
 
+/**
+ * @brief Build the frame independent part of the DSP parameters for all the configured outputs
+ * Must be called while holding rw_lock (shared or exclusive), the returned plan is not published.
+ */
+tl::expected<std::shared_ptr<const multi_resize_plan_t>, media_library_return> MediaLibraryMultiResize::Impl::
+    build_multi_resize_plan()
+{
+    size_t num_of_output_resolutions = GET_NUM_OF_OUTPUTS(m_multi_resize_config);
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "Building multi resize params for {} outputs, configuration generation {}",
+                          num_of_output_resolutions, m_config_generation);
+    auto plan = std::make_shared<multi_resize_plan_t>();
+
+    auto input_roi = get_input_roi();
+    if (!input_roi.has_value())
+    {
+        return tl::make_unexpected(input_roi.error());
+    }
+    plan->input_roi = input_roi.value();
+
+    std::vector<std::pair<uint8_t, const output_resolution_t *>> outputs;
+    outputs.reserve(num_of_output_resolutions);
+    for (size_t i = 0; i < num_of_output_resolutions; i++)
+    {
+        auto output_res_expected = m_multi_resize_config.get_output_resolution_by_index(i);
+        if (!output_res_expected.has_value())
+        {
+            return tl::make_unexpected(output_res_expected.error());
+        }
+        outputs.emplace_back(i, &output_res_expected.value().get());
+    }
+    split_to_crop_resize_params(std::move(outputs), *plan);
+
+    plan->multi_crop_resize_params = {
+        .src = nullptr,
+        .crop_resize_params = nullptr,
+        .crop_resize_params_count = 0,
+        .interpolation = m_multi_resize_config.application_input_streams_config.interpolation_type,
+    };
+
+    // enable only if not already done in dewarp
+    if (m_do_flip_rotate)
+    {
+        plan->flip_rotate_params = dsp_flip_rotate_params_t{
+            .flip_dir = static_cast<dsp_flip_direction_t>(m_flip_config.effective_value()),
+            .rot_ang = static_cast<dsp_rotation_angle_t>(m_multi_resize_config.rotation_config.effective_value()),
+        };
+    }
+
+    auto frame_size = std::make_pair(plan->input_roi.end_x - plan->input_roi.start_x,
+                                     plan->input_roi.end_y - plan->input_roi.start_y);
+    plan->histogram_sample_step = DspImageEnhancement::histogram_sample_step_for_frame(frame_size);
+
+    plan->generation = m_config_generation;
+    return plan;
+}
+
+/**
+ * @brief Get the DSP parameters of the current configuration generation, building and publishing them if needed
+ * Must be called while holding rw_lock, frames running in parallel may both build a plan, the last one is kept.
+ */
+tl::expected<std::shared_ptr<const multi_resize_plan_t>, media_library_return> MediaLibraryMultiResize::Impl::
+    get_multi_resize_plan()
+{
+    std::shared_ptr<const multi_resize_plan_t> plan;
+    {
+        std::lock_guard<std::mutex> plan_lock(m_plan_mutex);
+        plan = m_plan;
+    }
+    if (plan != nullptr && plan->generation == m_config_generation)
+    {
+        return plan;
+    }
+
+    auto plan_expected = build_multi_resize_plan();
+    if (!plan_expected.has_value())
+    {
+        return tl::make_unexpected(plan_expected.error());
+    }
+
+    std::lock_guard<std::mutex> plan_lock(m_plan_mutex);
+    m_plan = plan_expected.value();
+    return m_plan;
+}
+
 /**
  * @brief Perform multi resize on the DSP
+ * The DSP parameters are built once per configuration for all the outputs, each frame copies the groups of the outputs
+ * it produces into local parameters and patches in its source and destination images.
  *
  * @param[in] input_frame - pointer to the input frame
  * @param[out] output_frames - vector of output frames
@@ -985,10 +1183,19 @@ media_library_return MediaLibraryMultiResize::Impl::perform_multi_resize(
 
     hailo_dsp_buffer_data_t src_dsp_buffer_data = input_buffer->buffer_data->As<hailo_dsp_buffer_data_t>();
 
-    std::vector<output_data_and_config> outputs_data_and_config;
-    outputs_data_and_config.reserve(num_of_output_resolutions);
-
-    uint num_bufs_to_resize = 0;
+    // The storage is resized only by the first frame after the number of outputs changed
+    std::unique_lock<std::mutex> frame_lock(m_frame_mutex);
+    if (m_frame.output_dsp_images.size() != num_of_output_resolutions)
+    {
+        m_frame.output_dsp_buffer_data.resize(num_of_output_resolutions);
+        m_frame.output_dsp_images.resize(num_of_output_resolutions);
+        // a group has at least one output
+        m_frame.crop_resize_params.resize(num_of_output_resolutions);
+    }
+    std::vector<hailo_dsp_buffer_data_t> &output_dsp_buffer_data = m_frame.output_dsp_buffer_data;
+    std::vector<dsp_image_properties_t *> &output_dsp_images = m_frame.output_dsp_images;
+    std::fill(output_dsp_images.begin(), output_dsp_images.end(), nullptr);
+    bool any_output = false;
     for (size_t i = 0; i < num_of_output_resolutions; i++)
     {
         auto output_res_expected = m_multi_resize_config.get_output_resolution_by_index(i);
@@ -1006,14 +1213,15 @@ media_library_return MediaLibraryMultiResize::Impl::perform_multi_resize(
         }
 
         hailo_buffer_data_t *output_frame = output_frames[i]->buffer_data.get();
-        outputs_data_and_config.emplace_back(std::move(output_frame->As<hailo_dsp_buffer_data_t>()), &output_res);
-
         if (output_res != *output_frame)
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Invalid output frame width {} output frame height {}",
                                   output_frame->width, output_frame->height);
             return MEDIA_LIBRARY_ERROR;
         }
+        output_dsp_buffer_data[i] = output_frame->As<hailo_dsp_buffer_data_t>();
+        output_dsp_images[i] = &output_dsp_buffer_data[i].properties;
+        any_output = true;
 
         LOGGER__MODULE__DEBUG(
             MODULE_NAME,
@@ -1021,35 +1229,29 @@ media_library_return MediaLibraryMultiResize::Impl::perform_multi_resize(
             "= {}, y plane fd = {}",
             i, fmt::ptr(output_frame->planes[0].userptr), fmt::ptr(output_frame->planes[1].userptr),
             output_frame->width, output_frame->height, output_frame->planes[0].fd);
-        num_bufs_to_resize++;
     }
 
-    if (num_bufs_to_resize == 0)
+    if (!any_output)
     {
         LOGGER__MODULE__DEBUG(MODULE_NAME, "No need to perform multi resize");
         return MEDIA_LIBRARY_SUCCESS;
     }
 
-    auto input_roi = get_input_roi();
-    if (!input_roi.has_value())
+    auto plan_expected = get_multi_resize_plan();
+    if (!plan_expected.has_value())
     {
-        return input_roi.error();
+        return plan_expected.error();
     }
+    std::shared_ptr<const multi_resize_plan_t> plan = plan_expected.value();
 
-    auto crop_resize_params = split_to_crop_resize_params(outputs_data_and_config, input_roi.value());
+    size_t crop_resize_params_count =
+        compact_crop_resize_params(*plan, output_dsp_images.data(), m_frame.crop_resize_params.data());
 
-    dsp_multi_crop_resize_params_t multi_crop_resize_params = {
-        .src = &src_dsp_buffer_data.properties,
-        .crop_resize_params = crop_resize_params.data(),
-        .crop_resize_params_count = crop_resize_params.size(),
-        .interpolation = m_multi_resize_config.application_input_streams_config.interpolation_type,
-    };
-
-    // Apply the input ROI to all crop_resize_params
-    for (auto &p : crop_resize_params)
-    {
-        p.crop = &input_roi.value();
-    }
+    dsp_multi_crop_resize_params_t multi_crop_resize_params = plan->multi_crop_resize_params;
+    multi_crop_resize_params.src = &src_dsp_buffer_data.properties;
+    multi_crop_resize_params.crop_resize_params = m_frame.crop_resize_params.data();
+    multi_crop_resize_params.crop_resize_params_count = crop_resize_params_count;
+    std::optional<dsp_flip_rotate_params_t> flip_rotate_params = plan->flip_rotate_params;
 
     // Perform multi resize
     clock_gettime(CLOCK_MONOTONIC, &start_resize);
@@ -1076,9 +1278,7 @@ media_library_return MediaLibraryMultiResize::Impl::perform_multi_resize(
 
         if (dsp_image_enhancement_params->histogram_params)
         {
-            auto frame_size =
-                std::make_pair(input_roi->end_x - input_roi->start_x, input_roi->end_y - input_roi->start_y);
-            auto [x_sample_step, y_sample_step] = DspImageEnhancement::histogram_sample_step_for_frame(frame_size);
+            auto [x_sample_step, y_sample_step] = plan->histogram_sample_step;
             dsp_image_enhancement_params->histogram_params->x_sample_step = x_sample_step;
             dsp_image_enhancement_params->histogram_params->y_sample_step = y_sample_step;
             LOGGER__MODULE__DEBUG(MODULE_NAME,
@@ -1093,23 +1293,13 @@ media_library_return MediaLibraryMultiResize::Impl::perform_multi_resize(
         MODULE_NAME,
         "Performing multi resize on the DSP with digital zoom ROI: start_x {} start_y {} end_x {} end_y "
         "{} and post denoise filter",
-        input_roi->start_x, input_roi->start_y, input_roi->end_x, input_roi->end_y);
-
-    // enable only if not already done in dewarp
-    std::optional<dsp_flip_rotate_params_t> dsp_flip_rotate_params;
-    if (m_do_flip_rotate)
-    {
-        dsp_flip_rotate_params = dsp_flip_rotate_params_t{
-            .flip_dir = static_cast<dsp_flip_direction_t>(m_flip_config.effective_value()),
-            .rot_ang = static_cast<dsp_rotation_angle_t>(m_multi_resize_config.rotation_config.effective_value()),
-        };
-    }
+        plan->input_roi.start_x, plan->input_roi.start_y, plan->input_roi.end_x, plan->input_roi.end_y);
 
     const dsp_frontend_params_t dsp_frontend_params = {
         .multi_crop_resize_params = &multi_crop_resize_params,
         .privacy_mask_params = nullptr,
         .image_enhancement_params = dsp_image_enhancement_params ? &dsp_image_enhancement_params.value() : nullptr,
-        .flip_rotate_params = dsp_flip_rotate_params ? &dsp_flip_rotate_params.value() : nullptr,
+        .flip_rotate_params = flip_rotate_params ? &flip_rotate_params.value() : nullptr,
     };
     dsp_status ret = dsp_utils::perform_dsp_frontend_process(dsp_frontend_params);
 
@@ -1180,7 +1370,7 @@ media_library_return MediaLibraryMultiResize::Impl::handle_frame(HailoMediaLibra
         return MEDIA_LIBRARY_INVALID_ARGUMENT;
     }
 
-    std::shared_lock<std::shared_mutex> lock(rw_lock);
+    std::shared_lock<ProfiledSharedMutex> lock(rw_lock);
 
     // Acquire output buffers
     media_library_return media_lib_ret = MEDIA_LIBRARY_SUCCESS;
@@ -1196,7 +1386,7 @@ media_library_return MediaLibraryMultiResize::Impl::handle_frame(HailoMediaLibra
         // Saturate UV plane to value of 128 - to get a grayscale image
         if (input_frame->is_dmabuf())
         {
-            input_frame->sync_start(1);
+            input_frame->sync_start(1, DMA_SYNC_ACCESS_WRITE);
             memset(input_frame->get_plane_ptr(1), 128, input_frame->get_plane_size(1));
             input_frame->sync_end(1);
         }
@@ -1216,7 +1406,7 @@ media_library_return MediaLibraryMultiResize::Impl::handle_frame(HailoMediaLibra
 
     if (m_multi_resize_config.motion_detection_config.enabled)
     {
-        media_lib_ret = m_motion_detection.perform_motion_detection(output_frames);
+        media_lib_ret = m_motion_detection->perform_motion_detection(output_frames);
 
         if (media_lib_ret != MEDIA_LIBRARY_SUCCESS)
             return media_lib_ret;
@@ -1242,23 +1432,24 @@ media_library_return MediaLibraryMultiResize::Impl::handle_frame(HailoMediaLibra
 
 multi_resize_config_t MediaLibraryMultiResize::Impl::get_multi_resize_configs()
 {
-    std::shared_lock<std::shared_mutex> lock(rw_lock);
+    std::shared_lock<ProfiledSharedMutex> lock(rw_lock);
     return m_multi_resize_config;
 }
 
 application_input_streams_config_t MediaLibraryMultiResize::Impl::get_application_input_streams_config()
 {
-    std::shared_lock<std::shared_mutex> lock(rw_lock);
+    std::shared_lock<ProfiledSharedMutex> lock(rw_lock);
     return m_multi_resize_config.application_input_streams_config;
 }
 
 media_library_return MediaLibraryMultiResize::Impl::set_input_video_config(uint32_t width, uint32_t height,
                                                                            uint32_t framerate)
 {
-    std::unique_lock<std::shared_mutex> lock(rw_lock);
+    std::unique_lock<ProfiledSharedMutex> lock(rw_lock);
     m_multi_resize_config.input_video_config.dimensions.destination_width = width;
     m_multi_resize_config.input_video_config.dimensions.destination_height = height;
     m_multi_resize_config.input_video_config.framerate = framerate;
+    m_config_generation++;
 
     return MEDIA_LIBRARY_SUCCESS;
 }
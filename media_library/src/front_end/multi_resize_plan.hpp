@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file multi_resize_plan.hpp
+ * @brief Cached DSP parameters and output order of the multi-resize, and their per-frame patching
+ **/
+
+#pragma once
+#include <algorithm>
+#include <optional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "dsp_utils.hpp"
+
+/**
+ * @brief Frame independent part of the DSP multi-resize parameters, built for all the configured outputs.
+ * It is rebuilt only when the configuration generation changes and is immutable once published, each frame copies the
+ * groups of the outputs it produces and patches in its source and destination images.
+ */
+struct multi_resize_plan_t
+{
+    uint64_t generation = 0;
+    dsp_roi_t input_roi = {};
+    std::vector<dsp_crop_resize_params_t> crop_resize_params;
+    // output index of each destination slot, per crop_resize_params entry
+    std::vector<std::vector<uint8_t>> slot_outputs;
+    dsp_multi_crop_resize_params_t multi_crop_resize_params = {};
+    std::optional<dsp_flip_rotate_params_t> flip_rotate_params;
+    std::pair<uint16_t, uint16_t> histogram_sample_step = {0, 0};
+};
+
+/**
+ * @brief Order in which the output buffers are acquired, by descending priority and by index among equal priorities
+ *
+ * @param[in] priorities - priority of each output by output index
+ * @return std::vector<uint8_t> - the output indices in acquisition order
+ */
+inline std::vector<uint8_t> order_outputs_by_priority(const std::vector<uint32_t> &priorities)
+{
+    std::vector<uint8_t> order(priorities.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = static_cast<uint8_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&priorities](uint8_t a, uint8_t b) { return priorities[a] > priorities[b]; });
+    return order;
+}
+
+/**
+ * @brief Copies the groups of a plan for the outputs produced by a frame
+ * The DSP stops at the first empty destination slot of a group, so the skipped outputs are compacted out of each group
+ * (keeping the order of the others, so the group stays sorted by size) and the groups left empty are dropped.
+ *
+ * @param[in] plan - the plan
+ * @param[in] output_images - DSP image of each output by output index, nullptr for the outputs skipped by the frame
+ * @param[out] crop_resize_params - groups of the frame, room for as many groups as the plan has
+ * @return size_t - number of groups of the frame
+ */
+inline size_t compact_crop_resize_params(const multi_resize_plan_t &plan, dsp_image_properties_t *const *output_images,
+                                         dsp_crop_resize_params_t *crop_resize_params)
+{
+    size_t crop_resize_params_count = 0;
+    for (size_t p = 0; p < plan.crop_resize_params.size(); p++)
+    {
+        const dsp_crop_resize_params_t &plan_params = plan.crop_resize_params[p];
+        const std::vector<uint8_t> &slots = plan.slot_outputs[p];
+        dsp_crop_resize_params_t &frame_params = crop_resize_params[crop_resize_params_count];
+        frame_params = {};
+        frame_params.crop = plan_params.crop;
+        size_t used_slots = 0;
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (output_images[slots[i]] == nullptr)
+            {
+                continue;
+            }
+            frame_params.dst[used_slots] = output_images[slots[i]];
+            frame_params.scaling_params[used_slots] = plan_params.scaling_params[i];
+            used_slots++;
+        }
+        if (used_slots > 0)
+        {
+            crop_resize_params_count++;
+        }
+    }
+    return crop_resize_params_count;
+}
@@ -32,6 +32,7 @@
 #include "media_library_logger.hpp"
 #include "media_library_utils.hpp"
 #include "snapshot.hpp"
+#include "buffer_pool_registry.hpp"
 
 #define MODULE_NAME LoggerType::Encoder
 
@@ -51,7 +52,7 @@ Encoder::Impl::~Impl()
     dispose();
 }
 
-media_library_return Encoder::Impl::allocate_output_memory(HailoMediaLibraryBufferPtr buffer_ptr)
+media_library_return Encoder::Impl::allocate_output_memory(HailoMediaLibraryBufferPtr &buffer_ptr)
 {
     i32 ret;
     if (NULL == m_ewl)
@@ -65,11 +66,13 @@ media_library_return Encoder::Impl::allocate_output_memory(HailoMediaLibraryBuff
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
 
-    if (m_buffer_pool->acquire_buffer(buffer_ptr) != MEDIA_LIBRARY_SUCCESS)
+    auto buffer_expected = m_buffer_pool->acquire_buffer();
+    if (!buffer_expected.has_value())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire buffer");
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
+    buffer_ptr = std::move(buffer_expected.value());
     int planeFd = buffer_ptr->get_plane_fd(0);
     // Retrieve the physical address of the plane
     ret = EWLShareDmabuf(m_ewl, planeFd, &m_enc_in.busOutBuf);
@@ -95,7 +98,7 @@ tl::expected<EncoderOutputBuffer, media_library_return> Encoder::Impl::encode_ex
     media_library_return ret = MEDIA_LIBRARY_SUCCESS;
     VCEncRet encoder_ret_code;
     i32 unshare_ret_code;
-    HailoMediaLibraryBufferPtr buffer_ptr = std::make_shared<hailo_media_library_buffer>();
+    HailoMediaLibraryBufferPtr buffer_ptr;
     if (allocate_output_memory(buffer_ptr) != MEDIA_LIBRARY_SUCCESS)
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to allocate output memory");
@@ -168,12 +171,16 @@ void Encoder::Impl::init_buffer_pool(uint pool_size)
     if (m_buffer_pool == nullptr)
     {
         std::string name = "encoder_output";
-        m_buffer_pool = std::make_shared<MediaLibraryBufferPool>(m_vc_cfg.width, m_vc_cfg.height, HAILO_FORMAT_GRAY8,
-                                                                 (pool_size), HAILO_MEMORY_TYPE_DMABUF, name);
-        if (m_buffer_pool->init() != MEDIA_LIBRARY_SUCCESS)
+        // Streams of the same resolution share their output pool
+        buffer_pool_key_t key = {m_vc_cfg.width, m_vc_cfg.height, HAILO_FORMAT_GRAY8, HAILO_MEMORY_TYPE_DMABUF,
+                                 m_vc_cfg.width};
+        auto pool_expected = BufferPoolRegistry::get_instance().lease(key, pool_size, name);
+        if (!pool_expected.has_value())
         {
             LOGGER__MODULE__ERROR(MODULE_NAME, "Encoder - init_buffer_pool - Failed to init buffer pool");
+            return;
         }
+        m_buffer_pool = pool_expected.value();
     }
 }
 
@@ -188,14 +195,9 @@ Encoder::Impl::Impl(std::string json_string) : m_config(std::make_unique<Encoder
 
 media_library_return Encoder::Impl::dispose()
 {
-    media_library_return ret = MEDIA_LIBRARY_SUCCESS;
-    if (m_buffer_pool != nullptr)
-    {
-        ret = m_buffer_pool->free(false);
-        m_buffer_pool.reset();
-        m_buffer_pool = nullptr;
-    }
-    return ret;
+    // The pool is shared, returning the lease frees it once no other encoder uses it
+    m_buffer_pool.reset();
+    return MEDIA_LIBRARY_SUCCESS;
 }
 
 media_library_return Encoder::Impl::release()
@@ -266,7 +268,7 @@ media_library_return Encoder::Impl::init()
         return MEDIA_LIBRARY_CONFIGURATION_ERROR;
     }
 
-    init_buffer_pool(MAX_GOP_SIZE + 3);
+    init_buffer_pool(Encoder::OUTPUT_POOL_MAX_BUFFERS);
     EWLInitParam_t ewl_params;
     ewl_params.clientType = EWL_CLIENT_TYPE_HEVC_ENC;
     m_ewl = (void *)EWLInit(&ewl_params);
@@ -709,7 +711,7 @@ tl::expected<EncoderOutputBuffer, media_library_return> Encoder::finish()
 void Encoder::Impl::stop()
 {
     m_state = ENCODER_STATE_STOP;
-    std::unique_lock<std::mutex> lck(m_is_encoding_multiple_frames_mtx);
+    std::unique_lock<ProfiledMutex> lck(m_is_encoding_multiple_frames_mtx);
     m_is_encoding_multiple_frames_cv.wait(lck, [this]() { return !m_is_encoding_multiple_frames; });
     m_inputs.clear();
 }
@@ -747,6 +749,14 @@ media_library_return Encoder::Impl::update_input_buffer(HailoMediaLibraryBufferP
     {
         for (uint32_t i = 0; i < num_of_planes; i++)
         {
+            // Planes that live in the dmabuf of the previous plane are addressed relative to it
+            if (buf->shares_previous_plane_fd(i))
+            {
+                *bus_addresses[i] =
+                    *bus_addresses[i - 1] + (u32)(buf->get_plane_offset(i) - buf->get_plane_offset(i - 1));
+                continue;
+            }
+
             planeFd = buf->get_plane_fd(i);
             if (planeFd <= 0)
             {
@@ -759,10 +769,12 @@ media_library_return Encoder::Impl::update_input_buffer(HailoMediaLibraryBufferP
                 LOGGER__MODULE__ERROR(MODULE_NAME, "Could not get physical address of plane {}", i);
                 for (uint32_t j = 0; j <= i; j++)
                 {
-                    EWLUnshareDmabuf(m_ewl, buf->get_plane_fd(j));
+                    if (!buf->shares_previous_plane_fd(j))
+                        EWLUnshareDmabuf(m_ewl, buf->get_plane_fd(j));
                 }
                 return MEDIA_LIBRARY_ENCODER_COULD_NOT_GET_PHYSICAL_ADDRESS;
             }
+            *bus_addresses[i] += (u32)buf->get_plane_offset(i);
         }
     }
     else
@@ -800,7 +812,7 @@ media_library_return Encoder::Impl::encode_multiple_frames(std::vector<EncoderOu
     }
 
     // Assuming enc_params->encIn.gopSize is not 0.
-    std::unique_lock<std::mutex> lck(m_is_encoding_multiple_frames_mtx);
+    std::unique_lock<ProfiledMutex> lck(m_is_encoding_multiple_frames_mtx);
     m_is_encoding_multiple_frames = true;
     lck.unlock();
     for (uint8_t i = 0; i < gop_size; i++)
@@ -831,6 +843,9 @@ static void releaseDmabuf(HailoMediaLibraryBufferPtr buf, void *ewl)
 {
     for (uint32_t i = 0; i < buf->get_num_of_planes(); i++)
     {
+        if (buf->shares_previous_plane_fd(i))
+            continue;
+
         int planeFd = buf->get_plane_fd(i);
         if (planeFd <= 0)
         {
@@ -852,13 +867,13 @@ media_library_return Encoder::Impl::prepare_empty_output_buffer(EncoderOutputBuf
 
     // Allocate empty buffer output on error
     output.encoder_ret_code = VCENC_ERROR;
-    HailoMediaLibraryBufferPtr buffer_ptr = std::make_shared<hailo_media_library_buffer>();
-    if (m_buffer_pool->acquire_buffer(buffer_ptr) != MEDIA_LIBRARY_SUCCESS)
+    auto buffer_expected = m_buffer_pool->acquire_buffer();
+    if (!buffer_expected.has_value())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire buffer");
         return MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
-    output.buffer = buffer_ptr;
+    output.buffer = std::move(buffer_expected.value());
 
     return MEDIA_LIBRARY_SUCCESS;
 }
@@ -903,7 +918,8 @@ media_library_return Encoder::Impl::encode_frame(HailoMediaLibraryBufferPtr buf,
             {
                 for (uint32_t j = 0; j <= i; j++)
                 {
-                    EWLUnshareDmabuf(m_ewl, buf->get_plane_fd(j));
+                    if (!buf->shares_previous_plane_fd(j))
+                        EWLUnshareDmabuf(m_ewl, buf->get_plane_fd(j));
                 }
             }
         }
@@ -1050,7 +1066,7 @@ void Encoder::Impl::boost_settings_for_optical_zoom()
         rate_control.zoom_bitrate_adjuster.zooming_process_max_bitrate.value_or(
             DEFAULT_ZOOM_BITRATE_ADJUSTER_ZOOMING_MAX_BITRATE);
 
-    std::lock_guard<std::mutex> lock(m_settings_boost_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_settings_boost_mutex);
 
     if (!m_zooming_boost_enabled)
     {
@@ -1109,7 +1125,7 @@ void Encoder::Impl::boost_settings_for_optical_zoom()
 
 void Encoder::Impl::check_and_restore_settings(float current_optical_zoom)
 {
-    std::lock_guard<std::mutex> lock(m_settings_boost_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_settings_boost_mutex);
 
     if (m_zooming_boost_enabled)
     {
@@ -43,6 +43,7 @@ extern "C"
 
 // Hailo includes
 #include "buffer_pool.hpp"
+#include "profiled_mutex.hpp"
 #include "encoder_class.hpp"
 #include "encoder_gop_config.hpp"
 #include "encoder_internal.hpp"
@@ -200,8 +201,8 @@ class Encoder::Impl final
     EncoderCycleMonitor m_cycle_monitor;
 
     bool m_is_encoding_multiple_frames;
-    std::mutex m_is_encoding_multiple_frames_mtx;
-    std::condition_variable m_is_encoding_multiple_frames_cv;
+    ProfiledMutex m_is_encoding_multiple_frames_mtx{"encoder_multiple_frames"};
+    std::condition_variable_any m_is_encoding_multiple_frames_cv;
 
     std::vector<encoder_config_type_t> m_update_required;
     bool m_is_user_set_bitrate;
@@ -211,7 +212,7 @@ class Encoder::Impl final
     u32 m_original_gop_anomaly_bitrate_adjuster_enable; // TODO: Change to bool
     bool m_zooming_boost_enabled;
     std::chrono::steady_clock::time_point m_settings_boost_start_time;
-    std::mutex m_settings_boost_mutex;
+    ProfiledMutex m_settings_boost_mutex{"encoder_settings_boost"};
 
   public:
     Impl(std::string json_string);
@@ -260,7 +261,7 @@ class Encoder::Impl final
     VCEncPictureType get_input_format(std::string format);
     VCEncPictureCodingType find_next_pic();
     media_library_return update_input_buffer(HailoMediaLibraryBufferPtr buf);
-    media_library_return allocate_output_memory(HailoMediaLibraryBufferPtr buffer_ptr);
+    media_library_return allocate_output_memory(HailoMediaLibraryBufferPtr &buffer_ptr);
     tl::expected<EncoderOutputBuffer, media_library_return> encode_executer(encoder_operation_t op);
     media_library_return update_configurations();
     media_library_return update_gop_configurations();
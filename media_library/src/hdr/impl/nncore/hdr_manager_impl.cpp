@@ -10,6 +10,7 @@
 #include "video_device.hpp"
 #include "hailo_media_library_perfetto.hpp"
 #include "isp_utils.hpp"
+#include "threading_manager.hpp"
 
 #include <filesystem>
 #include <optional>
@@ -368,6 +369,8 @@ void HdrManager::Impl::hdr_loop()
     StitchContextPtr stitch_ctx;
     HDR::VideoBuffer *tmp_buf = NULL;
 
+    ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_HDR);
+
     if (!m_initialized)
     {
         LOGGER__MODULE__ERROR(LOGGER_TYPE, "HDR loop error: Not initialized");
@@ -56,6 +56,7 @@ HAILO_PERFETTO_DEFINE_CATEGORIES(
 #define VIDEO_DEV_THREADED_TRACK (perfetto::ThreadSubTrack::Current(VIDEO_DEV_TRACK))
 #define DSP_OPS_TRACK (perfetto::NamedTrack("Dsp Operations", 0, MEDIA_LIBRARY_TRACK))
 #define DSP_THREADED_TRACK (perfetto::ThreadSubTrack::Current(DSP_OPS_TRACK))
+#define LOCKS_TRACK (perfetto::NamedTrack("Locks", 0, MEDIA_LIBRARY_TRACK))
 
 /* We want all media-library tracks to go into specific tracks inside MEDIA_LIBRARY_TRACK */
 /* We specifically don't use TRACE_EVENT() directly,
@@ -27,6 +27,7 @@
 #include "media_library_utils.hpp"
 #include "analytics_db.hpp"
 #include "polygon_math.hpp"
+#include "buffer_pool_registry.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <sys/types.h>
@@ -145,28 +146,34 @@ tl::expected<PrivacyMaskBlenderPtr, media_library_return> PrivacyMaskBlender::cr
     return privacy_mask_blender_ptr;
 }
 
-media_library_return PrivacyMaskBlender::init_buffer_pool()
+buffer_pool_key_t PrivacyMaskBlender::get_buffer_pool_key(uint frame_width, uint frame_height)
 {
-    // Round up m_frame_width to be a multiple of byte_size / PRIVACY_MASK_QUANTIZATION (32)
+    // Round up frame_width to be a multiple of byte_size / PRIVACY_MASK_QUANTIZATION (32)
     int line_division = 8 / PRIVACY_MASK_QUANTIZATION;
-    uint frame_width = ((m_frame_width + (line_division - 1)) & ~(line_division - 1)) / line_division;
+    uint mask_width = ((frame_width + (line_division - 1)) & ~(line_division - 1)) / line_division;
     // Round bytes_per_line to be a multiple of byte_size (8)
-    uint bytes_per_line = (frame_width + 7) & ~7;
-    uint frame_height = m_frame_height / 4;
+    uint bytes_per_line = (mask_width + 7) & ~7;
+    uint mask_height = frame_height / 4;
+    return {mask_width, mask_height, HAILO_FORMAT_GRAY8, HAILO_MEMORY_TYPE_DMABUF, bytes_per_line};
+}
+
+media_library_return PrivacyMaskBlender::init_buffer_pool()
+{
     std::string name = "privacy_mask";
     // TODO: set pool size
-    m_buffer_pool = std::make_shared<MediaLibraryBufferPool>(frame_width, frame_height, HAILO_FORMAT_GRAY8, 1,
-                                                             HAILO_MEMORY_TYPE_DMABUF, bytes_per_line, name);
-    if (m_buffer_pool->init() != MEDIA_LIBRARY_SUCCESS)
+    buffer_pool_key_t key = get_buffer_pool_key(m_frame_width, m_frame_height);
+    auto pool_expected = BufferPoolRegistry::get_instance().lease(key, BUFFER_POOL_MAX_BUFFERS, name);
+    if (!pool_expected.has_value())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to initialize buffer pool");
         return media_library_return::MEDIA_LIBRARY_BUFFER_ALLOCATION_ERROR;
     }
+    m_buffer_pool = pool_expected.value();
 
     LOGGER__MODULE__INFO(MODULE_NAME,
                          "Buffer pool initialized successfully with frame size {}x{} "
                          "bytes_per_line {}",
-                         frame_width, frame_height, bytes_per_line);
+                         key.width, key.height, key.bytes_per_line);
     return media_library_return::MEDIA_LIBRARY_SUCCESS;
 }
 
@@ -487,11 +494,13 @@ media_library_return PrivacyMaskBlender::update_static_mask()
         return media_library_return::MEDIA_LIBRARY_ERROR;
     }
 
-    if (m_buffer_pool->acquire_buffer(m_latest_privacy_masks->static_data->bitmask) != MEDIA_LIBRARY_SUCCESS)
+    auto bitmask_expected = m_buffer_pool->acquire_buffer();
+    if (!bitmask_expected.has_value())
     {
         LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to acquire buffer");
         return media_library_return::MEDIA_LIBRARY_ERROR;
     }
+    m_latest_privacy_masks->static_data->bitmask = std::move(bitmask_expected.value());
 
     m_latest_privacy_masks->static_data->bitmask->sync_start();
     if (write_polygons_to_privacy_mask_data(m_static_privacy_masks, m_frame_width, m_frame_height,
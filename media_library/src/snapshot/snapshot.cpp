@@ -150,6 +150,10 @@ bool SnapshotManager::has_snapshot_requested(const std::string &stage_name)
 
 void SnapshotManager::take_snapshot(const std::string &stage_name, const HailoMediaLibraryBufferPtr &buffer)
 {
+    // Every stage passes its output here, which makes it the place to tell the buffer tracker who holds the buffer
+    if (buffer)
+        buffer->mark_stage(stage_name);
+
     if (!m_running)
     {
         return;
@@ -182,8 +186,10 @@ void SnapshotManager::take_snapshot(const std::string &stage_name, const HailoMe
     // Increment the pending operations counter
     m_pending_operations++;
 
-    // Use ThreadPool to process the snapshot request asynchronously
-    ThreadPool::GetInstance()->enqueue(&SnapshotManager::process_snapshot_request, this, request);
+    // Process the snapshot request asynchronously, on its own pool so that file writes never delay frame path tasks
+    ThreadPool::GetInstance(SNAPSHOT_THREAD_POOL_NAME, 1)->post([this, request]() {
+        process_snapshot_request(request);
+    });
 
     // Check if this was the last stage for this frame
     bool is_frame_complete = false;
@@ -305,10 +311,21 @@ std::string SnapshotManager::process_command(const std::string &command)
     {
         response = list_available_stages();
     }
+    else if (cmd_name == BufferTracker::DUMP_COMMAND)
+    {
+        std::string pool_name;
+        std::getline(cmd_stream >> std::ws, pool_name);
+        response = BufferTracker::get_instance().dump(pool_name);
+    }
+    else if (cmd_name == LockProfiler::DUMP_COMMAND)
+    {
+        response = LockProfiler::get_instance().dump();
+    }
     else if (!command.empty())
     {
         LOGGER__MODULE__WARNING(MODULE_NAME, "Unknown command: '{}'", command);
-        response = "Error: Unknown command. Available commands: 'snapshot [frames_count] [stage_list]', 'list_stages'";
+        response = "Error: Unknown command. Available commands: 'snapshot [frames_count] [stage_list]', "
+                   "'list_stages', 'buffers [pool_name]', 'locks'";
     }
 
     return response;
@@ -2,6 +2,7 @@
 #include "throttling_state_monitor.hpp"
 #include "common.hpp"
 #include "env_vars.hpp"
+#include "threading_manager.hpp"
 #include <iostream>
 #include <map>
 
@@ -333,6 +334,7 @@ void ThrottlingStateMonitor::start_timer(int duration, const std::function<void(
     auto future = m_timer_promise->get_future();
 
     m_timer_thread = std::thread([this, duration, callback, future = std::move(future)]() mutable {
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_THROTTLING_TIMER);
         // Wait for the duration or until the promise is fulfilled
         if (future.wait_for(std::chrono::milliseconds(duration)) == std::future_status::timeout)
         {
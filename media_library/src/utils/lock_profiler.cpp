@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "profiled_mutex.hpp"
+#include "hailo_media_library_perfetto.hpp"
+#include <algorithm>
+#include <sstream>
+
+void LockProfiler::Counters::on_contended_acquire(uint64_t wait_ns)
+{
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    contended.fetch_add(1, std::memory_order_relaxed);
+    total_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+    wait_histogram[time_bin(wait_ns)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max_wait_ns = this->max_wait_ns.load(std::memory_order_relaxed);
+    while (wait_ns > max_wait_ns &&
+           !this->max_wait_ns.compare_exchange_weak(max_wait_ns, wait_ns, std::memory_order_relaxed))
+    {
+    }
+
+    HAILO_MEDIA_LIBRARY_TRACE_COUNTER(name, wait_ns / 1000, LOCKS_TRACK);
+}
+
+LockProfiler::Counters *LockProfiler::register_lock(const char *name)
+{
+    std::unique_lock<std::mutex> lock(m_profiler_mutex);
+    std::unique_ptr<Counters> &counters = m_counters[name];
+    if (counters == nullptr)
+    {
+        counters = std::make_unique<Counters>();
+        counters->name = name;
+    }
+    counters->instances.fetch_add(1, std::memory_order_relaxed);
+    return counters.get();
+}
+
+std::vector<lock_stats_t> LockProfiler::get_lock_stats()
+{
+    std::unique_lock<std::mutex> lock(m_profiler_mutex);
+    std::vector<lock_stats_t> stats;
+    for (const auto &[name, counters] : m_counters)
+    {
+        lock_stats_t lock_stats = {};
+        lock_stats.name = name;
+        lock_stats.instances = counters->instances.load(std::memory_order_relaxed);
+        lock_stats.acquisitions = counters->acquisitions.load(std::memory_order_relaxed);
+        lock_stats.contended = counters->contended.load(std::memory_order_relaxed);
+        lock_stats.total_wait_us = counters->total_wait_ns.load(std::memory_order_relaxed) / 1000;
+        lock_stats.max_wait_us = counters->max_wait_ns.load(std::memory_order_relaxed) / 1000;
+        lock_stats.total_hold_us = counters->total_hold_ns.load(std::memory_order_relaxed) / 1000;
+        for (size_t bin = 0; bin < TIME_BINS; bin++)
+        {
+            lock_stats.wait_histogram.push_back(counters->wait_histogram[bin].load(std::memory_order_relaxed));
+            lock_stats.hold_histogram.push_back(counters->hold_histogram[bin].load(std::memory_order_relaxed));
+        }
+        stats.push_back(lock_stats);
+    }
+    return stats;
+}
+
+void LockProfiler::reset()
+{
+    std::unique_lock<std::mutex> lock(m_profiler_mutex);
+    for (auto &[name, counters] : m_counters)
+    {
+        counters->acquisitions = 0;
+        counters->contended = 0;
+        counters->total_wait_ns = 0;
+        counters->max_wait_ns = 0;
+        counters->total_hold_ns = 0;
+        for (size_t bin = 0; bin < TIME_BINS; bin++)
+        {
+            counters->wait_histogram[bin] = 0;
+            counters->hold_histogram[bin] = 0;
+        }
+    }
+}
+
+static void dump_histogram(std::stringstream &ss, const char *title, const std::vector<uint64_t> &histogram)
+{
+    ss << "  " << title << " (us):";
+    for (size_t bin = 0; bin < histogram.size(); bin++)
+    {
+        if (histogram[bin] == 0)
+            continue;
+        if (bin == 0)
+            ss << " <1:";
+        else if (bin == histogram.size() - 1)
+            ss << " >=" << (1 << (bin - 1)) << ":";
+        else
+            ss << " " << (1 << (bin - 1)) << "-" << (1 << bin) << ":";
+        ss << histogram[bin];
+    }
+    ss << "\n";
+}
+
+std::string LockProfiler::dump()
+{
+    if (!is_enabled())
+        return "Lock profiling is disabled, build with -Dlock_profiling=true";
+
+    std::vector<lock_stats_t> stats = get_lock_stats();
+    std::sort(stats.begin(), stats.end(), [](const lock_stats_t &a, const lock_stats_t &b) {
+        return a.total_wait_us > b.total_wait_us;
+    });
+
+    std::stringstream ss;
+    ss << "Locks:\n";
+    for (const lock_stats_t &lock_stats : stats)
+    {
+        ss << "- " << lock_stats.name << " (" << lock_stats.instances << " instances): " << lock_stats.acquisitions
+           << " acquisitions, " << lock_stats.contended << " contended, wait " << lock_stats.total_wait_us
+           << " us (max " << lock_stats.max_wait_us << " us), held " << lock_stats.total_hold_us << " us\n";
+        dump_histogram(ss, "wait", lock_stats.wait_histogram);
+        dump_histogram(ss, "hold", lock_stats.hold_histogram);
+    }
+    return ss.str();
+}
@@ -1,5 +1,6 @@
 #include "pipe_handler.hpp"
 #include "media_library_logger.hpp"
+#include "threading_manager.hpp"
 
 #include <fcntl.h>
 #include <sys/epoll.h>
@@ -59,7 +60,10 @@ bool PipeHandler::start()
     }
 
     m_running = true;
-    m_pipe_thread = std::thread([this]() { monitor_pipe(); });
+    m_pipe_thread = std::thread([this]() {
+        ThreadingManager::get_instance().register_current_thread(MEDIALIB_THREAD_PIPE_HANDLER);
+        monitor_pipe();
+    });
 
     LOGGER__MODULE__INFO(MODULE_NAME, "Pipe handler started at {}", m_pipe_path);
     return true;
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "threading_manager.hpp"
+#include "media_library_logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define MODULE_NAME LoggerType::Default
+
+// The kernel keeps up to 15 characters of a thread name
+#define THREAD_NAME_MAX_LENGTH (15)
+// Number of /proc/<pid>/task/<tid>/stat fields between the command name and the CPU the thread last ran on
+#define STAT_FIELDS_BEFORE_PROCESSOR (36)
+
+static pid_t current_thread_id()
+{
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// Unregisters the thread from the manager when it exits
+struct RegisteredThread
+{
+    pid_t tid = 0;
+
+    ~RegisteredThread()
+    {
+        if (tid != 0)
+            ThreadingManager::get_instance().unregister_thread(tid);
+    }
+};
+static thread_local RegisteredThread registered_thread;
+
+static int last_cpu_of(pid_t tid)
+{
+    std::ifstream stat_file("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string stat;
+    if (!std::getline(stat_file, stat))
+        return -1;
+
+    // The command name may contain spaces, the fields that follow it are space separated
+    size_t command_end = stat.rfind(')');
+    if (command_end == std::string::npos)
+        return -1;
+
+    std::istringstream fields(stat.substr(command_end + 1));
+    std::string field;
+    for (int i = 0; i < STAT_FIELDS_BEFORE_PROCESSOR && fields >> field; i++)
+    {
+    }
+    int cpu = -1;
+    fields >> cpu;
+    return cpu;
+}
+
+media_library_return ThreadingManager::apply(pid_t tid, const thread_config_t &config)
+{
+    media_library_return status = MEDIA_LIBRARY_SUCCESS;
+
+    struct sched_param param = {};
+    int policy = SCHED_OTHER;
+    switch (config.policy)
+    {
+    case THREAD_SCHED_POLICY_FIFO:
+        policy = SCHED_FIFO;
+        param.sched_priority = config.priority;
+        break;
+    case THREAD_SCHED_POLICY_RR:
+        policy = SCHED_RR;
+        param.sched_priority = config.priority;
+        break;
+    default:
+        break;
+    }
+
+    // Real-time policies need CAP_SYS_NICE (or an RLIMIT_RTPRIO), the thread keeps running with its current policy
+    if (sched_setscheduler(tid, policy, &param) != 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to set scheduling policy {} priority {} of thread {} ({}): {}",
+                              policy, param.sched_priority, config.name, tid, strerror(errno));
+        status = MEDIA_LIBRARY_ERROR;
+    }
+
+    if (policy == SCHED_OTHER && setpriority(PRIO_PROCESS, tid, config.nice) != 0)
+    {
+        LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to set nice {} of thread {} ({}): {}", config.nice, config.name,
+                              tid, strerror(errno));
+        status = MEDIA_LIBRARY_ERROR;
+    }
+
+    if (!config.cpus.empty())
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (int cpu : config.cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpu_set);
+        }
+        if (sched_setaffinity(tid, sizeof(cpu_set), &cpu_set) != 0)
+        {
+            LOGGER__MODULE__ERROR(MODULE_NAME, "Failed to set CPU affinity of thread {} ({}): {}", config.name, tid,
+                                  strerror(errno));
+            status = MEDIA_LIBRARY_ERROR;
+        }
+    }
+
+    LOGGER__MODULE__DEBUG(MODULE_NAME, "Thread {} ({}) scheduled with policy {} priority {} nice {} on {} CPUs",
+                          config.name, tid, policy, param.sched_priority, config.nice, config.cpus.size());
+    return status;
+}
+
+media_library_return ThreadingManager::configure(const std::vector<thread_config_t> &configs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    media_library_return status = MEDIA_LIBRARY_SUCCESS;
+
+    m_configs.clear();
+    for (const thread_config_t &config : configs)
+    {
+        m_configs[config.name] = config;
+    }
+
+    for (const auto &[tid, name] : m_threads)
+    {
+        auto it = m_configs.find(name);
+        if (it != m_configs.end() && apply(tid, it->second) != MEDIA_LIBRARY_SUCCESS)
+            status = MEDIA_LIBRARY_ERROR;
+    }
+    return status;
+}
+
+media_library_return ThreadingManager::register_current_thread(const std::string &name)
+{
+    pid_t tid = current_thread_id();
+    pthread_setname_np(pthread_self(), name.substr(0, THREAD_NAME_MAX_LENGTH).c_str());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_threads[tid] = name;
+    registered_thread.tid = tid;
+
+    auto it = m_configs.find(name);
+    if (it == m_configs.end())
+        return MEDIA_LIBRARY_SUCCESS;
+    return apply(tid, it->second);
+}
+
+void ThreadingManager::unregister_thread(pid_t tid)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_threads.erase(tid);
+}
+
+std::vector<thread_placement_t> ThreadingManager::get_thread_placements()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::vector<thread_placement_t> placements;
+
+    for (const auto &[tid, name] : m_threads)
+    {
+        thread_placement_t placement = {};
+        placement.name = name;
+        placement.tid = tid;
+
+        int policy = sched_getscheduler(tid);
+        struct sched_param param = {};
+        if (policy < 0 || sched_getparam(tid, &param) != 0)
+        {
+            LOGGER__MODULE__WARNING(MODULE_NAME, "Failed to get scheduling of thread {} ({}): {}", name, tid,
+                                    strerror(errno));
+            continue;
+        }
+        switch (policy & ~SCHED_RESET_ON_FORK)
+        {
+        case SCHED_FIFO:
+            placement.policy = THREAD_SCHED_POLICY_FIFO;
+            break;
+        case SCHED_RR:
+            placement.policy = THREAD_SCHED_POLICY_RR;
+            break;
+        default:
+            placement.policy = THREAD_SCHED_POLICY_OTHER;
+            break;
+        }
+        placement.priority = param.sched_priority;
+
+        // getpriority() may legitimately return -1, errno tells the failures apart
+        errno = 0;
+        placement.nice = getpriority(PRIO_PROCESS, tid);
+        if (errno != 0)
+            placement.nice = 0;
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        if (sched_getaffinity(tid, sizeof(cpu_set), &cpu_set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &cpu_set))
+                    placement.cpus.push_back(cpu);
+            }
+        }
+        placement.last_cpu = last_cpu_of(tid);
+
+        placements.push_back(placement);
+    }
+    return placements;
+}
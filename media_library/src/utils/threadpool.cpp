@@ -1,43 +1,157 @@
 #include "threadpool.hpp"
 
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
 std::shared_ptr<ThreadPool> ThreadPool::instance = nullptr;
 std::mutex ThreadPool::instance_mutex;
+std::unordered_map<std::string, std::shared_ptr<ThreadPool>> ThreadPool::named_instances;
+
+// The pool and worker index of the current thread, so that tasks submitted by a worker stay on its own ring
+static thread_local ThreadPool *current_pool = nullptr;
+static thread_local size_t current_worker_index = 0;
 
 ThreadPool::ThreadPool() : ThreadPool(MEDIALIB_THREADPOOL_DEFAULT_SIZE)
 {
 }
 
-ThreadPool::ThreadPool(size_t threads) : stop(false)
+ThreadPool::ThreadPool(size_t threads) : ThreadPool(threads, MEDIALIB_THREADPOOL_DEFAULT_NAME)
+{
+}
+
+ThreadPool::ThreadPool(size_t threads, const std::string &name, const std::vector<int> &cpu_affinity)
+    : m_name(name), m_next_worker(0), m_pending_tasks(0), m_stop(false)
 {
+    if (threads == 0)
+        threads = 1;
+
+    // All the workers exist before any of them starts, since a worker may steal from any other
+    for (size_t i = 0; i < threads; ++i)
+        m_workers.emplace_back(std::make_unique<Worker>());
+
     for (size_t i = 0; i < threads; ++i)
-        workers.emplace_back([this] {
-            for (;;)
+    {
+        m_workers[i]->thread = std::thread([this, i] { worker_loop(i); });
+        set_worker_attributes(i, cpu_affinity);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (std::unique_ptr<Worker> &worker : m_workers)
+        worker->thread.join();
+}
+
+void ThreadPool::set_worker_attributes(size_t worker_index, const std::vector<int> &cpu_affinity)
+{
+    pthread_t handle = m_workers[worker_index]->thread.native_handle();
+
+    // The kernel keeps up to 15 characters of a thread name, keep the worker index
+    std::string suffix = "_" + std::to_string(worker_index);
+    std::string thread_name = m_name.substr(0, 15 - std::min<size_t>(suffix.size(), 15)) + suffix;
+    pthread_setname_np(handle, thread_name.c_str());
+
+    if (cpu_affinity.empty())
+        return;
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpu_affinity)
+        CPU_SET(cpu, &cpu_set);
+    pthread_setaffinity_np(handle, sizeof(cpu_set), &cpu_set);
+}
+
+void ThreadPool::submit(InplaceTask &&task, ThreadPoolPriority priority)
+{
+    size_t worker_index = (current_pool == this) ? current_worker_index
+                                                 : m_next_worker.fetch_add(1, std::memory_order_relaxed) %
+                                                       m_workers.size();
+    {
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        // don't allow enqueueing after stopping the pool
+        if (m_stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+
+    Worker &worker = *m_workers[worker_index];
+    {
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_pending_tasks++;
+    }
+    m_condition.notify_one();
+}
+
+bool ThreadPool::pop_task(size_t worker_index, InplaceTask &task)
+{
+    for (size_t priority = 0; priority < PRIORITIES_COUNT; priority++)
+    {
+        // Own tasks are taken from the front in submission order
+        {
+            Worker &worker = *m_workers[worker_index];
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            if (!worker.tasks[priority].empty())
             {
-                std::function<void()> task;
-
-                {
-                    std::unique_lock<std::mutex> lock(this->queue_mutex);
-                    this->condition.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
-                    if (this->stop && this->tasks.empty())
-                        return;
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
-
-                task();
+                task = worker.tasks[priority].pop_front();
+                return true;
             }
-        });
+        }
+
+        // Steal from the back of the other workers, the oldest tasks stay with their owner
+        for (size_t i = 1; i < m_workers.size(); i++)
+        {
+            Worker &victim = *m_workers[(worker_index + i) % m_workers.size()];
+            std::unique_lock<std::mutex> lock(victim.mutex);
+            if (!victim.tasks[priority].empty())
+            {
+                task = victim.tasks[priority].pop_back();
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
-ThreadPool::~ThreadPool()
+void ThreadPool::worker_loop(size_t worker_index)
 {
+    current_pool = this;
+    current_worker_index = worker_index;
+
+    for (;;)
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        stop = true;
+        {
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_condition.wait(lock, [this] { return m_stop || m_pending_tasks > 0; });
+            if (m_stop && m_pending_tasks == 0)
+                return;
+            // Claim one of the queued tasks, there is always a queued task for every claim
+            m_pending_tasks--;
+        }
+
+        InplaceTask task;
+        // A scan may race with another worker taking the task it was about to find, look again
+        while (!pop_task(worker_index, task))
+            std::this_thread::yield();
+
+        // Tasks from enqueue() report exceptions through their future, a posted task has nobody to report to
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+        }
     }
-    condition.notify_all();
-    for (std::thread &worker : workers)
-        worker.join();
 }
 
 std::shared_ptr<ThreadPool> ThreadPool::GetInstance()
@@ -52,3 +166,15 @@ std::shared_ptr<ThreadPool> ThreadPool::GetInstance()
     }
     return instance;
 }
+
+std::shared_ptr<ThreadPool> ThreadPool::GetInstance(const std::string &name, size_t threads,
+                                                    const std::vector<int> &cpu_affinity)
+{
+    std::unique_lock<std::mutex> lock(instance_mutex);
+    auto it = named_instances.find(name);
+    if (it == named_instances.end())
+    {
+        it = named_instances.emplace(name, std::make_shared<ThreadPool>(threads, name, cpu_affinity)).first;
+    }
+    return it->second;
+}
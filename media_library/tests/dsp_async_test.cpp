@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file dsp_async_test.cpp
+ * @brief Checks the completion fences of the asynchronous DSP jobs, the order the jobs start in, the queue depth and
+ * the CPU fallback of a full queue
+ **/
+
+#include "dsp_utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+using namespace dsp_utils;
+
+static constexpr std::chrono::milliseconds TIMEOUT(5000);
+// time given to something that must not happen
+static constexpr std::chrono::milliseconds SETTLE(50);
+
+static bool is_readable(int fd)
+{
+    struct pollfd poll_fd = {fd, POLLIN, 0};
+    return poll(&poll_fd, 1, 0) == 1 && (poll_fd.revents & POLLIN);
+}
+
+/**
+ * @brief Jobs that record they started and then block until released, so the test controls when each completes
+ */
+class GatedJobs
+{
+  public:
+    explicit GatedJobs(size_t count) : m_started(count, false), m_released(count, false)
+    {
+    }
+
+    dsp_job_t job(size_t index, dsp_status status = DSP_SUCCESS)
+    {
+        return [this, index, status](dsp_device) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_started[index] = true;
+            m_cv.notify_all();
+            m_cv.wait(lock, [this, index] { return m_released[index]; });
+            return status;
+        };
+    }
+
+    void release(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released[index] = true;
+        m_cv.notify_all();
+    }
+
+    bool wait_started(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cv.wait_for(lock, TIMEOUT, [this, index] { return m_started[index]; });
+    }
+
+    size_t started_count()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t count = 0;
+        for (bool started : m_started)
+            count += started;
+        return count;
+    }
+
+    bool started(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_started[index];
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<bool> m_started;
+    std::vector<bool> m_released;
+};
+
+static bool test_fence()
+{
+    DspFence fence;
+    CHECK(!fence.is_signaled());
+    CHECK(!fence.wait_for(std::chrono::milliseconds(10)).has_value());
+    int fd = fence.fd();
+    CHECK(fd >= 0);
+    CHECK(fence.fd() == fd);
+    CHECK(!is_readable(fd));
+
+    std::thread signaler([&fence] {
+        std::this_thread::sleep_for(SETTLE);
+        fence.signal(DSP_INVALID_ARGUMENT);
+    });
+    CHECK(fence.wait() == DSP_INVALID_ARGUMENT);
+    signaler.join();
+    CHECK(fence.is_signaled());
+    CHECK(fence.wait_for(std::chrono::milliseconds(0)) == DSP_INVALID_ARGUMENT);
+    CHECK(is_readable(fd));
+
+    // the fd of a fence signaled before it was requested starts readable
+    DspFence signaled;
+    signaled.signal(DSP_SUCCESS);
+    CHECK(is_readable(signaled.fd()));
+    return true;
+}
+
+static bool test_no_device()
+{
+    std::atomic<bool> ran(false);
+    DspFencePtr fence = submit_dsp_job("test_no_device", [&ran](dsp_device) {
+        ran = true;
+        return DSP_SUCCESS;
+    });
+    CHECK(fence->wait_for(TIMEOUT) == DSP_UNINITIALIZED);
+    CHECK(!ran);
+    return true;
+}
+
+/**
+ * @brief Every worker takes the oldest queued job, and its fence is signaled with its status once it returns
+ */
+static bool test_order()
+{
+    static constexpr size_t COUNT = 12;
+    const size_t workers = MEDIALIB_DSP_ASYNC_WORKERS;
+    CHECK(set_async_queue_depth(COUNT) == DSP_SUCCESS);
+
+    GatedJobs jobs(COUNT);
+    std::vector<DspFencePtr> fences;
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        dsp_status status = (i % 3 == 0) ? DSP_INVALID_ARGUMENT : DSP_SUCCESS;
+        fences.push_back(submit_dsp_job("test_order", jobs.job(i, status)));
+    }
+
+    // the first jobs occupy all the workers, the others stay queued
+    for (size_t i = 0; i < workers; i++)
+        CHECK(jobs.wait_started(i));
+    std::this_thread::sleep_for(SETTLE);
+    CHECK(jobs.started_count() == workers);
+    for (const DspFencePtr &fence : fences)
+        CHECK(!fence->is_signaled());
+
+    int fd = fences[0]->fd();
+    CHECK(!is_readable(fd));
+
+    // each completion starts the next job in submission order
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        jobs.release(i);
+        CHECK(fences[i]->wait_for(TIMEOUT) == ((i % 3 == 0) ? DSP_INVALID_ARGUMENT : DSP_SUCCESS));
+        if (i + workers < COUNT)
+        {
+            CHECK(jobs.wait_started(i + workers));
+            CHECK(jobs.started_count() == i + 1 + workers);
+        }
+        for (size_t j = i + 1; j < COUNT; j++)
+            CHECK(!fences[j]->is_signaled());
+    }
+    CHECK(is_readable(fd));
+    return true;
+}
+
+/**
+ * @brief A submission to a full queue blocks until a job completes, unless it can run on the CPU backend
+ */
+static bool test_depth_and_fallback()
+{
+    const size_t workers = MEDIALIB_DSP_ASYNC_WORKERS;
+    CHECK(set_async_queue_depth(0) == DSP_INVALID_ARGUMENT);
+    CHECK(set_async_queue_depth(workers) == DSP_SUCCESS);
+
+    GatedJobs jobs(workers + 1);
+    std::vector<DspFencePtr> fences;
+    for (size_t i = 0; i < workers; i++)
+        fences.push_back(submit_dsp_job("test_depth", jobs.job(i)));
+
+    std::atomic<bool> submitted(false);
+    std::thread submitter([&] {
+        fences.push_back(submit_dsp_job("test_depth", jobs.job(workers)));
+        submitted = true;
+    });
+    std::this_thread::sleep_for(SETTLE);
+    CHECK(!submitted);
+
+    // a blend can run on the CPU, it completes on the submitting thread while the queue is full
+    std::vector<uint8_t> frame_data(64 * 32 * 3 / 2);
+    dsp_data_plane_t plane = {};
+    plane.userptr = frame_data.data();
+    plane.bytesperline = 64;
+    plane.bytesused = frame_data.size();
+    dsp_image_properties_t frame = {};
+    frame.width = 64;
+    frame.height = 32;
+    frame.planes = &plane;
+    frame.planes_count = 1;
+    frame.format = DSP_IMAGE_FORMAT_NV12;
+    frame.memory = DSP_MEMORY_TYPE_USERPTR;
+    set_cpu_fallback(true);
+    DspFencePtr blend_fence = submit_dsp_multiblend(&frame, nullptr, 0);
+    CHECK(blend_fence->is_signaled());
+    CHECK(blend_fence->wait() == DSP_SUCCESS);
+    set_cpu_fallback(false);
+    CHECK(!submitted);
+
+    jobs.release(0);
+    submitter.join();
+    CHECK(fences[0]->wait_for(TIMEOUT) == DSP_SUCCESS);
+    for (size_t i = 1; i <= workers; i++)
+    {
+        jobs.release(i);
+        CHECK(fences[i]->wait_for(TIMEOUT) == DSP_SUCCESS);
+    }
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = test_fence() && ok;
+    // before the device is acquired, the jobs fail without running
+    ok = test_no_device() && ok;
+    if (acquire_device() != DSP_SUCCESS)
+    {
+        printf("FAILED to acquire the DSP device\n");
+        return 1;
+    }
+    ok = test_order() && ok;
+    ok = test_depth_and_fallback() && ok;
+    release_device();
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
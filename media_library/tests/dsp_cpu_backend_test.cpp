@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file dsp_cpu_backend_test.cpp
+ * @brief Checks the resize interpolations of the CPU DSP backend against a floating point reference, its alpha
+ * blending against the exact division, and the placement of letterboxed crops
+ **/
+
+#include "dsp_cpu_backend.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+/**
+ * @brief A user pointer image of up to 4 planes
+ */
+struct test_image_t
+{
+    std::vector<std::vector<uint8_t>> storage;
+    dsp_data_plane_t planes[4];
+    dsp_image_properties_t properties;
+
+    test_image_t(dsp_image_format_t format, size_t width, size_t height) : planes(), properties()
+    {
+        // bytes per sample and subsampling shift of each plane, padded strides catch rows written past their width
+        struct plane_layout_t
+        {
+            size_t channels;
+            int shift;
+        };
+        std::vector<plane_layout_t> layouts;
+        switch (format)
+        {
+        case DSP_IMAGE_FORMAT_NV12:
+            layouts = {{1, 0}, {2, 1}};
+            break;
+        case DSP_IMAGE_FORMAT_A420:
+            layouts = {{1, 0}, {1, 1}, {1, 1}, {1, 0}};
+            break;
+        case DSP_IMAGE_FORMAT_RGB:
+            layouts = {{3, 0}};
+            break;
+        default:
+            layouts = {{1, 0}};
+            break;
+        }
+
+        storage.resize(layouts.size());
+        for (size_t i = 0; i < layouts.size(); i++)
+        {
+            size_t stride = ((width >> layouts[i].shift) * layouts[i].channels + 16 + 15) & ~15UL;
+            storage[i].assign(stride * (height >> layouts[i].shift), 0);
+            planes[i].userptr = storage[i].data();
+            planes[i].bytesperline = stride;
+            planes[i].bytesused = storage[i].size();
+        }
+        properties.width = width;
+        properties.height = height;
+        properties.planes = planes;
+        properties.planes_count = layouts.size();
+        properties.format = format;
+        properties.memory = DSP_MEMORY_TYPE_USERPTR;
+    }
+
+    test_image_t(const test_image_t &) = delete;
+    test_image_t &operator=(const test_image_t &) = delete;
+
+    uint8_t &at(size_t plane, size_t x, size_t y)
+    {
+        return storage[plane][y * planes[plane].bytesperline + x];
+    }
+
+    void randomize()
+    {
+        for (std::vector<uint8_t> &plane : storage)
+            for (uint8_t &value : plane)
+                value = static_cast<uint8_t>(rand());
+    }
+};
+
+static float reference_position(size_t dst_index, float scale)
+{
+    return (dst_index + 0.5f) * scale - 0.5f;
+}
+
+static int clamp_index(long index, size_t size)
+{
+    return static_cast<int>(std::clamp(index, 0L, static_cast<long>(size) - 1));
+}
+
+static float keys_kernel(float x)
+{
+    const float a = -0.75f;
+    x = std::fabs(x);
+    if (x <= 1.0f)
+        return ((a + 2) * x - (a + 3)) * x * x + 1;
+    if (x < 2.0f)
+        return ((a * x - 5 * a) * x + 8 * a) * x - 4 * a;
+    return 0.0f;
+}
+
+/**
+ * @brief Floating point reference of an interpolation at output sample (dx, dy) of a plane of channels bytes
+ * Bilinear clamps positions before the first source sample, as the DSP does, bicubic extends the edge samples.
+ */
+static float reference_sample(test_image_t &src, size_t channels, size_t src_width, size_t src_height,
+                              size_t dst_width, size_t dst_height, size_t dx, size_t dy, size_t c,
+                              dsp_interpolation_type_t interpolation)
+{
+    float scale_x = static_cast<float>(src_width) / dst_width;
+    float scale_y = static_cast<float>(src_height) / dst_height;
+    auto sample = [&](long x, long y) {
+        return static_cast<float>(src.at(0, clamp_index(x, src_width) * channels + c, clamp_index(y, src_height)));
+    };
+
+    if (interpolation == INTERPOLATION_TYPE_NEAREST_NEIGHBOR)
+        return sample(static_cast<long>((dx + 0.5f) * scale_x), static_cast<long>((dy + 0.5f) * scale_y));
+
+    float fx = reference_position(dx, scale_x);
+    float fy = reference_position(dy, scale_y);
+    if (interpolation == INTERPOLATION_TYPE_BICUBIC)
+    {
+        long x = static_cast<long>(std::floor(fx));
+        long y = static_cast<long>(std::floor(fy));
+        float value = 0;
+        for (long j = -1; j <= 2; j++)
+            for (long i = -1; i <= 2; i++)
+                value += sample(x + i, y + j) * keys_kernel(fx - (x + i)) * keys_kernel(fy - (y + j));
+        return std::clamp(value, 0.0f, 255.0f);
+    }
+
+    fx = std::max(fx, 0.0f);
+    fy = std::max(fy, 0.0f);
+    long x = static_cast<long>(fx);
+    long y = static_cast<long>(fy);
+    float tx = fx - x;
+    float ty = fy - y;
+    return (sample(x, y) * (1 - tx) + sample(x + 1, y) * tx) * (1 - ty) +
+           (sample(x, y + 1) * (1 - tx) + sample(x + 1, y + 1) * tx) * ty;
+}
+
+/**
+ * @brief Resize a random crop and compare every output sample to the reference
+ */
+static bool check_resize(dsp_image_format_t format, size_t channels, size_t src_width, size_t src_height,
+                         size_t dst_width, size_t dst_height, dsp_interpolation_type_t interpolation,
+                         float max_error)
+{
+    // the crop is offset into a larger image, so the kernels must read relative to it
+    const size_t crop_x = 6, crop_y = 4;
+    test_image_t src(format, src_width + crop_x + 10, src_height + crop_y + 6);
+    test_image_t dst(format, dst_width, dst_height);
+    src.randomize();
+    test_image_t crop(format, src_width, src_height);
+    for (size_t y = 0; y < src_height; y++)
+        for (size_t x = 0; x < src_width * channels; x++)
+            crop.at(0, x, y) = src.at(0, crop_x * channels + x, crop_y + y);
+    // the bytes past the row width must be left untouched
+    for (uint8_t &value : dst.storage[0])
+        value = 77;
+
+    dsp_resize_params_t resize_params = {};
+    resize_params.src = &src.properties;
+    resize_params.dst = &dst.properties;
+    resize_params.interpolation = interpolation;
+    dsp_crop_api_t crop_params = {};
+    crop_params.start_x = crop_x;
+    crop_params.start_y = crop_y;
+    crop_params.end_x = crop_x + src_width;
+    crop_params.end_y = crop_y + src_height;
+    CHECK(dsp_cpu::crop_and_resize_letterbox(&resize_params, &crop_params, nullptr) == DSP_SUCCESS);
+
+    for (size_t y = 0; y < dst_height; y++)
+    {
+        for (size_t x = 0; x < dst_width * channels; x++)
+        {
+            float expected = reference_sample(crop, channels, src_width, src_height, dst_width, dst_height,
+                                              x / channels, y, x % channels, interpolation);
+            float error = std::fabs(dst.at(0, x, y) - expected);
+            if (error > max_error)
+            {
+                printf("interpolation %d, %zux%zu to %zux%zu: sample (%zu, %zu) is %d, expected %.2f\n",
+                       interpolation, src_width, src_height, dst_width, dst_height, x, y, dst.at(0, x, y), expected);
+                return false;
+            }
+        }
+        for (size_t x = dst_width * channels; x < dst.planes[0].bytesperline; x++)
+            CHECK(dst.at(0, x, y) == 77);
+    }
+    return true;
+}
+
+static bool test_resize()
+{
+    // output widths around the 8 and 16 samples of the SIMD loops, so that the scalar tails are exercised
+    const size_t widths[] = {1, 2, 7, 8, 9, 15, 16, 17, 31, 33, 47, 64, 100};
+    const dsp_interpolation_type_t interpolations[] = {INTERPOLATION_TYPE_NEAREST_NEIGHBOR,
+                                                       INTERPOLATION_TYPE_BILINEAR, INTERPOLATION_TYPE_BICUBIC};
+    // the Q7 horizontal bilinear weights move a sample by up to 255/256 before the final rounding, the Q11 bicubic
+    // weights by less
+    const float max_errors[] = {0.0f, 1.5f, 1.0f};
+    for (size_t i = 0; i < 3; i++)
+    {
+        for (size_t width : widths)
+        {
+            // downscale and upscale
+            CHECK(check_resize(DSP_IMAGE_FORMAT_GRAY8, 1, 64, 40, width, 13, interpolations[i], max_errors[i]));
+            CHECK(check_resize(DSP_IMAGE_FORMAT_GRAY8, 1, 5, 7, width, 30, interpolations[i], max_errors[i]));
+            // interleaved channels
+            CHECK(check_resize(DSP_IMAGE_FORMAT_RGB, 3, 50, 20, width, 11, interpolations[i], max_errors[i]));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Blend a 256x256 A420 overlay over an NV12 frame for every alpha, with each pair of overlay and frame values
+ */
+static bool test_blend_exact()
+{
+    test_image_t frame(DSP_IMAGE_FORMAT_NV12, 256, 256);
+    test_image_t overlay(DSP_IMAGE_FORMAT_A420, 256, 256);
+    for (size_t y = 0; y < 256; y++)
+    {
+        for (size_t x = 0; x < 256; x++)
+            overlay.at(0, x, y) = static_cast<uint8_t>(x);
+    }
+
+    dsp_overlay_properties_t overlay_properties = {};
+    overlay_properties.overlay = overlay.properties;
+    for (int alpha = 0; alpha < 256; alpha++)
+    {
+        for (size_t y = 0; y < 256; y++)
+        {
+            for (size_t x = 0; x < 256; x++)
+            {
+                frame.at(0, x, y) = static_cast<uint8_t>(y);
+                overlay.at(3, x, y) = static_cast<uint8_t>(alpha);
+            }
+        }
+        CHECK(dsp_cpu::blend(&frame.properties, &overlay_properties, 1) == DSP_SUCCESS);
+
+        for (uint32_t y = 0; y < 256; y++)
+        {
+            for (uint32_t x = 0; x < 256; x++)
+            {
+                uint32_t expected = (x * alpha + y * (255 - alpha) + 127) / 255;
+                if (frame.at(0, x, y) != expected)
+                {
+                    printf("blend of %u over %u with alpha %d is %d, expected %u\n", x, y, alpha, frame.at(0, x, y),
+                           expected);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Blend random overlays of widths that leave SIMD tails at an offset, checking luma and chroma
+ */
+static bool test_blend_offsets()
+{
+    for (size_t width = 2; width <= 40; width += 2)
+    {
+        test_image_t frame(DSP_IMAGE_FORMAT_NV12, 64, 16);
+        test_image_t overlay(DSP_IMAGE_FORMAT_A420, width, 8);
+        frame.randomize();
+        overlay.randomize();
+        // only the samples of the copy are read, its planes still point to the frame
+        test_image_t original(DSP_IMAGE_FORMAT_NV12, 64, 16);
+        original.storage = frame.storage;
+
+        dsp_overlay_properties_t overlay_properties = {};
+        overlay_properties.overlay = overlay.properties;
+        overlay_properties.x_offset = 6;
+        overlay_properties.y_offset = 4;
+        CHECK(dsp_cpu::blend(&frame.properties, &overlay_properties, 1) == DSP_SUCCESS);
+
+        auto blended = [](uint32_t s, uint32_t d, uint32_t a) { return (s * a + d * (255 - a) + 127) / 255; };
+        for (size_t y = 0; y < 16; y++)
+        {
+            for (size_t x = 0; x < 64; x++)
+            {
+                bool inside = x >= 6 && x < 6 + width && y >= 4 && y < 12;
+                uint32_t expected = inside ? blended(overlay.at(0, x - 6, y - 4), original.at(0, x, y),
+                                                     overlay.at(3, x - 6, y - 4))
+                                           : original.at(0, x, y);
+                CHECK(frame.at(0, x, y) == expected);
+            }
+        }
+        // each chroma pair takes the alpha of the top left pixel of its 2x2 block
+        for (size_t y = 0; y < 8; y++)
+        {
+            for (size_t x = 0; x < 32; x++)
+            {
+                bool inside = x >= 3 && x < 3 + width / 2 && y >= 2 && y < 6;
+                for (size_t c = 0; c < 2; c++)
+                {
+                    uint32_t expected = original.at(1, x * 2 + c, y);
+                    if (inside)
+                    {
+                        expected = blended(overlay.at(1 + c, x - 3, y - 2), expected,
+                                           overlay.at(3, (x - 3) * 2, (y - 2) * 2));
+                    }
+                    CHECK(frame.at(1, x * 2 + c, y) == expected);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Letterbox a uniform NV12 crop and check where the image and the letterbox color land
+ *
+ * @param[in] dst_rect - x, y, width, height of the image in the output, the rest must be the letterbox color
+ */
+static bool check_letterbox(size_t src_width, size_t src_height, size_t dst_width, size_t dst_height,
+                            dsp_letterbox_alignment_t alignment, const size_t dst_rect[4])
+{
+    test_image_t src(DSP_IMAGE_FORMAT_NV12, src_width, src_height);
+    test_image_t dst(DSP_IMAGE_FORMAT_NV12, dst_width, dst_height);
+    std::fill(src.storage[0].begin(), src.storage[0].end(), 200);
+    for (size_t i = 0; i < src.storage[1].size(); i++)
+        src.storage[1][i] = (i % 2 == 0) ? 60 : 190;
+
+    dsp_resize_params_t resize_params = {};
+    resize_params.src = &src.properties;
+    resize_params.dst = &dst.properties;
+    resize_params.interpolation = INTERPOLATION_TYPE_BILINEAR;
+    dsp_letterbox_properties_t letterbox = {};
+    letterbox.alignment = alignment;
+    letterbox.color = {16, 100, 150};
+    CHECK(dsp_cpu::crop_and_resize_letterbox(&resize_params, nullptr, &letterbox) == DSP_SUCCESS);
+
+    for (size_t y = 0; y < dst_height; y++)
+    {
+        for (size_t x = 0; x < dst_width; x++)
+        {
+            bool inside = x >= dst_rect[0] && x < dst_rect[0] + dst_rect[2] && y >= dst_rect[1] &&
+                          y < dst_rect[1] + dst_rect[3];
+            CHECK(dst.at(0, x, y) == (inside ? 200 : 16));
+            if (x % 2 == 0 && y % 2 == 0)
+            {
+                CHECK(dst.at(1, x, y / 2) == (inside ? 60 : 100));
+                CHECK(dst.at(1, x + 1, y / 2) == (inside ? 190 : 150));
+            }
+        }
+    }
+    return true;
+}
+
+static bool test_letterbox()
+{
+    // wider than the output: bands above and below, rounded down to even rows
+    const size_t wide_middle[] = {0, 6, 64, 36};
+    CHECK(check_letterbox(90, 50, 64, 48, DSP_LETTERBOX_MIDDLE, wide_middle));
+    const size_t wide_up_left[] = {0, 0, 64, 36};
+    CHECK(check_letterbox(90, 50, 64, 48, DSP_LETTERBOX_UP_LEFT, wide_up_left));
+    // taller than the output: bands on the sides
+    const size_t tall_middle[] = {16, 0, 32, 64};
+    CHECK(check_letterbox(50, 100, 64, 64, DSP_LETTERBOX_MIDDLE, tall_middle));
+    const size_t tall_up_left[] = {0, 0, 32, 64};
+    CHECK(check_letterbox(50, 100, 64, 64, DSP_LETTERBOX_UP_LEFT, tall_up_left));
+    // same aspect ratio: no letterbox
+    const size_t same[] = {0, 0, 32, 16};
+    CHECK(check_letterbox(64, 32, 32, 16, DSP_LETTERBOX_MIDDLE, same));
+    return true;
+}
+
+int main()
+{
+    srand(1);
+    bool ok = true;
+    ok = test_resize() && ok;
+    ok = test_blend_exact() && ok;
+    ok = test_blend_offsets() && ok;
+    ok = test_letterbox() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
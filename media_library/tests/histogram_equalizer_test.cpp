@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file histogram_equalizer_test.cpp
+ * @brief Checks the fixed point histogram equalization against the double precision reference, and measures both
+ *
+ * Runs the checks by default, and the micro-benchmark when given --benchmark.
+ **/
+
+#include "histogram_equalizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Largest LUT difference allowed from the reference, in levels
+static constexpr int MAX_LUT_DIFF = 1;
+// Largest share of LUT entries allowed to differ from the reference, in 1/1000
+static constexpr long MAX_DIFFERING_PER_MILLE = 1;
+static constexpr int NUM_HISTOGRAMS = 3000;
+static constexpr int NUM_UPDATES_PER_HISTOGRAM = 5;
+static constexpr int NUM_BENCHMARK_ITERATIONS = 100000;
+
+/**
+ * @brief Double precision equalization the fixed point one replaced: clip the histogram at a multiple of its mean,
+ * spread the excess over all the bins, and blend the normalized CDF with the previous LUT
+ */
+static void reference_update(const uint32_t *histogram, double clip_threshold, double alpha, uint8_t *lut)
+{
+    std::vector<double> clipped_hist(histogram, histogram + DSP_HISTOGRAM_SIZE);
+    double sum_pixels_in_hist = std::accumulate(clipped_hist.begin(), clipped_hist.end(), 0.0);
+    double actual_clip_limit = clip_threshold * sum_pixels_in_hist / DSP_HISTOGRAM_SIZE;
+
+    double excess = 0;
+    for (auto &curr : clipped_hist)
+    {
+        if (curr > actual_clip_limit)
+        {
+            excess += curr - actual_clip_limit;
+            curr = actual_clip_limit;
+        }
+    }
+    double redist = excess / DSP_HISTOGRAM_SIZE;
+    for (auto &curr : clipped_hist)
+    {
+        curr += redist;
+    }
+
+    std::vector<double> cdf(DSP_HISTOGRAM_SIZE);
+    std::partial_sum(clipped_hist.begin(), clipped_hist.end(), cdf.begin());
+    double cdf_max = cdf.back();
+    for (int i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+    {
+        lut[i] = static_cast<uint8_t>(alpha * lut[i] + (1 - alpha) * ((cdf[i] * 255.0) / cdf_max + 0.5));
+    }
+}
+
+/**
+ * @brief Fills a histogram with a normal distribution of luma values, scaled to the given number of samples
+ */
+static void fill_histogram(std::mt19937 &rng, uint32_t samples, uint32_t *histogram)
+{
+    static constexpr int NUM_DRAWS = 10000;
+    std::normal_distribution<double> distribution(rng() % DSP_HISTOGRAM_SIZE, 1 + rng() % 60);
+    memset(histogram, 0, DSP_HISTOGRAM_SIZE * sizeof(uint32_t));
+    for (int i = 0; i < NUM_DRAWS; i++)
+    {
+        int value = std::clamp(static_cast<int>(distribution(rng)), 0, DSP_HISTOGRAM_SIZE - 1);
+        histogram[value] += samples / NUM_DRAWS;
+    }
+}
+
+static bool check_lut_matches_reference()
+{
+    static constexpr uint32_t SAMPLE_COUNTS[] = {10000, 200000, 20000000};
+    std::mt19937 rng(5);
+    int max_diff = 0;
+    long differing = 0;
+    long total = 0;
+
+    for (int h = 0; h < NUM_HISTOGRAMS; h++)
+    {
+        uint32_t histogram[DSP_HISTOGRAM_SIZE];
+        fill_histogram(rng, SAMPLE_COUNTS[h % 3], histogram);
+        double clip_threshold = 0.5 + (rng() % 400) / 100.0;
+        double alpha = (rng() % 100) / 100.0;
+
+        uint8_t reference_lut[DSP_HISTOGRAM_SIZE];
+        uint8_t lut[DSP_HISTOGRAM_SIZE];
+        for (int i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+        {
+            reference_lut[i] = lut[i] = rng();
+        }
+
+        HistogramEqualizer equalizer;
+        for (int u = 0; u < NUM_UPDATES_PER_HISTOGRAM; u++)
+        {
+            reference_update(histogram, clip_threshold, alpha, reference_lut);
+            equalizer.reset();
+            equalizer.update(histogram, clip_threshold, alpha, lut);
+            for (int i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+            {
+                int diff = std::abs(reference_lut[i] - lut[i]);
+                max_diff = std::max(max_diff, diff);
+                differing += diff != 0;
+                total++;
+                // continue from the same LUT, so differences don't accumulate over the updates
+                lut[i] = reference_lut[i];
+            }
+        }
+    }
+
+    printf("LUT vs reference: max diff %d, differing entries %ld of %ld\n", max_diff, differing, total);
+    return max_diff <= MAX_LUT_DIFF && differing * 1000 <= total * MAX_DIFFERING_PER_MILLE;
+}
+
+static bool check_prefix_sum()
+{
+    std::mt19937 rng(7);
+    uint32_t in[DSP_HISTOGRAM_SIZE];
+    uint32_t out[DSP_HISTOGRAM_SIZE];
+    for (auto &bin : in)
+    {
+        bin = rng() % 1000;
+    }
+    HistogramEqualizer::prefix_sum(in, out);
+
+    uint32_t sum = 0;
+    for (int i = 0; i < DSP_HISTOGRAM_SIZE; i++)
+    {
+        sum += in[i];
+        if (out[i] != sum)
+        {
+            printf("prefix sum mismatch at bin %d: %u != %u\n", i, out[i], sum);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename F> static double measure_us(F &&function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_BENCHMARK_ITERATIONS; i++)
+    {
+        function(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / NUM_BENCHMARK_ITERATIONS;
+}
+
+static void run_benchmark()
+{
+    std::mt19937 rng(11);
+    uint32_t histogram[DSP_HISTOGRAM_SIZE];
+    for (auto &bin : histogram)
+    {
+        bin = rng() % 100;
+    }
+    uint8_t lut[DSP_HISTOGRAM_SIZE] = {};
+    HistogramEqualizer equalizer;
+
+    // every iteration slightly changes the histogram so nothing is hoisted out of the loop
+    double reference_us = measure_us([&](int i) {
+        histogram[i % DSP_HISTOGRAM_SIZE] ^= 1;
+        reference_update(histogram, 2.0, 0.5, lut);
+    });
+    double regenerate_us = measure_us([&](int i) {
+        histogram[i % DSP_HISTOGRAM_SIZE] ^= 1;
+        equalizer.reset();
+        equalizer.update(histogram, 2.0, 0.5, lut);
+    });
+    double steady_us = measure_us([&](int i) {
+        histogram[i % DSP_HISTOGRAM_SIZE] ^= 1;
+        equalizer.update(histogram, 2.0, 0.5, lut);
+    });
+
+    printf("double reference: %.3f us, fixed point: %.3f us, steady histogram: %.3f us\n", reference_us,
+           regenerate_us, steady_us);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        run_benchmark();
+        return 0;
+    }
+
+    bool ok = check_prefix_sum();
+    ok = check_lut_matches_reference() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file index_free_list_test.cpp
+ * @brief Checks that IndexFreeList hands out every pushed index exactly once, also while several threads pop and push
+ * concurrently
+ **/
+
+#include "common/index_free_list.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+static bool test_single_thread()
+{
+    IndexFreeList list(4);
+    CHECK(list.empty());
+    CHECK(list.pop() == IndexFreeList::INVALID_INDEX);
+
+    // last pushed, first popped
+    for (uint32_t i = 0; i < 4; i++)
+        list.push(i);
+    CHECK(!list.empty());
+    CHECK(list.pop() == 3);
+    CHECK(list.pop() == 2);
+    list.push(3);
+    CHECK(list.pop() == 3);
+    CHECK(list.pop() == 1);
+    CHECK(list.pop() == 0);
+    CHECK(list.empty());
+    CHECK(list.pop() == IndexFreeList::INVALID_INDEX);
+    return true;
+}
+
+static bool test_concurrent()
+{
+    constexpr uint32_t CAPACITY = 8;
+    constexpr int THREADS = 4;
+    constexpr int ITERATIONS = 200000;
+    IndexFreeList list(CAPACITY);
+    for (uint32_t i = 0; i < CAPACITY; i++)
+        list.push(i);
+
+    // Each thread holds the indices it popped, an index held by two threads at once is a lost update of the head
+    std::vector<std::atomic<int>> holders(CAPACITY);
+    std::atomic<bool> shared_index(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < ITERATIONS; i++)
+            {
+                uint32_t index = list.pop();
+                if (index == IndexFreeList::INVALID_INDEX)
+                    continue;
+                if (holders[index].fetch_add(1) != 0)
+                    shared_index = true;
+                holders[index].fetch_sub(1);
+                list.push(index);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    CHECK(!shared_index);
+
+    // every index is back in the list, once
+    std::vector<bool> seen(CAPACITY, false);
+    for (uint32_t i = 0; i < CAPACITY; i++)
+    {
+        uint32_t index = list.pop();
+        CHECK(index < CAPACITY && !seen[index]);
+        seen[index] = true;
+    }
+    CHECK(list.empty());
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = test_single_thread() && ok;
+    ok = test_concurrent() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file lock_profiler_test.cpp
+ * @brief Checks the acquisitions, contention and hold times recorded by the profiled mutexes, including the
+ * re-acquisitions of condition variable waits
+ **/
+
+#include "profiled_mutex.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+static lock_stats_t get_stats(const std::string &name)
+{
+    for (const lock_stats_t &stats : LockProfiler::get_instance().get_lock_stats())
+    {
+        if (stats.name == name)
+            return stats;
+    }
+    return {};
+}
+
+static uint64_t histogram_total(const std::vector<uint64_t> &histogram)
+{
+    uint64_t total = 0;
+    for (uint64_t count : histogram)
+        total += count;
+    return total;
+}
+
+static bool test_uncontended()
+{
+    {
+        ProfiledMutex first("uncontended");
+        ProfiledMutex second("uncontended");
+        CHECK(get_stats("uncontended").instances == 2);
+        for (int i = 0; i < 3; i++)
+            std::lock_guard<ProfiledMutex> lock(first);
+        CHECK(second.try_lock());
+        second.unlock();
+    }
+
+    // the counters of a name outlive its mutexes
+    lock_stats_t stats = get_stats("uncontended");
+    CHECK(stats.instances == 0);
+    CHECK(stats.acquisitions == 4);
+    CHECK(stats.contended == 0 && stats.total_wait_us == 0);
+    CHECK(histogram_total(stats.wait_histogram) == 0);
+    CHECK(histogram_total(stats.hold_histogram) == 4);
+    return true;
+}
+
+static bool test_contended()
+{
+    ProfiledMutex mutex("contended");
+    std::unique_lock<ProfiledMutex> lock(mutex);
+    CHECK(!mutex.try_lock());
+    std::thread waiter([&mutex]() { std::lock_guard<ProfiledMutex> waiter_lock(mutex); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    lock.unlock();
+    waiter.join();
+
+    lock_stats_t stats = get_stats("contended");
+    CHECK(stats.acquisitions == 2);
+    CHECK(stats.contended == 1);
+    CHECK(stats.max_wait_us >= 10000 && stats.total_wait_us == stats.max_wait_us);
+    CHECK(histogram_total(stats.wait_histogram) == 1);
+    // the first lock was held for the 20 ms sleep
+    CHECK(stats.total_hold_us >= 10000);
+    return true;
+}
+
+static bool test_condition_variable()
+{
+    ProfiledMutex mutex("condition_variable");
+    std::condition_variable_any condition;
+    bool ready = false;
+    std::thread notifier([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<ProfiledMutex> lock(mutex);
+        ready = true;
+        condition.notify_all();
+    });
+    {
+        std::unique_lock<ProfiledMutex> lock(mutex);
+        condition.wait(lock, [&ready]() { return ready; });
+    }
+    notifier.join();
+
+    // the waiter locks before waiting and again when woken, the notifier once
+    lock_stats_t stats = get_stats("condition_variable");
+    CHECK(stats.acquisitions >= 3);
+    CHECK(histogram_total(stats.hold_histogram) == stats.acquisitions);
+    return true;
+}
+
+static bool test_shared()
+{
+    ProfiledSharedMutex mutex("shared");
+    {
+        std::shared_lock<ProfiledSharedMutex> first(mutex);
+        std::shared_lock<ProfiledSharedMutex> second(mutex);
+        CHECK(!mutex.try_lock());
+    }
+    {
+        std::unique_lock<ProfiledSharedMutex> lock(mutex);
+        CHECK(!mutex.try_lock_shared());
+    }
+
+    // hold times are recorded for the exclusive lock only
+    lock_stats_t stats = get_stats("shared");
+    CHECK(stats.acquisitions == 3);
+    CHECK(stats.contended == 0);
+    CHECK(histogram_total(stats.hold_histogram) == 1);
+    return true;
+}
+
+static bool test_reset()
+{
+    LockProfiler::get_instance().reset();
+    lock_stats_t stats = get_stats("contended");
+    CHECK(stats.name == "contended");
+    CHECK(stats.acquisitions == 0 && stats.contended == 0 && stats.max_wait_us == 0 && stats.total_hold_us == 0);
+    CHECK(histogram_total(stats.wait_histogram) == 0 && histogram_total(stats.hold_histogram) == 0);
+    CHECK(LockProfiler::get_instance().dump().find("- contended (0 instances)") != std::string::npos);
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = test_uncontended() && ok;
+    ok = test_contended() && ok;
+    ok = test_condition_variable() && ok;
+    ok = test_shared() && ok;
+    ok = test_reset() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
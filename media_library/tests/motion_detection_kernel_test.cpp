@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file motion_detection_kernel_test.cpp
+ * @brief Checks the fused motion mask kernel against the OpenCV passes it replaced, and measures both
+ *
+ * Runs the checks by default, and the micro-benchmark when given --benchmark.
+ **/
+
+#include "motion_detection_kernel.hpp"
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr int NUM_FRAMES = 200;
+static constexpr int NUM_BENCHMARK_ITERATIONS = 200;
+// Bytes added at the end of the rows of the planes and masks, so the strides differ from the width
+static constexpr size_t STRIDE_PADDING = 5;
+
+struct test_frames_t
+{
+    size_t width;
+    size_t height;
+    size_t stride;
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> previous;
+};
+
+/**
+ * @brief Creates frames of noise where a third of the pixels changed and the others only moved by a few levels
+ */
+static test_frames_t create_frames(std::mt19937 &rng, size_t width, size_t height)
+{
+    test_frames_t frames = {width, height, width + STRIDE_PADDING, {}, {}};
+    frames.current.resize(frames.stride * height);
+    frames.previous.resize(frames.stride * height);
+    for (size_t i = 0; i < frames.current.size(); i++)
+    {
+        frames.previous[i] = rng();
+        frames.current[i] = (rng() % 3 == 0) ? rng() : frames.previous[i] + rng() % 8;
+    }
+    return frames;
+}
+
+/**
+ * @brief The motion mask as computed before the fused kernel: difference, opening and threshold of the whole frame
+ */
+static cv::Mat multi_pass_motion_mask(const test_frames_t &frames, uint8_t threshold)
+{
+    cv::Mat current(frames.height, frames.width, CV_8UC1, const_cast<uint8_t *>(frames.current.data()), frames.stride);
+    cv::Mat previous(frames.height, frames.width, CV_8UC1, const_cast<uint8_t *>(frames.previous.data()),
+                     frames.stride);
+    cv::Mat mask;
+    cv::absdiff(current, previous, mask);
+    auto kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
+    cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+    cv::threshold(mask, mask, threshold, 255, cv::THRESH_BINARY);
+    return mask;
+}
+
+static bool check_frame(std::mt19937 &rng, MotionMaskKernel &kernel)
+{
+    test_frames_t frames = create_frames(rng, 8 + rng() % 70, 8 + rng() % 50);
+    size_t width = frames.width;
+    size_t height = frames.height;
+    uint8_t threshold = rng() % 40;
+    roi_t roi;
+    roi.x = rng() % (width / 2);
+    roi.y = rng() % (height / 2);
+    roi.width = 1 + rng() % (width - roi.x);
+    roi.height = 1 + rng() % (height - roi.y);
+
+    cv::Mat reference = multi_pass_motion_mask(frames, threshold);
+    cv::Rect cv_roi(roi.x, roi.y, roi.width, roi.height);
+    size_t reference_count = cv::countNonZero(reference(cv_roi));
+
+    // grid of cells of random sizes covering the frame
+    size_t columns = 1 + rng() % 7;
+    size_t rows = 1 + rng() % 7;
+    std::vector<uint32_t> cell_x;
+    std::vector<uint32_t> cell_y;
+    split_motion_map_cells(width, columns, cell_x);
+    split_motion_map_cells(height, rows, cell_y);
+    if (cell_x.front() != 0 || cell_x.back() != width || cell_y.front() != 0 || cell_y.back() != height)
+    {
+        printf("%zux%zu: cells do not cover the frame\n", width, height);
+        return false;
+    }
+    std::vector<uint32_t> cell_counts(columns * rows, 0xffffffff);
+    size_t packed_stride = (width + 7) / 8 + STRIDE_PADDING;
+    std::vector<uint8_t> packed_mask(packed_stride * height, 0xaa);
+    motion_mask_outputs_t outputs = {cell_x.data(),      cell_y.data(),      columns, rows,
+                                     cell_counts.data(), packed_mask.data(), packed_stride};
+
+    size_t mask_stride = width + STRIDE_PADDING;
+    std::vector<uint8_t> mask(mask_stride * height, 0x77);
+    size_t count = kernel.run({frames.current.data(), frames.stride, false},
+                              {frames.previous.data(), frames.stride, false}, width, height, roi, threshold,
+                              mask.data(), mask_stride, &outputs);
+    if (count != reference_count)
+    {
+        printf("%zux%zu: %zu moving pixels instead of %zu\n", width, height, count, reference_count);
+        return false;
+    }
+
+    std::vector<uint32_t> expected_cell_counts(columns * rows, 0);
+    for (size_t y = 0; y < height; y++)
+    {
+        size_t row = 0;
+        while (cell_y[row + 1] <= y)
+        {
+            row++;
+        }
+        for (size_t x = 0; x < width; x++)
+        {
+            bool in_roi = x >= roi.x && x < roi.x + roi.width && y >= roi.y && y < roi.y + roi.height;
+            uint8_t expected = in_roi ? reference.at<uint8_t>(y, x) : 0;
+            uint8_t value = mask[y * mask_stride + x];
+            if (value != expected)
+            {
+                printf("%zux%zu: mask is %u instead of %u at (%zu, %zu)\n", width, height, value, expected, x, y);
+                return false;
+            }
+            if (((packed_mask[y * packed_stride + x / 8] >> (x % 8)) & 1) != (value ? 1 : 0))
+            {
+                printf("%zux%zu: packed mask differs at (%zu, %zu)\n", width, height, x, y);
+                return false;
+            }
+
+            size_t column = 0;
+            while (cell_x[column + 1] <= x)
+            {
+                column++;
+            }
+            expected_cell_counts[row * columns + column] += value ? 1 : 0;
+        }
+    }
+    if (cell_counts != expected_cell_counts)
+    {
+        printf("%zux%zu: cell counts differ\n", width, height);
+        return false;
+    }
+
+    // the map marks the cells where more than the threshold fraction of the pixels move
+    float cell_threshold = (rng() % 20) / 100.0f;
+    motion_map_t map = {};
+    map.columns = columns;
+    map.rows = rows;
+    map.energy.resize(columns * rows);
+    map.cell_mask.assign((columns * rows + 7) / 8, 0xff);
+    fill_motion_map_cells(map, cell_x.data(), cell_y.data(), cell_counts.data(), cell_threshold);
+    for (size_t row = 0; row < rows; row++)
+    {
+        for (size_t column = 0; column < columns; column++)
+        {
+            size_t area = (cell_x[column + 1] - cell_x[column]) * (cell_y[row + 1] - cell_y[row]);
+            uint32_t cell_count = expected_cell_counts[row * columns + column];
+            bool expected_motion = cell_count > 0 && cell_count > area * cell_threshold;
+            if (map.energy[row * columns + column] != (area > 0 ? cell_count * 255 / area : 0) ||
+                map.cell_has_motion(column, row) != expected_motion)
+            {
+                printf("%zux%zu: motion map differs at cell (%zu, %zu)\n", width, height, column, row);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool check_mask_matches_multi_pass()
+{
+    std::mt19937 rng(1);
+    // the same kernel is reused across frame sizes, as by the motion detection
+    MotionMaskKernel kernel;
+    int failures = 0;
+    for (int i = 0; i < NUM_FRAMES; i++)
+    {
+        failures += check_frame(rng, kernel) ? 0 : 1;
+    }
+    printf("mask vs multi pass: %d of %d frames differ\n", failures, NUM_FRAMES);
+    return failures == 0;
+}
+
+template <typename F> static double measure_ms(F &&function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_BENCHMARK_ITERATIONS; i++)
+    {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / NUM_BENCHMARK_ITERATIONS;
+}
+
+static void run_benchmark()
+{
+    static constexpr uint8_t THRESHOLD = 16;
+    std::mt19937 rng(2);
+    for (auto [width, height] : {std::pair<size_t, size_t>{640, 360}, std::pair<size_t, size_t>{1280, 720}})
+    {
+        test_frames_t frames = create_frames(rng, width, height);
+        roi_t roi = {0, 0, static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        cv::Rect cv_roi(roi.x, roi.y, roi.width, roi.height);
+        std::vector<uint8_t> mask(width * height);
+        MotionMaskKernel kernel;
+
+        // the multi pass version also summed the mask of the ROI to count the moving pixels
+        volatile double multi_pass_sum = 0;
+        double multi_pass_ms = measure_ms([&]() {
+            cv::Mat reference = multi_pass_motion_mask(frames, THRESHOLD);
+            multi_pass_sum = cv::sum(reference(cv_roi))[0];
+        });
+        volatile size_t fused_count = 0;
+        double fused_ms = measure_ms([&]() {
+            fused_count = kernel.run({frames.current.data(), frames.stride, false},
+                                     {frames.previous.data(), frames.stride, false}, width, height, roi, THRESHOLD,
+                                     mask.data(), width);
+        });
+
+        printf("%zux%zu: multi pass %.3f ms, fused %.3f ms per frame\n", width, height, multi_pass_ms, fused_ms);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        run_benchmark();
+        return 0;
+    }
+
+    bool ok = check_mask_matches_multi_pass();
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file motion_reference_test.cpp
+ * @brief Checks the compact motion detection reference: its box downscaling, 4 bit quantization, running average
+ * background, and that it never points into the frames it was updated with
+ **/
+
+#include "motion_reference.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+static constexpr size_t STRIDE_PADDING = 3;
+
+static std::vector<uint8_t> random_frame(std::mt19937 &rng, size_t stride, size_t height)
+{
+    std::vector<uint8_t> frame(stride * height);
+    for (uint8_t &value : frame)
+        value = static_cast<uint8_t>(rng());
+    return frame;
+}
+
+static motion_reference_config_t create_config(uint32_t downscale, bool quantize, float background_learning_rate)
+{
+    motion_reference_config_t config;
+    config.enabled = true;
+    config.downscale = downscale;
+    config.quantize = quantize;
+    config.background_learning_rate = background_learning_rate;
+    return config;
+}
+
+static bool test_downscale()
+{
+    std::mt19937 rng(1);
+    for (size_t downscale = 1; downscale <= 4; downscale++)
+    {
+        // the sizes are not multiples of the downscale, the partial blocks are dropped
+        const size_t width = 23, height = 13, stride = width + STRIDE_PADDING;
+        std::vector<uint8_t> frame = random_frame(rng, stride, height);
+        MotionReference reference;
+        reference.configure(create_config(downscale, false, 0), width, height);
+        CHECK(reference.width() == width / downscale && reference.height() == height / downscale);
+        reference.set_current(frame.data(), stride);
+
+        motion_mask_plane_t current = reference.current();
+        CHECK(!current.packed);
+        if (downscale == 1)
+            CHECK(current.data == frame.data() && current.stride == stride);
+        for (size_t y = 0; y < reference.height(); y++)
+        {
+            for (size_t x = 0; x < reference.width(); x++)
+            {
+                uint32_t sum = 0;
+                for (size_t dy = 0; dy < downscale; dy++)
+                    for (size_t dx = 0; dx < downscale; dx++)
+                        sum += frame[(y * downscale + dy) * stride + x * downscale + dx];
+                uint32_t area = downscale * downscale;
+                CHECK(current.data[y * current.stride + x] == (sum + area / 2) / area);
+            }
+        }
+
+        // the reference is a copy, the frame buffer may be released after the update
+        reference.update();
+        CHECK(reference.is_initialized());
+        std::vector<uint8_t> expected(current.data, current.data + current.stride * reference.height());
+        memset(frame.data(), 0, frame.size());
+        motion_mask_plane_t plane = reference.reference();
+        for (size_t y = 0; y < reference.height(); y++)
+            CHECK(memcmp(plane.data + y * plane.stride, &expected[y * current.stride], reference.width()) == 0);
+    }
+    return true;
+}
+
+/**
+ * @brief A quantized reference holds the high nibbles, and the kernel compares with the middle of their ranges
+ */
+static bool test_quantize()
+{
+    std::mt19937 rng(2);
+    const size_t width = 37, height = 12, stride = width + STRIDE_PADDING;
+    std::vector<uint8_t> previous = random_frame(rng, stride, height);
+    std::vector<uint8_t> current = random_frame(rng, stride, height);
+
+    MotionReference reference;
+    reference.configure(create_config(1, true, 0), width, height);
+    reference.set_current(previous.data(), stride);
+    reference.update();
+    motion_mask_plane_t packed = reference.reference();
+    CHECK(packed.packed && packed.stride == (width + 1) / 2);
+
+    std::vector<uint8_t> unpacked(width * height);
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < width; x++)
+        {
+            uint8_t nibble = (packed.data[y * packed.stride + x / 2] >> ((x % 2) * 4)) & 0x0f;
+            CHECK(nibble == previous[y * stride + x] >> 4);
+            unpacked[y * width + x] = static_cast<uint8_t>(nibble << 4) | 0x08;
+        }
+    }
+
+    // ROIs at odd offsets start in the middle of a byte
+    const roi_t rois[] = {{0, 0, width, height}, {3, 1, 20, 9}, {8, 2, 29, 10}};
+    for (const roi_t &roi : rois)
+    {
+        MotionMaskKernel kernel;
+        std::vector<uint8_t> packed_mask(width * height), unpacked_mask(width * height);
+        size_t packed_count = kernel.run({current.data(), stride, false}, packed, width, height, roi, 20,
+                                         packed_mask.data(), width);
+        size_t unpacked_count = kernel.run({current.data(), stride, false}, {unpacked.data(), width, false}, width,
+                                           height, roi, 20, unpacked_mask.data(), width);
+        CHECK(packed_count == unpacked_count);
+        CHECK(packed_mask == unpacked_mask);
+    }
+    return true;
+}
+
+static bool test_background()
+{
+    const size_t width = 8, height = 4;
+    const float learning_rate = 0.25f;
+    MotionReference reference;
+    // the background is never quantized
+    reference.configure(create_config(1, true, learning_rate), width, height);
+    CHECK(!reference.reference().packed);
+
+    // the first frame initializes the background, the next ones move it towards them
+    std::vector<uint8_t> frame(width * height, 40);
+    reference.set_current(frame.data(), width);
+    reference.update();
+    std::fill(frame.begin(), frame.end(), 200);
+    float expected = 40;
+    for (int i = 0; i < 20; i++)
+    {
+        reference.set_current(frame.data(), width);
+        reference.update();
+        expected += (200 - expected) * learning_rate;
+        motion_mask_plane_t plane = reference.reference();
+        for (size_t j = 0; j < width * height; j++)
+            CHECK(std::fabs(plane.data[j] - expected) <= 1.0f);
+    }
+
+    // a slow rate still moves the background, thanks to its fractional bits, a background is kept across the change
+    reference.configure(create_config(1, false, 1.0f / 256), width, height);
+    std::fill(frame.begin(), frame.end(), 0);
+    for (int i = 0; i < 100; i++)
+    {
+        reference.set_current(frame.data(), width);
+        reference.update();
+    }
+    expected *= std::pow(1 - 1.0f / 256, 100);
+    CHECK(std::fabs(reference.reference().data[0] - expected) <= 1.0f);
+    return true;
+}
+
+static bool test_configure()
+{
+    const size_t width = 16, height = 8;
+    std::vector<uint8_t> frame(width * height, 1);
+    MotionReference reference;
+    reference.configure(create_config(2, false, 0), width, height);
+    CHECK(!reference.is_initialized());
+    reference.set_current(frame.data(), width);
+    reference.update();
+    CHECK(reference.is_initialized());
+
+    // the same geometry keeps the content
+    reference.configure(create_config(2, false, 0), width, height);
+    CHECK(reference.is_initialized());
+    // a different geometry, quantization or background drops it
+    reference.configure(create_config(4, false, 0), width, height);
+    CHECK(!reference.is_initialized());
+    reference.set_current(frame.data(), width);
+    reference.update();
+    reference.configure(create_config(4, true, 0), width, height);
+    CHECK(!reference.is_initialized());
+    reference.set_current(frame.data(), width);
+    reference.update();
+    reference.configure(create_config(4, true, 0.5f), width, height);
+    CHECK(!reference.is_initialized());
+    reference.set_current(frame.data(), width);
+    reference.update();
+    reference.configure(create_config(4, true, 0), width * 2, height);
+    CHECK(!reference.is_initialized());
+
+    reference.set_current(frame.data(), width * 2);
+    reference.update();
+    reference.reset();
+    CHECK(!reference.is_initialized());
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = test_downscale() && ok;
+    ok = test_quantize() && ok;
+    ok = test_background() && ok;
+    ok = test_configure() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file multi_resize_plan_test.cpp
+ * @brief Checks the per-frame compaction of the outputs skipped by a frame out of the cached multi-resize plan, and the
+ * priority order in which the output buffers are acquired
+ **/
+
+#include "multi_resize_plan.hpp"
+
+#include <cstdio>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+static constexpr size_t NUM_OUTPUTS = 9;
+
+/**
+ * @brief A plan of 2 groups: a full one of outputs 0, 2, 3, 5, 6, 7, 8 and 1, and output 4 alone.
+ * The scaling mode of each slot is its output index, so the slots can be followed through the compaction.
+ */
+static multi_resize_plan_t create_plan()
+{
+    multi_resize_plan_t plan;
+    plan.slot_outputs = {{0, 2, 3, 5, 6, 7, 8, 1}, {4}};
+    for (const std::vector<uint8_t> &slots : plan.slot_outputs)
+    {
+        dsp_crop_resize_params_t params = {};
+        params.crop = &plan.input_roi;
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            params.scaling_params[i].scaling_mode = static_cast<dsp_scaling_mode_t>(slots[i]);
+        }
+        plan.crop_resize_params.push_back(params);
+    }
+    return plan;
+}
+
+/**
+ * @brief Checks a group of the frame holds exactly the expected outputs, in order, followed by empty slots
+ */
+static bool check_group(const dsp_crop_resize_params_t &params, const multi_resize_plan_t &plan,
+                        std::vector<dsp_image_properties_t> &images, const std::vector<uint8_t> &expected_outputs)
+{
+    CHECK(params.crop == &plan.input_roi);
+    for (size_t i = 0; i < DSP_MULTI_RESIZE_OUTPUTS_COUNT; i++)
+    {
+        if (i < expected_outputs.size())
+        {
+            CHECK(params.dst[i] == &images[expected_outputs[i]]);
+            CHECK(params.scaling_params[i].scaling_mode == static_cast<dsp_scaling_mode_t>(expected_outputs[i]));
+        }
+        else
+        {
+            CHECK(params.dst[i] == nullptr);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compacts the plan for a frame producing the outputs not in skipped_outputs, and checks the groups
+ */
+static bool check_frame(const std::vector<uint8_t> &skipped_outputs,
+                        const std::vector<std::vector<uint8_t>> &expected_groups)
+{
+    multi_resize_plan_t plan = create_plan();
+    std::vector<dsp_image_properties_t> images(NUM_OUTPUTS);
+    std::vector<dsp_image_properties_t *> output_images(NUM_OUTPUTS);
+    for (size_t i = 0; i < NUM_OUTPUTS; i++)
+    {
+        output_images[i] = &images[i];
+    }
+    for (uint8_t output : skipped_outputs)
+    {
+        output_images[output] = nullptr;
+    }
+
+    // the storage is reused across frames, the previous content must not leak into the groups
+    dsp_crop_resize_params_t garbage = {};
+    for (size_t i = 0; i < DSP_MULTI_RESIZE_OUTPUTS_COUNT; i++)
+    {
+        garbage.dst[i] = &images[0];
+    }
+    std::vector<dsp_crop_resize_params_t> crop_resize_params(NUM_OUTPUTS, garbage);
+
+    size_t count = compact_crop_resize_params(plan, output_images.data(), crop_resize_params.data());
+    CHECK(count == expected_groups.size());
+    for (size_t p = 0; p < count; p++)
+    {
+        if (!check_group(crop_resize_params[p], plan, images, expected_groups[p]))
+        {
+            printf("group %zu differs\n", p);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_output_order(const std::vector<uint32_t> &priorities, const std::vector<uint8_t> &expected_order)
+{
+    std::vector<uint8_t> order = order_outputs_by_priority(priorities);
+    CHECK(order == expected_order);
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    // equal priorities keep the output order
+    ok = check_output_order({0, 0, 0}, {0, 1, 2}) && ok;
+    ok = check_output_order({1, 5, 3}, {1, 2, 0}) && ok;
+    ok = check_output_order({2, 7, 2, 7, 0}, {1, 3, 0, 2, 4}) && ok;
+    ok = check_output_order({}, {}) && ok;
+
+    // all the outputs are produced, the plan is copied as is
+    ok = check_frame({}, {{0, 2, 3, 5, 6, 7, 8, 1}, {4}}) && ok;
+    // a skipped output in the middle of a group shifts the next ones
+    ok = check_frame({3}, {{0, 2, 5, 6, 7, 8, 1}, {4}}) && ok;
+    // the first and last slots of a group
+    ok = check_frame({0, 1}, {{2, 3, 5, 6, 7, 8}, {4}}) && ok;
+    // a group left empty is dropped
+    ok = check_frame({4}, {{0, 2, 3, 5, 6, 7, 8, 1}}) && ok;
+    ok = check_frame({0, 2, 3, 5, 6, 7, 8, 1}, {{4}}) && ok;
+    // nothing produced
+    ok = check_frame({0, 1, 2, 3, 4, 5, 6, 7, 8}, {}) && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
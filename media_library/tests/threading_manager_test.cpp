@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file threading_manager_test.cpp
+ * @brief Checks that the configured nice values and CPU affinities are applied to the registered threads, whether they
+ * register before or after the configuration, and that exited threads are unregistered
+ **/
+
+#include "threading_manager.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <thread>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+/**
+ * @brief A thread that registers under a name and lives until stopped
+ */
+class NamedThread
+{
+  public:
+    explicit NamedThread(const char *name) : m_registered(false), m_stop(false)
+    {
+        m_thread = std::thread([this, name] {
+            media_library_return status = ThreadingManager::get_instance().register_current_thread(name);
+            char thread_name[16] = {};
+            pthread_getname_np(pthread_self(), thread_name, sizeof(thread_name));
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_status = status;
+            m_thread_name = thread_name;
+            m_registered = true;
+            m_cv.notify_all();
+            m_cv.wait(lock, [this] { return m_stop; });
+        });
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_registered; });
+    }
+
+    ~NamedThread()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    media_library_return status() const
+    {
+        return m_status;
+    }
+
+    const std::string &thread_name() const
+    {
+        return m_thread_name;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_registered;
+    bool m_stop;
+    media_library_return m_status;
+    std::string m_thread_name;
+    std::thread m_thread;
+};
+
+static std::optional<thread_placement_t> find_placement(const std::string &name)
+{
+    for (const thread_placement_t &placement : ThreadingManager::get_instance().get_thread_placements())
+    {
+        if (placement.name == name)
+            return placement;
+    }
+    return std::nullopt;
+}
+
+static thread_config_t create_config(const char *name, thread_sched_policy_t policy, int priority, int nice,
+                                     std::vector<int> cpus)
+{
+    thread_config_t config;
+    config.name = name;
+    config.policy = policy;
+    config.priority = priority;
+    config.nice = nice;
+    config.cpus = std::move(cpus);
+    return config;
+}
+
+static bool test_threading_manager()
+{
+    // the last CPU the test may run on, so that pinning to it is allowed in a restricted cpuset
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    CHECK(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int cpu = CPU_SETSIZE - 1;
+    while (!CPU_ISSET(cpu, &allowed))
+        cpu--;
+    int base_nice = getpriority(PRIO_PROCESS, 0);
+    // raising the nice value needs no privilege
+    int nice = std::min(base_nice + 5, 19);
+
+    // registered before its configuration, the thread keeps the default scheduling
+    NamedThread frontend(MEDIALIB_THREAD_FRONTEND_LOOP);
+    CHECK(frontend.status() == MEDIA_LIBRARY_SUCCESS);
+    CHECK(frontend.thread_name() == MEDIALIB_THREAD_FRONTEND_LOOP);
+    std::optional<thread_placement_t> placement = find_placement(MEDIALIB_THREAD_FRONTEND_LOOP);
+    CHECK(placement.has_value());
+    CHECK(placement->policy == THREAD_SCHED_POLICY_OTHER && placement->nice == base_nice);
+    CHECK(placement->cpus.size() == static_cast<size_t>(CPU_COUNT(&allowed)));
+
+    // a configuration is applied to the live threads
+    std::vector<thread_config_t> configs = {
+        create_config(MEDIALIB_THREAD_FRONTEND_LOOP, THREAD_SCHED_POLICY_OTHER, 0, nice, {cpu}),
+        create_config(MEDIALIB_THREAD_GYRO, THREAD_SCHED_POLICY_OTHER, 0, nice, {}),
+        create_config(MEDIALIB_THREAD_ENCODER_LOOP, THREAD_SCHED_POLICY_FIFO, 10, 0, {})};
+    CHECK(ThreadingManager::get_instance().configure(configs) == MEDIA_LIBRARY_SUCCESS);
+    placement = find_placement(MEDIALIB_THREAD_FRONTEND_LOOP);
+    CHECK(placement.has_value());
+    CHECK(placement->nice == nice);
+    CHECK(placement->cpus == std::vector<int>{cpu});
+
+    {
+        // and to the threads registered after it
+        NamedThread gyro(MEDIALIB_THREAD_GYRO);
+        CHECK(gyro.status() == MEDIA_LIBRARY_SUCCESS);
+        placement = find_placement(MEDIALIB_THREAD_GYRO);
+        CHECK(placement.has_value());
+        CHECK(placement->nice == nice);
+        CHECK(placement->cpus.size() == static_cast<size_t>(CPU_COUNT(&allowed)));
+
+        // names without a configuration keep the default scheduling
+        NamedThread hdr(MEDIALIB_THREAD_HDR);
+        CHECK(hdr.status() == MEDIA_LIBRARY_SUCCESS);
+        placement = find_placement(MEDIALIB_THREAD_HDR);
+        CHECK(placement.has_value() && placement->nice == base_nice);
+
+        // a real-time policy needs CAP_SYS_NICE, without it the thread reports the error and keeps its policy
+        NamedThread encoder(MEDIALIB_THREAD_ENCODER_LOOP);
+        placement = find_placement(MEDIALIB_THREAD_ENCODER_LOOP);
+        CHECK(placement.has_value());
+        if (encoder.status() == MEDIA_LIBRARY_SUCCESS)
+            CHECK(placement->policy == THREAD_SCHED_POLICY_FIFO && placement->priority == 10);
+        else
+            CHECK(placement->policy == THREAD_SCHED_POLICY_OTHER && placement->priority == 0);
+    }
+
+    // exited threads are unregistered
+    CHECK(!find_placement(MEDIALIB_THREAD_GYRO).has_value());
+    CHECK(!find_placement(MEDIALIB_THREAD_HDR).has_value());
+    CHECK(find_placement(MEDIALIB_THREAD_FRONTEND_LOOP).has_value());
+    frontend.stop();
+    CHECK(ThreadingManager::get_instance().get_thread_placements().empty());
+    return true;
+}
+
+int main()
+{
+    bool ok = test_threading_manager();
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file threadpool_test.cpp
+ * @brief Checks the task rings and the scheduling of ThreadPool, and measures its submission cost under contention
+ *
+ * Runs the checks by default, and the micro-benchmark when given --benchmark.
+ **/
+
+#include "threadpool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+static constexpr int NUM_BENCHMARK_TASKS = 200000;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+/**
+ * @brief The pool ThreadPool replaced: a single queue of std::function behind one mutex, shared by all the workers
+ */
+class SingleQueuePool
+{
+  public:
+    explicit SingleQueuePool(size_t threads) : m_stop(false)
+    {
+        for (size_t i = 0; i < threads; ++i)
+            m_workers.emplace_back([this] {
+                for (;;)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                        if (m_stop && m_tasks.empty())
+                            return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop();
+                    }
+                    task();
+                }
+            });
+    }
+
+    ~SingleQueuePool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        for (std::thread &worker : m_workers)
+            worker.join();
+    }
+
+    template <class F> std::future<void> enqueue(F &&f)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+        std::future<void> res = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]() { (*task)(); });
+        }
+        m_condition.notify_one();
+        return res;
+    }
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop;
+};
+
+static bool check_task_ring()
+{
+    TaskRing ring(4);
+    std::vector<int> order;
+    // wraps around and grows twice while partially drained
+    for (int i = 0; i < 3; i++)
+        ring.push_back([&order, i] { order.push_back(i); });
+    ring.pop_front()();
+    for (int i = 3; i < 12; i++)
+        ring.push_back([&order, i] { order.push_back(i); });
+    ring.pop_back()();
+    while (!ring.empty())
+        ring.pop_front()();
+
+    std::vector<int> expected = {0, 11, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    CHECK(order == expected);
+    return true;
+}
+
+static bool check_post_runs_all_tasks()
+{
+    static constexpr int NUM_PRODUCERS = 4;
+    static constexpr int NUM_TASKS = 5000;
+    std::atomic<int> done{0};
+    {
+        ThreadPool pool(3, "test_post");
+        std::vector<std::thread> producers;
+        for (int p = 0; p < NUM_PRODUCERS; p++)
+            producers.emplace_back([&pool, &done] {
+                for (int i = 0; i < NUM_TASKS; i++)
+                    pool.post([&done] { done++; });
+            });
+        for (std::thread &producer : producers)
+            producer.join();
+        // a throwing task is dropped without stopping its worker
+        for (int i = 0; i < 10; i++)
+            pool.post([] { throw std::runtime_error("dropped"); }, ThreadPoolPriority::High);
+
+        // move-only captures are supported
+        auto value = std::make_unique<int>(4);
+        std::promise<int> promise;
+        std::future<int> result = promise.get_future();
+        pool.post([value = std::move(value), promise = std::move(promise)]() mutable { promise.set_value(*value); });
+        CHECK(result.get() == 4);
+
+        while (done < NUM_PRODUCERS * NUM_TASKS)
+            std::this_thread::yield();
+    }
+    CHECK(done == NUM_PRODUCERS * NUM_TASKS);
+    return true;
+}
+
+static bool check_single_worker_order()
+{
+    ThreadPool pool(1, "test_order");
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    pool.post([gate_future] { gate_future.wait(); });
+
+    // queued while the worker is blocked: grows the ring, and high priority tasks jump ahead of the normal ones
+    std::vector<int> order;
+    for (int i = 0; i < 3 * MEDIALIB_THREADPOOL_RING_SIZE; i++)
+        pool.post([&order, i] { order.push_back(i); });
+    pool.post([&order] { order.push_back(-1); }, ThreadPoolPriority::High);
+    gate.set_value();
+    pool.invoke([] {});
+
+    CHECK(order.size() == 3 * MEDIALIB_THREADPOOL_RING_SIZE + 1);
+    CHECK(order[0] == -1);
+    for (int i = 0; i < 3 * MEDIALIB_THREADPOOL_RING_SIZE; i++)
+        CHECK(order[i + 1] == i);
+    return true;
+}
+
+/**
+ * @brief Nanoseconds per task for producers submitting their share of the tasks at once, until all of them ran
+ */
+template <class Submit> static double measure_ns(int producers, Submit &&submit)
+{
+    std::atomic<int> done{0};
+    int tasks_per_producer = NUM_BENCHMARK_TASKS / producers;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&] {
+            for (int i = 0; i < tasks_per_producer; i++)
+                submit([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        });
+    for (std::thread &thread : threads)
+        thread.join();
+    while (done.load(std::memory_order_relaxed) < tasks_per_producer * producers)
+        std::this_thread::yield();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (tasks_per_producer * producers);
+}
+
+static void run_benchmark()
+{
+    for (size_t workers : {1, 3})
+    {
+        for (int producers : {1, 4})
+        {
+            SingleQueuePool single_queue_pool(workers);
+            ThreadPool pool(workers, "bench");
+            double single_queue_ns = measure_ns(producers, [&](auto &&task) { single_queue_pool.enqueue(task); });
+            double enqueue_ns = measure_ns(producers, [&](auto &&task) { pool.enqueue(task); });
+            double post_ns = measure_ns(producers, [&](auto &&task) { pool.post(task); });
+            printf("%zu workers, %d producers: single queue %.0f ns, enqueue %.0f ns, post %.0f ns per task\n",
+                   workers, producers, single_queue_ns, enqueue_ns, post_ns);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+    {
+        run_benchmark();
+        return 0;
+    }
+
+    bool ok = check_task_ring();
+    ok = check_post_runs_all_tasks() && ok;
+    ok = check_single_worker_order() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
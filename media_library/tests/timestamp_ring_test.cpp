@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017-2024 Hailo Technologies Ltd. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * @file timestamp_ring_test.cpp
+ * @brief Checks the timestamp searches of TimestampRing, and that a full ring drops its oldest items, also while a
+ * consumer pops concurrently
+ **/
+
+#include "common/timestamp_ring.hpp"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                       \
+            return false;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+struct sample_t
+{
+    uint64_t timestamp_ns;
+    uint64_t sequence;
+};
+
+static bool test_bounds()
+{
+    TimestampRing<sample_t> ring(8);
+    CHECK(ring.capacity() == 8);
+    CHECK(ring.empty());
+    CHECK(ring.lower_bound(10) == 0 && ring.upper_bound(10) == 0);
+
+    // timestamps 10, 20, 20, 30, 40
+    std::vector<sample_t> samples = {{10, 0}, {20, 1}, {20, 2}, {30, 3}, {40, 4}};
+    CHECK(ring.push_many(samples) == samples.size());
+    CHECK(ring.size() == 5);
+    CHECK(ring.lower_bound(5) == 0 && ring.upper_bound(5) == 0);
+    CHECK(ring.lower_bound(10) == 0 && ring.upper_bound(10) == 1);
+    CHECK(ring.lower_bound(20) == 1 && ring.upper_bound(20) == 3);
+    CHECK(ring.lower_bound(25) == 3 && ring.upper_bound(25) == 3);
+    CHECK(ring.lower_bound(40) == 4 && ring.upper_bound(40) == 5);
+    CHECK(ring.lower_bound(50) == 5 && ring.upper_bound(50) == 5);
+
+    // the newest odd sequence not after 30 is 3, none is before 20
+    auto odd = [](const sample_t &sample) { return sample.sequence % 2 != 0; };
+    CHECK(ring.find_last(30, odd)->sequence == 3);
+    CHECK(ring.find_last(25, odd)->sequence == 1);
+    CHECK(!ring.find_last(15, odd).has_value());
+    CHECK(ring.size() == 5);
+    return true;
+}
+
+static bool test_pop_until()
+{
+    TimestampRing<sample_t> ring(8);
+    for (uint64_t i = 0; i < 6; i++)
+        CHECK(ring.push({(i + 1) * 10, i}));
+
+    // nothing up to a timestamp before the oldest
+    std::vector<sample_t> out = {{1, 1}};
+    CHECK(ring.pop_until(5, out) == 0 && out.empty());
+
+    // the timestamp is inclusive
+    CHECK(ring.pop_until(20, out) == 2);
+    CHECK(out[0].sequence == 0 && out[1].sequence == 1);
+
+    // the pointer overload stops at max_count, the rest stays queued
+    sample_t buffer[2];
+    CHECK(ring.pop_until(60, buffer, 2) == 2);
+    CHECK(buffer[0].sequence == 2 && buffer[1].sequence == 3);
+    CHECK(ring.size() == 2);
+
+    CHECK(ring.discard(1) == 1);
+    CHECK(ring.pop()->sequence == 5);
+    CHECK(!ring.pop().has_value());
+    CHECK(ring.discard(1) == 0);
+    CHECK(ring.dropped() == 0);
+    return true;
+}
+
+static bool test_full_ring()
+{
+    TimestampRing<sample_t> ring(4);
+    for (uint64_t i = 0; i < 10; i++)
+        CHECK(ring.push({i * 10, i}));
+
+    // the newest items are kept, the 6 oldest were dropped
+    CHECK(ring.size() == 4);
+    CHECK(ring.dropped() == 6);
+    CHECK(ring.lower_bound(60) == 0);
+    std::vector<sample_t> out;
+    CHECK(ring.pop_until(1000, out) == 4);
+    for (uint64_t i = 0; i < 4; i++)
+        CHECK(out[i].sequence == 6 + i);
+
+    // a batch larger than the ring keeps its tail
+    std::vector<sample_t> samples;
+    for (uint64_t i = 10; i < 20; i++)
+        samples.push_back({i * 10, i});
+    CHECK(ring.push_many(samples) == samples.size());
+    CHECK(ring.dropped() == 12);
+    CHECK(ring.pop()->sequence == 16);
+    return true;
+}
+
+static bool test_out_of_order()
+{
+    TimestampRing<sample_t> ring(8);
+    std::vector<sample_t> samples = {{10, 0}, {30, 1}, {20, 2}, {30, 3}, {5, 4}, {40, 5}};
+    CHECK(ring.push_many(samples) == 4);
+    CHECK(ring.dropped() == 2);
+    CHECK(!ring.push({35, 6}));
+    CHECK(ring.dropped() == 3);
+
+    std::vector<sample_t> out;
+    CHECK(ring.pop_until(100, out) == 4);
+    CHECK(out[0].sequence == 0 && out[1].sequence == 1 && out[2].sequence == 3 && out[3].sequence == 5);
+    return true;
+}
+
+/**
+ * @brief A producer overruns a small ring while the consumer pops, every popped item must be one that was pushed
+ * (its sequence matches its timestamp) and newer than the previous one
+ */
+static bool test_concurrent()
+{
+    static constexpr uint64_t COUNT = 2000000;
+    TimestampRing<sample_t> ring(16);
+    std::thread producer([&ring]() {
+        for (uint64_t i = 1; i <= COUNT; i++)
+            ring.push({i * 2, i});
+    });
+
+    // the newest item is never dropped, so it is eventually popped
+    uint64_t last = 0;
+    uint64_t popped = 0;
+    std::vector<sample_t> out;
+    sample_t buffer[3];
+    while (last != COUNT)
+    {
+        size_t count = (popped % 2 == 0) ? ring.pop_until(COUNT * 2, out) : ring.pop_until(COUNT * 2, buffer, 3);
+        const sample_t *items = (popped % 2 == 0) ? out.data() : buffer;
+        for (size_t i = 0; i < count; i++)
+        {
+            CHECK(items[i].timestamp_ns == items[i].sequence * 2);
+            CHECK(items[i].sequence > last);
+            last = items[i].sequence;
+        }
+        popped++;
+    }
+    producer.join();
+    CHECK(last == COUNT);
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = test_bounds() && ok;
+    ok = test_pop_until() && ok;
+    ok = test_full_ring() && ok;
+    ok = test_out_of_order() && ok;
+    ok = test_concurrent() && ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}